@@ -18,7 +18,9 @@
 #ifndef ENGINE_INTERFACE_BASE_H
 #define ENGINE_INTERFACE_BASE_H
 
+#include <vector>
 #include "tools/global.h"
+#include "tools/constants.h"
 
 class Operator_Base;
 
@@ -61,6 +63,16 @@ public:
 	//! Get the (interpolated) magnetic flux density field at \p pos. \sa SetInterpolationType
 	virtual double* GetBField(const unsigned int* pos, double* out) const =0;
 
+	//! Compile the (interpolated) field component \p n at \p pos into a weighted sum of raw engine values.
+	/*!
+	  The pointers to the raw values and their weights are appended to \p values and \p weights. The field component is the sum of all weight*value products.
+	  The pointers are only valid for the current engine (or snapshot) until the engine is reset. Returns false if this engine interface does not support compiled field access.
+	  \param dualField false for the electric field, true for the magnetic field
+	  \sa SetInterpolationType GetEField GetHField
+	  */
+	virtual bool CompileFieldGather(bool dualField, const unsigned int* pos, int n, std::vector<const FDTD_FLOAT*> &values, std::vector<double> &weights) const
+	{UNUSED(dualField);UNUSED(pos);UNUSED(n);UNUSED(values);UNUSED(weights);return false;}
+
 	//! Calculate the electric field integral along a given line
 	virtual double CalcVoltageIntegral(const unsigned int* start, const unsigned int* stop) const =0;
 
@@ -73,6 +85,13 @@ public:
 	//! Get the current number of timesteps
 	virtual unsigned int GetNumberOfTimesteps() const =0;
 
+	//! Use a snapshot of all fields inside the given box (inclusive start/stop index). All further field access will be served by this snapshot, returns false if not supported. \sa UpdateSnapshot
+	virtual bool EnableSnapshot(const unsigned int* start, const unsigned int* stop) {UNUSED(start);UNUSED(stop);return false;}
+	//! Copy the current fields of the running engine into the snapshot. The copy may be split into \a numParts parts, which can be updated concurrently. \sa EnableSnapshot
+	virtual void UpdateSnapshot(unsigned int part=0, unsigned int numParts=1) {UNUSED(part);UNUSED(numParts);}
+	//! Get the current number of timesteps of the running engine, may differ from GetNumberOfTimesteps() if a snapshot is used.
+	virtual unsigned int GetEngineNumberOfTimesteps() const {return GetNumberOfTimesteps();}
+
 	//! Calc (roughly) the total energy
 	/*!
 	  This method only calculates a very rough estimate of the total energy in the simulation domain.
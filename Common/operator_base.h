@@ -101,6 +101,8 @@ public:
 
 	//! Set flags to store material data for post-processing
 	virtual void SetMaterialStoreFlags(int type, bool val);
+	//! Get the flag to store material data for post-processing
+	bool GetMaterialStoreFlag(int type) const {if ((type<0) || (type>3)) return false; return m_StoreMaterial[type];}
 
 	//! Check storage flags and cleanup
 	virtual void CleanupMaterialStorage() = 0;
@@ -70,6 +70,9 @@ public:
 
 	double CalcTotalEnergyEstimate() const;
 
+	//! Field processings only read the engine fields, file dumps are serialized by the file writers.
+	virtual bool AllowParallelProcessing() const {return true;}
+
 	void SetFileType(FileType fileType) {m_fileType=fileType;}
 
 	static std::string GetFieldNameByType(DumpType type);
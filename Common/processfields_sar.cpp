@@ -273,6 +273,7 @@ void ProcessFieldsSAR::DumpFDData()
 		SAR_Calculation SAR_Calc;
 		SAR_Calc.SetAveragingMethod(m_SAR_method, g_settings.GetVerboseLevel()==0);
 		SAR_Calc.SetDebugLevel(g_settings.GetVerboseLevel());
+		SAR_Calc.SetDirectSummation(g_settings.SARDirectSummation());
 		SAR_Calc.SetNumLines(numLines);
 		if (m_DumpType == SAR_LOCAL_DUMP)
 			SAR_Calc.SetAveragingMass(0);
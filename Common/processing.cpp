@@ -30,6 +30,7 @@ Processing::Processing(Engine_Interface_Base* eng_if)
 	SetEngineInterface(eng_if);
 
 	Enabled = true;
+	m_Snapshot = false;
 	m_PS_pos = 0;
 	SetPrecision(12);
 	ProcessInterval=0;
@@ -66,6 +67,7 @@ void Processing::SetEngineInterface(Engine_Interface_Base* eng_if)
 {
 	delete m_Eng_Interface;
 	m_Eng_Interface = eng_if;
+	m_Snapshot = false;
 	if (m_Eng_Interface)
 		Op=m_Eng_Interface->GetOperator();
 	else
@@ -82,15 +84,21 @@ void Processing::SetName(string val, int number)
 bool Processing::CheckTimestep()
 {
 	unsigned int ts = m_Eng_Interface->GetNumberOfTimesteps();
+	if (IsProcessingTimestep(ts)==false)
+		return false;
+	if ((m_ProcessSteps.size()>m_PS_pos) && (m_ProcessSteps.at(m_PS_pos)==ts))
+		++m_PS_pos;
+	return true;
+}
+
+bool Processing::IsProcessingTimestep(unsigned int ts) const
+{
 	if (ts<startTS || ts>stopTS)
 		return false;
 	if (m_ProcessSteps.size()>m_PS_pos)
 	{
 		if (m_ProcessSteps.at(m_PS_pos)==ts)
-		{
-			++m_PS_pos;
 			return true;
-		}
 	}
 	if (ProcessInterval)
 	{
@@ -107,11 +115,27 @@ bool Processing::CheckTimestep()
 int Processing::GetNextInterval() const
 {
 	if (Enabled==false) return -1;
+	return GetNextInterval(m_Eng_Interface->GetNumberOfTimesteps(), m_PS_pos);
+}
+
+int Processing::GetNextEngineInterval() const
+{
+	if (Enabled==false) return -1;
+	unsigned int ts = m_Eng_Interface->GetEngineNumberOfTimesteps();
+	// skip all processing steps up to the current timestep, as CheckTimestep() will do for a due processing
+	size_t ps_pos = m_PS_pos;
+	while ((ps_pos<m_ProcessSteps.size()) && (m_ProcessSteps.at(ps_pos)<=ts))
+		++ps_pos;
+	return GetNextInterval(ts, ps_pos);
+}
+
+int Processing::GetNextInterval(unsigned int timestep, size_t ps_pos) const
+{
 	int next=INT_MAX;
-	int ts = (int)m_Eng_Interface->GetNumberOfTimesteps();
-	if (m_ProcessSteps.size()>m_PS_pos)
+	int ts = (int)timestep;
+	if (m_ProcessSteps.size()>ps_pos)
 	{
-		next = (int)m_ProcessSteps.at(m_PS_pos)-ts;
+		next = (int)m_ProcessSteps.at(ps_pos)-ts;
 	}
 	if (ProcessInterval!=0)
 	{
@@ -131,6 +155,34 @@ int Processing::GetNextInterval() const
 	return next;
 }
 
+bool Processing::EnableSnapshot()
+{
+	if ((Enabled==false) || (AllowParallelProcessing()==false))
+		return false;
+	m_Snapshot = m_Eng_Interface->EnableSnapshot(start, stop);
+	return m_Snapshot;
+}
+
+bool Processing::UpdateSnapshot()
+{
+	if (IsSnapshotDue()==false)
+		return false;
+	m_Eng_Interface->UpdateSnapshot();
+	return true;
+}
+
+bool Processing::IsSnapshotDue() const
+{
+	if ((Enabled==false) || (m_Snapshot==false))
+		return false;
+	return IsProcessingTimestep(m_Eng_Interface->GetEngineNumberOfTimesteps());
+}
+
+void Processing::UpdateSnapshot(unsigned int part, unsigned int numParts)
+{
+	m_Eng_Interface->UpdateSnapshot(part, numParts);
+}
+
 void Processing::AddStep(unsigned int step)
 {
 	if (m_ProcessSteps.size()==0)
@@ -309,6 +361,116 @@ void Processing::DumpBox2File( string vtkfilenameprefix, bool dualMesh ) const
 	file.close();
 }
 
+ProcessingArray::ProcessingArray(unsigned int maximalInterval)
+{
+	maxInterval=maximalInterval;
+	m_NextJob = 0;
+	m_NumCopyJobs = 0;
+	m_NextCopyJob = 0;
+	m_numThreads = 0;
+	m_thread_group = NULL;
+	m_startBarrier = NULL;
+	m_stopBarrier = NULL;
+	m_copyBarrier = NULL;
+	m_stopThreads = true;
+	m_Overlap = false;
+	m_BackgroundRunning = false;
+}
+
+ProcessingArray::~ProcessingArray()
+{
+	StopThreads();
+}
+
+void ProcessingArray::SetNumberOfThreads(unsigned int numThreads)
+{
+	StopThreads();
+	if (numThreads==0)
+		numThreads = boost::thread::hardware_concurrency();
+	// the main thread takes part in the processing as well
+	if (numThreads>0)
+		--numThreads;
+	m_numThreads = numThreads;
+	StartThreads();
+	if (m_thread_group==NULL)
+		m_Overlap = false;
+}
+
+void ProcessingArray::StartThreads()
+{
+	if (m_numThreads==0)
+		return;
+
+	if (g_settings.GetVerboseLevel()>0)
+		cout << "ProcessingArray: using " << m_numThreads+1 << " threads for processing." << endl;
+
+	m_stopThreads = false;
+	m_startBarrier = new boost::barrier(m_numThreads+1); // numThread workers + 1 controller
+	m_stopBarrier = new boost::barrier(m_numThreads+1); // numThread workers + 1 controller
+	m_copyBarrier = new boost::barrier(m_numThreads+1); // numThread workers + 1 controller
+
+	m_thread_group = new boost::thread_group();
+	for (unsigned int n=0; n<m_numThreads; n++)
+		m_thread_group->add_thread( new boost::thread( ProcessingArray_Thread(this) ) );
+}
+
+void ProcessingArray::StopThreads()
+{
+	if (m_thread_group==NULL) // prevent multiple invocations
+		return;
+
+	WaitProcessing();
+
+	// wake up all threads with the stop flag set
+	m_stopThreads = true;
+	m_startBarrier->wait();
+	m_thread_group->join_all();
+
+	delete m_thread_group;
+	m_thread_group = NULL;
+	delete m_startBarrier;
+	m_startBarrier = NULL;
+	delete m_stopBarrier;
+	m_stopBarrier = NULL;
+	delete m_copyBarrier;
+	m_copyBarrier = NULL;
+}
+
+void ProcessingArray::ProcessJobs()
+{
+	while (true)
+	{
+		size_t job;
+		{
+			boost::mutex::scoped_lock lock(m_JobMutex);
+			if (m_NextJob>=m_ParallelJobs.size())
+				return;
+			job = m_NextJob++;
+		}
+		m_ParallelResults.at(job) = m_ParallelJobs.at(job)->Process();
+	}
+}
+
+void ProcessingArray::CopySnapshots()
+{
+	if (m_NumCopyJobs==0)
+		return;
+	unsigned int numParts = m_numThreads+1;
+	while (true)
+	{
+		size_t job;
+		{
+			boost::mutex::scoped_lock lock(m_JobMutex);
+			if (m_NextCopyJob>=m_NumCopyJobs)
+				break;
+			job = m_NextCopyJob++;
+		}
+		m_ParallelJobs.at(job/numParts)->UpdateSnapshot(job%numParts, numParts);
+	}
+	// no processing may start before all parts of its snapshot are copied
+	m_copyBarrier->wait();
+}
+
 void ProcessingArray::AddProcessing(Processing* proc)
 {
 	ProcessArray.push_back(proc);
@@ -316,6 +478,7 @@ void ProcessingArray::AddProcessing(Processing* proc)
 
 void ProcessingArray::InitAll()
 {
+	WaitProcessing();
 	for (size_t i=0; i<ProcessArray.size(); ++i)
 	{
 		ProcessArray.at(i)->InitProcess();
@@ -324,6 +487,7 @@ void ProcessingArray::InitAll()
 
 void ProcessingArray::FlushNext()
 {
+	WaitProcessing();
 	for (size_t i=0; i<ProcessArray.size(); ++i)
 	{
 		ProcessArray.at(i)->FlushNext();
@@ -332,6 +496,7 @@ void ProcessingArray::FlushNext()
 
 void ProcessingArray::Reset()
 {
+	WaitProcessing();
 	for (size_t i=0; i<ProcessArray.size(); ++i)
 	{
 		ProcessArray.at(i)->Reset();
@@ -340,6 +505,7 @@ void ProcessingArray::Reset()
 
 void ProcessingArray::DeleteAll()
 {
+	WaitProcessing();
 	for (size_t i=0; i<ProcessArray.size(); ++i)
 	{
 		delete ProcessArray.at(i);
@@ -349,24 +515,127 @@ void ProcessingArray::DeleteAll()
 
 void ProcessingArray::PreProcess()
 {
+	WaitProcessing();
 	for (size_t i=0; i<ProcessArray.size(); ++i) ProcessArray.at(i)->PreProcess();
 }
 
 int ProcessingArray::Process()
 {
+	if (m_Overlap)
+		return ProcessOverlapped();
+
 	int nextProcess=maxInterval;
-	//this could be done nicely in parallel??
+
+	m_ParallelJobs.clear();
 	for (size_t i=0; i<ProcessArray.size(); ++i)
 	{
-		int step = ProcessArray.at(i)->Process();
+		Processing* proc = ProcessArray.at(i);
+		// keep a possible field snapshot up to date
+		proc->UpdateSnapshot();
+		if ((m_thread_group) && proc->GetEnable() && proc->AllowParallelProcessing())
+		{
+			m_ParallelJobs.push_back(proc);
+			continue;
+		}
+		int step = proc->Process();
+		if ((step>0) && (step<nextProcess))
+			nextProcess=step;
+	}
+
+	if (m_ParallelJobs.size()==0)
+		return nextProcess;
+
+	m_ParallelResults.resize(m_ParallelJobs.size());
+	m_NextJob = 0;
+	m_NumCopyJobs = 0;
+	if (m_ParallelJobs.size()==1)
+		ProcessJobs(); // not worth waking up the workers
+	else
+	{
+		m_startBarrier->wait(); // start the threads
+		ProcessJobs();
+		m_stopBarrier->wait(); // wait for the threads to finish all jobs
+	}
+
+	for (size_t i=0; i<m_ParallelResults.size(); ++i)
+	{
+		int step = m_ParallelResults.at(i);
 		if ((step>0) && (step<nextProcess))
 			nextProcess=step;
 	}
 	return nextProcess;
 }
 
+void ProcessingArray::SetOverlapProcessing(bool val)
+{
+	WaitProcessing();
+	m_Overlap = false;
+	if (val==false)
+		return;
+	if (m_thread_group==NULL)
+	{
+		cerr << "ProcessingArray::SetOverlapProcessing: Warning: No processing threads available, overlapping disabled." << endl;
+		return;
+	}
+
+	unsigned int numSnapshots = 0;
+	for (size_t i=0; i<ProcessArray.size(); ++i)
+		if (ProcessArray.at(i)->EnableSnapshot())
+			++numSnapshots;
+	if (g_settings.GetVerboseLevel()>0)
+		cout << "ProcessingArray: " << numSnapshots << " of " << ProcessArray.size() << " processings overlap with the engine using a field snapshot." << endl;
+	m_Overlap = (numSnapshots>0);
+}
+
+void ProcessingArray::WaitProcessing()
+{
+	if (m_BackgroundRunning==false)
+		return;
+	m_stopBarrier->wait(); // wait for the threads to finish all jobs
+	m_BackgroundRunning = false;
+}
+
+int ProcessingArray::ProcessOverlapped()
+{
+	// the snapshots can only be updated if the previous processing has finished
+	WaitProcessing();
+
+	int nextProcess=maxInterval;
+	m_ParallelJobs.clear();
+	for (size_t i=0; i<ProcessArray.size(); ++i)
+	{
+		Processing* proc = ProcessArray.at(i);
+		int step;
+		if (proc->GetSnapshotEnabled())
+		{
+			// the snapshot is copied by all threads below
+			if (proc->IsSnapshotDue())
+				m_ParallelJobs.push_back(proc);
+			step = proc->GetNextEngineInterval();
+		}
+		else
+			step = proc->Process();
+		if ((step>0) && (step<nextProcess))
+			nextProcess=step;
+	}
+
+	if (m_ParallelJobs.size()==0)
+		return nextProcess;
+
+	// all threads copy the snapshots, afterwards the worker threads process them, while the main thread returns to the engine
+	m_ParallelResults.resize(m_ParallelJobs.size());
+	m_NextJob = 0;
+	m_NumCopyJobs = m_ParallelJobs.size()*(m_numThreads+1);
+	m_NextCopyJob = 0;
+	m_BackgroundRunning = true;
+	m_startBarrier->wait();
+	CopySnapshots();
+	return nextProcess;
+}
+
 void ProcessingArray::PostProcess()
 {
+	WaitProcessing();
 	for (size_t i=0; i<ProcessArray.size(); ++i) ProcessArray.at(i)->PostProcess();
 }
 
@@ -375,3 +644,16 @@ void ProcessingArray::DumpBoxes2File( string vtkfilenameprefix ) const
 	for (size_t i=0; i<ProcessArray.size(); ++i)
 		ProcessArray.at(i)->DumpBox2File( vtkfilenameprefix );
 }
+
+void ProcessingArray_Thread::operator()()
+{
+	while (true)
+	{
+		m_PA->m_startBarrier->wait();
+		if (m_PA->m_stopThreads)
+			return;
+		m_PA->CopySnapshots();
+		m_PA->ProcessJobs();
+		m_PA->m_stopBarrier->wait();
+	}
+}
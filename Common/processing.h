@@ -39,7 +39,10 @@ typedef std::complex<double> double_complex;
 
 #include "Common/engine_interface_base.h"
 
+#include <boost/thread.hpp>
+
 class Operator_Base;
+class ProcessingArray_Thread;
 
 class Processing
 {
@@ -75,6 +78,8 @@ public:
 	void AddFrequency(std::vector<double> *freqs);
 
 	bool CheckTimestep();
+	//! Check if the given timestep is a processing timestep, without changing the processing state. \sa CheckTimestep
+	bool IsProcessingTimestep(unsigned int ts) const;
 
 	//! Process data prior to the simulation run.
 	virtual void PreProcess() {};
@@ -82,6 +87,22 @@ public:
 	//! Process data during simulation run.
 	virtual int Process() {return GetNextInterval();}
 
+	//! Returns true if Process() is only reading from the engine (and writing its own data) and may run concurrently to other processings.
+	virtual bool AllowParallelProcessing() const {return false;}
+
+	//! Use a snapshot of the fields inside the processing box, so Process() may run concurrently to the engine iteration. Returns false if not supported. \sa AllowParallelProcessing
+	virtual bool EnableSnapshot();
+	//! Returns true if this processing is using a field snapshot \sa EnableSnapshot
+	bool GetSnapshotEnabled() const {return m_Snapshot;}
+	//! Update the field snapshot if this processing is due at the current engine timestep. Returns true if Process() has to be invoked for the updated snapshot.
+	bool UpdateSnapshot();
+	//! Returns true if the field snapshot is due for an update at the current engine timestep. \sa UpdateSnapshot
+	bool IsSnapshotDue() const;
+	//! Copy the given part of the field snapshot, all \a numParts parts may be copied concurrently. \sa Engine_Interface_Base::UpdateSnapshot
+	void UpdateSnapshot(unsigned int part, unsigned int numParts);
+	//! Get the next processing interval as seen from the current engine timestep, assuming a due processing at this timestep is done. \sa UpdateSnapshot
+	int GetNextEngineInterval() const;
+
 	//! Process data after simulation has finished.
 	virtual void PostProcess();
 
@@ -127,7 +148,12 @@ protected:
 
 	bool Enabled;
 
+	//! processing uses a field snapshot \sa EnableSnapshot
+	bool m_Snapshot;
+
 	int GetNextInterval() const;
+	//! Get the next processing interval for the given timestep and position in list of processing steps
+	int GetNextInterval(unsigned int ts, size_t ps_pos) const;
 	unsigned int ProcessInterval;
 
 	size_t m_PS_pos; //! current position in list of processing steps
@@ -171,9 +197,13 @@ protected:
 
 class ProcessingArray
 {
+	friend class ProcessingArray_Thread;
 public:
-	ProcessingArray(unsigned int maximalInterval) {maxInterval=maximalInterval;}
-	~ProcessingArray() {};
+	ProcessingArray(unsigned int maximalInterval);
+	~ProcessingArray();
+
+	//! Set the number of threads used to run independent processings concurrently (0 = all cores, 1 = serial processing)
+	void SetNumberOfThreads(unsigned int numThreads);
 
 	void AddProcessing(Processing* proc);
 
@@ -193,6 +223,11 @@ public:
 	//! Invoke Process() on all Processings. Will return the smallest next iteration interval.
 	int Process();
 
+	//! Overlap the processing with the engine iteration. All processings supporting a field snapshot will be processed in the background, while the engine continues with the next timesteps. \sa Processing::EnableSnapshot
+	void SetOverlapProcessing(bool val);
+	//! Wait until all background processings are finished.
+	void WaitProcessing();
+
 	//! Invoke PostProcess() on all Processings.
 	void PostProcess();
 
@@ -205,6 +240,46 @@ public:
 protected:
 	unsigned int maxInterval;
 	std::vector<Processing*> ProcessArray;
+
+	//! processings to be executed by the worker threads, a subset of ProcessArray \sa Processing::AllowParallelProcessing
+	std::vector<Processing*> m_ParallelJobs;
+	std::vector<int> m_ParallelResults;
+	size_t m_NextJob;
+	boost::mutex m_JobMutex;
+
+	//! Execute parallel processing jobs until none is left, used by the worker threads and the main thread.
+	void ProcessJobs();
+
+	//! number of copy jobs, each due snapshot of m_ParallelJobs is copied in m_numThreads+1 parts
+	size_t m_NumCopyJobs;
+	size_t m_NextCopyJob;
+	//! Copy the due field snapshots, used by the worker threads and the main thread. All threads wait until all snapshots are copied.
+	void CopySnapshots();
+
+	unsigned int m_numThreads; //!< number of worker threads (main thread not included)
+	boost::thread_group* m_thread_group;
+	boost::barrier *m_startBarrier, *m_stopBarrier, *m_copyBarrier;
+	volatile bool m_stopThreads;
+
+	bool m_Overlap;
+	//! the worker threads are busy processing the field snapshots
+	bool m_BackgroundRunning;
+
+	//! Update the field snapshots and start processing them in the background.
+	int ProcessOverlapped();
+
+	void StartThreads();
+	void StopThreads();
+};
+
+class ProcessingArray_Thread
+{
+public:
+	ProcessingArray_Thread(ProcessingArray* ptr) {m_PA=ptr;}
+	void operator()();
+
+protected:
+	ProcessingArray* m_PA;
 };
 
 #endif // PROCESSING_H
@@ -57,6 +57,9 @@ public:
 	//! This method will write the TD and FD dump files using CalcIntegral() to calculate the integral parameter
 	virtual int Process();
 
+	//! Integral processings only read the engine fields and write their own files.
+	virtual bool AllowParallelProcessing() const {return true;}
+
 protected:
 	ProcessIntegral(Engine_Interface_Base* eng_if);
 
@@ -29,6 +29,7 @@ ProcessModeMatch::ProcessModeMatch(Engine_Interface_Base* eng_if) : ProcessInteg
 		m_ModeParser[n] = new CSFunctionParser();
 		m_ModeDist[n] = NULL;
 	}
+	m_Compiled = false;
 	delete[] m_Results;
 	m_Results = new double[2];
 }
@@ -195,12 +196,72 @@ void ProcessModeMatch::InitProcess()
 //			cerr << posP << " " << posPP << " : " << m_ModeDist[0][posP][posPP] << " , " << m_ModeDist[1][posP][posPP] << endl;
 		}
 
+	m_Compiled = CompileModeMatch();
+
 	ProcessIntegral::InitProcess();
 }
 
+bool ProcessModeMatch::CompileModeMatch()
+{
+	m_Gather_Values.clear();
+	m_Gather_Weights.clear();
+	m_Gather_Offset.clear();
+	m_Sample_Mode.clear();
+	m_Sample_Area.clear();
+
+	bool dualMesh = m_ModeFieldType==1;
+	int nP = (m_ny+1)%3;
+	int nPP = (m_ny+2)%3;
+	unsigned int pos[3] = {0,0,0};
+	pos[m_ny] = start[m_ny];
+	double area = 0;
+
+	for (unsigned int posP = 0; posP<m_numLines[0]; ++posP)
+	{
+		pos[nP] = start[nP] + posP;
+		for (unsigned int posPP = 0; posPP<m_numLines[1]; ++posPP)
+		{
+			pos[nPP] = start[nPP] + posPP;
+			area = Op->GetNodeArea(m_ny,pos,dualMesh);
+			for (int n=0; n<2; ++n)
+			{
+				m_Gather_Offset.push_back(m_Gather_Values.size());
+				if (m_Eng_Interface->CompileFieldGather(dualMesh, pos, (m_ny+n+1)%3, m_Gather_Values, m_Gather_Weights)==false)
+				{
+					m_Gather_Values.clear();
+					m_Gather_Weights.clear();
+					m_Gather_Offset.clear();
+					m_Sample_Mode.clear();
+					m_Sample_Area.clear();
+					return false;
+				}
+				m_Sample_Mode.push_back(m_ModeDist[n][posP][posPP] * area);
+				m_Sample_Area.push_back(area);
+			}
+		}
+	}
+	m_Gather_Offset.push_back(m_Gather_Values.size());
+	return true;
+}
+
+bool ProcessModeMatch::EnableSnapshot()
+{
+	bool snapshot = ProcessIntegral::EnableSnapshot();
+	// the compiled values have to point into the snapshot
+	if (snapshot && m_Compiled)
+		m_Compiled = CompileModeMatch();
+	return snapshot;
+}
+
 void ProcessModeMatch::Reset()
 {
 	ProcessIntegral::Reset();
+	m_Compiled = false;
+	m_Gather_Values.clear();
+	m_Gather_Weights.clear();
+	m_Gather_Offset.clear();
+	m_Sample_Mode.clear();
+	m_Sample_Area.clear();
 	for (int n=0; n<2; ++n)
 	{
 		Delete2DArray<double>(m_ModeDist[n],m_numLines);
@@ -224,6 +285,9 @@ void ProcessModeMatch::SetFieldType(int type)
 
 double* ProcessModeMatch::CalcMultipleIntegrals()
 {
+	if (m_Compiled)
+		return CalcCompiledIntegrals();
+
 	double value = 0;
 	double field = 0;
 	double purity = 0;
@@ -265,3 +329,33 @@ double* ProcessModeMatch::CalcMultipleIntegrals()
 	m_Results[0] = value;
 	return m_Results;
 }
+
+double* ProcessModeMatch::CalcCompiledIntegrals()
+{
+	double value = 0;
+	double purity = 0;
+	double field = 0;
+
+	const FDTD_FLOAT* const* values = m_Gather_Values.data();
+	const double* weights = m_Gather_Weights.data();
+	const unsigned int* offset = m_Gather_Offset.data();
+	const double* mode = m_Sample_Mode.data();
+	const double* area = m_Sample_Area.data();
+	size_t numSamples = m_Sample_Area.size();
+
+	for (size_t s=0; s<numSamples; ++s)
+	{
+		field = 0;
+		for (unsigned int i=offset[s]; i<offset[s+1]; ++i)
+			field += weights[i] * (*values[i]);
+		value += field * mode[s];
+		purity += field*field * area[s];
+	}
+
+	if (purity!=0)
+		m_Results[1] = value*value/purity;
+	else
+		m_Results[1] = 0;
+	m_Results[0] = value;
+	return m_Results;
+}
@@ -48,6 +48,8 @@ public:
 	virtual int GetNumberOfIntegrals() const {return 2;}
 	virtual double* CalcMultipleIntegrals();
 
+	virtual bool EnableSnapshot();
+
 protected:
 	//normal direction of the mode plane
 	int m_ny;
@@ -63,6 +65,24 @@ protected:
 
 	unsigned int m_numLines[2];
 	double** m_ModeDist[2];
+
+	//! Compile the mode matching into a list of raw engine values and weights. \sa Engine_Interface_Base::CompileFieldGather
+	bool CompileModeMatch();
+	//! Calculate the mode matching using the compiled gather list.
+	double* CalcCompiledIntegrals();
+
+	//! the compiled gather list is used for the mode matching
+	bool m_Compiled;
+	//! raw engine values for all field samples (one sample per mode plane node and direction)
+	std::vector<const FDTD_FLOAT*> m_Gather_Values;
+	//! weights for all raw engine values, including the interpolation coefficients and edge lengths
+	std::vector<double> m_Gather_Weights;
+	//! first entry of each field sample in the gather list, the last entry marks the end of the list
+	std::vector<unsigned int> m_Gather_Offset;
+	//! mode template times node area for each field sample
+	std::vector<double> m_Sample_Mode;
+	//! node area for each field sample
+	std::vector<double> m_Sample_Area;
 };
 
 #endif // PROCESSMODEMATCH_H
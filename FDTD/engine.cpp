@@ -161,6 +161,19 @@ void Engine::UpdateVoltages(unsigned int startX, unsigned int numX)
 }
 
 void Engine::UpdateCurrents(unsigned int startX, unsigned int numX)
+{
+	UpdateCurrents_Kernel<false>(startX, numX, NULL, NULL);
+}
+
+void Engine::UpdateCurrentsCalcEnergy(unsigned int startX, unsigned int numX, double &E_energy, double &H_energy)
+{
+	E_energy = 0;
+	H_energy = 0;
+	UpdateCurrents_Kernel<true>(startX, numX, &E_energy, &H_energy);
+}
+
+template <bool calcEnergy>
+void Engine::UpdateCurrents_Kernel(unsigned int startX, unsigned int numX, double* E_energy, double* H_energy)
 {
 	unsigned int pos[3];
 	pos[0] = startX;
@@ -203,6 +216,15 @@ void Engine::UpdateCurrents(unsigned int startX, unsigned int numX)
 				        volt[0][pos[0]  ][pos[1]  ][pos[2]] +
 				        volt[0][pos[0]  ][pos[1]+1][pos[2]]
 				    );
+
+				if (calcEnergy)
+				{
+					for (int n=0; n<3; ++n)
+					{
+						*E_energy += volt[n][pos[0]][pos[1]][pos[2]] * volt[n][pos[0]][pos[1]][pos[2]];
+						*H_energy += curr[n][pos[0]][pos[1]][pos[2]] * curr[n][pos[0]][pos[1]][pos[2]];
+					}
+				}
 			}
 		}
 		++pos[0];
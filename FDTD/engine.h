@@ -55,6 +55,11 @@ public:
 	inline virtual FDTD_FLOAT GetCurr( unsigned int n, unsigned int x, unsigned int y, unsigned int z )		const { return curr[n][x][y][z]; }
 	inline virtual FDTD_FLOAT GetCurr( unsigned int n, const unsigned int pos[3] )							const { return curr[n][pos[0]][pos[1]][pos[2]]; }
 
+	//! Get a pointer to the storage of a voltage, the pointer is valid until the engine is reset. Returns NULL if the value is always zero.
+	inline virtual const FDTD_FLOAT* GetVoltPtr( unsigned int n, const unsigned int pos[3] )					const { return &volt[n][pos[0]][pos[1]][pos[2]]; }
+	//! Get a pointer to the storage of a current, the pointer is valid until the engine is reset. Returns NULL if the value is always zero.
+	inline virtual const FDTD_FLOAT* GetCurrPtr( unsigned int n, const unsigned int pos[3] )					const { return &curr[n][pos[0]][pos[1]][pos[2]]; }
+
 	inline virtual void SetVolt( unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value)	{ volt[n][x][y][z]=value; }
 	inline virtual void SetVolt( unsigned int n, const unsigned int pos[3], FDTD_FLOAT value )						{ volt[n][pos[0]][pos[1]][pos[2]]=value; }
 	inline virtual void SetCurr( unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value)	{ curr[n][x][y][z]=value; }
@@ -73,6 +78,11 @@ public:
 	virtual void DoPreCurrentUpdates();
 	//! Main FDTD engine current updates
 	virtual void UpdateCurrents(unsigned int startX, unsigned int numX);
+	//! Main FDTD engine current updates, additionally sum up the squared voltages and currents of the updated lines
+	virtual void UpdateCurrentsCalcEnergy(unsigned int startX, unsigned int numX, double &E_energy, double &H_energy);
+	//! Current update kernel, optionally summing up the squared voltages and currents of the updated cells
+	template <bool calcEnergy>
+	void UpdateCurrents_Kernel(unsigned int startX, unsigned int numX, double* E_energy, double* H_energy);
 	//! Execute Post-Current extension updates
 	virtual void DoPostCurrentUpdates();
 	//! Apply extension current changes
@@ -84,6 +94,9 @@ public:
 
 	EngineType GetType() const {return m_type;}
 
+	//! Get the (rough) total energy estimate for the current timestep, if it was calculated during the iteration. Returns false if not available. \sa Engine_Interface_Base::CalcFastEnergy
+	virtual bool GetFastEnergy(double &energy) const {UNUSED(energy); return false;}
+
 protected:
 	EngineType m_type;
 
@@ -32,21 +32,23 @@ Engine_CylinderMultiGrid::Engine_CylinderMultiGrid(const Operator_CylinderMultiG
 {
 	Op_CMG = op;
 
-	m_WaitOnBase = new boost::barrier(2);
-	m_WaitOnChild = new boost::barrier(2);
-	m_WaitOnSync = new boost::barrier(2);
+	m_SyncBarrier = NULL;
+	m_TurnBarrier = NULL;
+	m_SyncThreads = 0;
+	m_LastTS = 0;
 
 	m_Eng_Ext_MG = new Engine_Ext_CylinderMultiGrid(NULL,true);
-	m_Eng_Ext_MG->SetBarrier(m_WaitOnBase, m_WaitOnChild, m_WaitOnSync);
 	m_Eng_Ext_MG->SetEngine(this);
 
 	Engine* eng = op->GetInnerOperator()->CreateEngine();
 	m_InnerEngine = dynamic_cast<Engine_Multithread*>(eng);
 
+	// the child extension syncs with this (base) engine
 	Engine_Ext_CylinderMultiGrid* m_InnerEng_Ext_MG = new Engine_Ext_CylinderMultiGrid(NULL,false);
-	m_InnerEng_Ext_MG->SetBarrier(m_WaitOnBase, m_WaitOnChild, m_WaitOnSync);
+	m_InnerEng_Ext_MG->SetEngine(this);
 
 	// if already has a base extension, switch places ... seems to be faster...
+	// after sorting by priority the base extension of the inner engine is executed first, its child grid is synced before this base grid reads from it
 	for (size_t n=0; n<m_InnerEngine->m_Eng_exts.size(); ++n)
 	{
 		Engine_Ext_CylinderMultiGrid* eng_mg = dynamic_cast<Engine_Ext_CylinderMultiGrid*>(m_InnerEngine->m_Eng_exts.at(n));
@@ -75,12 +77,10 @@ Engine_CylinderMultiGrid::~Engine_CylinderMultiGrid()
 	delete m_InnerEngine;
 	m_InnerEngine = NULL;
 
-	delete m_WaitOnBase;
-	m_WaitOnBase = NULL;
-	delete m_WaitOnChild;
-	m_WaitOnChild = NULL;
-	delete m_WaitOnSync;
-	m_WaitOnSync = NULL;
+	delete m_SyncBarrier;
+	m_SyncBarrier = NULL;
+	delete m_TurnBarrier;
+	m_TurnBarrier = NULL;
 
 	delete m_startBarrier;
 	m_startBarrier = NULL;
@@ -108,35 +108,48 @@ void Engine_CylinderMultiGrid::Init()
 	m_InnerEngine->SortExtensionByPriority();
 	SortExtensionByPriority();
 
+	InitSyncBarrier();
+
 #ifdef MPI_SUPPORT
 	//assign an MPI barrier to inner Engine
 	m_InnerEngine->m_MPI_Barrier  = new boost::barrier(2);
 #endif
 }
 
+void Engine_CylinderMultiGrid::InitSyncBarrier()
+{
+	unsigned int numThreads = m_numThreads + m_InnerEngine->m_numThreads;
+	if ((m_SyncBarrier!=NULL) && (m_SyncThreads==numThreads))
+		return;
+	delete m_SyncBarrier;
+	delete m_TurnBarrier;
+	m_SyncThreads = numThreads;
+	m_SyncBarrier = new boost::barrier(m_SyncThreads);
+	m_TurnBarrier = new boost::barrier(m_SyncThreads);
+}
+
 bool Engine_CylinderMultiGrid::IterateTS(unsigned int iterTS)
 {
+	// the number of threads may have changed since the last iteration
+	InitSyncBarrier();
+
 	m_Thread_NumTS = iterTS;
+	// the child data is interpolated to the base mesh by all threads during the last timestep
+	m_LastTS = numTS + iterTS - 1;
 
 	m_startBarrier->wait(); //start base and child iterations
 
 	m_stopBarrier->wait();  //tell base and child to wait for another start event...
 
-	//interpolate child data to base mesh...
-	for (unsigned int n=0; n<Op_CMG->m_Split_Pos-1; ++n)
-		InterpolVoltChild2Base(n);
-	for (unsigned int n=0; n<Op_CMG->m_Split_Pos-2; ++n)
-		InterpolCurrChild2Base(n);
-
 	return true;
 }
 
-void Engine_CylinderMultiGrid::InterpolVoltChild2Base(unsigned int rPos)
+void Engine_CylinderMultiGrid::InterpolVoltChild2Base(unsigned int rPos, unsigned int startA, unsigned int numA)
 {
 	//interpolate voltages from child engine to the base engine...
 	unsigned int pos[3];
 	pos[0] = rPos;
-	for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
+	for (pos[1]=startA; pos[1]<startA+numA; ++pos[1])
 	{
 		for (pos[2]=0; pos[2]<numVectors; ++pos[2])
 		{
@@ -155,12 +168,12 @@ void Engine_CylinderMultiGrid::InterpolVoltChild2Base(unsigned int rPos)
 	}
 }
 
-void Engine_CylinderMultiGrid::InterpolCurrChild2Base(unsigned int rPos)
+void Engine_CylinderMultiGrid::InterpolCurrChild2Base(unsigned int rPos, unsigned int startA, unsigned int numA)
 {
-	//interpolate voltages from child engine to the base engine...
+	//interpolate currents from child engine to the base engine...
 	unsigned int pos[3];
 	pos[0] = rPos;
-	for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
+	for (pos[1]=startA; pos[1]<startA+numA; ++pos[1])
 	{
 		for (pos[2]=0; pos[2]<numVectors; ++pos[2])
 		{
@@ -33,14 +33,22 @@ public:
 	static Engine_CylinderMultiGrid* New(const Operator_CylinderMultiGrid* op, unsigned int numThreads = 0);
 	virtual ~Engine_CylinderMultiGrid();
 
-	virtual void InterpolVoltChild2Base(unsigned int rPos);
-	virtual void InterpolCurrChild2Base(unsigned int rPos);
+	virtual void InterpolVoltChild2Base(unsigned int rPos) {InterpolVoltChild2Base(rPos,0,numLines[1]);}
+	virtual void InterpolCurrChild2Base(unsigned int rPos) {InterpolCurrChild2Base(rPos,0,numLines[1]);}
+
+	//! Interpolate the child voltages of the given r-line and the alpha-lines [\a startA, \a startA+\a numA) to the base engine
+	virtual void InterpolVoltChild2Base(unsigned int rPos, unsigned int startA, unsigned int numA);
+	//! Interpolate the child currents of the given r-line and the alpha-lines [\a startA, \a startA+\a numA) to the base engine
+	virtual void InterpolCurrChild2Base(unsigned int rPos, unsigned int startA, unsigned int numA);
 
 	virtual void Init();
 
 	//! Iterate \a iterTS number of timesteps
 	virtual bool IterateTS(unsigned int iterTS);
 
+	//! The energy estimate of the base engine would not include the interpolated child fields
+	virtual bool GetFastEnergy(double &energy) const {UNUSED(energy); return false;}
+
 protected:
 	Engine_CylinderMultiGrid(const Operator_CylinderMultiGrid* op);
 	const Operator_CylinderMultiGrid* Op_CMG;
@@ -54,10 +62,23 @@ protected:
 	Engine_CylinderMultiGrid_Thread* m_IteratorThread;
 	Engine_CylinderMultiGrid_Thread* m_InnerIteratorThread;
 
-	//extension barrier
-	boost::barrier *m_WaitOnBase;
-	boost::barrier *m_WaitOnChild;
-	boost::barrier *m_WaitOnSync;
+	//! (Re-)create the sync barrier if the number of threads of the base or child engine has changed
+	void InitSyncBarrier();
+
+	//! Get the index of a base (\a isBase) or child engine thread among all threads taking part in the sync
+	unsigned int GetSyncThreadID(bool isBase, int threadID) const {return isBase ? threadID : m_numThreads+threadID;}
+
+	//! Is the current timestep the last one of this iteration?
+	bool IsLastTimestep() const {return numTS==m_LastTS;}
+
+	//! barrier of all base and child engine threads, the base and child grid are updated concurrently and synced in between
+	boost::barrier *m_SyncBarrier;
+	//! barrier of all base and child engine threads, the child grid starts its updates after the base grid (only for alternating levels)
+	boost::barrier *m_TurnBarrier;
+	//! number of threads of the sync barrier
+	unsigned int m_SyncThreads;
+	//! the last timestep of the current iteration, the complete child grid is interpolated to the base grid after it
+	unsigned int m_LastTS;
 
 	Engine_Ext_CylinderMultiGrid* m_Eng_Ext_MG;
 
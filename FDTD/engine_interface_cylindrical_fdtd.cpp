@@ -47,6 +47,34 @@ double* Engine_Interface_Cylindrical_FDTD::GetHField(const unsigned int* pos, do
 	return Engine_Interface_FDTD::GetHField(iPos, out);
 }
 
+bool Engine_Interface_Cylindrical_FDTD::CompileFieldGather(bool dualField, const unsigned int* pos, int n, vector<const FDTD_FLOAT*> &values, vector<double> &weights) const
+{
+	if (m_Op_Cyl->GetClosedAlpha()==false)
+		return Engine_Interface_SSE_FDTD::CompileFieldGather(dualField, pos, n, values, weights);
+
+	// same index wrapping for the electric and magnetic field, see GetRawInterpolatedField and GetHField
+	unsigned int iPos[] = {pos[0],pos[1],pos[2]};
+
+	if ((m_InterpolType==NODE_INTERPOLATE) && (pos[1]==0))
+		iPos[1]=m_Op->GetNumberOfLines(1);
+
+	if ((m_InterpolType==CELL_INTERPOLATE) && (pos[1]==m_Op->GetNumberOfLines(1)))
+		iPos[1]=0;
+
+	return Engine_Interface_SSE_FDTD::CompileFieldGather(dualField, iPos, n, values, weights);
+}
+
+bool Engine_Interface_Cylindrical_FDTD::EnableSnapshot(const unsigned int* start, const unsigned int* stop)
+{
+	if (m_Op_Cyl->GetClosedAlpha()==false)
+		return Engine_Interface_SSE_FDTD::EnableSnapshot(start, stop);
+
+	// the interpolation may wrap around in alpha direction, use the full alpha range
+	unsigned int sn_start[] = {start[0],0,start[2]};
+	unsigned int sn_stop[] = {stop[0],m_Op->GetNumberOfLines(1,true),stop[2]};
+	return Engine_Interface_SSE_FDTD::EnableSnapshot(sn_start, sn_stop);
+}
+
 double* Engine_Interface_Cylindrical_FDTD::GetRawInterpolatedField(const unsigned int* pos, double* out, int type) const
 {
 	if (m_Op_Cyl->GetClosedAlpha()==false)
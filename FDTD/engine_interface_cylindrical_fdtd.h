@@ -29,6 +29,10 @@ public:
 
 	virtual double* GetHField(const unsigned int* pos, double* out) const;
 
+	virtual bool CompileFieldGather(bool dualField, const unsigned int* pos, int n, std::vector<const FDTD_FLOAT*> &values, std::vector<double> &weights) const;
+
+	virtual bool EnableSnapshot(const unsigned int* start, const unsigned int* stop);
+
 protected:
 	Operator_Cylinder* m_Op_Cyl;
 
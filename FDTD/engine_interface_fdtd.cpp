@@ -31,10 +31,48 @@ Engine_Interface_FDTD::Engine_Interface_FDTD(Operator* op) : Engine_Interface_Ba
 		cerr << "Engine_Interface_FDTD::Engine_Interface_FDTD: Error: Engine is not set! Exit!" << endl;
 		exit(1);
 	}
+	m_Eng_Source = m_Eng;
+	m_Snapshot = NULL;
 }
 
 Engine_Interface_FDTD::~Engine_Interface_FDTD()
 {
+	delete m_Snapshot;
+	m_Snapshot = NULL;
+}
+
+void Engine_Interface_FDTD::SetFDTDEngine(Engine* eng)
+{
+	delete m_Snapshot;
+	m_Snapshot = NULL;
+	m_Eng = eng;
+	m_Eng_Source = eng;
+}
+
+bool Engine_Interface_FDTD::EnableSnapshot(const unsigned int* start, const unsigned int* stop)
+{
+	// add a one cell margin needed by the field interpolation
+	unsigned int sn_start[3];
+	unsigned int sn_stop[3];
+	for (int n=0; n<3; ++n)
+	{
+		sn_start[n] = min(start[n],stop[n]);
+		if (sn_start[n]>0)
+			--sn_start[n];
+		sn_stop[n] = max(start[n],stop[n])+1;
+	}
+
+	delete m_Snapshot;
+	m_Snapshot = new Engine_Snapshot(m_Op, m_Eng_Source, sn_start, sn_stop);
+	m_Snapshot->Update(m_Eng_Source);
+	m_Eng = m_Snapshot;
+	return true;
+}
+
+void Engine_Interface_FDTD::UpdateSnapshot(unsigned int part, unsigned int numParts)
+{
+	if (m_Snapshot)
+		m_Snapshot->Update(m_Eng_Source, part, numParts);
 }
 
 double* Engine_Interface_FDTD::GetEField(const unsigned int* pos, double* out) const
@@ -136,8 +174,8 @@ double Engine_Interface_FDTD::GetRawDualField(unsigned int n, const unsigned int
 	double delta = m_Op->GetEdgeLength(n,pos,true);
 	if ((type==0) && (delta))
 		return value/delta;
-	if ((type==1) && (m_Op->m_mueR) && (delta))
-		return value*m_Op->m_mueR[n][pos[0]][pos[1]][pos[2]]/delta;
+	if ((type==1) && (delta))
+		return value*m_Op->GetDiscMaterial(2,n,pos)/delta;
 	return 0.0;
 }
 
@@ -197,6 +235,113 @@ double* Engine_Interface_FDTD::GetRawInterpolatedDualField(const unsigned int* p
 	return out;
 }
 
+bool Engine_Interface_FDTD::CompileFieldGather(bool dualField, const unsigned int* pos, int n, vector<const FDTD_FLOAT*> &values, vector<double> &weights) const
+{
+	// this has to follow the interpolation of GetRawInterpolatedField and GetRawInterpolatedDualField exactly
+	if ((n<0) || (n>2))
+		return false;
+	unsigned int iPos[] = {pos[0],pos[1],pos[2]};
+	int nP = (n+1)%3;
+	int nPP = (n+2)%3;
+	double delta;
+	double deltaRel;
+	if (dualField==false)
+	{
+		switch (m_InterpolType)
+		{
+		default:
+		case NO_INTERPOLATION:
+			AddRawFieldGather(n,pos,1.0,values,weights);
+			break;
+		case NODE_INTERPOLATE:
+			if (pos[n]==m_Op->GetNumberOfLines(n, true)-1)  // use only the "lower value" at the upper bound
+			{
+				--iPos[n];
+				AddRawFieldGather(n,iPos,1.0,values,weights);
+				break;
+			}
+			delta = m_Op->GetEdgeLength(n,iPos);
+			if (delta==0)
+				break;
+			if (pos[n]==0) // use only the "upper value" at the lower bound
+			{
+				AddRawFieldGather(n,iPos,1.0,values,weights);
+				break;
+			}
+			--iPos[n];
+			deltaRel = delta / (delta+m_Op->GetEdgeLength(n,iPos));
+			AddRawFieldGather(n,pos,1.0-deltaRel,values,weights);
+			AddRawFieldGather(n,iPos,deltaRel,values,weights);
+			break;
+		case CELL_INTERPOLATE:
+			if ((pos[0]==m_Op->GetNumberOfLines(0,true)-1) || (pos[1]==m_Op->GetNumberOfLines(1,true)-1) || (pos[2]==m_Op->GetNumberOfLines(2,true)-1))
+				break; //electric field outside the field domain is always zero
+			AddRawFieldGather(n,iPos,0.25,values,weights);
+			++iPos[nP];
+			AddRawFieldGather(n,iPos,0.25,values,weights);
+			++iPos[nPP];
+			AddRawFieldGather(n,iPos,0.25,values,weights);
+			--iPos[nP];
+			AddRawFieldGather(n,iPos,0.25,values,weights);
+			break;
+		}
+		return true;
+	}
+
+	switch (m_InterpolType)
+	{
+	default:
+	case NO_INTERPOLATION:
+		AddRawDualFieldGather(n,pos,1.0,values,weights);
+		break;
+	case NODE_INTERPOLATE:
+		if ((pos[0]==m_Op->GetNumberOfLines(0,true)-1) || (pos[1]==m_Op->GetNumberOfLines(1,true)-1) || (pos[2]==m_Op->GetNumberOfLines(2,true)-1) || (pos[nP]==0) || (pos[nPP]==0))
+			break;
+		AddRawDualFieldGather(n,iPos,0.25,values,weights);
+		--iPos[nP];
+		AddRawDualFieldGather(n,iPos,0.25,values,weights);
+		--iPos[nPP];
+		AddRawDualFieldGather(n,iPos,0.25,values,weights);
+		++iPos[nP];
+		AddRawDualFieldGather(n,iPos,0.25,values,weights);
+		break;
+	case CELL_INTERPOLATE:
+		if ((pos[n]>=m_Op->GetNumberOfLines(n,true)-1))
+			break; //magnetic field on the outer boundaries is always zero
+		delta = m_Op->GetEdgeLength(n,iPos,true);
+		++iPos[n];
+		deltaRel = delta / (delta+m_Op->GetEdgeLength(n,iPos,true));
+		AddRawDualFieldGather(n,pos,1.0-deltaRel,values,weights);
+		AddRawDualFieldGather(n,iPos,deltaRel,values,weights);
+		break;
+	}
+	return true;
+}
+
+void Engine_Interface_FDTD::AddRawFieldGather(unsigned int n, const unsigned int* pos, double weight, vector<const FDTD_FLOAT*> &values, vector<double> &weights) const
+{
+	double delta = m_Op->GetEdgeLength(n,pos);
+	if ((delta==0) || (weight==0))
+		return;
+	const FDTD_FLOAT* ptr = m_Eng->GetVoltPtr(n,pos);
+	if (ptr==NULL)
+		return;
+	values.push_back(ptr);
+	weights.push_back(weight/delta);
+}
+
+void Engine_Interface_FDTD::AddRawDualFieldGather(unsigned int n, const unsigned int* pos, double weight, vector<const FDTD_FLOAT*> &values, vector<double> &weights) const
+{
+	double delta = m_Op->GetEdgeLength(n,pos,true);
+	if ((delta==0) || (weight==0))
+		return;
+	const FDTD_FLOAT* ptr = m_Eng->GetCurrPtr(n,pos);
+	if (ptr==NULL)
+		return;
+	values.push_back(ptr);
+	weights.push_back(weight/delta);
+}
+
 double Engine_Interface_FDTD::CalcVoltageIntegral(const unsigned int* start, const unsigned int* stop) const
 {
 	if (((start[0]!=stop[0]) + (start[1]!=stop[1]) + (start[2]!=stop[2]))!=1)
@@ -260,10 +405,10 @@ double Engine_Interface_FDTD::GetRawField(unsigned int n, const unsigned int* po
 	double delta = m_Op->GetEdgeLength(n,pos);
 	if ((type==0) && (delta))
 		return value/delta;
-	if ((type==1) && (m_Op->m_kappa) && (delta))
-		return value*m_Op->m_kappa[n][pos[0]][pos[1]][pos[2]]/delta;
-	if ((type==3) && (m_Op->m_epsR) && (delta))
-		return value*m_Op->m_epsR[n][pos[0]][pos[1]][pos[2]]/delta;
+	if ((type==1) && (delta))
+		return value*m_Op->GetDiscMaterial(1,n,pos)/delta;
+	if ((type==3) && (delta))
+		return value*m_Op->GetDiscMaterial(0,n,pos)/delta;
 	if (type==2) //calc rot(H)
 	{
 		int nP = (n+1)%3;
@@ -291,6 +436,11 @@ double Engine_Interface_FDTD::GetRawField(unsigned int n, const unsigned int* po
 
 double Engine_Interface_FDTD::CalcFastEnergy() const
 {
+	// use the estimate calculated during the last iteration, if available
+	double energy;
+	if (m_Eng->GetFastEnergy(energy))
+		return energy;
+
 	double E_energy=0.0;
 	double H_energy=0.0;
 
@@ -23,6 +23,7 @@
 #include "Common/engine_interface_base.h"
 #include "operator.h"
 #include "engine.h"
+#include "engine_snapshot.h"
 
 class Engine_Interface_FDTD : public Engine_Interface_Base
 {
@@ -33,7 +34,7 @@ public:
 	//! Set the FDTD operator
 	virtual void SetFDTDOperator(Operator* op) {SetOperator(op); m_Op=op;}
 	//! Set the FDTD engine
-	virtual void SetFDTDEngine(Engine* eng) {m_Eng=eng;}
+	virtual void SetFDTDEngine(Engine* eng);
 
 	//! Get the FDTD engine in case direct access is needed. Direct access is not recommended!
 	const Engine* GetFDTDEngine() const {return m_Eng;}
@@ -47,22 +48,37 @@ public:
 	virtual double* GetDField(const unsigned int* pos, double* out) const;
 	virtual double* GetBField(const unsigned int* pos, double* out) const;
 
+	virtual bool CompileFieldGather(bool dualField, const unsigned int* pos, int n, std::vector<const FDTD_FLOAT*> &values, std::vector<double> &weights) const;
+
 	virtual double CalcVoltageIntegral(const unsigned int* start, const unsigned int* stop) const;
 
 	virtual double GetTime(bool dualTime=false) const {return ((double)m_Eng->GetNumberOfTimesteps() + (double)dualTime*0.5)*m_Op->GetTimestep();};
 	virtual unsigned int GetNumberOfTimesteps() const {return m_Eng->GetNumberOfTimesteps();}
 
+	virtual bool EnableSnapshot(const unsigned int* start, const unsigned int* stop);
+	virtual void UpdateSnapshot(unsigned int part=0, unsigned int numParts=1);
+	virtual unsigned int GetEngineNumberOfTimesteps() const {return m_Eng_Source->GetNumberOfTimesteps();}
+
 	virtual double CalcFastEnergy() const;
 
 protected:
 	Operator* m_Op;
+	//! engine used for all field access, either the running engine or its snapshot
 	Engine* m_Eng;
+	//! the running engine
+	Engine* m_Eng_Source;
+	Engine_Snapshot* m_Snapshot;
 
 	//! Internal method to get an interpolated field of a given type. (0: E, 1: J, 2: rotH, 3: D)
 	virtual double* GetRawInterpolatedField(const unsigned int* pos, double* out, int type) const;
 	//! Internal method to get a raw field of a given type. (0: E, 1: J, 2: rotH, 3: D)
 	virtual double GetRawField(unsigned int n, const unsigned int* pos, int type) const;
 
+	//! Internal method to add a raw electric field component to a compiled field gather. \sa CompileFieldGather
+	void AddRawFieldGather(unsigned int n, const unsigned int* pos, double weight, std::vector<const FDTD_FLOAT*> &values, std::vector<double> &weights) const;
+	//! Internal method to add a raw magnetic field component to a compiled field gather. \sa CompileFieldGather
+	void AddRawDualFieldGather(unsigned int n, const unsigned int* pos, double weight, std::vector<const FDTD_FLOAT*> &values, std::vector<double> &weights) const;
+
 	//! Internal method to get an interpolated dual field of a given type. (0: H, 1: B)
 	virtual double* GetRawInterpolatedDualField(const unsigned int* pos, double* out, int type) const;
 	//! Internal method to get a raw dual field of a given type. (0: H, 1: B)
@@ -36,6 +36,11 @@ Engine_Interface_SSE_FDTD::~Engine_Interface_SSE_FDTD()
 
 double Engine_Interface_SSE_FDTD::CalcFastEnergy() const
 {
+	// use the estimate calculated during the last iteration, if available
+	double energy;
+	if (m_Eng_SSE->GetFastEnergy(energy))
+		return energy;
+
 	f4vector E_energy;
 	E_energy.f[0]=0;
 	E_energy.f[1]=0;
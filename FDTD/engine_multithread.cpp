@@ -61,6 +61,9 @@ Engine_Multithread::Engine_Multithread(const Operator_Multithread* op) : ENGINE_
 	m_last_speed = 0;
 	m_opt_speed = false;
 	m_stopThreads = true;
+	m_FastEnergy = 0;
+	m_FastEnergy_TS = 0;
+	m_FastEnergy_Valid = false;
 
 #ifdef ENABLE_DEBUG_TIME
 	m_MPI_Barrier = 0;
@@ -176,6 +179,10 @@ void Engine_Multithread::changeNumThreads(unsigned int numThreads)
 	m_MPI_Barrier = 0;
 #endif
 
+	m_Thread_E_Energy.assign(m_numThreads, 0);
+	m_Thread_H_Energy.assign(m_numThreads, 0);
+	m_FastEnergy_Valid = false;
+
 	m_thread_group = new boost::thread_group();
 	for (unsigned int n=0; n<m_numThreads; n++)
 	{
@@ -212,6 +219,29 @@ bool Engine_Multithread::IterateTS(unsigned int iterTS)
 
 	m_stopBarrier->wait(); // wait for the threads to finish <iterTS> time steps
 
+	if (iterTS>0)
+	{
+		// reduce the energy estimate of the last timestep
+		double E_energy = 0;
+		double H_energy = 0;
+		for (unsigned int n=0; n<m_numThreads; ++n)
+		{
+			E_energy += m_Thread_E_Energy.at(n);
+			H_energy += m_Thread_H_Energy.at(n);
+		}
+		m_FastEnergy = __EPS0__*E_energy + __MUE0__*H_energy;
+		m_FastEnergy_TS = numTS;
+		m_FastEnergy_Valid = true;
+	}
+
+	return true;
+}
+
+bool Engine_Multithread::GetFastEnergy(double &energy) const
+{
+	if ((m_FastEnergy_Valid==false) || (m_FastEnergy_TS!=numTS))
+		return false;
+	energy = m_FastEnergy;
 	return true;
 }
 
@@ -372,8 +402,11 @@ void thread::operator()()
 			//pre current stuff
 			m_enginePtr->DoPreCurrentUpdates(m_threadID);
 
-			//current updates
-			m_enginePtr->UpdateCurrents(m_start,m_stop_h-m_start+1);
+			//current updates, the last timestep also calculates the energy estimate
+			if (iter==m_enginePtr->m_iterTS-1)
+				m_enginePtr->UpdateCurrentsCalcEnergy(m_start,m_stop_h-m_start+1,m_enginePtr->m_Thread_E_Energy.at(m_threadID),m_enginePtr->m_Thread_H_Energy.at(m_threadID));
+			else
+				m_enginePtr->UpdateCurrents(m_start,m_stop_h-m_start+1);
 
 			// record time
 			DEBUG_TIME( m_enginePtr->m_timer_list[boost::this_thread::get_id()].push_back( timer1.elapsed() ); )
@@ -95,6 +95,9 @@ public:
 	//! Iterate \a iterTS number of timesteps
 	virtual bool IterateTS(unsigned int iterTS);
 
+	//! The energy estimate is calculated by all threads during the current updates of the last timestep of each iteration
+	virtual bool GetFastEnergy(double &energy) const;
+
 	virtual void DoPreVoltageUpdates(int threadID);
 	virtual void DoPostVoltageUpdates(int threadID);
 	virtual void Apply2Voltages(int threadID);
@@ -117,6 +120,12 @@ protected:
 	bool m_opt_speed;
 	float m_last_speed;
 
+	//! partial sums of the squared voltages and currents of each thread, reduced after each iteration
+	std::vector<double> m_Thread_E_Energy, m_Thread_H_Energy;
+	double m_FastEnergy;
+	unsigned int m_FastEnergy_TS;
+	bool m_FastEnergy_Valid;
+
 #ifdef MPI_SUPPORT
 	/*! Workaround needed for subgridding scheme... (see Engine_CylinderMultiGrid)
 	 Some engines may need an additional barrier for synchronizing MPI communication.
@@ -0,0 +1,110 @@
+/*
+*	Copyright (C) 2026 agent (agent@local)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "engine_snapshot.h"
+#include "engine_sse.h"
+
+#include <cstring>
+
+Engine_Snapshot::Engine_Snapshot(const Operator* op, const Engine* eng, const unsigned int start[3], const unsigned int stop[3]) : Engine(op)
+{
+	// the snapshot has no direct array storage, always use the virtual field access
+	m_type = UNKNOWN;
+	for (int n=0; n<3; ++n)
+	{
+		m_start[n] = min(start[n],numLines[n]-1);
+		m_size[n] = min(stop[n],numLines[n]-1) - m_start[n] + 1;
+	}
+
+	// the z-lines of a sse engine are not stored in z-order, keep its packed layout and copy the full lines
+	m_numVectors = 0;
+	m_lineSize = m_size[2];
+	if (eng->GetType()==Engine::SSE)
+	{
+		m_numVectors = ((const Engine_sse*)eng)->GetNumberOfVectors();
+		m_lineSize = 4*m_numVectors;
+	}
+
+	size_t size = 3*(size_t)m_size[0]*m_size[1]*m_lineSize;
+	m_volt = new FDTD_FLOAT[size];
+	m_curr = new FDTD_FLOAT[size];
+	for (size_t i=0; i<size; ++i)
+	{
+		m_volt[i] = 0;
+		m_curr[i] = 0;
+	}
+}
+
+Engine_Snapshot::~Engine_Snapshot()
+{
+	delete[] m_volt;
+	m_volt = NULL;
+	delete[] m_curr;
+	m_curr = NULL;
+}
+
+bool Engine_Snapshot::IterateTS(unsigned int iterTS)
+{
+	UNUSED(iterTS);
+	cerr << "Engine_Snapshot::IterateTS: Error, a field snapshot cannot be iterated!" << endl;
+	return false;
+}
+
+void Engine_Snapshot::Update(Engine* eng, unsigned int part, unsigned int numParts)
+{
+	if (part==0)
+		numTS = eng->GetNumberOfTimesteps();
+
+	// the z-lines of all three components, numbered (n*m_size[0]+x)*m_size[1]+y
+	size_t numZLines = 3*(size_t)m_size[0]*m_size[1];
+	size_t first = numZLines*part/numParts;
+	size_t last = numZLines*(part+1)/numParts;
+
+	unsigned int pos[3];
+	for (size_t line=first; line<last; ++line)
+	{
+		unsigned int n = line/((size_t)m_size[0]*m_size[1]);
+		pos[0] = m_start[0] + (line/m_size[1])%m_size[0];
+		pos[1] = m_start[1] + line%m_size[1];
+		pos[2] = m_start[2];
+		FDTD_FLOAT* volt = &m_volt[line*m_lineSize];
+		FDTD_FLOAT* curr = &m_curr[line*m_lineSize];
+		switch (eng->GetType())
+		{
+		case Engine::SSE:
+			{
+				Engine_sse* eng_sse = (Engine_sse*)eng;
+				memcpy(volt, eng_sse->f4_volt[n][pos[0]][pos[1]], m_lineSize*sizeof(FDTD_FLOAT));
+				memcpy(curr, eng_sse->f4_curr[n][pos[0]][pos[1]], m_lineSize*sizeof(FDTD_FLOAT));
+				break;
+			}
+		case Engine::BASIC:
+			// the z-lines of the basic engine are contiguous
+			memcpy(volt, eng->Engine::GetVoltPtr(n,pos), m_lineSize*sizeof(FDTD_FLOAT));
+			memcpy(curr, eng->Engine::GetCurrPtr(n,pos), m_lineSize*sizeof(FDTD_FLOAT));
+			break;
+		default:
+			for (unsigned int z=0; z<m_size[2]; ++z)
+			{
+				pos[2] = m_start[2]+z;
+				volt[z] = eng->GetVolt(n,pos);
+				curr[z] = eng->GetCurr(n,pos);
+			}
+			break;
+		}
+	}
+}
@@ -0,0 +1,115 @@
+/*
+*	Copyright (C) 2026 agent (agent@local)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINE_SNAPSHOT_H
+#define ENGINE_SNAPSHOT_H
+
+#include "engine.h"
+
+//! Copy of the engine fields inside a box at a given timestep.
+/*!
+  The snapshot provides the field access methods of an engine for the fields inside its box only (access outside this box will return zero).
+  A processing may work on a snapshot, while the engine this snapshot was taken from is already iterating the next timesteps.
+  The snapshot cannot be iterated itself.
+  */
+class Engine_Snapshot : public Engine
+{
+public:
+	//! Create a snapshot of the given engine for a box (inclusive start and stop index) of the operator mesh.
+	Engine_Snapshot(const Operator* op, const Engine* eng, const unsigned int start[3], const unsigned int stop[3]);
+	virtual ~Engine_Snapshot();
+
+	virtual void Init() {}
+	virtual void Reset() {}
+
+	//! A snapshot cannot be iterated.
+	virtual bool IterateTS(unsigned int iterTS);
+
+	//! Copy the fields inside the snapshot box and the current timestep from the given engine.
+	/*!
+	  The z-lines of the box are split into \a numParts parts, several threads may copy different parts at the same time.
+	  Only the first part updates the timestep.
+	  */
+	void Update(Engine* eng, unsigned int part=0, unsigned int numParts=1);
+
+	inline virtual FDTD_FLOAT GetVolt( unsigned int n, unsigned int x, unsigned int y, unsigned int z )		const { return GetValue(m_volt,n,x,y,z); }
+	inline virtual FDTD_FLOAT GetVolt( unsigned int n, const unsigned int pos[3] )							const { return GetValue(m_volt,n,pos[0],pos[1],pos[2]); }
+	inline virtual FDTD_FLOAT GetCurr( unsigned int n, unsigned int x, unsigned int y, unsigned int z )		const { return GetValue(m_curr,n,x,y,z); }
+	inline virtual FDTD_FLOAT GetCurr( unsigned int n, const unsigned int pos[3] )							const { return GetValue(m_curr,n,pos[0],pos[1],pos[2]); }
+
+	inline virtual const FDTD_FLOAT* GetVoltPtr( unsigned int n, const unsigned int pos[3] )					const { return GetPtr(m_volt,n,pos[0],pos[1],pos[2]); }
+	inline virtual const FDTD_FLOAT* GetCurrPtr( unsigned int n, const unsigned int pos[3] )					const { return GetPtr(m_curr,n,pos[0],pos[1],pos[2]); }
+
+	inline virtual void SetVolt( unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value)	{ SetValue(m_volt,n,x,y,z,value); }
+	inline virtual void SetVolt( unsigned int n, const unsigned int pos[3], FDTD_FLOAT value )						{ SetValue(m_volt,n,pos[0],pos[1],pos[2],value); }
+	inline virtual void SetCurr( unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value)	{ SetValue(m_curr,n,x,y,z,value); }
+	inline virtual void SetCurr( unsigned int n, const unsigned int pos[3], FDTD_FLOAT value )						{ SetValue(m_curr,n,pos[0],pos[1],pos[2],value); }
+
+protected:
+	unsigned int m_start[3];
+	unsigned int m_size[3];
+
+	//! number of sse vectors of the engine, the snapshot keeps the packed z-line layout of a sse engine (zero for all other engines)
+	unsigned int m_numVectors;
+	//! number of values stored per z-line
+	unsigned int m_lineSize;
+
+	//! snapshot storage, z-lines of the n-th component of the box in x-y order
+	FDTD_FLOAT* m_volt;
+	FDTD_FLOAT* m_curr;
+
+	inline bool GetIndex(unsigned int n, unsigned int x, unsigned int y, unsigned int z, size_t &index) const
+	{
+		x-=m_start[0];
+		y-=m_start[1];
+		z-=m_start[2];
+		// unsigned underflow will also fail these checks
+		if ((n>2) || (x>=m_size[0]) || (y>=m_size[1]) || (z>=m_size[2]))
+			return false;
+		index = (((size_t)n*m_size[0] + x)*m_size[1] + y)*m_lineSize;
+		if (m_numVectors)
+		{
+			z+=m_start[2];
+			index += (z%m_numVectors)*4 + z/m_numVectors;
+		}
+		else
+			index += z;
+		return true;
+	}
+	inline FDTD_FLOAT GetValue(const FDTD_FLOAT* array, unsigned int n, unsigned int x, unsigned int y, unsigned int z) const
+	{
+		size_t index;
+		if (GetIndex(n,x,y,z,index))
+			return array[index];
+		return 0;
+	}
+	inline const FDTD_FLOAT* GetPtr(const FDTD_FLOAT* array, unsigned int n, unsigned int x, unsigned int y, unsigned int z) const
+	{
+		size_t index;
+		if (GetIndex(n,x,y,z,index))
+			return &array[index];
+		return NULL;
+	}
+	inline void SetValue(FDTD_FLOAT* array, unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value)
+	{
+		size_t index;
+		if (GetIndex(n,x,y,z,index))
+			array[index] = value;
+	}
+};
+
+#endif // ENGINE_SNAPSHOT_H
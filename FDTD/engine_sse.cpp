@@ -171,6 +171,25 @@ void Engine_sse::UpdateVoltages(unsigned int startX, unsigned int numX)
 }
 
 void Engine_sse::UpdateCurrents(unsigned int startX, unsigned int numX)
+{
+	UpdateCurrents_Kernel<false>(startX, numX, NULL, NULL);
+}
+
+void Engine_sse::UpdateCurrentsCalcEnergy(unsigned int startX, unsigned int numX, double &E_energy, double &H_energy)
+{
+	f4vector E_sum, H_sum;
+	for (int n=0; n<4; ++n)
+	{
+		E_sum.f[n] = 0;
+		H_sum.f[n] = 0;
+	}
+	UpdateCurrents_Kernel<true>(startX, numX, &E_sum, &H_sum);
+	E_energy = E_sum.f[0]+E_sum.f[1]+E_sum.f[2]+E_sum.f[3];
+	H_energy = H_sum.f[0]+H_sum.f[1]+H_sum.f[2]+H_sum.f[3];
+}
+
+template <bool calcEnergy>
+void Engine_sse::UpdateCurrents_Kernel(unsigned int startX, unsigned int numX, f4vector* E_energy, f4vector* H_energy)
 {
 	unsigned int pos[5];
 	f4vector temp;
@@ -214,6 +233,9 @@ void Engine_sse::UpdateCurrents(unsigned int startX, unsigned int numX)
 				        f4_volt[0][pos[0]  ][pos[1]  ][pos[2]].v +
 				        f4_volt[0][pos[0]  ][pos[1]+1][pos[2]].v
 				    );
+
+				if (calcEnergy)
+					AccumulateEnergy(pos, pos[2], E_energy, H_energy);
 			}
 
 			// for pos[2] = numVectors-1
@@ -257,6 +279,9 @@ void Engine_sse::UpdateCurrents(unsigned int startX, unsigned int numX)
 			        f4_volt[0][pos[0]  ][pos[1]  ][numVectors-1].v +
 			        f4_volt[0][pos[0]  ][pos[1]+1][numVectors-1].v
 			    );
+
+			if (calcEnergy)
+				AccumulateEnergy(pos, numVectors-1, E_energy, H_energy);
 		}
 		++pos[0];
 	}
@@ -32,12 +32,18 @@ public:
 
 	virtual unsigned int GetNumberOfTimesteps() {return numTS;};
 
+	//! Get the number of sse vectors in z-direction, z-line z is stored at vector z%numVectors and vector element z/numVectors
+	unsigned int GetNumberOfVectors() const {return numVectors;}
+
 	//this access functions muss be overloaded by any new engine using a different storage model
 	inline virtual FDTD_FLOAT GetVolt( unsigned int n, unsigned int x, unsigned int y, unsigned int z )	const { return f4_volt[n][x][y][z%numVectors].f[z/numVectors]; }
 	inline virtual FDTD_FLOAT GetVolt( unsigned int n, const unsigned int pos[3] )						const { return f4_volt[n][pos[0]][pos[1]][pos[2]%numVectors].f[pos[2]/numVectors]; }
 	inline virtual FDTD_FLOAT GetCurr( unsigned int n, unsigned int x, unsigned int y, unsigned int z )	const { return f4_curr[n][x][y][z%numVectors].f[z/numVectors]; }
 	inline virtual FDTD_FLOAT GetCurr( unsigned int n, const unsigned int pos[3] )						const { return f4_curr[n][pos[0]][pos[1]][pos[2]%numVectors].f[pos[2]/numVectors]; }
 
+	inline virtual const FDTD_FLOAT* GetVoltPtr( unsigned int n, const unsigned int pos[3] )					const { return &f4_volt[n][pos[0]][pos[1]][pos[2]%numVectors].f[pos[2]/numVectors]; }
+	inline virtual const FDTD_FLOAT* GetCurrPtr( unsigned int n, const unsigned int pos[3] )					const { return &f4_curr[n][pos[0]][pos[1]][pos[2]%numVectors].f[pos[2]/numVectors]; }
+
 	inline virtual void SetVolt( unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value)	{ f4_volt[n][x][y][z%numVectors].f[z/numVectors]=value; }
 	inline virtual void SetVolt( unsigned int n, const unsigned int pos[3], FDTD_FLOAT value )						{ f4_volt[n][pos[0]][pos[1]][pos[2]%numVectors].f[pos[2]/numVectors]=value; }
 	inline virtual void SetCurr( unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value)	{ f4_curr[n][x][y][z%numVectors].f[z/numVectors]=value; }
@@ -49,6 +55,20 @@ protected:
 
 	virtual void UpdateVoltages(unsigned int startX, unsigned int numX);
 	virtual void UpdateCurrents(unsigned int startX, unsigned int numX);
+	virtual void UpdateCurrentsCalcEnergy(unsigned int startX, unsigned int numX, double &E_energy, double &H_energy);
+
+	//! Current update kernel, optionally summing up the squared voltages and currents of the updated cells
+	template <bool calcEnergy>
+	void UpdateCurrents_Kernel(unsigned int startX, unsigned int numX, f4vector* E_energy, f4vector* H_energy);
+
+	inline void AccumulateEnergy(const unsigned int* pos, unsigned int vec, f4vector* E_energy, f4vector* H_energy) const
+	{
+		for (int n=0; n<3; ++n)
+		{
+			E_energy->v += f4_volt[n][pos[0]][pos[1]][vec].v * f4_volt[n][pos[0]][pos[1]][vec].v;
+			H_energy->v += f4_curr[n][pos[0]][pos[1]][vec].v * f4_curr[n][pos[0]][pos[1]][vec].v;
+		}
+	}
 
 	unsigned int numVectors;
 
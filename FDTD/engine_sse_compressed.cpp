@@ -31,17 +31,92 @@ Engine_SSE_Compressed* Engine_SSE_Compressed::New(const Operator_SSE_Compressed*
 Engine_SSE_Compressed::Engine_SSE_Compressed(const Operator_SSE_Compressed* op) : Engine_sse(op)
 {
 	Op = op;
+	m_Volt_ADE.order = 0;
+	m_Curr_ADE.order = 0;
 }
 
 Engine_SSE_Compressed::~Engine_SSE_Compressed()
 {
 }
 
+bool Engine_SSE_Compressed::InitDispersiveADE(unsigned int order)
+{
+	if ((order==0) || (m_Volt_ADE.order>0) || (m_Curr_ADE.order>0))
+		return false;
+
+	// number all flagged vectors in the order of the update kernels, the voltage kernel handles the first vector of each column last
+	unsigned int numVolt = 0;
+	unsigned int numCurr = 0;
+	m_Volt_ADE.colStart.resize(numLines[0]*numLines[1]);
+	m_Curr_ADE.colStart.resize(numLines[0]*numLines[1]);
+	for (unsigned int x=0; x<numLines[0]; ++x)
+		for (unsigned int y=0; y<numLines[1]; ++y)
+		{
+			m_Volt_ADE.colStart.at(x*numLines[1]+y) = numVolt;
+			m_Curr_ADE.colStart.at(x*numLines[1]+y) = numCurr;
+			for (unsigned int v=0; v<numVectors; ++v)
+			{
+				unsigned char flags = Op->m_Coeff_Flags[Op->m_Op_index[x][y][v]];
+				if (flags & Operator_SSE_Compressed::COEFF_DISPERSIVE_VOLT)
+					++numVolt;
+				// the currents of the last x- and y-lines are not updated
+				if ((flags & Operator_SSE_Compressed::COEFF_DISPERSIVE_CURR) && (x<numLines[0]-1) && (y<numLines[1]-1))
+					++numCurr;
+			}
+		}
+
+	Dispersive_ADE* ade[2] = {&m_Volt_ADE, &m_Curr_ADE};
+	unsigned int num[2] = {numVolt, numCurr};
+	f4vector zero;
+	for (int lane=0; lane<4; ++lane)
+		zero.f[lane] = 0;
+	for (int n=0; n<2; ++n)
+	{
+		ade[n]->order = order;
+		ade[n]->c_int.assign(num[n]*order*3, zero);
+		ade[n]->c_ext.assign(num[n]*order*3, zero);
+		ade[n]->c_lor.assign(num[n]*order*3, zero);
+		ade[n]->ade.assign(num[n]*order*3, zero);
+		ade[n]->lor.assign(num[n]*order*3, zero);
+	}
+	return true;
+}
+
+int Engine_SSE_Compressed::GetDispersiveSlot(bool volt, unsigned int x, unsigned int y, unsigned int vec) const
+{
+	const Dispersive_ADE &d = volt ? m_Volt_ADE : m_Curr_ADE;
+	unsigned char flag = volt ? Operator_SSE_Compressed::COEFF_DISPERSIVE_VOLT : Operator_SSE_Compressed::COEFF_DISPERSIVE_CURR;
+	if ((d.order==0) || (vec>=numVectors) || !(Op->m_Coeff_Flags[Op->m_Op_index[x][y][vec]] & flag))
+		return -1;
+	if (!volt && ((x>=numLines[0]-1) || (y>=numLines[1]-1)))
+		return -1;
+
+	// count the flagged vectors in front of vec in the kernel order of this column
+	int slot = d.colStart.at(x*numLines[1]+y);
+	for (unsigned int v=0; v<numVectors; ++v)
+	{
+		// the voltage kernel starts at the second vector
+		if (volt && (v==0))
+			continue;
+		if (v==vec)
+			return slot;
+		if (Op->m_Coeff_Flags[Op->m_Op_index[x][y][v]] & flag)
+			++slot;
+	}
+	// the first vector of the voltage kernel
+	return slot;
+}
+
 void Engine_SSE_Compressed::UpdateVoltages(unsigned int startX, unsigned int numX)
 {
 	unsigned int pos[3];
 	bool shift[2];
 	f4vector temp;
+	// dispersive vectors update their ADEs with the old voltages and subtract them right after the main update
+	bool fold = (m_Volt_ADE.order>0);
+	bool disp = false;
+	unsigned int slot = 0;
+	f4vector ade[3];
 
 	pos[0] = startX;
 	unsigned int index=0;
@@ -51,9 +126,15 @@ void Engine_SSE_Compressed::UpdateVoltages(unsigned int startX, unsigned int num
 		for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
 		{
 			shift[1]=pos[1];
+			if (fold)
+				slot = m_Volt_ADE.colStart[pos[0]*numLines[1]+pos[1]];
 			for (pos[2]=1; pos[2]<numVectors; ++pos[2])
 			{
 				index = Op->m_Op_index[pos[0]][pos[1]][pos[2]];
+				disp = fold && (Op->m_Coeff_Flags[index] & Operator_SSE_Compressed::COEFF_DISPERSIVE_VOLT);
+				if (disp)
+					FoldVoltageADE(pos, pos[2], slot, ade);
+
 				// x-polarization
 				f4_volt[0][pos[0]][pos[1]][pos[2]].v *=
 				    Op->f4_vv_Compressed[0][index].v;
@@ -86,11 +167,21 @@ void Engine_SSE_Compressed::UpdateVoltages(unsigned int startX, unsigned int num
 				        f4_curr[0][pos[0]         ][pos[1]]         [pos[2]].v +
 				        f4_curr[0][pos[0]         ][pos[1]-shift[1]][pos[2]].v
 				    );
+
+				if (disp)
+				{
+					SubtractADE(f4_volt, pos, pos[2], ade);
+					++slot;
+				}
 			}
 
 			// for pos[2] = 0
 			// x-polarization
 			index = Op->m_Op_index[pos[0]][pos[1]][0];
+			disp = fold && (Op->m_Coeff_Flags[index] & Operator_SSE_Compressed::COEFF_DISPERSIVE_VOLT);
+			if (disp)
+				FoldVoltageADE(pos, 0, slot, ade);
+
 #ifdef __SSE2__
 			temp.v = (__m128)_mm_slli_si128(
 			             (__m128i)f4_curr[1][pos[0]][pos[1]][numVectors-1].v, 4
@@ -142,15 +233,45 @@ void Engine_SSE_Compressed::UpdateVoltages(unsigned int startX, unsigned int num
 			        f4_curr[0][pos[0]         ][pos[1]         ][0].v +
 			        f4_curr[0][pos[0]         ][pos[1]-shift[1]][0].v
 			    );
+
+			if (disp)
+			{
+				SubtractADE(f4_volt, pos, 0, ade);
+				++slot;
+			}
 		}
 		++pos[0];
 	}
 }
 
 void Engine_SSE_Compressed::UpdateCurrents(unsigned int startX, unsigned int numX)
+{
+	UpdateCurrents_Kernel<false>(startX, numX, NULL, NULL);
+}
+
+void Engine_SSE_Compressed::UpdateCurrentsCalcEnergy(unsigned int startX, unsigned int numX, double &E_energy, double &H_energy)
+{
+	f4vector E_sum, H_sum;
+	for (int n=0; n<4; ++n)
+	{
+		E_sum.f[n] = 0;
+		H_sum.f[n] = 0;
+	}
+	UpdateCurrents_Kernel<true>(startX, numX, &E_sum, &H_sum);
+	E_energy = E_sum.f[0]+E_sum.f[1]+E_sum.f[2]+E_sum.f[3];
+	H_energy = H_sum.f[0]+H_sum.f[1]+H_sum.f[2]+H_sum.f[3];
+}
+
+template <bool calcEnergy>
+void Engine_SSE_Compressed::UpdateCurrents_Kernel(unsigned int startX, unsigned int numX, f4vector* E_energy, f4vector* H_energy)
 {
 	unsigned int pos[3];
 	f4vector temp;
+	// dispersive vectors update their ADEs with the old currents and subtract them right after the main update
+	bool fold = (m_Curr_ADE.order>0);
+	bool disp = false;
+	unsigned int slot = 0;
+	f4vector ade[3];
 
 	pos[0] = startX;
 	unsigned int index;
@@ -158,9 +279,15 @@ void Engine_SSE_Compressed::UpdateCurrents(unsigned int startX, unsigned int num
 	{
 		for (pos[1]=0; pos[1]<numLines[1]-1; ++pos[1])
 		{
+			if (fold)
+				slot = m_Curr_ADE.colStart[pos[0]*numLines[1]+pos[1]];
 			for (pos[2]=0; pos[2]<numVectors-1; ++pos[2])
 			{
 				index = Op->m_Op_index[pos[0]][pos[1]][pos[2]];
+				disp = fold && (Op->m_Coeff_Flags[index] & Operator_SSE_Compressed::COEFF_DISPERSIVE_CURR);
+				if (disp)
+					FoldCurrentADE(pos, pos[2], slot, ade);
+
 				// x-pol
 				f4_curr[0][pos[0]][pos[1]][pos[2]].v *=
 				    Op->f4_ii_Compressed[0][index].v;
@@ -193,9 +320,22 @@ void Engine_SSE_Compressed::UpdateCurrents(unsigned int startX, unsigned int num
 				        f4_volt[0][pos[0]  ][pos[1]  ][pos[2]].v +
 				        f4_volt[0][pos[0]  ][pos[1]+1][pos[2]].v
 				    );
+
+				if (disp)
+				{
+					SubtractADE(f4_curr, pos, pos[2], ade);
+					++slot;
+				}
+
+				if (calcEnergy)
+					AccumulateEnergy(pos, pos[2], E_energy, H_energy);
 			}
 
 			index = Op->m_Op_index[pos[0]][pos[1]][numVectors-1];
+			disp = fold && (Op->m_Coeff_Flags[index] & Operator_SSE_Compressed::COEFF_DISPERSIVE_CURR);
+			if (disp)
+				FoldCurrentADE(pos, numVectors-1, slot, ade);
+
 			// for pos[2] = numVectors-1
 			// x-pol
 #ifdef __SSE2__
@@ -249,6 +389,15 @@ void Engine_SSE_Compressed::UpdateCurrents(unsigned int startX, unsigned int num
 			        f4_volt[0][pos[0]  ][pos[1]  ][numVectors-1].v +
 			        f4_volt[0][pos[0]  ][pos[1]+1][numVectors-1].v
 			    );
+
+			if (disp)
+			{
+				SubtractADE(f4_curr, pos, numVectors-1, ade);
+				++slot;
+			}
+
+			if (calcEnergy)
+				AccumulateEnergy(pos, numVectors-1, E_energy, H_energy);
 		}
 		++pos[0];
 	}
@@ -27,12 +27,71 @@ public:
 	static Engine_SSE_Compressed* New(const Operator_SSE_Compressed* op);
 	virtual ~Engine_SSE_Compressed();
 
+	//! Packed ADE state and coefficients of all vectors flagged dispersive in the compressed operator
+	/*!
+	  The flagged vectors are numbered in the order of the update sweep, colStart gives the first one of each (x,y)-column (x*numLines[1]+y).
+	  All coefficient and state vectors are indexed by ((slot*order + o)*3 + n), unused lanes have zero coefficients.
+	  */
+	struct Dispersive_ADE
+	{
+		unsigned int order;
+		vector<unsigned int> colStart;
+		vector<f4vector,aligned_allocator<f4vector> > c_int;
+		vector<f4vector,aligned_allocator<f4vector> > c_ext;
+		vector<f4vector,aligned_allocator<f4vector> > c_lor;
+		vector<f4vector,aligned_allocator<f4vector> > ade;
+		vector<f4vector,aligned_allocator<f4vector> > lor;
+	};
+
+	//! Let the update kernels apply the ADEs of all flagged vectors with the given dispersion \a order, the coefficients have to be set afterwards
+	/*!
+	  Only a single dispersive extension can be folded into the main update, returns false if already in use.
+	  */
+	bool InitDispersiveADE(unsigned int order);
+
+	//! Get the slot of the flagged vector \a vec of the (x,y)-column in the voltage or current ADE data, returns -1 if the vector is not flagged or not updated
+	int GetDispersiveSlot(bool volt, unsigned int x, unsigned int y, unsigned int vec) const;
+
+	// dispersive extension needs access
+	Dispersive_ADE m_Volt_ADE;
+	Dispersive_ADE m_Curr_ADE;
+
 protected:
 	Engine_SSE_Compressed(const Operator_SSE_Compressed* op);
 	const Operator_SSE_Compressed* Op;
 
 	virtual void UpdateVoltages(unsigned int startX, unsigned int numX);
 	virtual void UpdateCurrents(unsigned int startX, unsigned int numX);
+	virtual void UpdateCurrentsCalcEnergy(unsigned int startX, unsigned int numX, double &E_energy, double &H_energy);
+
+	//! Current update kernel, optionally summing up the squared voltages and currents of the updated cells
+	template <bool calcEnergy>
+	void UpdateCurrents_Kernel(unsigned int startX, unsigned int numX, f4vector* E_energy, f4vector* H_energy);
+
+	//! Update the ADEs of a flagged vector from the old \a field values and return the sum of all orders in \a sum[n]
+	inline void UpdateDispersiveADE(Dispersive_ADE& d, f4vector**** field, const unsigned int* pos, unsigned int vec, unsigned int slot, f4vector sum[3])
+	{
+		for (int n=0; n<3; ++n)
+			for (int lane=0; lane<4; ++lane)
+				sum[n].f[lane] = 0;
+		unsigned int i = slot*d.order*3;
+		for (unsigned int o=0; o<d.order; ++o)
+			for (int n=0; n<3; ++n, ++i)
+			{
+				d.lor[i].v += d.c_lor[i].v * d.ade[i].v;
+				d.ade[i].v = d.ade[i].v * d.c_int[i].v + d.c_ext[i].v * (field[n][pos[0]][pos[1]][vec].v - d.lor[i].v);
+				sum[n].v += d.ade[i].v;
+			}
+	}
+	inline void FoldVoltageADE(const unsigned int* pos, unsigned int vec, unsigned int slot, f4vector sum[3]) {UpdateDispersiveADE(m_Volt_ADE, f4_volt, pos, vec, slot, sum);}
+	inline void FoldCurrentADE(const unsigned int* pos, unsigned int vec, unsigned int slot, f4vector sum[3]) {UpdateDispersiveADE(m_Curr_ADE, f4_curr, pos, vec, slot, sum);}
+
+	//! Subtract the summed ADEs from the updated \a field
+	inline void SubtractADE(f4vector**** field, const unsigned int* pos, unsigned int vec, const f4vector sum[3])
+	{
+		for (int n=0; n<3; ++n)
+			field[n][pos[0]][pos[1]][vec].v -= sum[n].v;
+	}
 };
 
 #endif // ENGINE_SSE_COMPRESSED_H
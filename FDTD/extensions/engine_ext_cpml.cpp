@@ -0,0 +1,426 @@
+/*
+*	Copyright (C) 2026 agent (agent@local)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "engine_ext_cpml.h"
+#include "operator_ext_cpml.h"
+#include "engine_field_access.h"
+#include "FDTD/engine_sse.h"
+#include "tools/array_ops.h"
+#include "tools/useful.h"
+
+Engine_Ext_CPML::Engine_Ext_CPML(Operator_Ext_CPML* op_ext) : Engine_Extension(op_ext)
+{
+	m_Op_CPML = op_ext;
+
+	//this ABC extension should be executed first!
+	m_Priority = ENG_EXT_PRIO_CPML;
+
+	volt_psi_nyP = Create3DArray<FDTD_FLOAT>(m_Op_CPML->m_numLines);
+	volt_psi_nyPP = Create3DArray<FDTD_FLOAT>(m_Op_CPML->m_numLines);
+	curr_psi_nyP = Create3DArray<FDTD_FLOAT>(m_Op_CPML->m_numLines);
+	curr_psi_nyPP = Create3DArray<FDTD_FLOAT>(m_Op_CPML->m_numLines);
+
+	m_numVectors = 0;
+	f4_volt_psi_nyP = NULL;
+	f4_volt_psi_nyPP = NULL;
+	f4_curr_psi_nyP = NULL;
+	f4_curr_psi_nyPP = NULL;
+	for (int n=0; n<2; ++n)
+	{
+		f4_volt_coeff[n] = NULL;
+		f4_curr_coeff[n] = NULL;
+	}
+
+	SetNumberOfThreads(1);
+}
+
+Engine_Ext_CPML::~Engine_Ext_CPML()
+{
+	Delete3DArray<FDTD_FLOAT>(volt_psi_nyP,m_Op_CPML->m_numLines);
+	volt_psi_nyP = NULL;
+	Delete3DArray<FDTD_FLOAT>(volt_psi_nyPP,m_Op_CPML->m_numLines);
+	volt_psi_nyPP = NULL;
+	Delete3DArray<FDTD_FLOAT>(curr_psi_nyP,m_Op_CPML->m_numLines);
+	curr_psi_nyP = NULL;
+	Delete3DArray<FDTD_FLOAT>(curr_psi_nyPP,m_Op_CPML->m_numLines);
+	curr_psi_nyPP = NULL;
+	DeletePackedStorage();
+}
+
+void Engine_Ext_CPML::SetNumberOfThreads(int nrThread)
+{
+	Engine_Extension::SetNumberOfThreads(nrThread);
+
+	// distribute all (x,y)-columns of the cpml box, a pml slab may only be a few lines thick in x-direction
+	m_numCols = AssignJobs2Threads(m_Op_CPML->m_numLines[0]*m_Op_CPML->m_numLines[1],m_NrThreads,false);
+	m_start.resize(m_NrThreads,0);
+	m_start.at(0)=0;
+	for (size_t n=1; n<m_numCols.size(); ++n)
+		m_start.at(n) = m_start.at(n-1) + m_numCols.at(n-1);
+}
+
+void Engine_Ext_CPML::SetEngine(Engine* eng)
+{
+	Engine_Extension::SetEngine(eng);
+	InitPackedStorage();
+}
+
+void Engine_Ext_CPML::InitPackedStorage()
+{
+	DeletePackedStorage();
+	if ((m_Eng==NULL) || (m_Eng->GetType()!=Engine::SSE) || (m_Op_CPML->m_volt_coeff[0]==NULL))
+		return;
+
+	// the packed layout requires the full z-range and whole columns in pml direction, a pml in z-direction is distributed over all sse vectors
+	if ((m_Op_CPML->m_ny==2) || (m_Op_CPML->m_StartPos[2]!=0) || (m_Op_CPML->m_numLines[2]!=m_Op_CPML->m_Op->GetNumberOfLines(2,true)))
+		return;
+
+	m_numVectors = ((Engine_sse*) m_Eng)->GetNumberOfVectors();
+	f4_volt_psi_nyP = Create3DArray_v4sf(m_Op_CPML->m_numLines);
+	f4_volt_psi_nyPP = Create3DArray_v4sf(m_Op_CPML->m_numLines);
+	f4_curr_psi_nyP = Create3DArray_v4sf(m_Op_CPML->m_numLines);
+	f4_curr_psi_nyPP = Create3DArray_v4sf(m_Op_CPML->m_numLines);
+	for (int n=0; n<2; ++n)
+	{
+		f4_volt_coeff[n] = Create3DArray_v4sf(m_Op_CPML->m_numLines);
+		f4_curr_coeff[n] = Create3DArray_v4sf(m_Op_CPML->m_numLines);
+	}
+
+	// copy the coefficients, the padding elements of the last vectors remain zero
+	unsigned int loc_pos[3];
+	for (int n=0; n<2; ++n)
+		for (loc_pos[0]=0; loc_pos[0]<m_Op_CPML->m_numLines[0]; ++loc_pos[0])
+			for (loc_pos[1]=0; loc_pos[1]<m_Op_CPML->m_numLines[1]; ++loc_pos[1])
+				for (loc_pos[2]=0; loc_pos[2]<m_Op_CPML->m_numLines[2]; ++loc_pos[2])
+				{
+					unsigned int v = loc_pos[2]%m_numVectors;
+					unsigned int e = loc_pos[2]/m_numVectors;
+					f4_volt_coeff[n][loc_pos[0]][loc_pos[1]][v].f[e] = m_Op_CPML->m_volt_coeff[n][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					f4_curr_coeff[n][loc_pos[0]][loc_pos[1]][v].f[e] = m_Op_CPML->m_curr_coeff[n][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+				}
+
+	// the scalar psi is not used by the packed update
+	Delete3DArray<FDTD_FLOAT>(volt_psi_nyP,m_Op_CPML->m_numLines);
+	volt_psi_nyP = NULL;
+	Delete3DArray<FDTD_FLOAT>(volt_psi_nyPP,m_Op_CPML->m_numLines);
+	volt_psi_nyPP = NULL;
+	Delete3DArray<FDTD_FLOAT>(curr_psi_nyP,m_Op_CPML->m_numLines);
+	curr_psi_nyP = NULL;
+	Delete3DArray<FDTD_FLOAT>(curr_psi_nyPP,m_Op_CPML->m_numLines);
+	curr_psi_nyPP = NULL;
+}
+
+void Engine_Ext_CPML::DeletePackedStorage()
+{
+	if (f4_volt_psi_nyP==NULL)
+		return;
+	Delete3DArray_v4sf(f4_volt_psi_nyP,m_Op_CPML->m_numLines);
+	Delete3DArray_v4sf(f4_volt_psi_nyPP,m_Op_CPML->m_numLines);
+	Delete3DArray_v4sf(f4_curr_psi_nyP,m_Op_CPML->m_numLines);
+	Delete3DArray_v4sf(f4_curr_psi_nyPP,m_Op_CPML->m_numLines);
+	f4_volt_psi_nyP = f4_volt_psi_nyPP = NULL;
+	f4_curr_psi_nyP = f4_curr_psi_nyPP = NULL;
+	for (int n=0; n<2; ++n)
+	{
+		Delete3DArray_v4sf(f4_volt_coeff[n],m_Op_CPML->m_numLines);
+		f4_volt_coeff[n] = NULL;
+		Delete3DArray_v4sf(f4_curr_coeff[n],m_Op_CPML->m_numLines);
+		f4_curr_coeff[n] = NULL;
+	}
+
+	// restore the scalar psi storage
+	if (volt_psi_nyP==NULL)
+		volt_psi_nyP = Create3DArray<FDTD_FLOAT>(m_Op_CPML->m_numLines);
+	if (volt_psi_nyPP==NULL)
+		volt_psi_nyPP = Create3DArray<FDTD_FLOAT>(m_Op_CPML->m_numLines);
+	if (curr_psi_nyP==NULL)
+		curr_psi_nyP = Create3DArray<FDTD_FLOAT>(m_Op_CPML->m_numLines);
+	if (curr_psi_nyPP==NULL)
+		curr_psi_nyPP = Create3DArray<FDTD_FLOAT>(m_Op_CPML->m_numLines);
+}
+
+template <class Access>
+void Engine_Ext_CPML::UpdateVoltagePsi(Access eng, unsigned int startCol, unsigned int numCols)
+{
+	int ny = m_Op_CPML->m_ny;
+	int nyP = m_Op_CPML->m_nyP;
+	int nyPP = m_Op_CPML->m_nyPP;
+	const unsigned int* numLines = m_Op_CPML->m_numLines;
+	const unsigned int* start = m_Op_CPML->m_StartPos;
+	FDTD_FLOAT*** coeff_nyP = m_Op_CPML->m_volt_coeff[0];
+	FDTD_FLOAT*** coeff_nyPP = m_Op_CPML->m_volt_coeff[1];
+
+	unsigned int pos[3];
+	unsigned int pos_shift[3];
+	unsigned int loc_pos[3];
+	FDTD_FLOAT psi;
+	for (unsigned int col=startCol; col<startCol+numCols; ++col)
+	{
+		loc_pos[0] = col/numLines[1];
+		loc_pos[1] = col%numLines[1];
+		pos[0] = loc_pos[0] + start[0];
+		pos[1] = loc_pos[1] + start[1];
+		for (loc_pos[2]=0; loc_pos[2]<numLines[2]; ++loc_pos[2])
+		{
+			pos[2] = loc_pos[2] + start[2];
+			// the lower boundary has no current difference, the psi remains zero
+			if (pos[ny]==0)
+				continue;
+			pos_shift[0] = pos[0];
+			pos_shift[1] = pos[1];
+			pos_shift[2] = pos[2];
+			--pos_shift[ny];
+
+			FDTD_FLOAT b = m_Op_CPML->m_volt_b[loc_pos[ny]];
+
+			psi = volt_psi_nyP[loc_pos[0]][loc_pos[1]][loc_pos[2]];
+			psi = b*psi + coeff_nyP[loc_pos[0]][loc_pos[1]][loc_pos[2]] * (eng.GetCurr(nyPP,pos) - eng.GetCurr(nyPP,pos_shift));
+			volt_psi_nyP[loc_pos[0]][loc_pos[1]][loc_pos[2]] = psi;
+			eng.SetVolt(nyP, pos, eng.GetVolt(nyP,pos) + psi);
+
+			psi = volt_psi_nyPP[loc_pos[0]][loc_pos[1]][loc_pos[2]];
+			psi = b*psi + coeff_nyPP[loc_pos[0]][loc_pos[1]][loc_pos[2]] * (eng.GetCurr(nyP,pos) - eng.GetCurr(nyP,pos_shift));
+			volt_psi_nyPP[loc_pos[0]][loc_pos[1]][loc_pos[2]] = psi;
+			eng.SetVolt(nyPP, pos, eng.GetVolt(nyPP,pos) + psi);
+		}
+	}
+}
+
+template <class Access>
+void Engine_Ext_CPML::UpdateCurrentPsi(Access eng, unsigned int startCol, unsigned int numCols)
+{
+	const Operator* op = m_Op_CPML->m_Op;
+	int ny = m_Op_CPML->m_ny;
+	int nyP = m_Op_CPML->m_nyP;
+	int nyPP = m_Op_CPML->m_nyPP;
+	const unsigned int* numLines = m_Op_CPML->m_numLines;
+	const unsigned int* start = m_Op_CPML->m_StartPos;
+	FDTD_FLOAT*** coeff_nyP = m_Op_CPML->m_curr_coeff[0];
+	FDTD_FLOAT*** coeff_nyPP = m_Op_CPML->m_curr_coeff[1];
+	unsigned int maxLines[3];
+	for (int n=0; n<3; ++n)
+		maxLines[n] = op->GetNumberOfLines(n,true)-1;
+
+	unsigned int pos[3];
+	unsigned int pos_shift[3];
+	unsigned int loc_pos[3];
+	FDTD_FLOAT psi;
+	for (unsigned int col=startCol; col<startCol+numCols; ++col)
+	{
+		loc_pos[0] = col/numLines[1];
+		loc_pos[1] = col%numLines[1];
+		pos[0] = loc_pos[0] + start[0];
+		pos[1] = loc_pos[1] + start[1];
+		// the currents on the last lines are not updated by the engine
+		if ((pos[0]>=maxLines[0]) || (pos[1]>=maxLines[1]))
+			continue;
+		for (loc_pos[2]=0; loc_pos[2]<numLines[2]; ++loc_pos[2])
+		{
+			pos[2] = loc_pos[2] + start[2];
+			if (pos[2]>=maxLines[2])
+				break;
+			pos_shift[0] = pos[0];
+			pos_shift[1] = pos[1];
+			pos_shift[2] = pos[2];
+			++pos_shift[ny];
+
+			FDTD_FLOAT b = m_Op_CPML->m_curr_b[loc_pos[ny]];
+
+			psi = curr_psi_nyP[loc_pos[0]][loc_pos[1]][loc_pos[2]];
+			psi = b*psi + coeff_nyP[loc_pos[0]][loc_pos[1]][loc_pos[2]] * (eng.GetVolt(nyPP,pos_shift) - eng.GetVolt(nyPP,pos));
+			curr_psi_nyP[loc_pos[0]][loc_pos[1]][loc_pos[2]] = psi;
+			eng.SetCurr(nyP, pos, eng.GetCurr(nyP,pos) + psi);
+
+			psi = curr_psi_nyPP[loc_pos[0]][loc_pos[1]][loc_pos[2]];
+			psi = b*psi + coeff_nyPP[loc_pos[0]][loc_pos[1]][loc_pos[2]] * (eng.GetVolt(nyP,pos_shift) - eng.GetVolt(nyP,pos));
+			curr_psi_nyPP[loc_pos[0]][loc_pos[1]][loc_pos[2]] = psi;
+			eng.SetCurr(nyPP, pos, eng.GetCurr(nyPP,pos) + psi);
+		}
+	}
+}
+
+void Engine_Ext_CPML::UpdateVoltagePsi_Packed(Engine_sse* eng, unsigned int startCol, unsigned int numCols)
+{
+	int ny = m_Op_CPML->m_ny;
+	int nyP = m_Op_CPML->m_nyP;
+	int nyPP = m_Op_CPML->m_nyPP;
+	const unsigned int* numLines = m_Op_CPML->m_numLines;
+	const unsigned int* start = m_Op_CPML->m_StartPos;
+
+	unsigned int pos[2];
+	unsigned int pos_shift[2];
+	unsigned int loc_pos[2];
+	f4vector b;
+	for (unsigned int col=startCol; col<startCol+numCols; ++col)
+	{
+		loc_pos[0] = col/numLines[1];
+		loc_pos[1] = col%numLines[1];
+		pos[0] = loc_pos[0] + start[0];
+		pos[1] = loc_pos[1] + start[1];
+		// the lower boundary has no current difference, the psi remains zero
+		if (pos[ny]==0)
+			continue;
+		pos_shift[0] = pos[0];
+		pos_shift[1] = pos[1];
+		--pos_shift[ny];
+
+		// the pml direction is x or y, the decay is the same for the whole column
+		b.f[0] = b.f[1] = b.f[2] = b.f[3] = m_Op_CPML->m_volt_b[loc_pos[ny]];
+
+		f4vector* psi_nyP = f4_volt_psi_nyP[loc_pos[0]][loc_pos[1]];
+		f4vector* psi_nyPP = f4_volt_psi_nyPP[loc_pos[0]][loc_pos[1]];
+		const f4vector* coeff_nyP = f4_volt_coeff[0][loc_pos[0]][loc_pos[1]];
+		const f4vector* coeff_nyPP = f4_volt_coeff[1][loc_pos[0]][loc_pos[1]];
+		f4vector* volt_nyP = eng->f4_volt[nyP][pos[0]][pos[1]];
+		f4vector* volt_nyPP = eng->f4_volt[nyPP][pos[0]][pos[1]];
+		const f4vector* curr_nyP = eng->f4_curr[nyP][pos[0]][pos[1]];
+		const f4vector* curr_nyPP = eng->f4_curr[nyPP][pos[0]][pos[1]];
+		const f4vector* curr_nyP_shift = eng->f4_curr[nyP][pos_shift[0]][pos_shift[1]];
+		const f4vector* curr_nyPP_shift = eng->f4_curr[nyPP][pos_shift[0]][pos_shift[1]];
+		for (unsigned int v=0; v<m_numVectors; ++v)
+		{
+			psi_nyP[v].v = b.v*psi_nyP[v].v + coeff_nyP[v].v * (curr_nyPP[v].v - curr_nyPP_shift[v].v);
+			volt_nyP[v].v = volt_nyP[v].v + psi_nyP[v].v;
+
+			psi_nyPP[v].v = b.v*psi_nyPP[v].v + coeff_nyPP[v].v * (curr_nyP[v].v - curr_nyP_shift[v].v);
+			volt_nyPP[v].v = volt_nyPP[v].v + psi_nyPP[v].v;
+		}
+	}
+}
+
+void Engine_Ext_CPML::UpdateCurrentPsi_Packed(Engine_sse* eng, unsigned int startCol, unsigned int numCols)
+{
+	int ny = m_Op_CPML->m_ny;
+	int nyP = m_Op_CPML->m_nyP;
+	int nyPP = m_Op_CPML->m_nyPP;
+	const unsigned int* numLines = m_Op_CPML->m_numLines;
+	const unsigned int* start = m_Op_CPML->m_StartPos;
+	unsigned int maxLines[2];
+	for (int n=0; n<2; ++n)
+		maxLines[n] = m_Op_CPML->m_Op->GetNumberOfLines(n,true)-1;
+
+	unsigned int pos[2];
+	unsigned int pos_shift[2];
+	unsigned int loc_pos[2];
+	f4vector b;
+	for (unsigned int col=startCol; col<startCol+numCols; ++col)
+	{
+		loc_pos[0] = col/numLines[1];
+		loc_pos[1] = col%numLines[1];
+		pos[0] = loc_pos[0] + start[0];
+		pos[1] = loc_pos[1] + start[1];
+		// the currents on the last lines are not updated by the engine, the coefficients of the last z-line are zero
+		if ((pos[0]>=maxLines[0]) || (pos[1]>=maxLines[1]))
+			continue;
+		pos_shift[0] = pos[0];
+		pos_shift[1] = pos[1];
+		++pos_shift[ny];
+
+		b.f[0] = b.f[1] = b.f[2] = b.f[3] = m_Op_CPML->m_curr_b[loc_pos[ny]];
+
+		f4vector* psi_nyP = f4_curr_psi_nyP[loc_pos[0]][loc_pos[1]];
+		f4vector* psi_nyPP = f4_curr_psi_nyPP[loc_pos[0]][loc_pos[1]];
+		const f4vector* coeff_nyP = f4_curr_coeff[0][loc_pos[0]][loc_pos[1]];
+		const f4vector* coeff_nyPP = f4_curr_coeff[1][loc_pos[0]][loc_pos[1]];
+		f4vector* curr_nyP = eng->f4_curr[nyP][pos[0]][pos[1]];
+		f4vector* curr_nyPP = eng->f4_curr[nyPP][pos[0]][pos[1]];
+		const f4vector* volt_nyP = eng->f4_volt[nyP][pos[0]][pos[1]];
+		const f4vector* volt_nyPP = eng->f4_volt[nyPP][pos[0]][pos[1]];
+		const f4vector* volt_nyP_shift = eng->f4_volt[nyP][pos_shift[0]][pos_shift[1]];
+		const f4vector* volt_nyPP_shift = eng->f4_volt[nyPP][pos_shift[0]][pos_shift[1]];
+		for (unsigned int v=0; v<m_numVectors; ++v)
+		{
+			psi_nyP[v].v = b.v*psi_nyP[v].v + coeff_nyP[v].v * (volt_nyPP_shift[v].v - volt_nyPP[v].v);
+			curr_nyP[v].v = curr_nyP[v].v + psi_nyP[v].v;
+
+			psi_nyPP[v].v = b.v*psi_nyPP[v].v + coeff_nyPP[v].v * (volt_nyP_shift[v].v - volt_nyP[v].v);
+			curr_nyPP[v].v = curr_nyPP[v].v + psi_nyPP[v].v;
+		}
+	}
+}
+
+void Engine_Ext_CPML::DoPostVoltageUpdates(int threadID)
+{
+	if (m_Eng==NULL)
+		return;
+	if (threadID>=m_NrThreads)
+		return;
+
+	//switch for different engine types to access faster inline engine functions
+	switch (m_Eng->GetType())
+	{
+	case Engine::BASIC:
+		{
+			Engine_Access_Basic acc = {m_Eng};
+			UpdateVoltagePsi(acc, m_start.at(threadID), m_numCols.at(threadID));
+			break;
+		}
+	case Engine::SSE:
+		{
+			if (f4_volt_psi_nyP)
+			{
+				UpdateVoltagePsi_Packed((Engine_sse*) m_Eng, m_start.at(threadID), m_numCols.at(threadID));
+				break;
+			}
+			Engine_Access_SSE acc = {(Engine_sse*) m_Eng};
+			UpdateVoltagePsi(acc, m_start.at(threadID), m_numCols.at(threadID));
+			break;
+		}
+	default:
+		{
+			Engine_Access_Virtual acc = {m_Eng};
+			UpdateVoltagePsi(acc, m_start.at(threadID), m_numCols.at(threadID));
+			break;
+		}
+	}
+}
+
+void Engine_Ext_CPML::DoPostCurrentUpdates(int threadID)
+{
+	if (m_Eng==NULL)
+		return;
+	if (threadID>=m_NrThreads)
+		return;
+
+	//switch for different engine types to access faster inline engine functions
+	switch (m_Eng->GetType())
+	{
+	case Engine::BASIC:
+		{
+			Engine_Access_Basic acc = {m_Eng};
+			UpdateCurrentPsi(acc, m_start.at(threadID), m_numCols.at(threadID));
+			break;
+		}
+	case Engine::SSE:
+		{
+			if (f4_volt_psi_nyP)
+			{
+				UpdateCurrentPsi_Packed((Engine_sse*) m_Eng, m_start.at(threadID), m_numCols.at(threadID));
+				break;
+			}
+			Engine_Access_SSE acc = {(Engine_sse*) m_Eng};
+			UpdateCurrentPsi(acc, m_start.at(threadID), m_numCols.at(threadID));
+			break;
+		}
+	default:
+		{
+			Engine_Access_Virtual acc = {m_Eng};
+			UpdateCurrentPsi(acc, m_start.at(threadID), m_numCols.at(threadID));
+			break;
+		}
+	}
+}
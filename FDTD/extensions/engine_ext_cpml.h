@@ -0,0 +1,87 @@
+/*
+*	Copyright (C) 2026 agent (agent@local)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINE_EXT_CPML_H
+#define ENGINE_EXT_CPML_H
+
+#include "engine_extension.h"
+#include "FDTD/engine.h"
+#include "FDTD/operator.h"
+#include "tools/array_ops.h"
+
+class Operator_Ext_CPML;
+class Engine_sse;
+
+class Engine_Ext_CPML : public Engine_Extension
+{
+public:
+	Engine_Ext_CPML(Operator_Ext_CPML* op_ext);
+	virtual ~Engine_Ext_CPML();
+
+	virtual void SetNumberOfThreads(int nrThread);
+
+	//! Set the engine, a sse engine will use the packed psi and coefficient storage if possible
+	virtual void SetEngine(Engine* eng);
+
+	virtual void DoPostVoltageUpdates() {Engine_Ext_CPML::DoPostVoltageUpdates(0);};
+	virtual void DoPostVoltageUpdates(int threadID);
+
+	virtual void DoPostCurrentUpdates() {Engine_Ext_CPML::DoPostCurrentUpdates(0);};
+	virtual void DoPostCurrentUpdates(int threadID);
+
+protected:
+	Operator_Ext_CPML* m_Op_CPML;
+
+	//! Add the voltage psi of the given (x,y)-columns, \a Access provides the (fast) field access of the engine type
+	template <class Access>
+	void UpdateVoltagePsi(Access eng, unsigned int startCol, unsigned int numCols);
+	//! Add the current psi of the given (x,y)-columns, \a Access provides the (fast) field access of the engine type
+	template <class Access>
+	void UpdateCurrentPsi(Access eng, unsigned int startCol, unsigned int numCols);
+
+	//! Add the voltage psi of the given (x,y)-columns using the packed sse storage
+	void UpdateVoltagePsi_Packed(Engine_sse* eng, unsigned int startCol, unsigned int numCols);
+	//! Add the current psi of the given (x,y)-columns using the packed sse storage
+	void UpdateCurrentPsi_Packed(Engine_sse* eng, unsigned int startCol, unsigned int numCols);
+
+	//! Create the packed sse storage, only possible if the cpml covers the full z-range of the sse engine (pml in x- or y-direction)
+	void InitPackedStorage();
+	//! Delete the packed sse storage
+	void DeletePackedStorage();
+
+	//! first (x,y)-column of the cpml box for each thread, the columns are numbered x*numLines[1]+y
+	vector<unsigned int> m_start;
+	//! number of (x,y)-columns for each thread
+	vector<unsigned int> m_numCols;
+
+	//! psi of the voltages and currents in nyP and nyPP direction (voltages/currents multiplied by the vi/iv operator)
+	FDTD_FLOAT*** volt_psi_nyP;
+	FDTD_FLOAT*** volt_psi_nyPP;
+	FDTD_FLOAT*** curr_psi_nyP;
+	FDTD_FLOAT*** curr_psi_nyPP;
+
+	//! psi and update coefficients in the packed layout of the sse engine, NULL if not used
+	unsigned int m_numVectors;
+	f4vector*** f4_volt_psi_nyP;
+	f4vector*** f4_volt_psi_nyPP;
+	f4vector*** f4_curr_psi_nyP;
+	f4vector*** f4_curr_psi_nyPP;
+	f4vector*** f4_volt_coeff[2];
+	f4vector*** f4_curr_coeff[2];
+};
+
+#endif // ENGINE_EXT_CPML_H
@@ -19,6 +19,7 @@
 #include "engine_ext_cylinder.h"
 #include "operator_ext_cylinder.h"
 #include "FDTD/engine_sse.h"
+#include "tools/useful.h"
 
 Engine_Ext_Cylinder::Engine_Ext_Cylinder(Operator_Ext_Cylinder* op_ext) : Engine_Extension(op_ext)
 {
@@ -31,71 +32,156 @@ Engine_Ext_Cylinder::Engine_Ext_Cylinder(Operator_Ext_Cylinder* op_ext) : Engine
 	for (int n=0; n<3; ++n)
 		numLines[n] = op_ext->m_Op->GetNumberOfLines(n,true);
 
+	m_numVectors = 0;
+	m_f4_vv_R0 = NULL;
+	m_f4_vi_R0 = NULL;
+
 	//this cylindrical extension should be executed first?
 	m_Priority = ENG_EXT_PRIO_CYLINDER;
+
+	SetNumberOfThreads(1);
+}
+
+Engine_Ext_Cylinder::~Engine_Ext_Cylinder()
+{
+	Delete1DArray_v4sf(m_f4_vv_R0);
+	m_f4_vv_R0 = NULL;
+	Delete1DArray_v4sf(m_f4_vi_R0);
+	m_f4_vi_R0 = NULL;
+}
+
+void Engine_Ext_Cylinder::SetNumberOfThreads(int nrThread)
+{
+	Engine_Extension::SetNumberOfThreads(nrThread);
+	AssignJobs();
+}
+
+void Engine_Ext_Cylinder::AssignJobs()
+{
+	// the r=0 update is split along z, the alpha-closure over all (r,vector) pairs
+	// if r=0 is included, its voltage alpha-closure is done by the thread owning the r=0 vectors
+	unsigned int firstR = CC_R0_included ? 1 : 0;
+	vector<unsigned int> jpt[3];
+	jpt[0] = AssignJobs2Threads(m_numVectors,m_NrThreads,false);
+	jpt[1] = AssignJobs2Threads((numLines[0]-firstR)*m_numVectors,m_NrThreads,false);
+	jpt[2] = AssignJobs2Threads((numLines[0]-1)*m_numVectors,m_NrThreads,false);
+	vector<unsigned int>* start[3] = {&m_R0_start, &m_volt_start, &m_curr_start};
+	vector<unsigned int>* num[3] = {&m_R0_num, &m_volt_num, &m_curr_num};
+	for (int n=0; n<3; ++n)
+	{
+		*num[n] = jpt[n];
+		start[n]->resize(m_NrThreads,0);
+		start[n]->at(0) = (n==1) ? firstR*m_numVectors : 0;
+		for (size_t t=1; t<jpt[n].size(); ++t)
+			start[n]->at(t) = start[n]->at(t-1) + jpt[n].at(t-1);
+	}
 }
 
 void Engine_Ext_Cylinder::SetEngine(Engine* eng)
 {
 	Engine_Extension::SetEngine(eng);
 	m_Eng_SSE = dynamic_cast<Engine_sse*>(m_Eng);
+
+	Delete1DArray_v4sf(m_f4_vv_R0);
+	m_f4_vv_R0 = NULL;
+	Delete1DArray_v4sf(m_f4_vi_R0);
+	m_f4_vi_R0 = NULL;
+	m_numVectors = 0;
+	if (m_Eng_SSE)
+		m_numVectors = m_Eng_SSE->GetNumberOfVectors();
+
+	if (CC_R0_included && (m_numVectors>0))
+	{
+		// pack the r=0 operator, the padding elements remain zero
+		m_f4_vv_R0 = Create1DArray_v4sf(m_numVectors);
+		m_f4_vi_R0 = Create1DArray_v4sf(m_numVectors);
+		for (unsigned int z=0; z<numLines[2]; ++z)
+		{
+			m_f4_vv_R0[z%m_numVectors].f[z/m_numVectors] = cyl_Op->vv_R0[z];
+			m_f4_vi_R0[z%m_numVectors].f[z/m_numVectors] = cyl_Op->vi_R0[z];
+		}
+	}
+	AssignJobs();
 }
 
-void Engine_Ext_Cylinder::DoPostVoltageUpdates()
+void Engine_Ext_Cylinder::DoPostVoltageUpdates(int threadID)
 {
 	if (CC_closedAlpha==false) return;
+	if (m_Eng_SSE==NULL) return;
+	if (threadID>=m_NrThreads)
+		return;
+
+	f4vector**** f4_volt = m_Eng_SSE->f4_volt;
+	f4vector**** f4_curr = m_Eng_SSE->f4_curr;
+	unsigned int last_A_Line = numLines[1]-2;
+	f4vector f4_sum;
+	f4vector f4_zero;
+	f4_zero.f[0] = f4_zero.f[1] = f4_zero.f[2] = f4_zero.f[3] = 0;
 
 	if (CC_R0_included)
 	{
-		unsigned int pos[3];
-		pos[0] = 0;
-		FDTD_FLOAT volt=0;
-		for (pos[2]=0; pos[2]<numLines[2]; ++pos[2])
+		for (unsigned int v=m_R0_start.at(threadID); v<m_R0_start.at(threadID)+m_R0_num.at(threadID); ++v)
 		{
-			volt =m_Eng_SSE->Engine_sse::GetVolt(2,0,0,pos[2])*cyl_Op->vv_R0[pos[2]];
-			for (pos[1]=0; pos[1]<numLines[1]-1; ++pos[1])
-				volt +=cyl_Op->vi_R0[pos[2]] *  m_Eng_SSE->Engine_sse::GetCurr(1,0,pos[1],pos[2]);
-			m_Eng_SSE->Engine_sse::SetVolt(2,0,0,pos[2], volt);
-		}
+			// sum of all alpha-currents around the z-axis
+			f4_sum.v = f4_curr[1][0][0][v].v;
+			for (unsigned int a=1; a<numLines[1]-1; ++a)
+				f4_sum.v += f4_curr[1][0][a][v].v;
+			f4_volt[2][0][0][v].v = f4_volt[2][0][0][v].v * m_f4_vv_R0[v].v + m_f4_vi_R0[v].v * f4_sum.v;
 
-		for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
-		{
-			for (pos[2]=0; pos[2]<numLines[2]; ++pos[2])
+			for (unsigned int a=0; a<numLines[1]; ++a)
 			{
-				m_Eng_SSE->Engine_sse::SetVolt(1,0,pos[1],pos[2], 0); //no voltage in alpha-direction at r=0
-				m_Eng_SSE->Engine_sse::SetVolt(2,0,pos[1],pos[2], m_Eng_SSE->Engine_sse::GetVolt(2,0,0,pos[2]) );
+				f4_volt[1][0][a][v].v = f4_zero.v; //no voltage in alpha-direction at r=0
+				f4_volt[2][0][a][v].v = f4_volt[2][0][0][v].v;
 			}
+
+			//close alpha at r=0
+			f4_volt[0][0][0][v].v = f4_volt[0][0][last_A_Line][v].v;
 		}
 	}
 
 	//close alpha
-	unsigned int pos[3];
 	// copy tangential voltages from last alpha-plane to first
-	unsigned int last_A_Line = numLines[1]-2;
-	for (pos[0]=0; pos[0]<numLines[0]; ++pos[0])
+	for (unsigned int k=m_volt_start.at(threadID); k<m_volt_start.at(threadID)+m_volt_num.at(threadID); ++k)
 	{
-		for (pos[2]=0; pos[2]<numLines[2]; ++pos[2])
-		{
-			m_Eng_SSE->Engine_sse::SetVolt(0,pos[0],0,pos[2], m_Eng_SSE->Engine_sse::GetVolt(0,pos[0],last_A_Line,pos[2]) );
-			m_Eng_SSE->Engine_sse::SetVolt(2,pos[0],0,pos[2], m_Eng_SSE->Engine_sse::GetVolt(2,pos[0],last_A_Line,pos[2]) );
-		}
+		unsigned int r = k/m_numVectors;
+		unsigned int v = k%m_numVectors;
+		f4_volt[0][r][0][v].v = f4_volt[0][r][last_A_Line][v].v;
+		f4_volt[2][r][0][v].v = f4_volt[2][r][last_A_Line][v].v;
 	}
 }
 
-void Engine_Ext_Cylinder::DoPostCurrentUpdates()
+void Engine_Ext_Cylinder::DoPostCurrentUpdates(int threadID)
 {
 	if (CC_closedAlpha==false) return;
+	if (m_Eng_SSE==NULL) return;
+	if (threadID>=m_NrThreads)
+		return;
+
+	f4vector**** f4_curr = m_Eng_SSE->f4_curr;
+	unsigned int last_A_Line = numLines[1]-2;
+
+	// the currents of the last z-line are not copied, keep them in the vector which contains them
+	unsigned int lastZ_vec = (numLines[2]-1)%m_numVectors;
+	unsigned int lastZ_elem = (numLines[2]-1)/m_numVectors;
+	FDTD_FLOAT lastZ_curr[2];
 
 	//close alpha
-	unsigned int pos[3];
 	// copy tangential currents from first alpha-plane to last
-	for (pos[0]=0; pos[0]<numLines[0]-1; ++pos[0])
+	for (unsigned int k=m_curr_start.at(threadID); k<m_curr_start.at(threadID)+m_curr_num.at(threadID); ++k)
 	{
-		unsigned int last_A_Line = numLines[1]-2;
-		for (pos[2]=0; pos[2]<numLines[2]-1; ++pos[2])
+		unsigned int r = k/m_numVectors;
+		unsigned int v = k%m_numVectors;
+		if (v==lastZ_vec)
+		{
+			lastZ_curr[0] = f4_curr[0][r][last_A_Line][v].f[lastZ_elem];
+			lastZ_curr[1] = f4_curr[2][r][last_A_Line][v].f[lastZ_elem];
+		}
+		f4_curr[0][r][last_A_Line][v].v = f4_curr[0][r][0][v].v;
+		f4_curr[2][r][last_A_Line][v].v = f4_curr[2][r][0][v].v;
+		if (v==lastZ_vec)
 		{
-			m_Eng_SSE->Engine_sse::SetCurr(0,pos[0],last_A_Line,pos[2], m_Eng_SSE->Engine_sse::GetCurr(0,pos[0],0,pos[2]) );
-			m_Eng_SSE->Engine_sse::SetCurr(2,pos[0],last_A_Line,pos[2], m_Eng_SSE->Engine_sse::GetCurr(2,pos[0],0,pos[2]) );
+			f4_curr[0][r][last_A_Line][v].f[lastZ_elem] = lastZ_curr[0];
+			f4_curr[2][r][last_A_Line][v].f[lastZ_elem] = lastZ_curr[1];
 		}
 	}
 }
@@ -21,6 +21,7 @@
 #include "FDTD/engine.h"
 #include "engine_extension.h"
 #include "FDTD/operator_cylinder.h"
+#include "tools/array_ops.h"
 
 class Operator_Ext_Cylinder;
 class Engine_sse;
@@ -29,10 +30,15 @@ class Engine_Ext_Cylinder : public Engine_Extension
 {
 public:
 	Engine_Ext_Cylinder(Operator_Ext_Cylinder* op_ext);
+	virtual ~Engine_Ext_Cylinder();
 
-	virtual void DoPostVoltageUpdates();
+	virtual void SetNumberOfThreads(int nrThread);
 
-	virtual void DoPostCurrentUpdates();
+	virtual void DoPostVoltageUpdates() {Engine_Ext_Cylinder::DoPostVoltageUpdates(0);}
+	virtual void DoPostVoltageUpdates(int threadID);
+
+	virtual void DoPostCurrentUpdates() {Engine_Ext_Cylinder::DoPostCurrentUpdates(0);}
+	virtual void DoPostCurrentUpdates(int threadID);
 
 	virtual void SetEngine(Engine* eng);
 
@@ -44,6 +50,25 @@ protected:
 
 	bool CC_closedAlpha;
 	bool CC_R0_included;
+
+	//! number of sse vectors in z-direction of the engine
+	unsigned int m_numVectors;
+	//! the r=0 operator packed into sse vectors in z-direction, the padding elements are zero
+	f4vector* m_f4_vv_R0;
+	f4vector* m_f4_vi_R0;
+
+	//! Distribute the r=0 vectors and the alpha-closure (r,vector) pairs to the threads
+	void AssignJobs();
+
+	//! first and number of z-vectors of the r=0 update for each thread
+	vector<unsigned int> m_R0_start;
+	vector<unsigned int> m_R0_num;
+	//! first and number of voltage alpha-closure (r,vector) pairs for each thread, numbered r*m_numVectors+vector
+	vector<unsigned int> m_volt_start;
+	vector<unsigned int> m_volt_num;
+	//! first and number of current alpha-closure (r,vector) pairs for each thread, numbered r*m_numVectors+vector
+	vector<unsigned int> m_curr_start;
+	vector<unsigned int> m_curr_num;
 };
 
 #endif // ENGINE_CYLINDER_H
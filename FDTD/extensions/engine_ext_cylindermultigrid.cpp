@@ -32,13 +32,6 @@ Engine_Ext_CylinderMultiGrid::~Engine_Ext_CylinderMultiGrid()
 {
 }
 
-void Engine_Ext_CylinderMultiGrid::SetBarrier(boost::barrier* waitBase, boost::barrier* waitChild, boost::barrier* waitSync)
-{
-	m_WaitOnBase = waitBase;
-	m_WaitOnChild = waitChild;
-	m_WaitOnSync = waitSync;
-}
-
 void Engine_Ext_CylinderMultiGrid::SetEngine(Engine* eng)
 {
 	m_Eng_MG = dynamic_cast<Engine_CylinderMultiGrid*>(eng);
@@ -49,38 +42,37 @@ void Engine_Ext_CylinderMultiGrid::SetEngine(Engine* eng)
 	}
 }
 
-void Engine_Ext_CylinderMultiGrid::DoPreVoltageUpdates()
+void Engine_Ext_CylinderMultiGrid::GetSyncJobs(unsigned int numJobs, unsigned int syncID, unsigned int &start, unsigned int &stop) const
 {
-	//cerr << "Engine_Ext_CylinderMultiGrid::DoPreVoltageUpdates() for " << m_IsBase << endl;
-	if (!m_IsBase)
+	// with alternating levels only the base engine threads interpolate, the number of working threads does not change
+	unsigned int numSync = AlternateLevels() ? m_Eng_MG->m_numThreads : m_Eng_MG->m_SyncThreads;
+	if (syncID>=numSync)
 	{
-		//cerr << "child: volt wait on base " << endl;
-		m_WaitOnBase->wait(); //wait on base to finish current sync and/or to finish voltage updates, than start child voltage updates
+		start = stop = 0;
+		return;
 	}
+	start = (numJobs*syncID)/numSync;
+	stop = (numJobs*(syncID+1))/numSync;
 }
 
-void Engine_Ext_CylinderMultiGrid::DoPostVoltageUpdates()
+void Engine_Ext_CylinderMultiGrid::DoPreVoltageUpdates(int threadID)
 {
-
+	UNUSED(threadID);
+	if (!m_IsBase && AlternateLevels())
+		m_Eng_MG->m_TurnBarrier->wait();	//wait for the base to finish its voltage updates
 }
 
-void Engine_Ext_CylinderMultiGrid::Apply2Voltages()
+void Engine_Ext_CylinderMultiGrid::Apply2Voltages(int threadID)
 {
-	if (m_IsBase)
-	{
-		m_WaitOnBase->wait();	//base voltage updates are done, tell child to start its voltage updates
-		m_WaitOnChild->wait();	//wait for child to finish its updates
-		SyncVoltages();			//child is finish, run sync and go to current updates next
-		m_WaitOnSync->wait();	//sync is done... move on and tell child to move on...
-	}
-	else
-	{
-		m_WaitOnChild->wait();	//child is finished voltage updates, will tell base to run sync
-		m_WaitOnSync->wait();	//wait for base to finish sync before going to wait for current updates
-	}
+	unsigned int syncID = m_Eng_MG->GetSyncThreadID(m_IsBase, threadID);
+	if (m_IsBase && AlternateLevels())
+		m_Eng_MG->m_TurnBarrier->wait();	//base voltage updates are done, tell the child to start its voltage updates
+	m_Eng_MG->m_SyncBarrier->wait();	//base and child voltage updates are done
+	SyncVoltages(syncID);
+	m_Eng_MG->m_SyncBarrier->wait();	//sync is done... move on to the current updates
 }
 
-void Engine_Ext_CylinderMultiGrid::SyncVoltages()
+void Engine_Ext_CylinderMultiGrid::SyncVoltages(unsigned int syncID)
 {
 	if (m_Eng_MG==NULL)
 	{
@@ -101,9 +93,13 @@ void Engine_Ext_CylinderMultiGrid::SyncVoltages()
 	v_null.f[1] = 0;
 	v_null.f[2] = 0;
 	v_null.f[3] = 0;
-	for (pos[1]=0; pos[1]<numLines[1]-1; pos[1]+=2)
+
+	// every child alpha-line is synced from two base alpha-lines
+	unsigned int start, stop;
+	GetSyncJobs(numLines[1]/2, syncID, start, stop);
+	for (pos1_half=start; pos1_half<stop; ++pos1_half)
 	{
-		pos1_half = pos[1]/2;
+		pos[1] = 2*pos1_half;
 		for (pos[2]=0; pos[2]<m_Eng_MG->numVectors; ++pos[2])
 		{
 			//r - direczion
@@ -119,40 +115,27 @@ void Engine_Ext_CylinderMultiGrid::SyncVoltages()
 	}
 }
 
-void Engine_Ext_CylinderMultiGrid::DoPreCurrentUpdates()
+void Engine_Ext_CylinderMultiGrid::DoPreCurrentUpdates(int threadID)
 {
-	//cerr << "Engine_Ext_CylinderMultiGrid::DoPreCurrentUpdates() for " << m_IsBase << endl;
-	if (!m_IsBase)
-	{
-		//cerr << "child: curr wait on base " << endl;
-		m_WaitOnBase->wait(); //wait on base to finish voltage sync and current updates, than start child current updates
-	}
+	UNUSED(threadID);
+	if (!m_IsBase && AlternateLevels())
+		m_Eng_MG->m_TurnBarrier->wait();	//wait for the base to finish its current updates
 }
 
-void Engine_Ext_CylinderMultiGrid::DoPostCurrentUpdates()
+void Engine_Ext_CylinderMultiGrid::Apply2Current(int threadID)
 {
-
+	unsigned int syncID = m_Eng_MG->GetSyncThreadID(m_IsBase, threadID);
+	bool lastTS = m_Eng_MG->IsLastTimestep();
+	if (m_IsBase && AlternateLevels())
+		m_Eng_MG->m_TurnBarrier->wait();	//base current updates are done, tell the child to start its current updates
+	m_Eng_MG->m_SyncBarrier->wait();	//base and child current updates are done
+	SyncCurrents(syncID);
+	if (lastTS)
+		InterpolChild2Base(syncID);
+	m_Eng_MG->m_SyncBarrier->wait();	//sync is done... move on to the next voltage updates
 }
 
-void Engine_Ext_CylinderMultiGrid::Apply2Current()
-{
-	if (m_IsBase)
-	{
-		//cerr << "Base: curr wait on base done, wait on sync" << endl;
-		m_WaitOnBase->wait();	//base current updates are done, tell child to start its current updates
-		m_WaitOnChild->wait();	//wait for child to finish its updates
-		SyncCurrents();			//child is finish, run sync and go to voltage updates next
-		m_WaitOnSync->wait();	//sync is done... move on and tell child to move on...
-	}
-	else
-	{
-		m_WaitOnChild->wait();	//child is finished current updates, will tell base to run sync...
-		m_WaitOnSync->wait();	//wait for base to finish sync before going to wait for next voltage updates
-		//cerr << "Child: curr done, wait on sync" << endl;
-	}
-}
-
-void Engine_Ext_CylinderMultiGrid::SyncCurrents()
+void Engine_Ext_CylinderMultiGrid::SyncCurrents(unsigned int syncID)
 {
 	if (m_Eng_MG==NULL)
 	{
@@ -160,6 +143,32 @@ void Engine_Ext_CylinderMultiGrid::SyncCurrents()
 		return;
 	}
 
-	m_Eng_MG->InterpolCurrChild2Base(m_Eng_MG->Op_CMG->GetSplitPos()-2);
+	unsigned int start, stop;
+	GetSyncJobs(m_Eng_MG->numLines[1], syncID, start, stop);
+	m_Eng_MG->InterpolCurrChild2Base(m_Eng_MG->Op_CMG->GetSplitPos()-2, start, stop-start);
 	return;
 }
+
+void Engine_Ext_CylinderMultiGrid::InterpolChild2Base(unsigned int syncID)
+{
+	// distribute all (r,alpha)-lines of the child grid
+	unsigned int numA = m_Eng_MG->numLines[1];
+	unsigned int numR[2] = {m_Eng_MG->Op_CMG->GetSplitPos()-1, m_Eng_MG->Op_CMG->GetSplitPos()-2};
+	for (int n=0; n<2; ++n)
+	{
+		unsigned int start, stop;
+		GetSyncJobs(numR[n]*numA, syncID, start, stop);
+		unsigned int k = start;
+		while (k<stop)
+		{
+			unsigned int r = k/numA;
+			unsigned int a = k%numA;
+			unsigned int num = min(numA-a, stop-k);
+			if (n==0)
+				m_Eng_MG->InterpolVoltChild2Base(r, a, num);
+			else
+				m_Eng_MG->InterpolCurrChild2Base(r, a, num);
+			k += num;
+		}
+	}
+}
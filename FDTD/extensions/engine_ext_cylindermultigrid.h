@@ -24,33 +24,48 @@
 
 class Operator_Ext_CylinderMultiGrid;
 
+//! Engine extension syncing a base and child grid of the cylindrical multi-grid
+/*!
+  The base and child engine update their fields concurrently, each with its own share of the threads.
+  Afterwards all threads of both engines meet at a common barrier and interpolate between the grids in parallel.
+  With alternating levels (see Operator_CylinderMultiGrid::AlternateLevels) the child engine waits for the base engine to finish its updates
+  and the base engine threads interpolate alone, only one engine is working at a time.
+  */
 class Engine_Ext_CylinderMultiGrid : public Engine_Extension
 {
 public:
 	Engine_Ext_CylinderMultiGrid(Operator_Extension* op_ext, bool isBase);
 	virtual ~Engine_Ext_CylinderMultiGrid();
 
-	void SetBarrier(boost::barrier* waitBase, boost::barrier* waitChild, boost::barrier* waitSync);
+	virtual void DoPreVoltageUpdates() {Engine_Ext_CylinderMultiGrid::DoPreVoltageUpdates(0);}
+	virtual void DoPreVoltageUpdates(int threadID);
 
-	virtual void DoPreVoltageUpdates();
-	virtual void DoPostVoltageUpdates();
-	virtual void Apply2Voltages();
+	virtual void Apply2Voltages() {Engine_Ext_CylinderMultiGrid::Apply2Voltages(0);}
+	virtual void Apply2Voltages(int threadID);
 
-	virtual void DoPreCurrentUpdates();
-	virtual void DoPostCurrentUpdates();
-	virtual void Apply2Current();
+	virtual void DoPreCurrentUpdates() {Engine_Ext_CylinderMultiGrid::DoPreCurrentUpdates(0);}
+	virtual void DoPreCurrentUpdates(int threadID);
 
+	virtual void Apply2Current() {Engine_Ext_CylinderMultiGrid::Apply2Current(0);}
+	virtual void Apply2Current(int threadID);
+
+	//! Set the base engine of the multi-grid, for the base and the child extension
 	virtual void SetEngine(Engine* eng);
 
 protected:
-	void SyncVoltages();
-	void SyncCurrents();
+	//! Is the child engine waiting for the base engine (alternating levels)?
+	bool AlternateLevels() const {return m_Eng_MG->Op_CMG->AlternateLevels();}
 
-	Engine_CylinderMultiGrid* m_Eng_MG;
+	//! Get the range [\a start, \a stop) of \a numJobs jobs for the given sync thread
+	void GetSyncJobs(unsigned int numJobs, unsigned int syncID, unsigned int &start, unsigned int &stop) const;
+
+	void SyncVoltages(unsigned int syncID);
+	void SyncCurrents(unsigned int syncID);
 
-	boost::barrier *m_WaitOnBase;
-	boost::barrier *m_WaitOnChild;
-	boost::barrier *m_WaitOnSync;
+	//! Interpolate all child voltages and currents to the base engine
+	void InterpolChild2Base(unsigned int syncID);
+
+	Engine_CylinderMultiGrid* m_Eng_MG;
 
 	bool m_IsBase;
 };
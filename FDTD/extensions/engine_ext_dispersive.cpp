@@ -17,11 +17,13 @@
 
 #include "engine_ext_dispersive.h"
 #include "operator_ext_dispersive.h"
-#include "FDTD/engine_sse.h"
+#include "engine_field_access.h"
+#include <algorithm>
 
 Engine_Ext_Dispersive::Engine_Ext_Dispersive(Operator_Ext_Dispersive* op_ext_disp) : Engine_Extension(op_ext_disp)
 {
 	m_Op_Ext_Disp = op_ext_disp;
+	m_Folded = false;
 	int order = m_Op_Ext_Disp->m_Order;
 	curr_ADE = new FDTD_FLOAT**[order];
 	volt_ADE = new FDTD_FLOAT**[order];
@@ -49,6 +51,8 @@ Engine_Ext_Dispersive::Engine_Ext_Dispersive(Operator_Ext_Dispersive* op_ext_dis
 				volt_ADE[o][n] = NULL;
 		}
 	}
+
+	SetNumberOfThreads(1);
 }
 
 Engine_Ext_Dispersive::~Engine_Ext_Dispersive()
@@ -73,90 +77,147 @@ Engine_Ext_Dispersive::~Engine_Ext_Dispersive()
 	volt_ADE=NULL;
 }
 
-void Engine_Ext_Dispersive::Apply2Voltages()
+void Engine_Ext_Dispersive::SetNumberOfThreads(int nrThread)
 {
+	Engine_Extension::SetNumberOfThreads(nrThread);
+
+	// count the dispersive cells of all orders per x-line, the cells are sorted by x (see Operator_Ext_LorentzMaterial::BuildExtension)
+	vector<unsigned int> cellsPerX;
+	unsigned int numCells = 0;
+	for (int o=0;o<m_Op_Ext_Disp->m_Order;++o)
+	{
+		unsigned int* pos_x = m_Op_Ext_Disp->m_LM_pos[o][0];
+		for (unsigned int i=0; i<m_Op_Ext_Disp->m_LM_Count.at(o); ++i)
+		{
+			if (pos_x[i]>=cellsPerX.size())
+				cellsPerX.resize(pos_x[i]+1,0);
+			++cellsPerX[pos_x[i]];
+			++numCells;
+		}
+	}
+
+	// assign contiguous x-ranges with about the same number of cells to each thread
+	vector<unsigned int> stopX(m_NrThreads,cellsPerX.size());
+	unsigned int x = 0;
+	double sum = 0;
+	for (int t=0; t<m_NrThreads-1; ++t)
+	{
+		double target = (double)numCells*(t+1)/m_NrThreads;
+		while ((x<cellsPerX.size()) && (sum<target))
+			sum += cellsPerX[x++];
+		stopX[t] = x;
+	}
+
+	m_cellStart.resize(m_Op_Ext_Disp->m_Order);
+	m_cellStop.resize(m_Op_Ext_Disp->m_Order);
+	for (int o=0;o<m_Op_Ext_Disp->m_Order;++o)
+	{
+		unsigned int* pos_x = m_Op_Ext_Disp->m_LM_pos[o][0];
+		unsigned int count = m_Op_Ext_Disp->m_LM_Count.at(o);
+		m_cellStart[o].resize(m_NrThreads);
+		m_cellStop[o].resize(m_NrThreads);
+		for (int t=0; t<m_NrThreads; ++t)
+		{
+			m_cellStart[o][t] = (t==0) ? 0 : m_cellStop[o][t-1];
+			m_cellStop[o][t] = lower_bound(pos_x, pos_x+count, stopX[t]) - pos_x;
+		}
+	}
+}
+
+template <class Access>
+void Engine_Ext_Dispersive::ApplyVoltageADE(Access eng, int order, unsigned int start, unsigned int stop)
+{
+	unsigned int **pos = m_Op_Ext_Disp->m_LM_pos[order];
+	for (unsigned int i=start; i<stop; ++i)
+	{
+		eng.SetVolt(0,pos[0][i],pos[1][i],pos[2][i], eng.GetVolt(0,pos[0][i],pos[1][i],pos[2][i]) - volt_ADE[order][0][i]);
+		eng.SetVolt(1,pos[0][i],pos[1][i],pos[2][i], eng.GetVolt(1,pos[0][i],pos[1][i],pos[2][i]) - volt_ADE[order][1][i]);
+		eng.SetVolt(2,pos[0][i],pos[1][i],pos[2][i], eng.GetVolt(2,pos[0][i],pos[1][i],pos[2][i]) - volt_ADE[order][2][i]);
+	}
+}
+
+template <class Access>
+void Engine_Ext_Dispersive::ApplyCurrentADE(Access eng, int order, unsigned int start, unsigned int stop)
+{
+	unsigned int **pos = m_Op_Ext_Disp->m_LM_pos[order];
+	for (unsigned int i=start; i<stop; ++i)
+	{
+		eng.SetCurr(0,pos[0][i],pos[1][i],pos[2][i], eng.GetCurr(0,pos[0][i],pos[1][i],pos[2][i]) - curr_ADE[order][0][i]);
+		eng.SetCurr(1,pos[0][i],pos[1][i],pos[2][i], eng.GetCurr(1,pos[0][i],pos[1][i],pos[2][i]) - curr_ADE[order][1][i]);
+		eng.SetCurr(2,pos[0][i],pos[1][i],pos[2][i], eng.GetCurr(2,pos[0][i],pos[1][i],pos[2][i]) - curr_ADE[order][2][i]);
+	}
+}
+
+void Engine_Ext_Dispersive::Apply2Voltages(int threadID)
+{
+	if (m_Folded || (threadID>=m_NrThreads))
+		return;
+
 	for (int o=0;o<m_Op_Ext_Disp->m_Order;++o)
 	{
 		if (m_Op_Ext_Disp->m_volt_ADE_On[o]==false) continue;
 
-		unsigned int **pos = m_Op_Ext_Disp->m_LM_pos[o];
+		unsigned int start = m_cellStart[o][threadID];
+		unsigned int stop = m_cellStop[o][threadID];
 
 		//switch for different engine types to access faster inline engine functions
 		switch (m_Eng->GetType())
 		{
 		case Engine::BASIC:
 		{
-			for (unsigned int i=0; i<m_Op_Ext_Disp->m_LM_Count.at(o); ++i)
-			{
-				m_Eng->Engine::SetVolt(0,pos[0][i],pos[1][i],pos[2][i], m_Eng->Engine::GetVolt(0,pos[0][i],pos[1][i],pos[2][i]) - volt_ADE[o][0][i]);
-				m_Eng->Engine::SetVolt(1,pos[0][i],pos[1][i],pos[2][i], m_Eng->Engine::GetVolt(1,pos[0][i],pos[1][i],pos[2][i]) - volt_ADE[o][1][i]);
-				m_Eng->Engine::SetVolt(2,pos[0][i],pos[1][i],pos[2][i], m_Eng->Engine::GetVolt(2,pos[0][i],pos[1][i],pos[2][i]) - volt_ADE[o][2][i]);
-			}
+			Engine_Access_Basic acc = {m_Eng};
+			ApplyVoltageADE(acc, o, start, stop);
 			break;
 		}
 		case Engine::SSE:
 		{
-			Engine_sse* eng_sse = (Engine_sse*)m_Eng;
-			for (unsigned int i=0; i<m_Op_Ext_Disp->m_LM_Count.at(o); ++i)
-			{
-				eng_sse->Engine_sse::SetVolt(0,pos[0][i],pos[1][i],pos[2][i], eng_sse->Engine_sse::GetVolt(0,pos[0][i],pos[1][i],pos[2][i]) - volt_ADE[o][0][i]);
-				eng_sse->Engine_sse::SetVolt(1,pos[0][i],pos[1][i],pos[2][i], eng_sse->Engine_sse::GetVolt(1,pos[0][i],pos[1][i],pos[2][i]) - volt_ADE[o][1][i]);
-				eng_sse->Engine_sse::SetVolt(2,pos[0][i],pos[1][i],pos[2][i], eng_sse->Engine_sse::GetVolt(2,pos[0][i],pos[1][i],pos[2][i]) - volt_ADE[o][2][i]);
-			}
+			Engine_Access_SSE acc = {(Engine_sse*)m_Eng};
+			ApplyVoltageADE(acc, o, start, stop);
 			break;
 		}
 		default:
-			for (unsigned int i=0; i<m_Op_Ext_Disp->m_LM_Count.at(o); ++i)
-			{
-				m_Eng->SetVolt(0,pos[0][i],pos[1][i],pos[2][i], m_Eng->GetVolt(0,pos[0][i],pos[1][i],pos[2][i]) - volt_ADE[o][0][i]);
-				m_Eng->SetVolt(1,pos[0][i],pos[1][i],pos[2][i], m_Eng->GetVolt(1,pos[0][i],pos[1][i],pos[2][i]) - volt_ADE[o][1][i]);
-				m_Eng->SetVolt(2,pos[0][i],pos[1][i],pos[2][i], m_Eng->GetVolt(2,pos[0][i],pos[1][i],pos[2][i]) - volt_ADE[o][2][i]);
-			}
+		{
+			Engine_Access_Virtual acc = {m_Eng};
+			ApplyVoltageADE(acc, o, start, stop);
 			break;
 		}
+		}
 	}
 }
 
-void Engine_Ext_Dispersive::Apply2Current()
+void Engine_Ext_Dispersive::Apply2Current(int threadID)
 {
+	if (m_Folded || (threadID>=m_NrThreads))
+		return;
+
 	for (int o=0;o<m_Op_Ext_Disp->m_Order;++o)
 	{
 		if (m_Op_Ext_Disp->m_curr_ADE_On[o]==false) continue;
 
-		unsigned int **pos = m_Op_Ext_Disp->m_LM_pos[o];
+		unsigned int start = m_cellStart[o][threadID];
+		unsigned int stop = m_cellStop[o][threadID];
 
 		//switch for different engine types to access faster inline engine functions
 		switch (m_Eng->GetType())
 		{
 		case Engine::BASIC:
 		{
-			for (unsigned int i=0; i<m_Op_Ext_Disp->m_LM_Count.at(o); ++i)
-			{
-				m_Eng->Engine::SetCurr(0,pos[0][i],pos[1][i],pos[2][i], m_Eng->Engine::GetCurr(0,pos[0][i],pos[1][i],pos[2][i]) - curr_ADE[o][0][i]);
-				m_Eng->Engine::SetCurr(1,pos[0][i],pos[1][i],pos[2][i], m_Eng->Engine::GetCurr(1,pos[0][i],pos[1][i],pos[2][i]) - curr_ADE[o][1][i]);
-				m_Eng->Engine::SetCurr(2,pos[0][i],pos[1][i],pos[2][i], m_Eng->Engine::GetCurr(2,pos[0][i],pos[1][i],pos[2][i]) - curr_ADE[o][2][i]);
-			}
+			Engine_Access_Basic acc = {m_Eng};
+			ApplyCurrentADE(acc, o, start, stop);
 			break;
 		}
 		case Engine::SSE:
 		{
-			Engine_sse* eng_sse = (Engine_sse*)m_Eng;
-			for (unsigned int i=0; i<m_Op_Ext_Disp->m_LM_Count.at(o); ++i)
-			{
-				eng_sse->Engine_sse::SetCurr(0,pos[0][i],pos[1][i],pos[2][i], eng_sse->Engine_sse::GetCurr(0,pos[0][i],pos[1][i],pos[2][i]) - curr_ADE[o][0][i]);
-				eng_sse->Engine_sse::SetCurr(1,pos[0][i],pos[1][i],pos[2][i], eng_sse->Engine_sse::GetCurr(1,pos[0][i],pos[1][i],pos[2][i]) - curr_ADE[o][1][i]);
-				eng_sse->Engine_sse::SetCurr(2,pos[0][i],pos[1][i],pos[2][i], eng_sse->Engine_sse::GetCurr(2,pos[0][i],pos[1][i],pos[2][i]) - curr_ADE[o][2][i]);
-			}
+			Engine_Access_SSE acc = {(Engine_sse*)m_Eng};
+			ApplyCurrentADE(acc, o, start, stop);
 			break;
 		}
 		default:
-			for (unsigned int i=0; i<m_Op_Ext_Disp->m_LM_Count.at(o); ++i)
-			{
-				m_Eng->SetCurr(0,pos[0][i],pos[1][i],pos[2][i], m_Eng->GetCurr(0,pos[0][i],pos[1][i],pos[2][i]) - curr_ADE[o][0][i]);
-				m_Eng->SetCurr(1,pos[0][i],pos[1][i],pos[2][i], m_Eng->GetCurr(1,pos[0][i],pos[1][i],pos[2][i]) - curr_ADE[o][1][i]);
-				m_Eng->SetCurr(2,pos[0][i],pos[1][i],pos[2][i], m_Eng->GetCurr(2,pos[0][i],pos[1][i],pos[2][i]) - curr_ADE[o][2][i]);
-			}
+		{
+			Engine_Access_Virtual acc = {m_Eng};
+			ApplyCurrentADE(acc, o, start, stop);
 			break;
 		}
+		}
 	}
 }
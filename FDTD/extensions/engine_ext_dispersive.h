@@ -30,8 +30,12 @@ public:
 	Engine_Ext_Dispersive(Operator_Ext_Dispersive* op_ext_disp);
 	virtual ~Engine_Ext_Dispersive();
 
-	virtual void Apply2Voltages();
-	virtual void Apply2Current();
+	virtual void SetNumberOfThreads(int nrThread);
+
+	virtual void Apply2Voltages() {Engine_Ext_Dispersive::Apply2Voltages(0);}
+	virtual void Apply2Voltages(int threadID);
+	virtual void Apply2Current() {Engine_Ext_Dispersive::Apply2Current(0);}
+	virtual void Apply2Current(int threadID);
 
 protected:
 	Operator_Ext_Dispersive* m_Op_Ext_Disp;
@@ -39,6 +43,9 @@ protected:
 	//! Dispersive order
 	int m_Order;
 
+	//! The ADEs are applied by the main engine update, all separate updates are skipped \sa Operator_Ext_LorentzMaterial::FoldIntoMainUpdate
+	bool m_Folded;
+
 	//! ADE currents
 	// Array setup: curr_ADE[N_order][direction][mesh_pos]
 	FDTD_FLOAT ***curr_ADE;
@@ -46,6 +53,18 @@ protected:
 	//! ADE voltages
 	// Array setup: volt_ADE[N_order][direction][mesh_pos]
 	FDTD_FLOAT ***volt_ADE;
+
+	//! First and last+1 dispersive cell of each thread, array setup: m_cellStart[N_order][threadID]
+	/*!
+	  All orders are split at the same x-lines, a cell (position) is therefore always handled by the same thread.
+	  */
+	vector< vector<unsigned int> > m_cellStart;
+	vector< vector<unsigned int> > m_cellStop;
+
+	template <class Access>
+	void ApplyVoltageADE(Access eng, int order, unsigned int start, unsigned int stop);
+	template <class Access>
+	void ApplyCurrentADE(Access eng, int order, unsigned int start, unsigned int stop);
 };
 
 #endif // ENGINE_EXT_DISPERSIVE_H
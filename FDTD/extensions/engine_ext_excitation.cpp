@@ -17,12 +17,26 @@
 
 #include "engine_ext_excitation.h"
 #include "operator_ext_excitation.h"
-#include "FDTD/engine_sse.h"
+#include "engine_field_access.h"
+#include "FDTD/operator_sse.h"
+#include <algorithm>
+
+//! sort key of an excitation point: memory position in the engine (first) and the index of the point (second)
+typedef pair<size_t,unsigned int> ExciteKey;
+
+//! order excitation points by delay, points with the same delay remain in memory order
+struct ExciteDelayCompare
+{
+	const unsigned int* delay;
+	bool operator()(const ExciteKey &a, const ExciteKey &b) const {return delay[a.second]<delay[b.second];}
+};
 
 Engine_Ext_Excitation::Engine_Ext_Excitation(Operator_Ext_Excitation* op_ext) : Engine_Extension(op_ext)
 {
 	m_Op_Exc = op_ext;
 	m_Priority = ENG_EXT_PRIO_EXCITATION;
+
+	SetNumberOfThreads(1);
 }
 
 Engine_Ext_Excitation::~Engine_Ext_Excitation()
@@ -30,140 +44,170 @@ Engine_Ext_Excitation::~Engine_Ext_Excitation()
 
 }
 
-void Engine_Ext_Excitation::Apply2Voltages()
+void Engine_Ext_Excitation::SetNumberOfThreads(int nrThread)
+{
+	Engine_Extension::SetNumberOfThreads(nrThread);
+
+	SetupExcitePoints(m_Volt, m_Op_Exc->Volt_Count, m_Op_Exc->Volt_index, m_Op_Exc->Volt_dir, m_Op_Exc->Volt_amp, m_Op_Exc->Volt_delay);
+	SetupExcitePoints(m_Curr, m_Op_Exc->Curr_Count, m_Op_Exc->Curr_index, m_Op_Exc->Curr_dir, m_Op_Exc->Curr_amp, m_Op_Exc->Curr_delay);
+}
+
+void Engine_Ext_Excitation::SetupExcitePoints(vector<ExcitePoints> &points, unsigned int count, unsigned int* const index[3], const unsigned short* dir, const FDTD_FLOAT* amp, const unsigned int* delay)
+{
+	points.clear();
+	points.resize(m_NrThreads);
+
+	// sort all points into the memory order of the engine, the sse engines interleave each z-line over its sse vectors
+	const Operator* op = m_Op_Exc->m_Op;
+	unsigned int numLines[3] = {op->GetNumberOfLines(0,true), op->GetNumberOfLines(1,true), op->GetNumberOfLines(2,true)};
+	unsigned int numVectors = ceil((double)numLines[2]/4.0);
+	bool sse_order = (dynamic_cast<const Operator_sse*>(op)!=NULL);
+	vector<ExciteKey> order(count);
+	for (unsigned int i=0; i<count; ++i)
+	{
+		size_t key = ((size_t)dir[i]*numLines[0] + index[0][i])*numLines[1] + index[1][i];
+		if (sse_order)
+			key = (key*numVectors + index[2][i]%numVectors)*4 + index[2][i]/numVectors;
+		else
+			key = key*numLines[2] + index[2][i];
+		order.at(i) = ExciteKey(key, i);
+	}
+	sort(order.begin(), order.end());
+
+	ExciteDelayCompare delayCompare = {delay};
+	unsigned int start = 0;
+	for (int t=0; t<m_NrThreads; ++t)
+	{
+		// contiguous ranges in memory order, a field component excited by several points is kept within one thread
+		unsigned int stop = (t==m_NrThreads-1) ? count : max(start, (unsigned int)((double)count*(t+1)/m_NrThreads));
+		while ((stop>0) && (stop<count) && (order.at(stop).first==order.at(stop-1).first))
+			++stop;
+
+		// group the points of this thread by delay
+		stable_sort(order.begin()+start, order.begin()+stop, delayCompare);
+
+		ExcitePoints &p = points.at(t);
+		for (int n=0; n<3; ++n)
+			p.pos[n].resize(stop-start);
+		p.dir.resize(stop-start);
+		p.amp.resize(stop-start);
+		for (unsigned int k=start; k<stop; ++k)
+		{
+			unsigned int i = order.at(k).second;
+			for (int n=0; n<3; ++n)
+				p.pos[n][k-start] = index[n][i];
+			p.dir[k-start] = dir[i];
+			p.amp[k-start] = amp[i];
+			if ((k==start) || (delay[i]!=delay[order.at(k-1).second]))
+			{
+				p.groupDelay.push_back(delay[i]);
+				p.groupStart.push_back(k-start);
+			}
+		}
+		p.groupStart.push_back(stop-start);
+		start = stop;
+	}
+}
+
+template <class Access>
+void Engine_Ext_Excitation::ApplyExcitation(Access eng, bool volt, const ExcitePoints &points, const FDTD_FLOAT* signal)
 {
-	//soft voltage excitation here (E-field excite)
 	int exc_pos;
-	unsigned int ny;
-	unsigned int pos[3];
 	int numTS = m_Eng->GetNumberOfTimesteps();
 	unsigned int length = m_Op_Exc->m_Exc->GetLength();
-	FDTD_FLOAT* exc_volt =  m_Op_Exc->m_Exc->GetVoltageSignal();
 
 	int p = numTS+1;
 	if (m_Op_Exc->m_Exc->GetSignalPeriod()>0)
 		p = int(m_Op_Exc->m_Exc->GetSignalPeriod()/m_Op_Exc->m_Exc->GetTimestep());
 
+	for (size_t g=0; g<points.groupDelay.size(); ++g)
+	{
+		exc_pos = numTS - (int)points.groupDelay[g];
+		exc_pos *= (exc_pos>0);
+		exc_pos %= p;
+		exc_pos *= (exc_pos<(int)length);
+		FDTD_FLOAT sig = signal[exc_pos];
+		// nothing to add, e.g. before the delay or after the end of the signal
+		if (sig==0)
+			continue;
+
+		unsigned int start = points.groupStart[g];
+		unsigned int stop = points.groupStart[g+1];
+		const unsigned int* pos_x = &points.pos[0][0];
+		const unsigned int* pos_y = &points.pos[1][0];
+		const unsigned int* pos_z = &points.pos[2][0];
+		const unsigned int* dir = &points.dir[0];
+		const FDTD_FLOAT* amp = &points.amp[0];
+		if (volt)
+			for (unsigned int i=start; i<stop; ++i)
+				eng.SetVolt(dir[i], pos_x[i], pos_y[i], pos_z[i], eng.GetVolt(dir[i], pos_x[i], pos_y[i], pos_z[i]) + amp[i]*sig);
+		else
+			for (unsigned int i=start; i<stop; ++i)
+				eng.SetCurr(dir[i], pos_x[i], pos_y[i], pos_z[i], eng.GetCurr(dir[i], pos_x[i], pos_y[i], pos_z[i]) + amp[i]*sig);
+	}
+}
+
+void Engine_Ext_Excitation::Apply2Voltages(int threadID)
+{
+	if (threadID>=m_NrThreads)
+		return;
+
+	//soft voltage excitation here (E-field excite)
+	const ExcitePoints &points = m_Volt.at(threadID);
+	FDTD_FLOAT* exc_volt =  m_Op_Exc->m_Exc->GetVoltageSignal();
+
 	//switch for different engine types to access faster inline engine functions
 	switch (m_Eng->GetType())
 	{
 	case Engine::BASIC:
 		{
-			for (unsigned int n=0; n<m_Op_Exc->Volt_Count; ++n)
-			{
-				exc_pos = numTS - (int)m_Op_Exc->Volt_delay[n];
-				exc_pos *= (exc_pos>0);
-				exc_pos %= p;
-				exc_pos *= (exc_pos<(int)length);
-				ny = m_Op_Exc->Volt_dir[n];
-				pos[0]=m_Op_Exc->Volt_index[0][n];
-				pos[1]=m_Op_Exc->Volt_index[1][n];
-				pos[2]=m_Op_Exc->Volt_index[2][n];
-				m_Eng->Engine::SetVolt(ny,pos, m_Eng->Engine::GetVolt(ny,pos) + m_Op_Exc->Volt_amp[n]*exc_volt[exc_pos]);
-			}
+			Engine_Access_Basic acc = {m_Eng};
+			ApplyExcitation(acc, true, points, exc_volt);
 			break;
 		}
 	case Engine::SSE:
 		{
-			for (unsigned int n=0; n<m_Op_Exc->Volt_Count; ++n)
-			{
-				Engine_sse* eng_sse = (Engine_sse*) m_Eng;
-				exc_pos = numTS - (int)m_Op_Exc->Volt_delay[n];
-				exc_pos *= (exc_pos>0);
-				exc_pos %= p;
-				exc_pos *= (exc_pos<(int)length);
-				ny = m_Op_Exc->Volt_dir[n];
-				pos[0]=m_Op_Exc->Volt_index[0][n];
-				pos[1]=m_Op_Exc->Volt_index[1][n];
-				pos[2]=m_Op_Exc->Volt_index[2][n];
-				eng_sse->Engine_sse::SetVolt(ny,pos, eng_sse->Engine_sse::GetVolt(ny,pos) + m_Op_Exc->Volt_amp[n]*exc_volt[exc_pos]);
-			}
+			Engine_Access_SSE acc = {(Engine_sse*) m_Eng};
+			ApplyExcitation(acc, true, points, exc_volt);
 			break;
 		}
 	default:
 		{
-			for (unsigned int n=0; n<m_Op_Exc->Volt_Count; ++n)
-			{
-				exc_pos = numTS - (int)m_Op_Exc->Volt_delay[n];
-				exc_pos *= (exc_pos>0);
-				exc_pos %= p;
-				exc_pos *= (exc_pos<(int)length);
-				ny = m_Op_Exc->Volt_dir[n];
-				pos[0]=m_Op_Exc->Volt_index[0][n];
-				pos[1]=m_Op_Exc->Volt_index[1][n];
-				pos[2]=m_Op_Exc->Volt_index[2][n];
-				m_Eng->SetVolt(ny,pos, m_Eng->GetVolt(ny,pos) + m_Op_Exc->Volt_amp[n]*exc_volt[exc_pos]);
-			}
+			Engine_Access_Virtual acc = {m_Eng};
+			ApplyExcitation(acc, true, points, exc_volt);
 			break;
 		}
 	}
 }
 
-void Engine_Ext_Excitation::Apply2Current()
+void Engine_Ext_Excitation::Apply2Current(int threadID)
 {
-	//soft current excitation here (H-field excite)
+	if (threadID>=m_NrThreads)
+		return;
 
-	int exc_pos;
-	unsigned int ny;
-	unsigned int pos[3];
-	int numTS = m_Eng->GetNumberOfTimesteps();
-	unsigned int length = m_Op_Exc->m_Exc->GetLength();
+	//soft current excitation here (H-field excite)
+	const ExcitePoints &points = m_Curr.at(threadID);
 	FDTD_FLOAT* exc_curr =  m_Op_Exc->m_Exc->GetCurrentSignal();
 
-	int p = numTS+1;
-	if (m_Op_Exc->m_Exc->GetSignalPeriod()>0)
-		p = int(m_Op_Exc->m_Exc->GetSignalPeriod()/m_Op_Exc->m_Exc->GetTimestep());
-
 	//switch for different engine types to access faster inline engine functions
 	switch (m_Eng->GetType())
 	{
 	case Engine::BASIC:
 		{
-			for (unsigned int n=0; n<m_Op_Exc->Curr_Count; ++n)
-			{
-				exc_pos = numTS - (int)m_Op_Exc->Curr_delay[n];
-				exc_pos *= (exc_pos>0);
-				exc_pos %= p;
-				exc_pos *= (exc_pos<(int)length);
-				ny = m_Op_Exc->Curr_dir[n];
-				pos[0]=m_Op_Exc->Curr_index[0][n];
-				pos[1]=m_Op_Exc->Curr_index[1][n];
-				pos[2]=m_Op_Exc->Curr_index[2][n];
-				m_Eng->Engine::SetCurr(ny,pos, m_Eng->Engine::GetCurr(ny,pos) + m_Op_Exc->Curr_amp[n]*exc_curr[exc_pos]);
-			}
+			Engine_Access_Basic acc = {m_Eng};
+			ApplyExcitation(acc, false, points, exc_curr);
 			break;
 		}
 	case Engine::SSE:
 		{
-			for (unsigned int n=0; n<m_Op_Exc->Curr_Count; ++n)
-			{
-				Engine_sse* eng_sse = (Engine_sse*) m_Eng;
-				exc_pos = numTS - (int)m_Op_Exc->Curr_delay[n];
-				exc_pos *= (exc_pos>0);
-				exc_pos %= p;
-				exc_pos *= (exc_pos<(int)length);
-				ny = m_Op_Exc->Curr_dir[n];
-				pos[0]=m_Op_Exc->Curr_index[0][n];
-				pos[1]=m_Op_Exc->Curr_index[1][n];
-				pos[2]=m_Op_Exc->Curr_index[2][n];
-				eng_sse->Engine_sse::SetCurr(ny,pos, eng_sse->Engine_sse::GetCurr(ny,pos) + m_Op_Exc->Curr_amp[n]*exc_curr[exc_pos]);
-			}
+			Engine_Access_SSE acc = {(Engine_sse*) m_Eng};
+			ApplyExcitation(acc, false, points, exc_curr);
 			break;
 		}
 	default:
 		{
-			for (unsigned int n=0; n<m_Op_Exc->Curr_Count; ++n)
-			{
-				exc_pos = numTS - (int)m_Op_Exc->Curr_delay[n];
-				exc_pos *= (exc_pos>0);
-				exc_pos %= p;
-				exc_pos *= (exc_pos<(int)length);
-				ny = m_Op_Exc->Curr_dir[n];
-				pos[0]=m_Op_Exc->Curr_index[0][n];
-				pos[1]=m_Op_Exc->Curr_index[1][n];
-				pos[2]=m_Op_Exc->Curr_index[2][n];
-				m_Eng->SetCurr(ny,pos, m_Eng->GetCurr(ny,pos) + m_Op_Exc->Curr_amp[n]*exc_curr[exc_pos]);
-			}
+			Engine_Access_Virtual acc = {m_Eng};
+			ApplyExcitation(acc, false, points, exc_curr);
 			break;
 		}
 	}
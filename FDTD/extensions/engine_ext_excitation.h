@@ -30,11 +30,36 @@ public:
 	Engine_Ext_Excitation(Operator_Ext_Excitation* op_ext);
 	virtual ~Engine_Ext_Excitation();
 
-	virtual void Apply2Voltages();
-	virtual void Apply2Current();
+	virtual void SetNumberOfThreads(int nrThread);
+
+	virtual void Apply2Voltages() {Engine_Ext_Excitation::Apply2Voltages(0);}
+	virtual void Apply2Voltages(int threadID);
+	virtual void Apply2Current() {Engine_Ext_Excitation::Apply2Current(0);}
+	virtual void Apply2Current(int threadID);
 
 protected:
 	Operator_Ext_Excitation* m_Op_Exc;
+
+	//! Excitation points of one thread, grouped by their delay and sorted into the memory order of the engine within each group
+	struct ExcitePoints
+	{
+		vector<unsigned int> pos[3];
+		vector<unsigned int> dir;
+		vector<FDTD_FLOAT> amp;
+		vector<unsigned int> groupDelay; //!< delay of each group
+		vector<unsigned int> groupStart; //!< first point of each group, the last entry is the number of points
+	};
+
+	//! Excitation points for each thread, a field component is always excited by a single thread
+	vector<ExcitePoints> m_Volt;
+	vector<ExcitePoints> m_Curr;
+
+	//! Distribute and group the given excitation points over all threads
+	void SetupExcitePoints(vector<ExcitePoints> &points, unsigned int count, unsigned int* const index[3], const unsigned short* dir, const FDTD_FLOAT* amp, const unsigned int* delay);
+
+	//! Add the excitation \a signal to all points, the signal sample is looked up once per delay group, \a Access provides the (fast) field access of the engine type
+	template <class Access>
+	void ApplyExcitation(Access eng, bool volt, const ExcitePoints &points, const FDTD_FLOAT* signal);
 };
 
 #endif // ENGINE_EXT_EXCITATION_H
@@ -17,7 +17,11 @@
 
 #include "engine_ext_lorentzmaterial.h"
 #include "operator_ext_lorentzmaterial.h"
-#include "FDTD/engine_sse.h"
+#include "engine_field_access.h"
+#include "FDTD/engine_sse_compressed.h"
+
+//! number of cells gathered at once for the ADE updates
+#define LOR_ADE_BLOCK_SIZE 256
 
 Engine_Ext_LorentzMaterial::Engine_Ext_LorentzMaterial(Operator_Ext_LorentzMaterial* op_ext_lorentz) : Engine_Ext_Dispersive(op_ext_lorentz)
 {
@@ -76,247 +80,210 @@ Engine_Ext_LorentzMaterial::~Engine_Ext_LorentzMaterial()
 	volt_Lor_ADE=NULL;
 }
 
-void Engine_Ext_LorentzMaterial::DoPreVoltageUpdates()
+void Engine_Ext_LorentzMaterial::SetEngine(Engine* eng)
 {
+	Engine_Ext_Dispersive::SetEngine(eng);
+	m_Folded = false;
+	if (m_Op_Ext_Lor->m_Folded==false)
+		return;
+	Engine_SSE_Compressed* eng_compr = dynamic_cast<Engine_SSE_Compressed*>(eng);
+	if (eng_compr)
+		m_Folded = FoldIntoEngine(eng_compr);
+	if (!m_Folded)
+		cerr << "Engine_Ext_LorentzMaterial::SetEngine: Warning: The engine cannot apply the dispersive update, using the separate dispersive update..." << endl;
+}
+
+bool Engine_Ext_LorentzMaterial::FoldIntoEngine(Engine_SSE_Compressed* eng)
+{
+	if (eng->InitDispersiveADE(m_Order)==false)
+		return false;
+
+	unsigned int numVectors = eng->GetNumberOfVectors();
 	for (int o=0;o<m_Order;++o)
 	{
-		if (m_Op_Ext_Lor->m_volt_ADE_On[o]==false) continue;
-
 		unsigned int **pos = m_Op_Ext_Lor->m_LM_pos[o];
-
-		if (m_Op_Ext_Lor->m_volt_Lor_ADE_On[o])
+		const unsigned int* coeff = m_Op_Ext_Lor->m_LM_coeff[o];
+		for (unsigned int i=0; i<m_Op_Ext_Lor->m_LM_Count.at(o); ++i)
 		{
-			//switch for different engine types to access faster inline engine functions
-			switch (m_Eng->GetType())
-			{
-			case Engine::BASIC:
+			unsigned int vec = pos[2][i]%numVectors;
+			unsigned int lane = pos[2][i]/numVectors;
+			int volt_slot = eng->GetDispersiveSlot(true, pos[0][i], pos[1][i], vec);
+			int curr_slot = eng->GetDispersiveSlot(false, pos[0][i], pos[1][i], vec);
+			for (int n=0; n<3; ++n)
 			{
-				for (unsigned int i=0; i<m_Op_Ext_Lor->m_LM_Count.at(o); ++i)
+				// the unused lanes and orders keep zero coefficients, their ADEs remain zero
+				if (m_Op_Ext_Lor->m_volt_ADE_On[o] && (volt_slot>=0))
 				{
-					volt_Lor_ADE[o][0][i]+=m_Op_Ext_Lor->v_Lor_ADE[o][0][i]*volt_ADE[o][0][i];
-					volt_ADE[o][0][i] *= m_Op_Ext_Lor->v_int_ADE[o][0][i];
-					volt_ADE[o][0][i] += m_Op_Ext_Lor->v_ext_ADE[o][0][i] * (m_Eng->Engine::GetVolt(0,pos[0][i],pos[1][i],pos[2][i])-volt_Lor_ADE[o][0][i]);
-
-					volt_Lor_ADE[o][1][i]+=m_Op_Ext_Lor->v_Lor_ADE[o][1][i]*volt_ADE[o][1][i];
-					volt_ADE[o][1][i] *= m_Op_Ext_Lor->v_int_ADE[o][1][i];
-					volt_ADE[o][1][i] += m_Op_Ext_Lor->v_ext_ADE[o][1][i] * (m_Eng->Engine::GetVolt(1,pos[0][i],pos[1][i],pos[2][i])-volt_Lor_ADE[o][2][i]);
-
-					volt_Lor_ADE[o][2][i]+=m_Op_Ext_Lor->v_Lor_ADE[o][2][i]*volt_ADE[o][2][i];
-					volt_ADE[o][2][i] *= m_Op_Ext_Lor->v_int_ADE[o][2][i];
-					volt_ADE[o][2][i] += m_Op_Ext_Lor->v_ext_ADE[o][2][i] * (m_Eng->Engine::GetVolt(2,pos[0][i],pos[1][i],pos[2][i])-volt_Lor_ADE[o][2][i]);
+					unsigned int index = (volt_slot*m_Order + o)*3 + n;
+					eng->m_Volt_ADE.c_int.at(index).f[lane] = m_Op_Ext_Lor->v_int_ADE[o][n][coeff[i]];
+					eng->m_Volt_ADE.c_ext.at(index).f[lane] = m_Op_Ext_Lor->v_ext_ADE[o][n][coeff[i]];
+					if (m_Op_Ext_Lor->m_volt_Lor_ADE_On[o])
+						eng->m_Volt_ADE.c_lor.at(index).f[lane] = m_Op_Ext_Lor->v_Lor_ADE[o][n][coeff[i]];
 				}
-				break;
-			}
-			case Engine::SSE:
-			{
-				Engine_sse* eng_sse = (Engine_sse*)m_Eng;
-				for (unsigned int i=0; i<m_Op_Ext_Lor->m_LM_Count.at(o); ++i)
+				if (m_Op_Ext_Lor->m_curr_ADE_On[o] && (curr_slot>=0))
 				{
-					volt_Lor_ADE[o][0][i]+=m_Op_Ext_Lor->v_Lor_ADE[o][0][i]*volt_ADE[o][0][i];
-					volt_ADE[o][0][i] *= m_Op_Ext_Lor->v_int_ADE[o][0][i];
-					volt_ADE[o][0][i] += m_Op_Ext_Lor->v_ext_ADE[o][0][i] * (eng_sse->Engine_sse::GetVolt(0,pos[0][i],pos[1][i],pos[2][i])-volt_Lor_ADE[o][0][i]);
-
-					volt_Lor_ADE[o][1][i]+=m_Op_Ext_Lor->v_Lor_ADE[o][1][i]*volt_ADE[o][1][i];
-					volt_ADE[o][1][i] *= m_Op_Ext_Lor->v_int_ADE[o][1][i];
-					volt_ADE[o][1][i] += m_Op_Ext_Lor->v_ext_ADE[o][1][i] * (eng_sse->Engine_sse::GetVolt(1,pos[0][i],pos[1][i],pos[2][i])-volt_Lor_ADE[o][1][i]);
-
-					volt_Lor_ADE[o][2][i]+=m_Op_Ext_Lor->v_Lor_ADE[o][2][i]*volt_ADE[o][2][i];
-					volt_ADE[o][2][i] *= m_Op_Ext_Lor->v_int_ADE[o][2][i];
-					volt_ADE[o][2][i] += m_Op_Ext_Lor->v_ext_ADE[o][2][i] * (eng_sse->Engine_sse::GetVolt(2,pos[0][i],pos[1][i],pos[2][i])-volt_Lor_ADE[o][2][i]);
+					unsigned int index = (curr_slot*m_Order + o)*3 + n;
+					eng->m_Curr_ADE.c_int.at(index).f[lane] = m_Op_Ext_Lor->i_int_ADE[o][n][coeff[i]];
+					eng->m_Curr_ADE.c_ext.at(index).f[lane] = m_Op_Ext_Lor->i_ext_ADE[o][n][coeff[i]];
+					if (m_Op_Ext_Lor->m_curr_Lor_ADE_On[o])
+						eng->m_Curr_ADE.c_lor.at(index).f[lane] = m_Op_Ext_Lor->i_Lor_ADE[o][n][coeff[i]];
 				}
-				break;
 			}
-			default:
-				for (unsigned int i=0; i<m_Op_Ext_Lor->m_LM_Count.at(o); ++i)
-				{
-					volt_Lor_ADE[o][0][i]+=m_Op_Ext_Lor->v_Lor_ADE[o][0][i]*volt_ADE[o][0][i];
-					volt_ADE[o][0][i] *= m_Op_Ext_Lor->v_int_ADE[o][0][i];
-					volt_ADE[o][0][i] += m_Op_Ext_Lor->v_ext_ADE[o][0][i] * (m_Eng->GetVolt(0,pos[0][i],pos[1][i],pos[2][i])-volt_Lor_ADE[o][0][i]);
+		}
+	}
+	return true;
+}
 
-					volt_Lor_ADE[o][1][i]+=m_Op_Ext_Lor->v_Lor_ADE[o][1][i]*volt_ADE[o][1][i];
-					volt_ADE[o][1][i] *= m_Op_Ext_Lor->v_int_ADE[o][1][i];
-					volt_ADE[o][1][i] += m_Op_Ext_Lor->v_ext_ADE[o][1][i] * (m_Eng->GetVolt(1,pos[0][i],pos[1][i],pos[2][i])-volt_Lor_ADE[o][1][i]);
+template <class Access>
+void Engine_Ext_LorentzMaterial::UpdateVoltageADE(Access eng, int order, unsigned int start, unsigned int stop)
+{
+	unsigned int **pos = m_Op_Ext_Lor->m_LM_pos[order];
+	//the coefficients are shared by all cells of a coefficient set
+	const unsigned int* coeff = m_Op_Ext_Lor->m_LM_coeff[order];
+	FDTD_FLOAT volt[LOR_ADE_BLOCK_SIZE];
 
-					volt_Lor_ADE[o][2][i]+=m_Op_Ext_Lor->v_Lor_ADE[o][2][i]*volt_ADE[o][2][i];
-					volt_ADE[o][2][i] *= m_Op_Ext_Lor->v_int_ADE[o][2][i];
-					volt_ADE[o][2][i] += m_Op_Ext_Lor->v_ext_ADE[o][2][i] * (m_Eng->GetVolt(2,pos[0][i],pos[1][i],pos[2][i])-volt_Lor_ADE[o][2][i]);
-				}
-				break;
-			}
-		}
-		else
+	for (unsigned int block=start; block<stop; block+=LOR_ADE_BLOCK_SIZE)
+	{
+		unsigned int num = min(stop-block, (unsigned int)LOR_ADE_BLOCK_SIZE);
+		for (int n=0; n<3; ++n)
 		{
-			//switch for different engine types to access faster inline engine functions
-			switch (m_Eng->GetType())
-			{
-			case Engine::BASIC:
+			//gather the engine voltages, all following updates work on contiguous arrays
+			for (unsigned int i=0; i<num; ++i)
+				volt[i] = eng.GetVolt(n,pos[0][block+i],pos[1][block+i],pos[2][block+i]);
+
+			FDTD_FLOAT* ade = &volt_ADE[order][n][block];
+			const FDTD_FLOAT* v_int = m_Op_Ext_Lor->v_int_ADE[order][n];
+			const FDTD_FLOAT* v_ext = m_Op_Ext_Lor->v_ext_ADE[order][n];
+			if (m_Op_Ext_Lor->m_volt_Lor_ADE_On[order])
 			{
-				for (unsigned int i=0; i<m_Op_Ext_Lor->m_LM_Count.at(o); ++i)
+				FDTD_FLOAT* lor = &volt_Lor_ADE[order][n][block];
+				const FDTD_FLOAT* v_lor = m_Op_Ext_Lor->v_Lor_ADE[order][n];
+				for (unsigned int i=0; i<num; ++i)
 				{
-					volt_ADE[o][0][i] *= m_Op_Ext_Lor->v_int_ADE[o][0][i];
-					volt_ADE[o][0][i] += m_Op_Ext_Lor->v_ext_ADE[o][0][i] * m_Eng->Engine::GetVolt(0,pos[0][i],pos[1][i],pos[2][i]);
-
-					volt_ADE[o][1][i] *= m_Op_Ext_Lor->v_int_ADE[o][1][i];
-					volt_ADE[o][1][i] += m_Op_Ext_Lor->v_ext_ADE[o][1][i] * m_Eng->Engine::GetVolt(1,pos[0][i],pos[1][i],pos[2][i]);
-
-					volt_ADE[o][2][i] *= m_Op_Ext_Lor->v_int_ADE[o][2][i];
-					volt_ADE[o][2][i] += m_Op_Ext_Lor->v_ext_ADE[o][2][i] * m_Eng->Engine::GetVolt(2,pos[0][i],pos[1][i],pos[2][i]);
+					const unsigned int k = coeff[block+i];
+					lor[i] += v_lor[k]*ade[i];
+					ade[i] = ade[i]*v_int[k] + v_ext[k]*(volt[i]-lor[i]);
 				}
-				break;
 			}
-			case Engine::SSE:
+			else
 			{
-				Engine_sse* eng_sse = (Engine_sse*)m_Eng;
-				for (unsigned int i=0; i<m_Op_Ext_Lor->m_LM_Count.at(o); ++i)
-				{
-					volt_ADE[o][0][i] *= m_Op_Ext_Lor->v_int_ADE[o][0][i];
-					volt_ADE[o][0][i] += m_Op_Ext_Lor->v_ext_ADE[o][0][i] * eng_sse->Engine_sse::GetVolt(0,pos[0][i],pos[1][i],pos[2][i]);
-
-					volt_ADE[o][1][i] *= m_Op_Ext_Lor->v_int_ADE[o][1][i];
-					volt_ADE[o][1][i] += m_Op_Ext_Lor->v_ext_ADE[o][1][i] * eng_sse->Engine_sse::GetVolt(1,pos[0][i],pos[1][i],pos[2][i]);
-
-					volt_ADE[o][2][i] *= m_Op_Ext_Lor->v_int_ADE[o][2][i];
-					volt_ADE[o][2][i] += m_Op_Ext_Lor->v_ext_ADE[o][2][i] * eng_sse->Engine_sse::GetVolt(2,pos[0][i],pos[1][i],pos[2][i]);
-				}
-				break;
-			}
-			default:
-				for (unsigned int i=0; i<m_Op_Ext_Lor->m_LM_Count.at(o); ++i)
-				{
-					volt_ADE[o][0][i] *= m_Op_Ext_Lor->v_int_ADE[o][0][i];
-					volt_ADE[o][0][i] += m_Op_Ext_Lor->v_ext_ADE[o][0][i] * m_Eng->GetVolt(0,pos[0][i],pos[1][i],pos[2][i]);
-
-					volt_ADE[o][1][i] *= m_Op_Ext_Lor->v_int_ADE[o][1][i];
-					volt_ADE[o][1][i] += m_Op_Ext_Lor->v_ext_ADE[o][1][i] * m_Eng->GetVolt(1,pos[0][i],pos[1][i],pos[2][i]);
-
-					volt_ADE[o][2][i] *= m_Op_Ext_Lor->v_int_ADE[o][2][i];
-					volt_ADE[o][2][i] += m_Op_Ext_Lor->v_ext_ADE[o][2][i] * m_Eng->GetVolt(2,pos[0][i],pos[1][i],pos[2][i]);
-				}
-				break;
+				for (unsigned int i=0; i<num; ++i)
+					ade[i] = ade[i]*v_int[coeff[block+i]] + v_ext[coeff[block+i]]*volt[i];
 			}
 		}
 	}
 }
 
-void Engine_Ext_LorentzMaterial::DoPreCurrentUpdates()
+template <class Access>
+void Engine_Ext_LorentzMaterial::UpdateCurrentADE(Access eng, int order, unsigned int start, unsigned int stop)
 {
-	for (int o=0;o<m_Order;++o)
-	{
-		if (m_Op_Ext_Lor->m_curr_ADE_On[o]==false) continue;
-
-		unsigned int **pos = m_Op_Ext_Lor->m_LM_pos[o];
+	unsigned int **pos = m_Op_Ext_Lor->m_LM_pos[order];
+	//the coefficients are shared by all cells of a coefficient set
+	const unsigned int* coeff = m_Op_Ext_Lor->m_LM_coeff[order];
+	FDTD_FLOAT curr[LOR_ADE_BLOCK_SIZE];
 
-		if (m_Op_Ext_Lor->m_curr_Lor_ADE_On[o])
+	for (unsigned int block=start; block<stop; block+=LOR_ADE_BLOCK_SIZE)
+	{
+		unsigned int num = min(stop-block, (unsigned int)LOR_ADE_BLOCK_SIZE);
+		for (int n=0; n<3; ++n)
 		{
-			//switch for different engine types to access faster inline engine functions
-			switch (m_Eng->GetType())
-			{
-			case Engine::BASIC:
+			//gather the engine currents, all following updates work on contiguous arrays
+			for (unsigned int i=0; i<num; ++i)
+				curr[i] = eng.GetCurr(n,pos[0][block+i],pos[1][block+i],pos[2][block+i]);
+
+			FDTD_FLOAT* ade = &curr_ADE[order][n][block];
+			const FDTD_FLOAT* i_int = m_Op_Ext_Lor->i_int_ADE[order][n];
+			const FDTD_FLOAT* i_ext = m_Op_Ext_Lor->i_ext_ADE[order][n];
+			if (m_Op_Ext_Lor->m_curr_Lor_ADE_On[order])
 			{
-				for (unsigned int i=0; i<m_Op_Ext_Lor->m_LM_Count.at(o); ++i)
+				FDTD_FLOAT* lor = &curr_Lor_ADE[order][n][block];
+				const FDTD_FLOAT* i_lor = m_Op_Ext_Lor->i_Lor_ADE[order][n];
+				for (unsigned int i=0; i<num; ++i)
 				{
-					curr_Lor_ADE[o][0][i]+=m_Op_Ext_Lor->i_Lor_ADE[o][0][i]*curr_ADE[o][0][i];
-					curr_ADE[o][0][i] *= m_Op_Ext_Lor->i_int_ADE[o][0][i];
-					curr_ADE[o][0][i] += m_Op_Ext_Lor->i_ext_ADE[o][0][i] * (m_Eng->Engine::GetCurr(0,pos[0][i],pos[1][i],pos[2][i])-curr_Lor_ADE[o][0][i]);
-
-					curr_Lor_ADE[o][1][i]+=m_Op_Ext_Lor->i_Lor_ADE[o][1][i]*curr_ADE[o][1][i];
-					curr_ADE[o][1][i] *= m_Op_Ext_Lor->i_int_ADE[o][1][i];
-					curr_ADE[o][1][i] += m_Op_Ext_Lor->i_ext_ADE[o][1][i] * (m_Eng->Engine::GetCurr(1,pos[0][i],pos[1][i],pos[2][i])-curr_Lor_ADE[o][1][i]);
-
-					curr_Lor_ADE[o][2][i]+=m_Op_Ext_Lor->i_Lor_ADE[o][2][i]*curr_ADE[o][2][i];
-					curr_ADE[o][2][i] *= m_Op_Ext_Lor->i_int_ADE[o][2][i];
-					curr_ADE[o][2][i] += m_Op_Ext_Lor->i_ext_ADE[o][2][i] * (m_Eng->Engine::GetCurr(2,pos[0][i],pos[1][i],pos[2][i])-curr_Lor_ADE[o][2][i]);
+					const unsigned int k = coeff[block+i];
+					lor[i] += i_lor[k]*ade[i];
+					ade[i] = ade[i]*i_int[k] + i_ext[k]*(curr[i]-lor[i]);
 				}
-				break;
 			}
-			case Engine::SSE:
+			else
 			{
-				Engine_sse* eng_sse = (Engine_sse*)m_Eng;
-				for (unsigned int i=0; i<m_Op_Ext_Lor->m_LM_Count.at(o); ++i)
-				{
-					curr_Lor_ADE[o][0][i]+=m_Op_Ext_Lor->i_Lor_ADE[o][0][i]*curr_ADE[o][0][i];
-					curr_ADE[o][0][i] *= m_Op_Ext_Lor->i_int_ADE[o][0][i];
-					curr_ADE[o][0][i] += m_Op_Ext_Lor->i_ext_ADE[o][0][i] * (eng_sse->Engine_sse::GetCurr(0,pos[0][i],pos[1][i],pos[2][i])-curr_Lor_ADE[o][0][i]);
+				for (unsigned int i=0; i<num; ++i)
+					ade[i] = ade[i]*i_int[coeff[block+i]] + i_ext[coeff[block+i]]*curr[i];
+			}
+		}
+	}
+}
 
-					curr_Lor_ADE[o][1][i]+=m_Op_Ext_Lor->i_Lor_ADE[o][1][i]*curr_ADE[o][1][i];
-					curr_ADE[o][1][i] *= m_Op_Ext_Lor->i_int_ADE[o][1][i];
-					curr_ADE[o][1][i] += m_Op_Ext_Lor->i_ext_ADE[o][1][i] * (eng_sse->Engine_sse::GetCurr(1,pos[0][i],pos[1][i],pos[2][i])-curr_Lor_ADE[o][1][i]);
+void Engine_Ext_LorentzMaterial::DoPreVoltageUpdates(int threadID)
+{
+	if (m_Folded || (threadID>=m_NrThreads))
+		return;
 
-					curr_Lor_ADE[o][2][i]+=m_Op_Ext_Lor->i_Lor_ADE[o][2][i]*curr_ADE[o][2][i];
-					curr_ADE[o][2][i] *= m_Op_Ext_Lor->i_int_ADE[o][2][i];
-					curr_ADE[o][2][i] += m_Op_Ext_Lor->i_ext_ADE[o][2][i] * (eng_sse->Engine_sse::GetCurr(2,pos[0][i],pos[1][i],pos[2][i])-curr_Lor_ADE[o][2][i]);
-				}
-				break;
-			}
-			default:
-				for (unsigned int i=0; i<m_Op_Ext_Lor->m_LM_Count.at(o); ++i)
-				{
-					curr_Lor_ADE[o][0][i]+=m_Op_Ext_Lor->i_Lor_ADE[o][0][i]*curr_ADE[o][0][i];
-					curr_ADE[o][0][i] *= m_Op_Ext_Lor->i_int_ADE[o][0][i];
-					curr_ADE[o][0][i] += m_Op_Ext_Lor->i_ext_ADE[o][0][i] * (m_Eng->GetCurr(0,pos[0][i],pos[1][i],pos[2][i])-curr_Lor_ADE[o][0][i]);
+	for (int o=0;o<m_Order;++o)
+	{
+		if (m_Op_Ext_Lor->m_volt_ADE_On[o]==false) continue;
 
-					curr_Lor_ADE[o][1][i]+=m_Op_Ext_Lor->i_Lor_ADE[o][1][i]*curr_ADE[o][1][i];
-					curr_ADE[o][1][i] *= m_Op_Ext_Lor->i_int_ADE[o][1][i];
-					curr_ADE[o][1][i] += m_Op_Ext_Lor->i_ext_ADE[o][1][i] * (m_Eng->GetCurr(1,pos[0][i],pos[1][i],pos[2][i])-curr_Lor_ADE[o][1][i]);
+		unsigned int start = m_cellStart[o][threadID];
+		unsigned int stop = m_cellStop[o][threadID];
 
-					curr_Lor_ADE[o][2][i]+=m_Op_Ext_Lor->i_Lor_ADE[o][2][i]*curr_ADE[o][2][i];
-					curr_ADE[o][2][i] *= m_Op_Ext_Lor->i_int_ADE[o][2][i];
-					curr_ADE[o][2][i] += m_Op_Ext_Lor->i_ext_ADE[o][2][i] * (m_Eng->GetCurr(2,pos[0][i],pos[1][i],pos[2][i])-curr_Lor_ADE[o][2][i]);
-				}
-				break;
-			}
+		//switch for different engine types to access faster inline engine functions
+		switch (m_Eng->GetType())
+		{
+		case Engine::BASIC:
+		{
+			Engine_Access_Basic acc = {m_Eng};
+			UpdateVoltageADE(acc, o, start, stop);
+			break;
 		}
-		else
+		case Engine::SSE:
 		{
-			//switch for different engine types to access faster inline engine functions
-			switch (m_Eng->GetType())
-			{
-			case Engine::BASIC:
-			{
-				for (unsigned int i=0; i<m_Op_Ext_Lor->m_LM_Count.at(o); ++i)
-				{
-					curr_ADE[o][0][i] *= m_Op_Ext_Lor->i_int_ADE[o][0][i];
-					curr_ADE[o][0][i] += m_Op_Ext_Lor->i_ext_ADE[o][0][i] * m_Eng->Engine::GetCurr(0,pos[0][i],pos[1][i],pos[2][i]);
-
-					curr_ADE[o][1][i] *= m_Op_Ext_Lor->i_int_ADE[o][1][i];
-					curr_ADE[o][1][i] += m_Op_Ext_Lor->i_ext_ADE[o][1][i] * m_Eng->Engine::GetCurr(1,pos[0][i],pos[1][i],pos[2][i]);
-
-					curr_ADE[o][2][i] *= m_Op_Ext_Lor->i_int_ADE[o][2][i];
-					curr_ADE[o][2][i] += m_Op_Ext_Lor->i_ext_ADE[o][2][i] * m_Eng->Engine::GetCurr(2,pos[0][i],pos[1][i],pos[2][i]);
-				}
-				break;
-			}
-			case Engine::SSE:
-			{
-				Engine_sse* eng_sse = (Engine_sse*)m_Eng;
-				for (unsigned int i=0; i<m_Op_Ext_Lor->m_LM_Count.at(o); ++i)
-				{
-					curr_ADE[o][0][i] *= m_Op_Ext_Lor->i_int_ADE[o][0][i];
-					curr_ADE[o][0][i] += m_Op_Ext_Lor->i_ext_ADE[o][0][i] * eng_sse->Engine_sse::GetCurr(0,pos[0][i],pos[1][i],pos[2][i]);
+			Engine_Access_SSE acc = {(Engine_sse*)m_Eng};
+			UpdateVoltageADE(acc, o, start, stop);
+			break;
+		}
+		default:
+		{
+			Engine_Access_Virtual acc = {m_Eng};
+			UpdateVoltageADE(acc, o, start, stop);
+			break;
+		}
+		}
+	}
+}
 
-					curr_ADE[o][1][i] *= m_Op_Ext_Lor->i_int_ADE[o][1][i];
-					curr_ADE[o][1][i] += m_Op_Ext_Lor->i_ext_ADE[o][1][i] * eng_sse->Engine_sse::GetCurr(1,pos[0][i],pos[1][i],pos[2][i]);
+void Engine_Ext_LorentzMaterial::DoPreCurrentUpdates(int threadID)
+{
+	if (m_Folded || (threadID>=m_NrThreads))
+		return;
 
-					curr_ADE[o][2][i] *= m_Op_Ext_Lor->i_int_ADE[o][2][i];
-					curr_ADE[o][2][i] += m_Op_Ext_Lor->i_ext_ADE[o][2][i] * eng_sse->Engine_sse::GetCurr(2,pos[0][i],pos[1][i],pos[2][i]);
-				}
-				break;
-			}
-			default:
-				for (unsigned int i=0; i<m_Op_Ext_Lor->m_LM_Count.at(o); ++i)
-				{
-					curr_ADE[o][0][i] *= m_Op_Ext_Lor->i_int_ADE[o][0][i];
-					curr_ADE[o][0][i] += m_Op_Ext_Lor->i_ext_ADE[o][0][i] * m_Eng->GetCurr(0,pos[0][i],pos[1][i],pos[2][i]);
+	for (int o=0;o<m_Order;++o)
+	{
+		if (m_Op_Ext_Lor->m_curr_ADE_On[o]==false) continue;
 
-					curr_ADE[o][1][i] *= m_Op_Ext_Lor->i_int_ADE[o][1][i];
-					curr_ADE[o][1][i] += m_Op_Ext_Lor->i_ext_ADE[o][1][i] * m_Eng->GetCurr(1,pos[0][i],pos[1][i],pos[2][i]);
+		unsigned int start = m_cellStart[o][threadID];
+		unsigned int stop = m_cellStop[o][threadID];
 
-					curr_ADE[o][2][i] *= m_Op_Ext_Lor->i_int_ADE[o][2][i];
-					curr_ADE[o][2][i] += m_Op_Ext_Lor->i_ext_ADE[o][2][i] * m_Eng->GetCurr(2,pos[0][i],pos[1][i],pos[2][i]);
-				}
-				break;
-			}
+		//switch for different engine types to access faster inline engine functions
+		switch (m_Eng->GetType())
+		{
+		case Engine::BASIC:
+		{
+			Engine_Access_Basic acc = {m_Eng};
+			UpdateCurrentADE(acc, o, start, stop);
+			break;
+		}
+		case Engine::SSE:
+		{
+			Engine_Access_SSE acc = {(Engine_sse*)m_Eng};
+			UpdateCurrentADE(acc, o, start, stop);
+			break;
+		}
+		default:
+		{
+			Engine_Access_Virtual acc = {m_Eng};
+			UpdateCurrentADE(acc, o, start, stop);
+			break;
+		}
 		}
 	}
 }
-
@@ -21,6 +21,7 @@
 #include "engine_ext_dispersive.h"
 
 class Operator_Ext_LorentzMaterial;
+class Engine_SSE_Compressed;
 
 class Engine_Ext_LorentzMaterial : public Engine_Ext_Dispersive
 {
@@ -28,13 +29,28 @@ public:
 	Engine_Ext_LorentzMaterial(Operator_Ext_LorentzMaterial* op_ext_lorentz);
 	virtual ~Engine_Ext_LorentzMaterial();
 
-	virtual void DoPreVoltageUpdates();
+	//! Set the engine, a compressed sse engine applies the ADEs within its main update if the operator extension was folded
+	virtual void SetEngine(Engine* eng);
 
-	virtual void DoPreCurrentUpdates();
+	virtual void DoPreVoltageUpdates() {Engine_Ext_LorentzMaterial::DoPreVoltageUpdates(0);}
+	virtual void DoPreVoltageUpdates(int threadID);
+
+	virtual void DoPreCurrentUpdates() {Engine_Ext_LorentzMaterial::DoPreCurrentUpdates(0);}
+	virtual void DoPreCurrentUpdates(int threadID);
 
 protected:
 	Operator_Ext_LorentzMaterial* m_Op_Ext_Lor;
 
+	//! Update the voltage ADEs of the given cells, the engine voltages are gathered block-wise for a vectorized update
+	template <class Access>
+	void UpdateVoltageADE(Access eng, int order, unsigned int start, unsigned int stop);
+	//! Update the current ADEs of the given cells, the engine currents are gathered block-wise for a vectorized update
+	template <class Access>
+	void UpdateCurrentADE(Access eng, int order, unsigned int start, unsigned int stop);
+
+	//! Copy all ADE coefficients into the packed dispersive data of the compressed engine
+	bool FoldIntoEngine(Engine_SSE_Compressed* eng);
+
 	//! ADE Lorentz voltages
 	// Array setup: volt_Lor_ADE[N_order][direction][mesh_pos]
 	FDTD_FLOAT ***volt_Lor_ADE;
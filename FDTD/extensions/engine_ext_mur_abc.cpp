@@ -19,6 +19,7 @@
 #include "operator_ext_mur_abc.h"
 #include "FDTD/engine.h"
 #include "FDTD/engine_sse.h"
+#include "engine_field_access.h"
 #include "tools/array_ops.h"
 #include "tools/useful.h"
 #include "operator_ext_excitation.h"
@@ -40,6 +41,13 @@ Engine_Ext_Mur_ABC::Engine_Ext_Mur_ABC(Operator_Ext_Mur_ABC* op_ext) : Engine_Ex
 	m_volt_nyP = Create2DArray<FDTD_FLOAT>(m_numLines);
 	m_volt_nyPP = Create2DArray<FDTD_FLOAT>(m_numLines);
 
+	m_numVectors = 0;
+	m_lineDir = -1;
+	m_f4_Coeff_nyP = NULL;
+	m_f4_Coeff_nyPP = NULL;
+	m_f4_volt_nyP = NULL;
+	m_f4_volt_nyPP = NULL;
+
 	//find if some excitation is on this mur-abc and find the max length of this excite, so that the abc can start after the excitation is done...
 	int maxDelay=-1;
 	Operator_Ext_Excitation* Exc_ext = m_Op_mur->m_Op->GetExcitationExtension();
@@ -63,83 +71,213 @@ Engine_Ext_Mur_ABC::Engine_Ext_Mur_ABC(Operator_Ext_Mur_ABC* op_ext) : Engine_Ex
 
 Engine_Ext_Mur_ABC::~Engine_Ext_Mur_ABC()
 {
+	DeletePackedStorage();
 	Delete2DArray(m_volt_nyP,m_numLines);
 	m_volt_nyP = NULL;
 	Delete2DArray(m_volt_nyPP,m_numLines);
 	m_volt_nyPP = NULL;
 }
 
-
 void Engine_Ext_Mur_ABC::SetNumberOfThreads(int nrThread)
 {
 	Engine_Extension::SetNumberOfThreads(nrThread);
+	AssignPlane2Threads();
+}
 
-	m_numX = AssignJobs2Threads(m_numLines[0],m_NrThreads,false);
+void Engine_Ext_Mur_ABC::AssignPlane2Threads()
+{
+	// distribute the whole boundary plane, not only the lines in the first in-plane direction
+	unsigned int numJobs = m_numLines[0]*m_numLines[1];
+	if (m_numVectors>0)
+		numJobs = m_numLines[(m_lineDir==m_nyP) ? 0 : 1]*m_numVectors;
+	m_numPos = AssignJobs2Threads(numJobs,m_NrThreads,false);
 	m_start.resize(m_NrThreads,0);
 	m_start.at(0)=0;
-	for (size_t n=1; n<m_numX.size(); ++n)
-		m_start.at(n) = m_start.at(n-1) + m_numX.at(n-1);
+	for (size_t n=1; n<m_numPos.size(); ++n)
+		m_start.at(n) = m_start.at(n-1) + m_numPos.at(n-1);
 }
 
+void Engine_Ext_Mur_ABC::SetEngine(Engine* eng)
+{
+	Engine_Extension::SetEngine(eng);
+	InitPackedStorage();
+	AssignPlane2Threads();
+}
 
-void Engine_Ext_Mur_ABC::DoPreVoltageUpdates(int threadID)
+void Engine_Ext_Mur_ABC::InitPackedStorage()
 {
-	if (IsActive()==false) return;
-	if (m_Eng==NULL) return;
-	if (threadID>=m_NrThreads)
+	DeletePackedStorage();
+	// a plane normal to z contains only single elements of the sse vectors
+	if ((m_Eng==NULL) || (m_Eng->GetType()!=Engine::SSE) || (m_ny==2))
+		return;
+
+	Engine_sse* eng_sse = (Engine_sse*) m_Eng;
+	m_numVectors = eng_sse->GetNumberOfVectors();
+	m_lineDir = (m_ny==0) ? 1 : 0;
+	int zIdx = (m_nyP==2) ? 0 : 1;
+	unsigned int numLines = m_numLines[1-zIdx];
+
+	m_f4_Coeff_nyP = Create1DArray_v4sf(numLines*m_numVectors);
+	m_f4_Coeff_nyPP = Create1DArray_v4sf(numLines*m_numVectors);
+	m_f4_volt_nyP = Create1DArray_v4sf(numLines*m_numVectors);
+	m_f4_volt_nyPP = Create1DArray_v4sf(numLines*m_numVectors);
+
+	// copy the coefficients, the padding elements of the last vectors remain zero
+	unsigned int pos[2];
+	for (unsigned int line=0; line<numLines; ++line)
+		for (unsigned int z=0; z<m_numLines[zIdx]; ++z)
+		{
+			pos[1-zIdx] = line;
+			pos[zIdx] = z;
+			unsigned int k = line*m_numVectors + z%m_numVectors;
+			m_f4_Coeff_nyP[k].f[z/m_numVectors] = m_Mur_Coeff_nyP[pos[0]][pos[1]];
+			m_f4_Coeff_nyPP[k].f[z/m_numVectors] = m_Mur_Coeff_nyPP[pos[0]][pos[1]];
+		}
+
+	// the scalar voltage planes are not used by the packed update
+	Delete2DArray(m_volt_nyP,m_numLines);
+	m_volt_nyP = NULL;
+	Delete2DArray(m_volt_nyPP,m_numLines);
+	m_volt_nyPP = NULL;
+}
+
+void Engine_Ext_Mur_ABC::DeletePackedStorage()
+{
+	if (m_numVectors==0)
 		return;
+	Delete1DArray_v4sf(m_f4_Coeff_nyP);
+	Delete1DArray_v4sf(m_f4_Coeff_nyPP);
+	Delete1DArray_v4sf(m_f4_volt_nyP);
+	Delete1DArray_v4sf(m_f4_volt_nyPP);
+	m_f4_Coeff_nyP = m_f4_Coeff_nyPP = NULL;
+	m_f4_volt_nyP = m_f4_volt_nyPP = NULL;
+	m_numVectors = 0;
+	m_lineDir = -1;
+
+	// restore the scalar voltage planes
+	if (m_volt_nyP==NULL)
+		m_volt_nyP = Create2DArray<FDTD_FLOAT>(m_numLines);
+	if (m_volt_nyPP==NULL)
+		m_volt_nyPP = Create2DArray<FDTD_FLOAT>(m_numLines);
+}
+
+template <class Access>
+void Engine_Ext_Mur_ABC::PreVoltageUpdates(Access eng, unsigned int start, unsigned int num)
+{
 	unsigned int pos[] = {0,0,0};
 	unsigned int pos_shift[] = {0,0,0};
 	pos[m_ny] = m_LineNr;
 	pos_shift[m_ny] = m_LineNr_Shift;
+	for (unsigned int k=start; k<start+num; ++k)
+	{
+		unsigned int i = k/m_numLines[1];
+		unsigned int j = k%m_numLines[1];
+		pos[m_nyP] = pos_shift[m_nyP] = i;
+		pos[m_nyPP] = pos_shift[m_nyPP] = j;
+		m_volt_nyP[i][j] = eng.GetVolt(m_nyP,pos_shift) - m_Mur_Coeff_nyP[i][j] * eng.GetVolt(m_nyP,pos);
+		m_volt_nyPP[i][j] = eng.GetVolt(m_nyPP,pos_shift) - m_Mur_Coeff_nyPP[i][j] * eng.GetVolt(m_nyPP,pos);
+	}
+}
+
+template <class Access>
+void Engine_Ext_Mur_ABC::PostVoltageUpdates(Access eng, unsigned int start, unsigned int num)
+{
+	unsigned int pos_shift[] = {0,0,0};
+	pos_shift[m_ny] = m_LineNr_Shift;
+	for (unsigned int k=start; k<start+num; ++k)
+	{
+		unsigned int i = k/m_numLines[1];
+		unsigned int j = k%m_numLines[1];
+		pos_shift[m_nyP] = i;
+		pos_shift[m_nyPP] = j;
+		m_volt_nyP[i][j] += m_Mur_Coeff_nyP[i][j] * eng.GetVolt(m_nyP,pos_shift);
+		m_volt_nyPP[i][j] += m_Mur_Coeff_nyPP[i][j] * eng.GetVolt(m_nyPP,pos_shift);
+	}
+}
+
+template <class Access>
+void Engine_Ext_Mur_ABC::ApplyVoltages(Access eng, unsigned int start, unsigned int num)
+{
+	unsigned int pos[] = {0,0,0};
+	pos[m_ny] = m_LineNr;
+	for (unsigned int k=start; k<start+num; ++k)
+	{
+		unsigned int i = k/m_numLines[1];
+		unsigned int j = k%m_numLines[1];
+		pos[m_nyP] = i;
+		pos[m_nyPP] = j;
+		eng.SetVolt(m_nyP,pos, m_volt_nyP[i][j]);
+		eng.SetVolt(m_nyPP,pos, m_volt_nyPP[i][j]);
+	}
+}
+
+void Engine_Ext_Mur_ABC::PreVoltageUpdates_Packed(Engine_sse* eng, unsigned int start, unsigned int num)
+{
+	for (unsigned int k=start; k<start+num; ++k)
+	{
+		unsigned int line = k/m_numVectors;
+		unsigned int v = k%m_numVectors;
+		m_f4_volt_nyP[k].v = GetVoltVectors(eng,m_nyP,m_LineNr_Shift,line)[v].v - m_f4_Coeff_nyP[k].v * GetVoltVectors(eng,m_nyP,m_LineNr,line)[v].v;
+		m_f4_volt_nyPP[k].v = GetVoltVectors(eng,m_nyPP,m_LineNr_Shift,line)[v].v - m_f4_Coeff_nyPP[k].v * GetVoltVectors(eng,m_nyPP,m_LineNr,line)[v].v;
+	}
+}
+
+void Engine_Ext_Mur_ABC::PostVoltageUpdates_Packed(Engine_sse* eng, unsigned int start, unsigned int num)
+{
+	for (unsigned int k=start; k<start+num; ++k)
+	{
+		unsigned int line = k/m_numVectors;
+		unsigned int v = k%m_numVectors;
+		m_f4_volt_nyP[k].v += m_f4_Coeff_nyP[k].v * GetVoltVectors(eng,m_nyP,m_LineNr_Shift,line)[v].v;
+		m_f4_volt_nyPP[k].v += m_f4_Coeff_nyPP[k].v * GetVoltVectors(eng,m_nyPP,m_LineNr_Shift,line)[v].v;
+	}
+}
+
+void Engine_Ext_Mur_ABC::ApplyVoltages_Packed(Engine_sse* eng, unsigned int start, unsigned int num)
+{
+	for (unsigned int k=start; k<start+num; ++k)
+	{
+		unsigned int line = k/m_numVectors;
+		unsigned int v = k%m_numVectors;
+		GetVoltVectors(eng,m_nyP,m_LineNr,line)[v].v = m_f4_volt_nyP[k].v;
+		GetVoltVectors(eng,m_nyPP,m_LineNr,line)[v].v = m_f4_volt_nyPP[k].v;
+	}
+}
+
+void Engine_Ext_Mur_ABC::DoPreVoltageUpdates(int threadID)
+{
+	if (IsActive()==false) return;
+	if (m_Eng==NULL) return;
+	if (threadID>=m_NrThreads)
+		return;
+
+	if (m_numVectors>0)
+	{
+		PreVoltageUpdates_Packed((Engine_sse*) m_Eng, m_start.at(threadID), m_numPos.at(threadID));
+		return;
+	}
 
 	//switch for different engine types to access faster inline engine functions
 	switch (m_Eng->GetType())
 	{
 	case Engine::BASIC:
 		{
-			for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
-			{
-				pos[m_nyP]=lineX+m_start.at(threadID);
-				pos_shift[m_nyP] = pos[m_nyP];
-				for (pos[m_nyPP]=0; pos[m_nyPP]<m_numLines[1]; ++pos[m_nyPP])
-				{
-					pos_shift[m_nyPP] = pos[m_nyPP];
-					m_volt_nyP[pos[m_nyP]][pos[m_nyPP]] = m_Eng->Engine::GetVolt(m_nyP,pos_shift) - m_Op_mur->m_Mur_Coeff_nyP[pos[m_nyP]][pos[m_nyPP]] * m_Eng->Engine::GetVolt(m_nyP,pos);
-					m_volt_nyPP[pos[m_nyP]][pos[m_nyPP]] = m_Eng->Engine::GetVolt(m_nyPP,pos_shift) - m_Op_mur->m_Mur_Coeff_nyPP[pos[m_nyP]][pos[m_nyPP]] * m_Eng->Engine::GetVolt(m_nyPP,pos);
-				}
-			}
+			Engine_Access_Basic acc = {m_Eng};
+			PreVoltageUpdates(acc, m_start.at(threadID), m_numPos.at(threadID));
 			break;
 		}
 	case Engine::SSE:
 		{
-			Engine_sse* eng_sse = (Engine_sse*) m_Eng;
-			for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
-			{
-				pos[m_nyP]=lineX+m_start.at(threadID);
-				pos_shift[m_nyP] = pos[m_nyP];
-				for (pos[m_nyPP]=0; pos[m_nyPP]<m_numLines[1]; ++pos[m_nyPP])
-				{
-					pos_shift[m_nyPP] = pos[m_nyPP];
-					m_volt_nyP[pos[m_nyP]][pos[m_nyPP]] = eng_sse->Engine_sse::GetVolt(m_nyP,pos_shift) - m_Op_mur->m_Mur_Coeff_nyP[pos[m_nyP]][pos[m_nyPP]] * eng_sse->Engine_sse::GetVolt(m_nyP,pos);
-					m_volt_nyPP[pos[m_nyP]][pos[m_nyPP]] = eng_sse->Engine_sse::GetVolt(m_nyPP,pos_shift) - m_Op_mur->m_Mur_Coeff_nyPP[pos[m_nyP]][pos[m_nyPP]] * eng_sse->Engine_sse::GetVolt(m_nyPP,pos);
-				}
-			}
+			Engine_Access_SSE acc = {(Engine_sse*) m_Eng};
+			PreVoltageUpdates(acc, m_start.at(threadID), m_numPos.at(threadID));
 			break;
 		}
 	default:
-		for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
 		{
-			pos[m_nyP]=lineX+m_start.at(threadID);
-			pos_shift[m_nyP] = pos[m_nyP];
-			for (pos[m_nyPP]=0; pos[m_nyPP]<m_numLines[1]; ++pos[m_nyPP])
-			{
-				pos_shift[m_nyPP] = pos[m_nyPP];
-				m_volt_nyP[pos[m_nyP]][pos[m_nyPP]] = m_Eng->GetVolt(m_nyP,pos_shift) - m_Op_mur->m_Mur_Coeff_nyP[pos[m_nyP]][pos[m_nyPP]] * m_Eng->GetVolt(m_nyP,pos);
-				m_volt_nyPP[pos[m_nyP]][pos[m_nyPP]] = m_Eng->GetVolt(m_nyPP,pos_shift) - m_Op_mur->m_Mur_Coeff_nyPP[pos[m_nyP]][pos[m_nyPP]] * m_Eng->GetVolt(m_nyPP,pos);
-			}
+			Engine_Access_Virtual acc = {m_Eng};
+			PreVoltageUpdates(acc, m_start.at(threadID), m_numPos.at(threadID));
+			break;
 		}
-		break;
 	}
 }
 
@@ -149,60 +287,34 @@ void Engine_Ext_Mur_ABC::DoPostVoltageUpdates(int threadID)
 	if (m_Eng==NULL) return;
 	if (threadID>=m_NrThreads)
 		return;
-	unsigned int pos[] = {0,0,0};
-	unsigned int pos_shift[] = {0,0,0};
-	pos[m_ny] = m_LineNr;
-	pos_shift[m_ny] = m_LineNr_Shift;
+
+	if (m_numVectors>0)
+	{
+		PostVoltageUpdates_Packed((Engine_sse*) m_Eng, m_start.at(threadID), m_numPos.at(threadID));
+		return;
+	}
 
 	//switch for different engine types to access faster inline engine functions
 	switch (m_Eng->GetType())
 	{
 	case Engine::BASIC:
 		{
-			for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
-			{
-				pos[m_nyP]=lineX+m_start.at(threadID);
-				pos_shift[m_nyP] = pos[m_nyP];
-				for (pos[m_nyPP]=0; pos[m_nyPP]<m_numLines[1]; ++pos[m_nyPP])
-				{
-					pos_shift[m_nyPP] = pos[m_nyPP];
-					m_volt_nyP[pos[m_nyP]][pos[m_nyPP]] += m_Op_mur->m_Mur_Coeff_nyP[pos[m_nyP]][pos[m_nyPP]] * m_Eng->Engine::GetVolt(m_nyP,pos_shift);
-					m_volt_nyPP[pos[m_nyP]][pos[m_nyPP]] += m_Op_mur->m_Mur_Coeff_nyPP[pos[m_nyP]][pos[m_nyPP]] * m_Eng->Engine::GetVolt(m_nyPP,pos_shift);
-				}
-			}
+			Engine_Access_Basic acc = {m_Eng};
+			PostVoltageUpdates(acc, m_start.at(threadID), m_numPos.at(threadID));
 			break;
 		}
-
 	case Engine::SSE:
 		{
-			Engine_sse* eng_sse = (Engine_sse*) m_Eng;
-			for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
-			{
-				pos[m_nyP]=lineX+m_start.at(threadID);
-				pos_shift[m_nyP] = pos[m_nyP];
-				for (pos[m_nyPP]=0; pos[m_nyPP]<m_numLines[1]; ++pos[m_nyPP])
-				{
-					pos_shift[m_nyPP] = pos[m_nyPP];
-					m_volt_nyP[pos[m_nyP]][pos[m_nyPP]] += m_Op_mur->m_Mur_Coeff_nyP[pos[m_nyP]][pos[m_nyPP]] * eng_sse->Engine_sse::GetVolt(m_nyP,pos_shift);
-					m_volt_nyPP[pos[m_nyP]][pos[m_nyPP]] += m_Op_mur->m_Mur_Coeff_nyPP[pos[m_nyP]][pos[m_nyPP]] * eng_sse->Engine_sse::GetVolt(m_nyPP,pos_shift);
-				}
-			}
+			Engine_Access_SSE acc = {(Engine_sse*) m_Eng};
+			PostVoltageUpdates(acc, m_start.at(threadID), m_numPos.at(threadID));
 			break;
 		}
-
 	default:
-		for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
 		{
-			pos[m_nyP]=lineX+m_start.at(threadID);
-			pos_shift[m_nyP] = pos[m_nyP];
-			for (pos[m_nyPP]=0; pos[m_nyPP]<m_numLines[1]; ++pos[m_nyPP])
-			{
-				pos_shift[m_nyPP] = pos[m_nyPP];
-				m_volt_nyP[pos[m_nyP]][pos[m_nyPP]] += m_Op_mur->m_Mur_Coeff_nyP[pos[m_nyP]][pos[m_nyPP]] * m_Eng->GetVolt(m_nyP,pos_shift);
-				m_volt_nyPP[pos[m_nyP]][pos[m_nyPP]] += m_Op_mur->m_Mur_Coeff_nyPP[pos[m_nyP]][pos[m_nyPP]] * m_Eng->GetVolt(m_nyPP,pos_shift);
-			}
+			Engine_Access_Virtual acc = {m_Eng};
+			PostVoltageUpdates(acc, m_start.at(threadID), m_numPos.at(threadID));
+			break;
 		}
-		break;
 	}
 }
 
@@ -212,52 +324,33 @@ void Engine_Ext_Mur_ABC::Apply2Voltages(int threadID)
 	if (threadID>=m_NrThreads)
 		return;
 	if (m_Eng==NULL) return;
-	unsigned int pos[] = {0,0,0};
-	pos[m_ny] = m_LineNr;
+
+	if (m_numVectors>0)
+	{
+		ApplyVoltages_Packed((Engine_sse*) m_Eng, m_start.at(threadID), m_numPos.at(threadID));
+		return;
+	}
 
 	//switch for different engine types to access faster inline engine functions
 	switch (m_Eng->GetType())
 	{
 	case Engine::BASIC:
 		{
-			for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
-			{
-				pos[m_nyP]=lineX+m_start.at(threadID);
-				for (pos[m_nyPP]=0; pos[m_nyPP]<m_numLines[1]; ++pos[m_nyPP])
-				{
-					m_Eng->Engine::SetVolt(m_nyP,pos, m_volt_nyP[pos[m_nyP]][pos[m_nyPP]]);
-					m_Eng->Engine::SetVolt(m_nyPP,pos, m_volt_nyPP[pos[m_nyP]][pos[m_nyPP]]);
-				}
-			}
+			Engine_Access_Basic acc = {m_Eng};
+			ApplyVoltages(acc, m_start.at(threadID), m_numPos.at(threadID));
 			break;
 		}
-
 	case Engine::SSE:
 		{
-			Engine_sse* eng_sse = (Engine_sse*) m_Eng;
-			for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
-			{
-				pos[m_nyP]=lineX+m_start.at(threadID);
-				for (pos[m_nyPP]=0; pos[m_nyPP]<m_numLines[1]; ++pos[m_nyPP])
-				{
-					eng_sse->Engine_sse::SetVolt(m_nyP,pos, m_volt_nyP[pos[m_nyP]][pos[m_nyPP]]);
-					eng_sse->Engine_sse::SetVolt(m_nyPP,pos, m_volt_nyPP[pos[m_nyP]][pos[m_nyPP]]);
-				}
-			}
+			Engine_Access_SSE acc = {(Engine_sse*) m_Eng};
+			ApplyVoltages(acc, m_start.at(threadID), m_numPos.at(threadID));
 			break;
 		}
-
 	default:
-		for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
 		{
-			pos[m_nyP]=lineX+m_start.at(threadID);
-			for (pos[m_nyPP]=0; pos[m_nyPP]<m_numLines[1]; ++pos[m_nyPP])
-			{
-				m_Eng->SetVolt(m_nyP,pos, m_volt_nyP[pos[m_nyP]][pos[m_nyPP]]);
-				m_Eng->SetVolt(m_nyPP,pos, m_volt_nyPP[pos[m_nyP]][pos[m_nyPP]]);
-			}
+			Engine_Access_Virtual acc = {m_Eng};
+			ApplyVoltages(acc, m_start.at(threadID), m_numPos.at(threadID));
+			break;
 		}
-		break;
 	}
-
 }
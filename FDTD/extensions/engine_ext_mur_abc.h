@@ -21,6 +21,7 @@
 #include "engine_extension.h"
 #include "FDTD/engine.h"
 #include "FDTD/operator.h"
+#include "FDTD/engine_sse.h"
 
 class Operator_Ext_Mur_ABC;
 
@@ -32,6 +33,8 @@ public:
 
 	virtual void SetNumberOfThreads(int nrThread);
 
+	virtual void SetEngine(Engine* eng);
+
 	virtual void DoPreVoltageUpdates() {Engine_Ext_Mur_ABC::DoPreVoltageUpdates(0);}
 	virtual void DoPreVoltageUpdates(int threadID);
 	virtual void DoPostVoltageUpdates() {Engine_Ext_Mur_ABC::DoPostVoltageUpdates(0);}
@@ -51,13 +54,52 @@ protected:
 	int m_LineNr_Shift;
 	unsigned int m_numLines[2];
 
+	//! Distribute the boundary plane (or its packed vectors) to the threads
+	void AssignPlane2Threads();
+
+	//! Setup the packed storage if the engine uses sse vectors in z-direction and z is an in-plane direction of this abc
+	void InitPackedStorage();
+	void DeletePackedStorage();
+
+	//! Get the sse vectors of the given component along z at the abc line (or the shifted line) and the in-plane line \a line
+	inline f4vector* GetVoltVectors(Engine_sse* eng, int n, unsigned int lineNr, unsigned int line) const
+	{
+		if (m_ny==0)
+			return eng->f4_volt[n][lineNr][line];
+		return eng->f4_volt[n][line][lineNr];
+	}
+
+	//! Mur update of the given range of plane positions, numbered pos[m_nyP]*m_numLines[1]+pos[m_nyPP], \a Access provides the (fast) field access of the engine type
+	template <class Access>
+	void PreVoltageUpdates(Access eng, unsigned int start, unsigned int num);
+	template <class Access>
+	void PostVoltageUpdates(Access eng, unsigned int start, unsigned int num);
+	template <class Access>
+	void ApplyVoltages(Access eng, unsigned int start, unsigned int num);
+
+	//! Packed Mur update of the given range of sse vectors, numbered line*m_numVectors+vector
+	void PreVoltageUpdates_Packed(Engine_sse* eng, unsigned int start, unsigned int num);
+	void PostVoltageUpdates_Packed(Engine_sse* eng, unsigned int start, unsigned int num);
+	void ApplyVoltages_Packed(Engine_sse* eng, unsigned int start, unsigned int num);
+
+	//! first plane position (or packed vector) for each thread
 	vector<unsigned int> m_start;
-	vector<unsigned int> m_numX;
+	//! number of plane positions (or packed vectors) for each thread
+	vector<unsigned int> m_numPos;
 
 	FDTD_FLOAT** m_Mur_Coeff_nyP;
 	FDTD_FLOAT** m_Mur_Coeff_nyPP;
 	FDTD_FLOAT** m_volt_nyP; //n+1 direction
 	FDTD_FLOAT** m_volt_nyPP; //n+2 direction
+
+	//! number of sse vectors in z-direction, zero if the packed storage is not used
+	unsigned int m_numVectors;
+	//! the in-plane direction which is not z, the packed storage is numbered line*m_numVectors+vector
+	int m_lineDir;
+	f4vector* m_f4_Coeff_nyP;
+	f4vector* m_f4_Coeff_nyPP;
+	f4vector* m_f4_volt_nyP;
+	f4vector* m_f4_volt_nyPP;
 };
 
 #endif // ENGINE_EXT_MUR_ABC_H
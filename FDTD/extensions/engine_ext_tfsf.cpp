@@ -17,199 +17,175 @@
 
 #include "engine_ext_tfsf.h"
 #include "operator_ext_tfsf.h"
-#include "FDTD/engine_sse.h"
+#include "engine_field_access.h"
+#include "tools/useful.h"
+
+//! number of injection points calculated at once
+#define TFSF_BLOCK_SIZE 256
 
 Engine_Ext_TFSF::Engine_Ext_TFSF(Operator_Ext_TFSF* op_ext) : Engine_Extension(op_ext)
 {
 	m_Op_TFSF = op_ext;
 	m_Priority = ENG_EXT_PRIO_TFSF;
 
-	m_DelayLookup = new unsigned int[m_Op_TFSF->m_maxDelay+1];
+	SetNumberOfThreads(1);
 }
 
 Engine_Ext_TFSF::~Engine_Ext_TFSF()
 {
-	delete[] m_DelayLookup;
-	m_DelayLookup = NULL;
 }
 
-void Engine_Ext_TFSF::DoPostVoltageUpdates()
+void Engine_Ext_TFSF::SplitInjection(const Operator_Ext_TFSF::Injection& inj, vector<unsigned int> &start)
 {
-	unsigned int numTS = m_Eng->GetNumberOfTimesteps();
-	unsigned int length = m_Op_TFSF->m_Exc->GetLength();
-
-	int p = int(m_Op_TFSF->m_Exc->GetSignalPeriod()/m_Op_TFSF->m_Exc->GetTimestep());
-
-	for (unsigned int n=0;n<=m_Op_TFSF->m_maxDelay;++n)
+	unsigned int num = inj.dir.size();
+	start.resize(m_NrThreads+1);
+	start.at(0) = 0;
+	for (int t=1; t<m_NrThreads; ++t)
 	{
-		if ( numTS < n )
-			m_DelayLookup[n]=0;
-		else if ((numTS-n >= length) && (p==0))
-			m_DelayLookup[n]=0;
-		else
-			m_DelayLookup[n] = numTS - n;
-		if (p>0)
-			m_DelayLookup[n] = (m_DelayLookup[n] % p);
+		unsigned int k = max(start.at(t-1), (unsigned int)((double)num*t/m_NrThreads));
+		// edges of adjacent faces may inject into the same field component twice, keep these points within one thread
+		while ((k>0) && (k<num) && (inj.dir[k]==inj.dir[k-1]) && (inj.pos[0][k]==inj.pos[0][k-1]) && (inj.pos[1][k]==inj.pos[1][k-1]) && (inj.pos[2][k]==inj.pos[2][k-1]))
+			++k;
+		start.at(t) = k;
 	}
+	start.at(m_NrThreads) = num;
+}
 
-	//get the current signal since an H-field is added ...
-	FDTD_FLOAT* signal =  m_Op_TFSF->m_Exc->GetCurrentSignal();
-
-	int nP,nPP;
-	unsigned int ui_pos;
-	unsigned int pos[3];
-	for (int n=0;n<3;++n)
-	{
-		nP = (n+1)%3;
-		nPP = (n+2)%3;
-
-		// lower plane
-		pos[nP] = m_Op_TFSF->m_Start[nP];
-		ui_pos = 0;
-		if (m_Op_TFSF->m_ActiveDir[n][0])
-		{
-
-			for (unsigned int i=0;i<m_Op_TFSF->m_numLines[nP];++i)
-			{
-				pos[nPP] = m_Op_TFSF->m_Start[nPP];
-				for (unsigned int j=0;j<m_Op_TFSF->m_numLines[nPP];++j)
-				{
-					// current updates
-					pos[n] = m_Op_TFSF->m_Start[n];
-
-					m_Eng->SetVolt(nP,pos, m_Eng->GetVolt(nP,pos)
-								   + (1.0-m_Op_TFSF->m_VoltDelayDelta[n][0][0][ui_pos])*m_Op_TFSF->m_VoltAmp[n][0][0][ui_pos]*signal[m_DelayLookup[  m_Op_TFSF->m_VoltDelay[n][0][0][ui_pos]]]
-								   +      m_Op_TFSF->m_VoltDelayDelta[n][0][0][ui_pos] *m_Op_TFSF->m_VoltAmp[n][0][0][ui_pos]*signal[m_DelayLookup[1+m_Op_TFSF->m_VoltDelay[n][0][0][ui_pos]]] );
-
-					m_Eng->SetVolt(nPP,pos, m_Eng->GetVolt(nPP,pos)
-								   + (1.0-m_Op_TFSF->m_VoltDelayDelta[n][0][1][ui_pos])*m_Op_TFSF->m_VoltAmp[n][0][1][ui_pos]*signal[m_DelayLookup[  m_Op_TFSF->m_VoltDelay[n][0][1][ui_pos]]]
-								   +      m_Op_TFSF->m_VoltDelayDelta[n][0][1][ui_pos] *m_Op_TFSF->m_VoltAmp[n][0][1][ui_pos]*signal[m_DelayLookup[1+m_Op_TFSF->m_VoltDelay[n][0][1][ui_pos]]] );
-
-					++pos[nPP];
-					++ui_pos;
-				}
-				++pos[nP];
-			}
-		}
+void Engine_Ext_TFSF::SetNumberOfThreads(int nrThread)
+{
+	Engine_Extension::SetNumberOfThreads(nrThread);
 
-		// upper plane
-		pos[nP] = m_Op_TFSF->m_Start[nP];
-		ui_pos = 0;
-		if (m_Op_TFSF->m_ActiveDir[n][1])
-		{
+	SplitInjection(m_Op_TFSF->m_VoltInj, m_VoltStart);
+	SplitInjection(m_Op_TFSF->m_CurrInj, m_CurrStart);
 
-			for (unsigned int i=0;i<m_Op_TFSF->m_numLines[nP];++i)
-			{
-				pos[nPP] = m_Op_TFSF->m_Start[nPP];
-				for (unsigned int j=0;j<m_Op_TFSF->m_numLines[nPP];++j)
-				{
-					// current updates
-					pos[n] = m_Op_TFSF->m_Stop[n];
-
-					m_Eng->SetVolt(nP,pos, m_Eng->GetVolt(nP,pos)
-								   + (1.0-m_Op_TFSF->m_VoltDelayDelta[n][1][0][ui_pos])*m_Op_TFSF->m_VoltAmp[n][1][0][ui_pos]*signal[m_DelayLookup[  m_Op_TFSF->m_VoltDelay[n][1][0][ui_pos]]]
-								   +      m_Op_TFSF->m_VoltDelayDelta[n][1][0][ui_pos] *m_Op_TFSF->m_VoltAmp[n][1][0][ui_pos]*signal[m_DelayLookup[1+m_Op_TFSF->m_VoltDelay[n][1][0][ui_pos]]] );
-
-					m_Eng->SetVolt(nPP,pos, m_Eng->GetVolt(nPP,pos)
-								   + (1.0-m_Op_TFSF->m_VoltDelayDelta[n][1][1][ui_pos])*m_Op_TFSF->m_VoltAmp[n][1][1][ui_pos]*signal[m_DelayLookup[  m_Op_TFSF->m_VoltDelay[n][1][1][ui_pos]]]
-								   +      m_Op_TFSF->m_VoltDelayDelta[n][1][1][ui_pos] *m_Op_TFSF->m_VoltAmp[n][1][1][ui_pos]*signal[m_DelayLookup[1+m_Op_TFSF->m_VoltDelay[n][1][1][ui_pos]]] );
-
-					++pos[nPP];
-					++ui_pos;
-				}
-				++pos[nP];
-			}
-		}
-	}
+	m_DelayedSignal.resize(m_NrThreads);
+	for (int t=0; t<m_NrThreads; ++t)
+		m_DelayedSignal.at(t).resize(m_Op_TFSF->m_maxDelay+1);
 }
 
-void Engine_Ext_TFSF::DoPostCurrentUpdates()
+void Engine_Ext_TFSF::CalcDelayedSignal(FDTD_FLOAT* signal, FDTD_FLOAT* delayed)
 {
 	unsigned int numTS = m_Eng->GetNumberOfTimesteps();
 	unsigned int length = m_Op_TFSF->m_Exc->GetLength();
 
 	int p = int(m_Op_TFSF->m_Exc->GetSignalPeriod()/m_Op_TFSF->m_Exc->GetTimestep());
 
-	for (unsigned int n=0;n<m_Op_TFSF->m_maxDelay;++n)
+	unsigned int index;
+	for (unsigned int n=0;n<=m_Op_TFSF->m_maxDelay;++n)
 	{
 		if ( numTS < n )
-			m_DelayLookup[n]=0;
+			index=0;
 		else if ((numTS-n >= length) && (p==0))
-			m_DelayLookup[n]=0;
+			index=0;
 		else
-			m_DelayLookup[n] = numTS - n;
+			index = numTS - n;
 		if (p>0)
-			m_DelayLookup[n] = (m_DelayLookup[n] % p);
+			index = (index % p);
+		delayed[n] = signal[index];
 	}
+}
 
-	//get the current signal since an E-field is added ...
-	FDTD_FLOAT* signal =  m_Op_TFSF->m_Exc->GetVoltageSignal();
+template <class Access>
+void Engine_Ext_TFSF::ApplyInjection(Access eng, bool volt, const FDTD_FLOAT* delayed, unsigned int start, unsigned int stop)
+{
+	const Operator_Ext_TFSF::Injection &inj = volt ? m_Op_TFSF->m_VoltInj : m_Op_TFSF->m_CurrInj;
+	const unsigned int* pos_x = &inj.pos[0][0];
+	const unsigned int* pos_y = &inj.pos[1][0];
+	const unsigned int* pos_z = &inj.pos[2][0];
+	FDTD_FLOAT inc[TFSF_BLOCK_SIZE];
 
-	int nP,nPP;
-	unsigned int ui_pos;
-	unsigned int pos[3];
-	for (int n=0;n<3;++n)
+	for (unsigned int block=start; block<stop; block+=TFSF_BLOCK_SIZE)
 	{
-		if (!m_Op_TFSF->m_ActiveDir[n][0] && !m_Op_TFSF->m_ActiveDir[n][1])
-			continue;
+		unsigned int num = min(stop-block, (unsigned int)TFSF_BLOCK_SIZE);
+
+		//calculate the incident field on contiguous arrays
+		const unsigned int* delay = &inj.delay[block];
+		const FDTD_FLOAT* amp_lo = &inj.amp_lo[block];
+		const FDTD_FLOAT* amp_hi = &inj.amp_hi[block];
+		for (unsigned int i=0; i<num; ++i)
+			inc[i] = amp_lo[i]*delayed[delay[i]] + amp_hi[i]*delayed[delay[i]+1];
+
+		//add it to the engine fields, the points are sorted in memory order
+		const unsigned int* dir = &inj.dir[block];
+		if (volt)
+			for (unsigned int i=0; i<num; ++i)
+				eng.SetVolt(dir[i], pos_x[block+i], pos_y[block+i], pos_z[block+i], eng.GetVolt(dir[i], pos_x[block+i], pos_y[block+i], pos_z[block+i]) + inc[i]);
+		else
+			for (unsigned int i=0; i<num; ++i)
+				eng.SetCurr(dir[i], pos_x[block+i], pos_y[block+i], pos_z[block+i], eng.GetCurr(dir[i], pos_x[block+i], pos_y[block+i], pos_z[block+i]) + inc[i]);
+	}
+}
 
-		nP = (n+1)%3;
-		nPP = (n+2)%3;
+void Engine_Ext_TFSF::DoPostVoltageUpdates(int threadID)
+{
+	if (threadID>=m_NrThreads)
+		return;
+	unsigned int start = m_VoltStart.at(threadID);
+	unsigned int stop = m_VoltStart.at(threadID+1);
+	if (start>=stop)
+		return;
+
+	//get the current signal since an H-field is added ...
+	FDTD_FLOAT* delayed = &m_DelayedSignal.at(threadID)[0];
+	CalcDelayedSignal(m_Op_TFSF->m_Exc->GetCurrentSignal(), delayed);
 
-		// lower plane
-		pos[nP] = m_Op_TFSF->m_Start[nP];
-		ui_pos = 0;
-		if (m_Op_TFSF->m_ActiveDir[n][0])
+	//switch for different engine types to access faster inline engine functions
+	switch (m_Eng->GetType())
+	{
+	case Engine::BASIC:
+		{
+			Engine_Access_Basic acc = {m_Eng};
+			ApplyInjection(acc, true, delayed, start, stop);
+			break;
+		}
+	case Engine::SSE:
+		{
+			Engine_Access_SSE acc = {(Engine_sse*) m_Eng};
+			ApplyInjection(acc, true, delayed, start, stop);
+			break;
+		}
+	default:
 		{
-			for (unsigned int i=0;i<m_Op_TFSF->m_numLines[nP];++i)
-			{
-				pos[nPP] = m_Op_TFSF->m_Start[nPP];
-				for (unsigned int j=0;j<m_Op_TFSF->m_numLines[nPP];++j)
-				{
-					// current updates
-					pos[n] = m_Op_TFSF->m_Start[n]-1;
-
-					m_Eng->SetCurr(nP,pos, m_Eng->GetCurr(nP,pos)
-								   + (1.0-m_Op_TFSF->m_CurrDelayDelta[n][0][0][ui_pos])*m_Op_TFSF->m_CurrAmp[n][0][0][ui_pos]*signal[m_DelayLookup[  m_Op_TFSF->m_CurrDelay[n][0][0][ui_pos]]]
-								   +      m_Op_TFSF->m_CurrDelayDelta[n][0][0][ui_pos] *m_Op_TFSF->m_CurrAmp[n][0][0][ui_pos]*signal[m_DelayLookup[1+m_Op_TFSF->m_CurrDelay[n][0][0][ui_pos]]] );
-
-					m_Eng->SetCurr(nPP,pos, m_Eng->GetCurr(nPP,pos)
-								   + (1.0-m_Op_TFSF->m_CurrDelayDelta[n][0][1][ui_pos])*m_Op_TFSF->m_CurrAmp[n][0][1][ui_pos]*signal[m_DelayLookup[  m_Op_TFSF->m_CurrDelay[n][0][1][ui_pos]]]
-								   +      m_Op_TFSF->m_CurrDelayDelta[n][0][1][ui_pos] *m_Op_TFSF->m_CurrAmp[n][0][1][ui_pos]*signal[m_DelayLookup[1+m_Op_TFSF->m_CurrDelay[n][0][1][ui_pos]]] );
-
-					++pos[nPP];
-					++ui_pos;
-				}
-				++pos[nP];
-			}
+			Engine_Access_Virtual acc = {m_Eng};
+			ApplyInjection(acc, true, delayed, start, stop);
+			break;
 		}
+	}
+}
 
-		// upper plane
-		pos[nP] = m_Op_TFSF->m_Start[nP];
-		ui_pos = 0;
-		if (m_Op_TFSF->m_ActiveDir[n][1])
+void Engine_Ext_TFSF::DoPostCurrentUpdates(int threadID)
+{
+	if (threadID>=m_NrThreads)
+		return;
+	unsigned int start = m_CurrStart.at(threadID);
+	unsigned int stop = m_CurrStart.at(threadID+1);
+	if (start>=stop)
+		return;
+
+	//get the voltage signal since an E-field is added ...
+	FDTD_FLOAT* delayed = &m_DelayedSignal.at(threadID)[0];
+	CalcDelayedSignal(m_Op_TFSF->m_Exc->GetVoltageSignal(), delayed);
+
+	//switch for different engine types to access faster inline engine functions
+	switch (m_Eng->GetType())
+	{
+	case Engine::BASIC:
+		{
+			Engine_Access_Basic acc = {m_Eng};
+			ApplyInjection(acc, false, delayed, start, stop);
+			break;
+		}
+	case Engine::SSE:
+		{
+			Engine_Access_SSE acc = {(Engine_sse*) m_Eng};
+			ApplyInjection(acc, false, delayed, start, stop);
+			break;
+		}
+	default:
 		{
-			for (unsigned int i=0;i<m_Op_TFSF->m_numLines[nP];++i)
-			{
-				pos[nPP] = m_Op_TFSF->m_Start[nPP];
-				for (unsigned int j=0;j<m_Op_TFSF->m_numLines[nPP];++j)
-				{
-					// current updates
-					pos[n] = m_Op_TFSF->m_Stop[n];
-
-					m_Eng->SetCurr(nP,pos, m_Eng->GetCurr(nP,pos)
-								   + (1.0-m_Op_TFSF->m_CurrDelayDelta[n][1][0][ui_pos])*m_Op_TFSF->m_CurrAmp[n][1][0][ui_pos]*signal[m_DelayLookup[  m_Op_TFSF->m_CurrDelay[n][1][0][ui_pos]]]
-								   +      m_Op_TFSF->m_CurrDelayDelta[n][1][0][ui_pos] *m_Op_TFSF->m_CurrAmp[n][1][0][ui_pos]*signal[m_DelayLookup[1+m_Op_TFSF->m_CurrDelay[n][1][0][ui_pos]]] );
-
-					m_Eng->SetCurr(nPP,pos, m_Eng->GetCurr(nPP,pos)
-								   + (1.0-m_Op_TFSF->m_CurrDelayDelta[n][1][1][ui_pos])*m_Op_TFSF->m_CurrAmp[n][1][1][ui_pos]*signal[m_DelayLookup[  m_Op_TFSF->m_CurrDelay[n][1][1][ui_pos]]]
-								   +      m_Op_TFSF->m_CurrDelayDelta[n][1][1][ui_pos] *m_Op_TFSF->m_CurrAmp[n][1][1][ui_pos]*signal[m_DelayLookup[1+m_Op_TFSF->m_CurrDelay[n][1][1][ui_pos]]] );
-
-					++pos[nPP];
-					++ui_pos;
-				}
-				++pos[nP];
-			}
+			Engine_Access_Virtual acc = {m_Eng};
+			ApplyInjection(acc, false, delayed, start, stop);
+			break;
 		}
 	}
 }
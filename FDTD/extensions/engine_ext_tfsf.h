@@ -19,8 +19,7 @@
 #define ENGINE_EXT_TFSF_H
 
 #include "engine_extension.h"
-
-class Operator_Ext_TFSF;
+#include "operator_ext_tfsf.h"
 
 class Engine_Ext_TFSF : public Engine_Extension
 {
@@ -28,13 +27,32 @@ public:
 	Engine_Ext_TFSF(Operator_Ext_TFSF* op_ext);
 	virtual ~Engine_Ext_TFSF();
 
-	virtual void DoPostVoltageUpdates();
-	virtual void DoPostCurrentUpdates();
+	virtual void SetNumberOfThreads(int nrThread);
+
+	virtual void DoPostVoltageUpdates() {Engine_Ext_TFSF::DoPostVoltageUpdates(0);}
+	virtual void DoPostVoltageUpdates(int threadID);
+	virtual void DoPostCurrentUpdates() {Engine_Ext_TFSF::DoPostCurrentUpdates(0);}
+	virtual void DoPostCurrentUpdates(int threadID);
 
 protected:
 	Operator_Ext_TFSF* m_Op_TFSF;
 
-	unsigned int* m_DelayLookup;
+	//! Calculate the delayed excitation signal for all delays of the current timestep
+	void CalcDelayedSignal(FDTD_FLOAT* signal, FDTD_FLOAT* delayed);
+
+	//! Add the incident field to the injection points [start,stop), \a Access provides the (fast) field access of the engine type
+	template <class Access>
+	void ApplyInjection(Access eng, bool volt, const FDTD_FLOAT* delayed, unsigned int start, unsigned int stop);
+
+	//! Distribute the injection points over the threads, points of the same field component are never split
+	void SplitInjection(const Operator_Ext_TFSF::Injection& inj, vector<unsigned int> &start);
+
+	//! first injection point of each thread, the last entry is the total number of points
+	vector<unsigned int> m_VoltStart;
+	vector<unsigned int> m_CurrStart;
+
+	//! delayed signal for each thread, array setup [threadID][delay]
+	vector< vector<FDTD_FLOAT> > m_DelayedSignal;
 };
 
 #endif // ENGINE_EXT_TFSF_H
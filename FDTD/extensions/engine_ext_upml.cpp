@@ -32,6 +32,16 @@ Engine_Ext_UPML::Engine_Ext_UPML(Operator_Ext_UPML* op_ext) : Engine_Extension(o
 	volt_flux = Create_N_3DArray<FDTD_FLOAT>(m_Op_UPML->m_numLines);
 	curr_flux = Create_N_3DArray<FDTD_FLOAT>(m_Op_UPML->m_numLines);
 
+	m_numVectors = 0;
+	f4_volt_flux = NULL;
+	f4_curr_flux = NULL;
+	f4_vv = NULL;
+	f4_vvfo = NULL;
+	f4_vvfn = NULL;
+	f4_ii = NULL;
+	f4_iifo = NULL;
+	f4_iifn = NULL;
+
 	SetNumberOfThreads(1);
 }
 
@@ -41,61 +51,145 @@ Engine_Ext_UPML::~Engine_Ext_UPML()
 	volt_flux=NULL;
 	Delete_N_3DArray<FDTD_FLOAT>(curr_flux,m_Op_UPML->m_numLines);
 	curr_flux=NULL;
+	DeletePackedStorage();
 }
 
 void Engine_Ext_UPML::SetNumberOfThreads(int nrThread)
 {
 	Engine_Extension::SetNumberOfThreads(nrThread);
 
-	m_numX = AssignJobs2Threads(m_Op_UPML->m_numLines[0],m_NrThreads,false);
+	// distribute all (x,y)-columns of the upml box, a pml slab may only be a few lines thick in x-direction
+	m_numCols = AssignJobs2Threads(m_Op_UPML->m_numLines[0]*m_Op_UPML->m_numLines[1],m_NrThreads,false);
 	m_start.resize(m_NrThreads,0);
 	m_start.at(0)=0;
-	for (size_t n=1; n<m_numX.size(); ++n)
-		m_start.at(n) = m_start.at(n-1) + m_numX.at(n-1);
+	for (size_t n=1; n<m_numCols.size(); ++n)
+		m_start.at(n) = m_start.at(n-1) + m_numCols.at(n-1);
 }
 
+void Engine_Ext_UPML::SetEngine(Engine* eng)
+{
+	Engine_Extension::SetEngine(eng);
+	InitPackedStorage();
+}
+
+void Engine_Ext_UPML::InitPackedStorage()
+{
+	DeletePackedStorage();
+	m_zVector.clear();
+	m_zElement.clear();
+	if ((m_Eng==NULL) || (m_Eng->GetType()!=Engine::SSE))
+		return;
+
+	Engine_sse* eng_sse = (Engine_sse*) m_Eng;
+	unsigned int numVectors = eng_sse->GetNumberOfVectors();
+	for (unsigned int z=0; z<m_Op_UPML->m_numLines[2]; ++z)
+	{
+		m_zVector.push_back((z+m_Op_UPML->m_StartPos[2])%numVectors);
+		m_zElement.push_back((z+m_Op_UPML->m_StartPos[2])/numVectors);
+	}
+
+	// the packed layout requires the full z-range, e.g. a pml in z-direction is distributed over all sse vectors
+	if ((m_Op_UPML->m_StartPos[2]!=0) || (m_Op_UPML->m_numLines[2]!=m_Op_UPML->m_Op->GetNumberOfLines(2,true)))
+		return;
+
+	m_numVectors = numVectors;
+	f4_volt_flux = Create_N_3DArray_v4sf(m_Op_UPML->m_numLines);
+	f4_curr_flux = Create_N_3DArray_v4sf(m_Op_UPML->m_numLines);
+	f4_vv   = Create_N_3DArray_v4sf(m_Op_UPML->m_numLines);
+	f4_vvfo = Create_N_3DArray_v4sf(m_Op_UPML->m_numLines);
+	f4_vvfn = Create_N_3DArray_v4sf(m_Op_UPML->m_numLines);
+	f4_ii   = Create_N_3DArray_v4sf(m_Op_UPML->m_numLines);
+	f4_iifo = Create_N_3DArray_v4sf(m_Op_UPML->m_numLines);
+	f4_iifn = Create_N_3DArray_v4sf(m_Op_UPML->m_numLines);
+
+	// copy the coefficients, the padding elements of the last vectors remain zero
+	unsigned int loc_pos[3];
+	for (int n=0; n<3; ++n)
+		for (loc_pos[0]=0; loc_pos[0]<m_Op_UPML->m_numLines[0]; ++loc_pos[0])
+			for (loc_pos[1]=0; loc_pos[1]<m_Op_UPML->m_numLines[1]; ++loc_pos[1])
+				for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
+				{
+					unsigned int v = m_zVector.at(loc_pos[2]);
+					unsigned int e = m_zElement.at(loc_pos[2]);
+					f4_vv[n][loc_pos[0]][loc_pos[1]][v].f[e]   = m_Op_UPML->vv[n][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					f4_vvfo[n][loc_pos[0]][loc_pos[1]][v].f[e] = m_Op_UPML->vvfo[n][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					f4_vvfn[n][loc_pos[0]][loc_pos[1]][v].f[e] = m_Op_UPML->vvfn[n][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					f4_ii[n][loc_pos[0]][loc_pos[1]][v].f[e]   = m_Op_UPML->ii[n][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					f4_iifo[n][loc_pos[0]][loc_pos[1]][v].f[e] = m_Op_UPML->iifo[n][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					f4_iifn[n][loc_pos[0]][loc_pos[1]][v].f[e] = m_Op_UPML->iifn[n][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+				}
+
+	// the scalar flux is not used by the packed update
+	Delete_N_3DArray<FDTD_FLOAT>(volt_flux,m_Op_UPML->m_numLines);
+	volt_flux=NULL;
+	Delete_N_3DArray<FDTD_FLOAT>(curr_flux,m_Op_UPML->m_numLines);
+	curr_flux=NULL;
+}
+
+void Engine_Ext_UPML::DeletePackedStorage()
+{
+	if (f4_volt_flux==NULL)
+		return;
+	Delete_N_3DArray_v4sf(f4_volt_flux,m_Op_UPML->m_numLines);
+	Delete_N_3DArray_v4sf(f4_curr_flux,m_Op_UPML->m_numLines);
+	Delete_N_3DArray_v4sf(f4_vv,m_Op_UPML->m_numLines);
+	Delete_N_3DArray_v4sf(f4_vvfo,m_Op_UPML->m_numLines);
+	Delete_N_3DArray_v4sf(f4_vvfn,m_Op_UPML->m_numLines);
+	Delete_N_3DArray_v4sf(f4_ii,m_Op_UPML->m_numLines);
+	Delete_N_3DArray_v4sf(f4_iifo,m_Op_UPML->m_numLines);
+	Delete_N_3DArray_v4sf(f4_iifn,m_Op_UPML->m_numLines);
+	f4_volt_flux = f4_curr_flux = NULL;
+	f4_vv = f4_vvfo = f4_vvfn = NULL;
+	f4_ii = f4_iifo = f4_iifn = NULL;
+
+	// restore the scalar flux storage
+	if (volt_flux==NULL)
+		volt_flux = Create_N_3DArray<FDTD_FLOAT>(m_Op_UPML->m_numLines);
+	if (curr_flux==NULL)
+		curr_flux = Create_N_3DArray<FDTD_FLOAT>(m_Op_UPML->m_numLines);
+}
 
 void Engine_Ext_UPML::DoPreVoltageUpdates(int threadID)
 {
 	if (m_Eng==NULL)
 		return;
-
 	if (threadID>=m_NrThreads)
 		return;
 
 	unsigned int pos[3];
 	unsigned int loc_pos[3];
+	unsigned int v, e;
 	FDTD_FLOAT f_help;
+	f4vector f4_help;
+
 	switch (m_Eng->GetType())
 	{
 	case Engine::BASIC:
 		{
-			for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
+			for (unsigned int col=m_start.at(threadID); col<m_start.at(threadID)+m_numCols.at(threadID); ++col)
 			{
-				loc_pos[0]=lineX+m_start.at(threadID);
+				loc_pos[0] = col/m_Op_UPML->m_numLines[1];
+				loc_pos[1] = col%m_Op_UPML->m_numLines[1];
 				pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
-				for (loc_pos[1]=0; loc_pos[1]<m_Op_UPML->m_numLines[1]; ++loc_pos[1])
+				pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
+				for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
 				{
-					pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
-					for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
-					{
-						pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
-
-						f_help = m_Op_UPML->vv[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->Engine::GetVolt(0,pos)
-						         - m_Op_UPML->vvfo[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						m_Eng->Engine::SetVolt(0,pos, volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
-						volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
-
-						f_help = m_Op_UPML->vv[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->Engine::GetVolt(1,pos)
-						         - m_Op_UPML->vvfo[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						m_Eng->Engine::SetVolt(1,pos, volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
-						volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
-
-						f_help = m_Op_UPML->vv[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->Engine::GetVolt(2,pos)
-						         - m_Op_UPML->vvfo[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						m_Eng->Engine::SetVolt(2,pos, volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
-						volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
-					}
+					pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
+
+					f_help = m_Op_UPML->vv[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->Engine::GetVolt(0,pos)
+					         - m_Op_UPML->vvfo[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					m_Eng->Engine::SetVolt(0,pos, volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
+
+					f_help = m_Op_UPML->vv[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->Engine::GetVolt(1,pos)
+					         - m_Op_UPML->vvfo[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					m_Eng->Engine::SetVolt(1,pos, volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
+
+					f_help = m_Op_UPML->vv[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->Engine::GetVolt(2,pos)
+					         - m_Op_UPML->vvfo[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					m_Eng->Engine::SetVolt(2,pos, volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
 				}
 			}
 			break;
@@ -103,30 +197,60 @@ void Engine_Ext_UPML::DoPreVoltageUpdates(int threadID)
 	case Engine::SSE:
 		{
 			Engine_sse* eng_sse = (Engine_sse*) m_Eng;
-			for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
+			if (f4_volt_flux)
 			{
-				loc_pos[0]=lineX+m_start.at(threadID);
-				pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
-				for (loc_pos[1]=0; loc_pos[1]<m_Op_UPML->m_numLines[1]; ++loc_pos[1])
+				// packed storage, update whole sse vectors
+				for (unsigned int col=m_start.at(threadID); col<m_start.at(threadID)+m_numCols.at(threadID); ++col)
+				{
+					loc_pos[0] = col/m_Op_UPML->m_numLines[1];
+					loc_pos[1] = col%m_Op_UPML->m_numLines[1];
+					pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
+					pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
+					for (v=0; v<m_numVectors; ++v)
+					{
+						f4_help.v = f4_vv[0][loc_pos[0]][loc_pos[1]][v].v * eng_sse->f4_volt[0][pos[0]][pos[1]][v].v
+						            - f4_vvfo[0][loc_pos[0]][loc_pos[1]][v].v * f4_volt_flux[0][loc_pos[0]][loc_pos[1]][v].v;
+						eng_sse->f4_volt[0][pos[0]][pos[1]][v].v = f4_volt_flux[0][loc_pos[0]][loc_pos[1]][v].v;
+						f4_volt_flux[0][loc_pos[0]][loc_pos[1]][v].v = f4_help.v;
+
+						f4_help.v = f4_vv[1][loc_pos[0]][loc_pos[1]][v].v * eng_sse->f4_volt[1][pos[0]][pos[1]][v].v
+						            - f4_vvfo[1][loc_pos[0]][loc_pos[1]][v].v * f4_volt_flux[1][loc_pos[0]][loc_pos[1]][v].v;
+						eng_sse->f4_volt[1][pos[0]][pos[1]][v].v = f4_volt_flux[1][loc_pos[0]][loc_pos[1]][v].v;
+						f4_volt_flux[1][loc_pos[0]][loc_pos[1]][v].v = f4_help.v;
+
+						f4_help.v = f4_vv[2][loc_pos[0]][loc_pos[1]][v].v * eng_sse->f4_volt[2][pos[0]][pos[1]][v].v
+						            - f4_vvfo[2][loc_pos[0]][loc_pos[1]][v].v * f4_volt_flux[2][loc_pos[0]][loc_pos[1]][v].v;
+						eng_sse->f4_volt[2][pos[0]][pos[1]][v].v = f4_volt_flux[2][loc_pos[0]][loc_pos[1]][v].v;
+						f4_volt_flux[2][loc_pos[0]][loc_pos[1]][v].v = f4_help.v;
+					}
+				}
+			}
+			else
+			{
+				for (unsigned int col=m_start.at(threadID); col<m_start.at(threadID)+m_numCols.at(threadID); ++col)
 				{
+					loc_pos[0] = col/m_Op_UPML->m_numLines[1];
+					loc_pos[1] = col%m_Op_UPML->m_numLines[1];
+					pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
 					pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
 					for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
 					{
-						pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
+						v = m_zVector[loc_pos[2]];
+						e = m_zElement[loc_pos[2]];
 
-						f_help = m_Op_UPML->vv[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * eng_sse->Engine_sse::GetVolt(0,pos)
+						f_help = m_Op_UPML->vv[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * eng_sse->f4_volt[0][pos[0]][pos[1]][v].f[e]
 						         - m_Op_UPML->vvfo[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						eng_sse->Engine_sse::SetVolt(0,pos, volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+						eng_sse->f4_volt[0][pos[0]][pos[1]][v].f[e] = volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
 						volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
 
-						f_help = m_Op_UPML->vv[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * eng_sse->Engine_sse::GetVolt(1,pos)
+						f_help = m_Op_UPML->vv[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * eng_sse->f4_volt[1][pos[0]][pos[1]][v].f[e]
 						         - m_Op_UPML->vvfo[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						eng_sse->Engine_sse::SetVolt(1,pos, volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+						eng_sse->f4_volt[1][pos[0]][pos[1]][v].f[e] = volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
 						volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
 
-						f_help = m_Op_UPML->vv[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * eng_sse->Engine_sse::GetVolt(2,pos)
+						f_help = m_Op_UPML->vv[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * eng_sse->f4_volt[2][pos[0]][pos[1]][v].f[e]
 						         - m_Op_UPML->vvfo[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						eng_sse->Engine_sse::SetVolt(2,pos, volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+						eng_sse->f4_volt[2][pos[0]][pos[1]][v].f[e] = volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
 						volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
 					}
 				}
@@ -135,38 +259,35 @@ void Engine_Ext_UPML::DoPreVoltageUpdates(int threadID)
 		}
 	default:
 		{
-			for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
+			for (unsigned int col=m_start.at(threadID); col<m_start.at(threadID)+m_numCols.at(threadID); ++col)
 			{
-				loc_pos[0]=lineX+m_start.at(threadID);
+				loc_pos[0] = col/m_Op_UPML->m_numLines[1];
+				loc_pos[1] = col%m_Op_UPML->m_numLines[1];
 				pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
-				for (loc_pos[1]=0; loc_pos[1]<m_Op_UPML->m_numLines[1]; ++loc_pos[1])
+				pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
+				for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
 				{
-					pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
-					for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
-					{
-						pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
-
-						f_help = m_Op_UPML->vv[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->GetVolt(0,pos)
-						         - m_Op_UPML->vvfo[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						m_Eng->SetVolt(0,pos, volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
-						volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
-
-						f_help = m_Op_UPML->vv[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->GetVolt(1,pos)
-						         - m_Op_UPML->vvfo[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						m_Eng->SetVolt(1,pos, volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
-						volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
-
-						f_help = m_Op_UPML->vv[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->GetVolt(2,pos)
-						         - m_Op_UPML->vvfo[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						m_Eng->SetVolt(2,pos, volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
-						volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
-					}
+					pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
+
+					f_help = m_Op_UPML->vv[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->GetVolt(0,pos)
+					         - m_Op_UPML->vvfo[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					m_Eng->SetVolt(0,pos, volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
+
+					f_help = m_Op_UPML->vv[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->GetVolt(1,pos)
+					         - m_Op_UPML->vvfo[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					m_Eng->SetVolt(1,pos, volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
+
+					f_help = m_Op_UPML->vv[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->GetVolt(2,pos)
+					         - m_Op_UPML->vvfo[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					m_Eng->SetVolt(2,pos, volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
 				}
 			}
 			break;
 		}
 	}
-
 }
 
 void Engine_Ext_UPML::DoPostVoltageUpdates(int threadID)
@@ -178,35 +299,35 @@ void Engine_Ext_UPML::DoPostVoltageUpdates(int threadID)
 
 	unsigned int pos[3];
 	unsigned int loc_pos[3];
+	unsigned int v, e;
 	FDTD_FLOAT f_help;
+	f4vector f4_help;
 
 	switch (m_Eng->GetType())
 	{
 	case Engine::BASIC:
 		{
-			for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
+			for (unsigned int col=m_start.at(threadID); col<m_start.at(threadID)+m_numCols.at(threadID); ++col)
 			{
-				loc_pos[0]=lineX+m_start.at(threadID);
+				loc_pos[0] = col/m_Op_UPML->m_numLines[1];
+				loc_pos[1] = col%m_Op_UPML->m_numLines[1];
 				pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
-				for (loc_pos[1]=0; loc_pos[1]<m_Op_UPML->m_numLines[1]; ++loc_pos[1])
+				pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
+				for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
 				{
-					pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
-					for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
-					{
-						pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
+					pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
 
-						f_help = volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->Engine::GetVolt(0,pos);
-						m_Eng->Engine::SetVolt(0,pos, f_help + m_Op_UPML->vvfn[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					f_help = volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->Engine::GetVolt(0,pos);
+					m_Eng->Engine::SetVolt(0,pos, f_help + m_Op_UPML->vvfn[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
 
-						f_help = volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->Engine::GetVolt(1,pos);
-						m_Eng->Engine::SetVolt(1,pos, f_help + m_Op_UPML->vvfn[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					f_help = volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->Engine::GetVolt(1,pos);
+					m_Eng->Engine::SetVolt(1,pos, f_help + m_Op_UPML->vvfn[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
 
-						f_help = volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->Engine::GetVolt(2,pos);
-						m_Eng->Engine::SetVolt(2,pos, f_help + m_Op_UPML->vvfn[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
-					}
+					f_help = volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->Engine::GetVolt(2,pos);
+					m_Eng->Engine::SetVolt(2,pos, f_help + m_Op_UPML->vvfn[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
 				}
 			}
 			break;
@@ -214,28 +335,55 @@ void Engine_Ext_UPML::DoPostVoltageUpdates(int threadID)
 	case Engine::SSE:
 		{
 			Engine_sse* eng_sse = (Engine_sse*) m_Eng;
-			for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
+			if (f4_volt_flux)
 			{
-				loc_pos[0]=lineX+m_start.at(threadID);
-				pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
-				for (loc_pos[1]=0; loc_pos[1]<m_Op_UPML->m_numLines[1]; ++loc_pos[1])
+				// packed storage, update whole sse vectors
+				for (unsigned int col=m_start.at(threadID); col<m_start.at(threadID)+m_numCols.at(threadID); ++col)
+				{
+					loc_pos[0] = col/m_Op_UPML->m_numLines[1];
+					loc_pos[1] = col%m_Op_UPML->m_numLines[1];
+					pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
+					pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
+					for (v=0; v<m_numVectors; ++v)
+					{
+						f4_help.v = f4_volt_flux[0][loc_pos[0]][loc_pos[1]][v].v;
+						f4_volt_flux[0][loc_pos[0]][loc_pos[1]][v].v = eng_sse->f4_volt[0][pos[0]][pos[1]][v].v;
+						eng_sse->f4_volt[0][pos[0]][pos[1]][v].v = f4_help.v + f4_vvfn[0][loc_pos[0]][loc_pos[1]][v].v * f4_volt_flux[0][loc_pos[0]][loc_pos[1]][v].v;
+
+						f4_help.v = f4_volt_flux[1][loc_pos[0]][loc_pos[1]][v].v;
+						f4_volt_flux[1][loc_pos[0]][loc_pos[1]][v].v = eng_sse->f4_volt[1][pos[0]][pos[1]][v].v;
+						eng_sse->f4_volt[1][pos[0]][pos[1]][v].v = f4_help.v + f4_vvfn[1][loc_pos[0]][loc_pos[1]][v].v * f4_volt_flux[1][loc_pos[0]][loc_pos[1]][v].v;
+
+						f4_help.v = f4_volt_flux[2][loc_pos[0]][loc_pos[1]][v].v;
+						f4_volt_flux[2][loc_pos[0]][loc_pos[1]][v].v = eng_sse->f4_volt[2][pos[0]][pos[1]][v].v;
+						eng_sse->f4_volt[2][pos[0]][pos[1]][v].v = f4_help.v + f4_vvfn[2][loc_pos[0]][loc_pos[1]][v].v * f4_volt_flux[2][loc_pos[0]][loc_pos[1]][v].v;
+					}
+				}
+			}
+			else
+			{
+				for (unsigned int col=m_start.at(threadID); col<m_start.at(threadID)+m_numCols.at(threadID); ++col)
 				{
+					loc_pos[0] = col/m_Op_UPML->m_numLines[1];
+					loc_pos[1] = col%m_Op_UPML->m_numLines[1];
+					pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
 					pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
 					for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
 					{
-						pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
+						v = m_zVector[loc_pos[2]];
+						e = m_zElement[loc_pos[2]];
 
 						f_help = volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = eng_sse->Engine_sse::GetVolt(0,pos);
-						eng_sse->Engine_sse::SetVolt(0,pos, f_help + m_Op_UPML->vvfn[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+						volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = eng_sse->f4_volt[0][pos[0]][pos[1]][v].f[e];
+						eng_sse->f4_volt[0][pos[0]][pos[1]][v].f[e] = f_help + m_Op_UPML->vvfn[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
 
 						f_help = volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = eng_sse->Engine_sse::GetVolt(1,pos);
-						eng_sse->Engine_sse::SetVolt(1,pos, f_help + m_Op_UPML->vvfn[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+						volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = eng_sse->f4_volt[1][pos[0]][pos[1]][v].f[e];
+						eng_sse->f4_volt[1][pos[0]][pos[1]][v].f[e] = f_help + m_Op_UPML->vvfn[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
 
 						f_help = volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = eng_sse->Engine_sse::GetVolt(2,pos);
-						eng_sse->Engine_sse::SetVolt(2,pos, f_help + m_Op_UPML->vvfn[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+						volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = eng_sse->f4_volt[2][pos[0]][pos[1]][v].f[e];
+						eng_sse->f4_volt[2][pos[0]][pos[1]][v].f[e] = f_help + m_Op_UPML->vvfn[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
 					}
 				}
 			}
@@ -243,35 +391,32 @@ void Engine_Ext_UPML::DoPostVoltageUpdates(int threadID)
 		}
 	default:
 		{
-			for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
+			for (unsigned int col=m_start.at(threadID); col<m_start.at(threadID)+m_numCols.at(threadID); ++col)
 			{
-				loc_pos[0]=lineX+m_start.at(threadID);
+				loc_pos[0] = col/m_Op_UPML->m_numLines[1];
+				loc_pos[1] = col%m_Op_UPML->m_numLines[1];
 				pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
-				for (loc_pos[1]=0; loc_pos[1]<m_Op_UPML->m_numLines[1]; ++loc_pos[1])
+				pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
+				for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
 				{
-					pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
-					for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
-					{
-						pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
+					pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
 
-						f_help = volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->GetVolt(0,pos);
-						m_Eng->SetVolt(0,pos, f_help + m_Op_UPML->vvfn[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					f_help = volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->GetVolt(0,pos);
+					m_Eng->SetVolt(0,pos, f_help + m_Op_UPML->vvfn[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
 
-						f_help = volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->GetVolt(1,pos);
-						m_Eng->SetVolt(1,pos, f_help + m_Op_UPML->vvfn[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					f_help = volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->GetVolt(1,pos);
+					m_Eng->SetVolt(1,pos, f_help + m_Op_UPML->vvfn[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
 
-						f_help = volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->GetVolt(2,pos);
-						m_Eng->SetVolt(2,pos, f_help + m_Op_UPML->vvfn[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
-					}
+					f_help = volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->GetVolt(2,pos);
+					m_Eng->SetVolt(2,pos, f_help + m_Op_UPML->vvfn[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * volt_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
 				}
 			}
 			break;
 		}
 	}
-
 }
 
 void Engine_Ext_UPML::DoPreCurrentUpdates(int threadID)
@@ -283,38 +428,38 @@ void Engine_Ext_UPML::DoPreCurrentUpdates(int threadID)
 
 	unsigned int pos[3];
 	unsigned int loc_pos[3];
+	unsigned int v, e;
 	FDTD_FLOAT f_help;
+	f4vector f4_help;
 
 	switch (m_Eng->GetType())
 	{
 	case Engine::BASIC:
 		{
-			for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
+			for (unsigned int col=m_start.at(threadID); col<m_start.at(threadID)+m_numCols.at(threadID); ++col)
 			{
-				loc_pos[0]=lineX+m_start.at(threadID);
+				loc_pos[0] = col/m_Op_UPML->m_numLines[1];
+				loc_pos[1] = col%m_Op_UPML->m_numLines[1];
 				pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
-				for (loc_pos[1]=0; loc_pos[1]<m_Op_UPML->m_numLines[1]; ++loc_pos[1])
+				pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
+				for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
 				{
-					pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
-					for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
-					{
-						pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
-
-						f_help = m_Op_UPML->ii[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->Engine::GetCurr(0,pos)
-						         - m_Op_UPML->iifo[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						m_Eng->Engine::SetCurr(0,pos, curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
-						curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
-
-						f_help = m_Op_UPML->ii[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->Engine::GetCurr(1,pos)
-						         - m_Op_UPML->iifo[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						m_Eng->Engine::SetCurr(1,pos, curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
-						curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
-
-						f_help = m_Op_UPML->ii[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->Engine::GetCurr(2,pos)
-						         - m_Op_UPML->iifo[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						m_Eng->Engine::SetCurr(2,pos, curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
-						curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
-					}
+					pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
+
+					f_help = m_Op_UPML->ii[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->Engine::GetCurr(0,pos)
+					         - m_Op_UPML->iifo[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					m_Eng->Engine::SetCurr(0,pos, curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
+
+					f_help = m_Op_UPML->ii[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->Engine::GetCurr(1,pos)
+					         - m_Op_UPML->iifo[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					m_Eng->Engine::SetCurr(1,pos, curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
+
+					f_help = m_Op_UPML->ii[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->Engine::GetCurr(2,pos)
+					         - m_Op_UPML->iifo[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					m_Eng->Engine::SetCurr(2,pos, curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
 				}
 			}
 			break;
@@ -322,32 +467,61 @@ void Engine_Ext_UPML::DoPreCurrentUpdates(int threadID)
 	case Engine::SSE:
 		{
 			Engine_sse* eng_sse = (Engine_sse*) m_Eng;
-			for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
+			if (f4_curr_flux)
 			{
-				loc_pos[0]=lineX+m_start.at(threadID);
-				pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
-				for (loc_pos[1]=0; loc_pos[1]<m_Op_UPML->m_numLines[1]; ++loc_pos[1])
+				// packed storage, update whole sse vectors
+				for (unsigned int col=m_start.at(threadID); col<m_start.at(threadID)+m_numCols.at(threadID); ++col)
 				{
+					loc_pos[0] = col/m_Op_UPML->m_numLines[1];
+					loc_pos[1] = col%m_Op_UPML->m_numLines[1];
+					pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
+					pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
+					for (v=0; v<m_numVectors; ++v)
+					{
+						f4_help.v = f4_ii[0][loc_pos[0]][loc_pos[1]][v].v * eng_sse->f4_curr[0][pos[0]][pos[1]][v].v
+						            - f4_iifo[0][loc_pos[0]][loc_pos[1]][v].v * f4_curr_flux[0][loc_pos[0]][loc_pos[1]][v].v;
+						eng_sse->f4_curr[0][pos[0]][pos[1]][v].v = f4_curr_flux[0][loc_pos[0]][loc_pos[1]][v].v;
+						f4_curr_flux[0][loc_pos[0]][loc_pos[1]][v].v = f4_help.v;
+
+						f4_help.v = f4_ii[1][loc_pos[0]][loc_pos[1]][v].v * eng_sse->f4_curr[1][pos[0]][pos[1]][v].v
+						            - f4_iifo[1][loc_pos[0]][loc_pos[1]][v].v * f4_curr_flux[1][loc_pos[0]][loc_pos[1]][v].v;
+						eng_sse->f4_curr[1][pos[0]][pos[1]][v].v = f4_curr_flux[1][loc_pos[0]][loc_pos[1]][v].v;
+						f4_curr_flux[1][loc_pos[0]][loc_pos[1]][v].v = f4_help.v;
+
+						f4_help.v = f4_ii[2][loc_pos[0]][loc_pos[1]][v].v * eng_sse->f4_curr[2][pos[0]][pos[1]][v].v
+						            - f4_iifo[2][loc_pos[0]][loc_pos[1]][v].v * f4_curr_flux[2][loc_pos[0]][loc_pos[1]][v].v;
+						eng_sse->f4_curr[2][pos[0]][pos[1]][v].v = f4_curr_flux[2][loc_pos[0]][loc_pos[1]][v].v;
+						f4_curr_flux[2][loc_pos[0]][loc_pos[1]][v].v = f4_help.v;
+					}
+				}
+			}
+			else
+			{
+				for (unsigned int col=m_start.at(threadID); col<m_start.at(threadID)+m_numCols.at(threadID); ++col)
+				{
+					loc_pos[0] = col/m_Op_UPML->m_numLines[1];
+					loc_pos[1] = col%m_Op_UPML->m_numLines[1];
+					pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
 					pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
 					for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
 					{
-						pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
+						v = m_zVector[loc_pos[2]];
+						e = m_zElement[loc_pos[2]];
 
-						f_help = m_Op_UPML->ii[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * eng_sse->Engine_sse::GetCurr(0,pos)
+						f_help = m_Op_UPML->ii[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * eng_sse->f4_curr[0][pos[0]][pos[1]][v].f[e]
 						         - m_Op_UPML->iifo[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						eng_sse->Engine_sse::SetCurr(0,pos, curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+						eng_sse->f4_curr[0][pos[0]][pos[1]][v].f[e] = curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
 						curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
 
-						f_help = m_Op_UPML->ii[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * eng_sse->Engine_sse::GetCurr(1,pos)
+						f_help = m_Op_UPML->ii[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * eng_sse->f4_curr[1][pos[0]][pos[1]][v].f[e]
 						         - m_Op_UPML->iifo[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						eng_sse->Engine_sse::SetCurr(1,pos, curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+						eng_sse->f4_curr[1][pos[0]][pos[1]][v].f[e] = curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
 						curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
 
-						f_help = m_Op_UPML->ii[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * eng_sse->Engine_sse::GetCurr(2,pos)
+						f_help = m_Op_UPML->ii[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * eng_sse->f4_curr[2][pos[0]][pos[1]][v].f[e]
 						         - m_Op_UPML->iifo[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						eng_sse->Engine_sse::SetCurr(2,pos, curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+						eng_sse->f4_curr[2][pos[0]][pos[1]][v].f[e] = curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
 						curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
-
 					}
 				}
 			}
@@ -355,32 +529,30 @@ void Engine_Ext_UPML::DoPreCurrentUpdates(int threadID)
 		}
 	default:
 		{
-			for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
+			for (unsigned int col=m_start.at(threadID); col<m_start.at(threadID)+m_numCols.at(threadID); ++col)
 			{
-				loc_pos[0]=lineX+m_start.at(threadID);
+				loc_pos[0] = col/m_Op_UPML->m_numLines[1];
+				loc_pos[1] = col%m_Op_UPML->m_numLines[1];
 				pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
-				for (loc_pos[1]=0; loc_pos[1]<m_Op_UPML->m_numLines[1]; ++loc_pos[1])
+				pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
+				for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
 				{
-					pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
-					for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
-					{
-						pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
-
-						f_help = m_Op_UPML->ii[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->GetCurr(0,pos)
-						         - m_Op_UPML->iifo[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						m_Eng->SetCurr(0,pos, curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
-						curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
-
-						f_help = m_Op_UPML->ii[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->GetCurr(1,pos)
-						         - m_Op_UPML->iifo[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						m_Eng->SetCurr(1,pos, curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
-						curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
-
-						f_help = m_Op_UPML->ii[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->GetCurr(2,pos)
-						         - m_Op_UPML->iifo[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						m_Eng->SetCurr(2,pos, curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
-						curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
-					}
+					pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
+
+					f_help = m_Op_UPML->ii[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->GetCurr(0,pos)
+					         - m_Op_UPML->iifo[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					m_Eng->SetCurr(0,pos, curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
+
+					f_help = m_Op_UPML->ii[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->GetCurr(1,pos)
+					         - m_Op_UPML->iifo[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					m_Eng->SetCurr(1,pos, curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
+
+					f_help = m_Op_UPML->ii[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]   * m_Eng->GetCurr(2,pos)
+					         - m_Op_UPML->iifo[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					m_Eng->SetCurr(2,pos, curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = f_help;
 				}
 			}
 			break;
@@ -397,35 +569,35 @@ void Engine_Ext_UPML::DoPostCurrentUpdates(int threadID)
 
 	unsigned int pos[3];
 	unsigned int loc_pos[3];
+	unsigned int v, e;
 	FDTD_FLOAT f_help;
+	f4vector f4_help;
 
 	switch (m_Eng->GetType())
 	{
 	case Engine::BASIC:
 		{
-			for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
+			for (unsigned int col=m_start.at(threadID); col<m_start.at(threadID)+m_numCols.at(threadID); ++col)
 			{
-				loc_pos[0]=lineX+m_start.at(threadID);
+				loc_pos[0] = col/m_Op_UPML->m_numLines[1];
+				loc_pos[1] = col%m_Op_UPML->m_numLines[1];
 				pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
-				for (loc_pos[1]=0; loc_pos[1]<m_Op_UPML->m_numLines[1]; ++loc_pos[1])
+				pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
+				for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
 				{
-					pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
-					for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
-					{
-						pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
+					pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
 
-						f_help = curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->Engine::GetCurr(0,pos);
-						m_Eng->Engine::SetCurr(0,pos, f_help + m_Op_UPML->iifn[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					f_help = curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->Engine::GetCurr(0,pos);
+					m_Eng->Engine::SetCurr(0,pos, f_help + m_Op_UPML->iifn[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
 
-						f_help = curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->Engine::GetCurr(1,pos);
-						m_Eng->Engine::SetCurr(1,pos, f_help + m_Op_UPML->iifn[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					f_help = curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->Engine::GetCurr(1,pos);
+					m_Eng->Engine::SetCurr(1,pos, f_help + m_Op_UPML->iifn[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
 
-						f_help = curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->Engine::GetCurr(2,pos);
-						m_Eng->Engine::SetCurr(2,pos, f_help + m_Op_UPML->iifn[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
-					}
+					f_help = curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->Engine::GetCurr(2,pos);
+					m_Eng->Engine::SetCurr(2,pos, f_help + m_Op_UPML->iifn[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
 				}
 			}
 			break;
@@ -433,28 +605,55 @@ void Engine_Ext_UPML::DoPostCurrentUpdates(int threadID)
 	case Engine::SSE:
 		{
 			Engine_sse* eng_sse = (Engine_sse*) m_Eng;
-			for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
+			if (f4_curr_flux)
 			{
-				loc_pos[0]=lineX+m_start.at(threadID);
-				pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
-				for (loc_pos[1]=0; loc_pos[1]<m_Op_UPML->m_numLines[1]; ++loc_pos[1])
+				// packed storage, update whole sse vectors
+				for (unsigned int col=m_start.at(threadID); col<m_start.at(threadID)+m_numCols.at(threadID); ++col)
+				{
+					loc_pos[0] = col/m_Op_UPML->m_numLines[1];
+					loc_pos[1] = col%m_Op_UPML->m_numLines[1];
+					pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
+					pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
+					for (v=0; v<m_numVectors; ++v)
+					{
+						f4_help.v = f4_curr_flux[0][loc_pos[0]][loc_pos[1]][v].v;
+						f4_curr_flux[0][loc_pos[0]][loc_pos[1]][v].v = eng_sse->f4_curr[0][pos[0]][pos[1]][v].v;
+						eng_sse->f4_curr[0][pos[0]][pos[1]][v].v = f4_help.v + f4_iifn[0][loc_pos[0]][loc_pos[1]][v].v * f4_curr_flux[0][loc_pos[0]][loc_pos[1]][v].v;
+
+						f4_help.v = f4_curr_flux[1][loc_pos[0]][loc_pos[1]][v].v;
+						f4_curr_flux[1][loc_pos[0]][loc_pos[1]][v].v = eng_sse->f4_curr[1][pos[0]][pos[1]][v].v;
+						eng_sse->f4_curr[1][pos[0]][pos[1]][v].v = f4_help.v + f4_iifn[1][loc_pos[0]][loc_pos[1]][v].v * f4_curr_flux[1][loc_pos[0]][loc_pos[1]][v].v;
+
+						f4_help.v = f4_curr_flux[2][loc_pos[0]][loc_pos[1]][v].v;
+						f4_curr_flux[2][loc_pos[0]][loc_pos[1]][v].v = eng_sse->f4_curr[2][pos[0]][pos[1]][v].v;
+						eng_sse->f4_curr[2][pos[0]][pos[1]][v].v = f4_help.v + f4_iifn[2][loc_pos[0]][loc_pos[1]][v].v * f4_curr_flux[2][loc_pos[0]][loc_pos[1]][v].v;
+					}
+				}
+			}
+			else
+			{
+				for (unsigned int col=m_start.at(threadID); col<m_start.at(threadID)+m_numCols.at(threadID); ++col)
 				{
+					loc_pos[0] = col/m_Op_UPML->m_numLines[1];
+					loc_pos[1] = col%m_Op_UPML->m_numLines[1];
+					pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
 					pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
 					for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
 					{
-						pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
+						v = m_zVector[loc_pos[2]];
+						e = m_zElement[loc_pos[2]];
 
 						f_help = curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = eng_sse->Engine_sse::GetCurr(0,pos);
-						eng_sse->Engine_sse::SetCurr(0,pos, f_help + m_Op_UPML->iifn[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+						curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = eng_sse->f4_curr[0][pos[0]][pos[1]][v].f[e];
+						eng_sse->f4_curr[0][pos[0]][pos[1]][v].f[e] = f_help + m_Op_UPML->iifn[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
 
 						f_help = curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = eng_sse->Engine_sse::GetCurr(1,pos);
-						eng_sse->Engine_sse::SetCurr(1,pos, f_help + m_Op_UPML->iifn[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+						curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = eng_sse->f4_curr[1][pos[0]][pos[1]][v].f[e];
+						eng_sse->f4_curr[1][pos[0]][pos[1]][v].f[e] = f_help + m_Op_UPML->iifn[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
 
 						f_help = curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = eng_sse->Engine_sse::GetCurr(2,pos);
-						eng_sse->Engine_sse::SetCurr(2,pos, f_help + m_Op_UPML->iifn[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+						curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = eng_sse->f4_curr[2][pos[0]][pos[1]][v].f[e];
+						eng_sse->f4_curr[2][pos[0]][pos[1]][v].f[e] = f_help + m_Op_UPML->iifn[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
 					}
 				}
 			}
@@ -462,29 +661,27 @@ void Engine_Ext_UPML::DoPostCurrentUpdates(int threadID)
 		}
 	default:
 		{
-			for (unsigned int lineX=0; lineX<m_numX.at(threadID); ++lineX)
+			for (unsigned int col=m_start.at(threadID); col<m_start.at(threadID)+m_numCols.at(threadID); ++col)
 			{
-				loc_pos[0]=lineX+m_start.at(threadID);
+				loc_pos[0] = col/m_Op_UPML->m_numLines[1];
+				loc_pos[1] = col%m_Op_UPML->m_numLines[1];
 				pos[0] = loc_pos[0] + m_Op_UPML->m_StartPos[0];
-				for (loc_pos[1]=0; loc_pos[1]<m_Op_UPML->m_numLines[1]; ++loc_pos[1])
+				pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
+				for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
 				{
-					pos[1] = loc_pos[1] + m_Op_UPML->m_StartPos[1];
-					for (loc_pos[2]=0; loc_pos[2]<m_Op_UPML->m_numLines[2]; ++loc_pos[2])
-					{
-						pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
+					pos[2] = loc_pos[2] + m_Op_UPML->m_StartPos[2];
 
-						f_help = curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->GetCurr(0,pos);
-						m_Eng->SetCurr(0,pos, f_help + m_Op_UPML->iifn[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					f_help = curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->GetCurr(0,pos);
+					m_Eng->SetCurr(0,pos, f_help + m_Op_UPML->iifn[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[0][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
 
-						f_help = curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->GetCurr(1,pos);
-						m_Eng->SetCurr(1,pos, f_help + m_Op_UPML->iifn[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
+					f_help = curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->GetCurr(1,pos);
+					m_Eng->SetCurr(1,pos, f_help + m_Op_UPML->iifn[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[1][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
 
-						f_help = curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
-						curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->GetCurr(2,pos);
-						m_Eng->SetCurr(2,pos, f_help + m_Op_UPML->iifn[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
-					}
+					f_help = curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]];
+					curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] = m_Eng->GetCurr(2,pos);
+					m_Eng->SetCurr(2,pos, f_help + m_Op_UPML->iifn[2][loc_pos[0]][loc_pos[1]][loc_pos[2]] * curr_flux[2][loc_pos[0]][loc_pos[1]][loc_pos[2]]);
 				}
 			}
 			break;
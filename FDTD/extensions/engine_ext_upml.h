@@ -21,6 +21,7 @@
 #include "engine_extension.h"
 #include "FDTD/engine.h"
 #include "FDTD/operator.h"
+#include "tools/array_ops.h"
 
 class Operator_Ext_UPML;
 
@@ -32,6 +33,9 @@ public:
 
 	virtual void SetNumberOfThreads(int nrThread);
 
+	//! Set the engine, a sse engine will use the packed flux and coefficient storage if possible
+	virtual void SetEngine(Engine* eng);
+
 	virtual void DoPreVoltageUpdates() {Engine_Ext_UPML::DoPreVoltageUpdates(0);};
 	virtual void DoPreVoltageUpdates(int threadID);
 	virtual void DoPostVoltageUpdates() {Engine_Ext_UPML::DoPostVoltageUpdates(0);};
@@ -45,11 +49,33 @@ public:
 protected:
 	Operator_Ext_UPML* m_Op_UPML;
 
+	//! first (x,y)-column of the upml box for each thread, the columns are numbered x*numLines[1]+y
 	vector<unsigned int> m_start;
-	vector<unsigned int> m_numX;
+	//! number of (x,y)-columns for each thread
+	vector<unsigned int> m_numCols;
 
 	FDTD_FLOAT**** volt_flux;
 	FDTD_FLOAT**** curr_flux;
+
+	//! Create the packed sse storage, only possible if the upml covers the full z-range of the sse engine
+	void InitPackedStorage();
+	//! Delete the packed sse storage
+	void DeletePackedStorage();
+
+	//! sse vector index and vector element of every local z-line, used for a sse engine without packed storage
+	vector<unsigned int> m_zVector;
+	vector<unsigned int> m_zElement;
+
+	//! flux and coefficients in the packed layout of the sse engine, NULL if not used
+	unsigned int m_numVectors;
+	f4vector**** f4_volt_flux;
+	f4vector**** f4_curr_flux;
+	f4vector**** f4_vv;
+	f4vector**** f4_vvfo;
+	f4vector**** f4_vvfn;
+	f4vector**** f4_ii;
+	f4vector**** f4_iifo;
+	f4vector**** f4_iifn;
 };
 
 #endif // ENGINE_EXT_UPML_H
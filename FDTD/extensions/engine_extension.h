@@ -23,6 +23,7 @@
 // priority definitions for some important extensions
 #define ENG_EXT_PRIO_STEADYSTATE		+2e6  //steady state extension priority
 #define ENG_EXT_PRIO_UPML				+1e6  //unaxial pml extension priority
+#define ENG_EXT_PRIO_CPML				+1e6  //convolutional pml extension priority
 #define ENG_EXT_PRIO_CYLINDER			+1e5  //cylindrial extension priority
 #define ENG_EXT_PRIO_TFSF				+5e4  //total-field/scattered-field extension priority
 #define ENG_EXT_PRIO_EXCITATION			-1000 //excitation priority
@@ -0,0 +1,74 @@
+/*
+*	Copyright (C) 2026 agent (agent@local)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINE_FIELD_ACCESS_H
+#define ENGINE_FIELD_ACCESS_H
+
+#include "FDTD/engine.h"
+#include "FDTD/engine_sse.h"
+
+/*!
+  Field access wrappers for engine extensions.
+  An extension may implement its update loops once as a template using one of these wrappers, and switch on Engine::GetType() to instantiate it with the fast inline access of the engine type.
+  */
+
+//! Inline field access of the basic engine
+struct Engine_Access_Basic
+{
+	Engine* eng;
+	inline FDTD_FLOAT GetVolt(unsigned int n, unsigned int x, unsigned int y, unsigned int z) const {return eng->Engine::GetVolt(n,x,y,z);}
+	inline FDTD_FLOAT GetCurr(unsigned int n, unsigned int x, unsigned int y, unsigned int z) const {return eng->Engine::GetCurr(n,x,y,z);}
+	inline void SetVolt(unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value) {eng->Engine::SetVolt(n,x,y,z,value);}
+	inline void SetCurr(unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value) {eng->Engine::SetCurr(n,x,y,z,value);}
+
+	inline FDTD_FLOAT GetVolt(unsigned int n, const unsigned int pos[3]) const {return eng->Engine::GetVolt(n,pos);}
+	inline FDTD_FLOAT GetCurr(unsigned int n, const unsigned int pos[3]) const {return eng->Engine::GetCurr(n,pos);}
+	inline void SetVolt(unsigned int n, const unsigned int pos[3], FDTD_FLOAT value) {eng->Engine::SetVolt(n,pos,value);}
+	inline void SetCurr(unsigned int n, const unsigned int pos[3], FDTD_FLOAT value) {eng->Engine::SetCurr(n,pos,value);}
+};
+
+//! Inline field access of the sse engines
+struct Engine_Access_SSE
+{
+	Engine_sse* eng;
+	inline FDTD_FLOAT GetVolt(unsigned int n, unsigned int x, unsigned int y, unsigned int z) const {return eng->Engine_sse::GetVolt(n,x,y,z);}
+	inline FDTD_FLOAT GetCurr(unsigned int n, unsigned int x, unsigned int y, unsigned int z) const {return eng->Engine_sse::GetCurr(n,x,y,z);}
+	inline void SetVolt(unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value) {eng->Engine_sse::SetVolt(n,x,y,z,value);}
+	inline void SetCurr(unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value) {eng->Engine_sse::SetCurr(n,x,y,z,value);}
+
+	inline FDTD_FLOAT GetVolt(unsigned int n, const unsigned int pos[3]) const {return eng->Engine_sse::GetVolt(n,pos);}
+	inline FDTD_FLOAT GetCurr(unsigned int n, const unsigned int pos[3]) const {return eng->Engine_sse::GetCurr(n,pos);}
+	inline void SetVolt(unsigned int n, const unsigned int pos[3], FDTD_FLOAT value) {eng->Engine_sse::SetVolt(n,pos,value);}
+	inline void SetCurr(unsigned int n, const unsigned int pos[3], FDTD_FLOAT value) {eng->Engine_sse::SetCurr(n,pos,value);}
+};
+
+//! Virtual field access for all other engines
+struct Engine_Access_Virtual
+{
+	Engine* eng;
+	inline FDTD_FLOAT GetVolt(unsigned int n, unsigned int x, unsigned int y, unsigned int z) const {return eng->GetVolt(n,x,y,z);}
+	inline FDTD_FLOAT GetCurr(unsigned int n, unsigned int x, unsigned int y, unsigned int z) const {return eng->GetCurr(n,x,y,z);}
+	inline void SetVolt(unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value) {eng->SetVolt(n,x,y,z,value);}
+	inline void SetCurr(unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value) {eng->SetCurr(n,x,y,z,value);}
+
+	inline FDTD_FLOAT GetVolt(unsigned int n, const unsigned int pos[3]) const {return eng->GetVolt(n,pos);}
+	inline FDTD_FLOAT GetCurr(unsigned int n, const unsigned int pos[3]) const {return eng->GetCurr(n,pos);}
+	inline void SetVolt(unsigned int n, const unsigned int pos[3], FDTD_FLOAT value) {eng->SetVolt(n,pos,value);}
+	inline void SetCurr(unsigned int n, const unsigned int pos[3], FDTD_FLOAT value) {eng->SetCurr(n,pos,value);}
+};
+
+#endif // ENGINE_FIELD_ACCESS_H
@@ -143,7 +143,12 @@ bool Operator_Ext_ConductingSheet::BuildExtension()
 
 	size_t numCS = v_pos[0].size();
 	if (numCS==0)
+	{
+		Delete_N_3DArray<int>(tanDir,numLines);
+		Delete_N_3DArray<float>(Conductivity,numLines);
+		Delete_N_3DArray<float>(Thickness,numLines);
 		return false;
+	}
 
 	m_LM_Count.push_back(numCS);
 	m_LM_Count.push_back(numCS);
@@ -257,5 +262,22 @@ bool Operator_Ext_ConductingSheet::BuildExtension()
 			}
 		}
 	}
+	Delete_N_3DArray<int>(tanDir,numLines);
+	Delete_N_3DArray<float>(Conductivity,numLines);
+	Delete_N_3DArray<float>(Thickness,numLines);
+
+	// the cells of a uniform sheet share a few coefficient sets
+	CompressCoefficients();
+	FoldIntoMainUpdate();
 	return true;
 }
+
+double Operator_Ext_ConductingSheet::EstimateMemory() const
+{
+	// the build uses three temporary full size arrays (tangential direction, conductivity and thickness)
+	double numLines[3] = {(double)m_Op->GetNumberOfLines(0,true),(double)m_Op->GetNumberOfLines(1,true),(double)m_Op->GetNumberOfLines(2,true)};
+	double build = 3.0*3.0*numLines[0]*numLines[1]*numLines[2]*sizeof(float);
+	// a second order model for all sheet cells, see Operator_Ext_LorentzMaterial::EstimateMemory
+	double numCells = m_Op->GetNumberCellsInBoundBox(CSProperties::CONDUCTINGSHEET);
+	return build + numCells*3.0*2.0*(sizeof(unsigned int) + 10.0*sizeof(FDTD_FLOAT) + 7.0*sizeof(double));
+}
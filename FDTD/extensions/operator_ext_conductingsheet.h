@@ -42,6 +42,8 @@ public:
 
 	virtual string GetExtensionName() const {return string("Conducting Sheet Extension");}
 
+	virtual double EstimateMemory() const;
+
 protected:
 	//! Copy constructor
 	Operator_Ext_ConductingSheet(Operator* op, Operator_Ext_ConductingSheet* op_ext);
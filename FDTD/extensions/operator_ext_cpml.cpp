@@ -0,0 +1,262 @@
+/*
+*	Copyright (C) 2026 agent (agent@local)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "operator_ext_cpml.h"
+#include "engine_ext_cpml.h"
+#include "tools/array_ops.h"
+#include "fparser.hh"
+
+using namespace std;
+
+Operator_Ext_CPML::Operator_Ext_CPML(Operator* op) : Operator_Extension(op)
+{
+	setlocale(LC_NUMERIC, "en_US.UTF-8");
+	m_GradingFunction = new FunctionParser();
+	//default grading function, same as for the upml
+	SetGradingFunction(" -log(1e-6)*log(2.5)/(2*dl*Z*(pow(2.5,W/dl)-1)) * pow(2.5, D/dl) ");
+
+	m_ny = -1;
+	m_nyP = -1;
+	m_nyPP = -1;
+	m_top = false;
+	m_Size = 0;
+	for (int n=0; n<3; ++n)
+	{
+		m_StartPos[n]=0;
+		m_numLines[n]=0;
+	}
+	for (int n=0; n<2; ++n)
+	{
+		m_volt_coeff[n] = NULL;
+		m_curr_coeff[n] = NULL;
+	}
+}
+
+Operator_Ext_CPML::~Operator_Ext_CPML()
+{
+	delete m_GradingFunction;
+	m_GradingFunction = NULL;
+	DeleteCoefficients();
+}
+
+void Operator_Ext_CPML::DeleteCoefficients()
+{
+	for (int n=0; n<2; ++n)
+	{
+		Delete3DArray(m_volt_coeff[n],m_numLines);
+		m_volt_coeff[n] = NULL;
+		Delete3DArray(m_curr_coeff[n],m_numLines);
+		m_curr_coeff[n] = NULL;
+	}
+}
+
+void Operator_Ext_CPML::SetDirection(int ny, bool top_ny, unsigned int size)
+{
+	if ((ny<0) || (ny>2))
+		return;
+
+	// the coefficients are allocated for the current pml box
+	DeleteCoefficients();
+
+	m_ny = ny;
+	m_nyP = (ny+1)%3;
+	m_nyPP = (ny+2)%3;
+	m_top = top_ny;
+	m_Size = size;
+
+	for (int n=0; n<3; ++n)
+	{
+		m_StartPos[n] = 0;
+		m_numLines[n] = m_Op->GetNumberOfLines(n,true);
+	}
+	if (m_top)
+		m_StartPos[m_ny] = m_Op->GetNumberOfLines(m_ny,true)-1-m_Size;
+	m_numLines[m_ny] = m_Size+1;
+}
+
+bool Operator_Ext_CPML::Create_CPML(Operator* op, const int ui_BC[6], const unsigned int ui_size[6], const string gradFunc)
+{
+	int BC[6]={ui_BC[0],ui_BC[1],ui_BC[2],ui_BC[3],ui_BC[4],ui_BC[5]};
+	unsigned int size[6]={ui_size[0],ui_size[1],ui_size[2],ui_size[3],ui_size[4],ui_size[5]};
+
+	//check if mesh is large enough to support the pml
+	for (int n=0; n<3; ++n)
+		if ( (size[2*n]*(BC[2*n]==4)+size[2*n+1]*(BC[2*n+1]==4)) >= op->GetNumberOfLines(n,true) )
+		{
+			cerr << "Operator_Ext_CPML::Create_CPML: Warning: Not enough lines in direction: " << n << ", resetting to PEC" << endl;
+			BC[2*n]=0;
+			BC[2*n+1]=0;
+		}
+
+	for (int n=0; n<6; ++n)
+	{
+		if (BC[n]!=4)
+			continue;
+		Operator_Ext_CPML* op_ext_cpml = new Operator_Ext_CPML(op);
+		op_ext_cpml->SetGradingFunction(gradFunc);
+		op_ext_cpml->SetDirection(n/2, n%2, size[n]);
+		op->AddExtension(op_ext_cpml);
+	}
+	return true;
+}
+
+bool Operator_Ext_CPML::SetGradingFunction(string func)
+{
+	if (func.empty())
+		return true;
+
+	m_GradFunc = func;
+	int res = m_GradingFunction->Parse(m_GradFunc.c_str(), "D,dl,W,Z,N");
+	if (res < 0) return true;
+
+	cerr << "Operator_Ext_CPML::SetGradingFunction: Warning, an error occurred parsing the pml grading function (see below) ..." << endl;
+	cerr << func << "\n" << string(res, ' ') << "^\n" << m_GradingFunction->ErrorMsg() << "\n";
+	return false;
+}
+
+double Operator_Ext_CPML::CalcGrading(double depth, double width)
+{
+	if (depth<=0)
+		return 0;
+	if (depth>width)
+		depth = width;
+	double vars[5] = {depth, width/m_Size, width, __Z0__, (double)m_Size};
+	return m_GradingFunction->Eval(vars);
+}
+
+bool Operator_Ext_CPML::BuildExtension()
+{
+	/*Calculate the cpml coefficients as defined in:
+	  Allen Taflove, computational electrodynamics - the FDTD method, third edition, chapter 7.9
+	  - using kappa=1 and alpha=0, the grading function defines the pml conductivity
+	  - the derivatives of the EC-FDTD are the current/voltage differences multiplied by the vi/iv operator, which are applied by the engine extension
+	*/
+	if (m_Op==NULL)
+		return false;
+	if (m_ny<0)
+	{
+		cerr << "Operator_Ext_CPML::BuildExtension: Warning, Extension not initialized! Use SetDirection!! Abort build!!" << endl;
+		return false;
+	}
+
+	double dT = m_Op->GetTimestep();
+	unsigned int numLines = m_Op->GetNumberOfLines(m_ny,true);
+	//the pml interface towards the simulation domain
+	unsigned int iface = m_top ? numLines-1-m_Size : m_Size;
+	double width = fabs(m_Op->GetDiscLine(m_ny,m_StartPos[m_ny]+m_Size) - m_Op->GetDiscLine(m_ny,m_StartPos[m_ny]))*m_Op->GetGridDelta();
+
+	m_volt_b.resize(m_numLines[m_ny]);
+	m_volt_c.resize(m_numLines[m_ny]);
+	m_curr_b.resize(m_numLines[m_ny]);
+	m_curr_c.resize(m_numLines[m_ny]);
+
+	for (unsigned int n=0; n<m_numLines[m_ny]; ++n)
+	{
+		unsigned int pos = m_StartPos[m_ny]+n;
+		double depth = fabs(m_Op->GetDiscLine(m_ny,pos) - m_Op->GetDiscLine(m_ny,iface))*m_Op->GetGridDelta();
+		double b = exp(-CalcGrading(depth,width)*dT/__EPS0__);
+		m_volt_b.at(n) = b;
+		m_volt_c.at(n) = b-1;
+
+		//the currents are located on the dual lines, the last line has no current
+		if (pos>=numLines-1)
+		{
+			m_curr_b.at(n) = 1;
+			m_curr_c.at(n) = 0;
+			continue;
+		}
+		double dual_line = 0.5*(m_Op->GetDiscLine(m_ny,pos) + m_Op->GetDiscLine(m_ny,pos+1));
+		if (m_top)
+			depth = (dual_line - m_Op->GetDiscLine(m_ny,iface))*m_Op->GetGridDelta();
+		else
+			depth = (m_Op->GetDiscLine(m_ny,iface) - dual_line)*m_Op->GetGridDelta();
+		b = exp(-CalcGrading(depth,width)*dT/__EPS0__);
+		m_curr_b.at(n) = b;
+		m_curr_c.at(n) = b-1;
+	}
+	return true;
+}
+
+void Operator_Ext_CPML::CalcCoefficients()
+{
+	// precalculate the psi update coefficients for every cell, the engine only has to apply them to the field differences
+	DeleteCoefficients();
+	if (m_volt_c.empty())
+		return;
+	for (int n=0; n<2; ++n)
+	{
+		m_volt_coeff[n] = Create3DArray<FDTD_FLOAT>(m_numLines);
+		m_curr_coeff[n] = Create3DArray<FDTD_FLOAT>(m_numLines);
+	}
+	unsigned int maxLines[3];
+	for (int n=0; n<3; ++n)
+		maxLines[n] = m_Op->GetNumberOfLines(n,true)-1;
+
+	unsigned int pos[3];
+	unsigned int loc_pos[3];
+	for (loc_pos[0]=0; loc_pos[0]<m_numLines[0]; ++loc_pos[0])
+	{
+		pos[0] = loc_pos[0] + m_StartPos[0];
+		for (loc_pos[1]=0; loc_pos[1]<m_numLines[1]; ++loc_pos[1])
+		{
+			pos[1] = loc_pos[1] + m_StartPos[1];
+			for (loc_pos[2]=0; loc_pos[2]<m_numLines[2]; ++loc_pos[2])
+			{
+				pos[2] = loc_pos[2] + m_StartPos[2];
+
+				// the lower boundary has no current difference, the psi remains zero
+				if (pos[m_ny]>0)
+				{
+					FDTD_FLOAT c = m_volt_c.at(loc_pos[m_ny]);
+					m_volt_coeff[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] = -c*m_Op->GetVI(m_nyP,pos[0],pos[1],pos[2]);
+					m_volt_coeff[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] =  c*m_Op->GetVI(m_nyPP,pos[0],pos[1],pos[2]);
+				}
+
+				// the currents on the last lines are not updated by the engine
+				if ((pos[0]<maxLines[0]) && (pos[1]<maxLines[1]) && (pos[2]<maxLines[2]))
+				{
+					FDTD_FLOAT c = m_curr_c.at(loc_pos[m_ny]);
+					m_curr_coeff[0][loc_pos[0]][loc_pos[1]][loc_pos[2]] =  c*m_Op->GetIV(m_nyP,pos[0],pos[1],pos[2]);
+					m_curr_coeff[1][loc_pos[0]][loc_pos[1]][loc_pos[2]] = -c*m_Op->GetIV(m_nyPP,pos[0],pos[1],pos[2]);
+				}
+			}
+		}
+	}
+}
+
+Engine_Extension* Operator_Ext_CPML::CreateEngineExtention()
+{
+	// all extensions are build, the vi/iv inside the pml are final (e.g. a conducting sheet reaching into the pml)
+	CalcCoefficients();
+	Engine_Ext_CPML* eng_ext = new Engine_Ext_CPML(this);
+	return eng_ext;
+}
+
+void Operator_Ext_CPML::ShowStat(ostream &ostr)  const
+{
+	Operator_Extension::ShowStat(ostr);
+
+	ostr << " PML range\t\t: " << "[" << m_StartPos[0]<< "," << m_StartPos[1]<< "," << m_StartPos[2]<< "] to ["
+	<<  m_StartPos[0]+m_numLines[0]-1 << "," << m_StartPos[1]+m_numLines[1]-1 << "," << m_StartPos[2]+m_numLines[2]-1 << "]" << endl;
+	ostr << " Grading function\t: \"" << m_GradFunc << "\"" << endl;
+}
+
+double Operator_Ext_CPML::EstimateMemory() const
+{
+	// two voltage and two current psi of the engine extension and their update coefficients, the decay profiles are negligible
+	return 8.0*m_numLines[0]*m_numLines[1]*m_numLines[2]*sizeof(FDTD_FLOAT);
+}
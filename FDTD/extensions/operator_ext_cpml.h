@@ -0,0 +1,98 @@
+/*
+*	Copyright (C) 2026 agent (agent@local)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPERATOR_EXT_CPML_H
+#define OPERATOR_EXT_CPML_H
+
+#include "FDTD/operator.h"
+#include "operator_extension.h"
+
+class FunctionParser;
+
+//! Operator extension implementing a convolutional perfectly matched layer (cpml)
+/*!
+  Each extension is a pml slab at one side of the simulation domain, covering its full transverse range.
+  The main engine performs the unmodified updates, the engine extension adds the recursive convolution (psi) of the derivative in the pml direction afterwards.
+  Only the psi of the two transverse voltage and current components are stored for every cell.
+  The decay (b) is a 1D profile along the pml direction, the psi update coefficients (c*vi and c*iv) are precalculated for every cell.
+  Overlapping slabs at edges and corners each handle their own derivative and need no special treatment.
+  Currently only available for the cartesian operator.
+  */
+class Operator_Ext_CPML : public Operator_Extension
+{
+	friend class Engine_Ext_CPML;
+public:
+	virtual ~Operator_Ext_CPML();
+
+	virtual bool IsMPISave() const {return true;}
+
+	//! Define the pml direction \a ny=0,1,2 -> x,y,z, at the lower or upper (\a top_ny) end of the mesh and its size in cells
+	void SetDirection(int ny, bool top_ny, unsigned int size);
+
+	//! Set the grading function for the pml conductivity, see Operator_Ext_UPML::SetGradingFunction
+	virtual bool SetGradingFunction(string func);
+
+	virtual bool BuildExtension();
+
+	virtual Engine_Extension* CreateEngineExtention();
+
+	virtual string GetExtensionName() const {return string("Convolutional PML Extension");}
+
+	virtual void ShowStat(ostream &ostr) const;
+
+	virtual double EstimateMemory() const;
+
+	//! Create a cpml slab for every boundary of type 4, the caller has to ensure a cartesian operator
+	static bool Create_CPML(Operator* op, const int ui_BC[6], const unsigned int ui_size[6], const string gradFunc);
+
+protected:
+	Operator_Ext_CPML(Operator* op);
+
+	int m_ny, m_nyP, m_nyPP;
+	bool m_top;
+	unsigned int m_Size;
+
+	unsigned int m_StartPos[3];
+	unsigned int m_numLines[3];
+
+	string m_GradFunc;
+	FunctionParser* m_GradingFunction;
+
+	//! Calculate the pml conductivity at the given depth
+	double CalcGrading(double depth, double width);
+
+	//! recursive convolution coefficients along the pml direction (local lines), psi_new = b*psi_old + c*derivative
+	vector<FDTD_FLOAT> m_volt_b;
+	vector<FDTD_FLOAT> m_volt_c;
+	vector<FDTD_FLOAT> m_curr_b;
+	vector<FDTD_FLOAT> m_curr_c;
+
+	//! Calculate the psi update coefficients from the final vi/iv of the operator, called for every new engine extension
+	void CalcCoefficients();
+	//! Delete the psi update coefficients
+	void DeleteCoefficients();
+
+	//! psi update coefficients of the nyP and nyPP components for every local cell, c*vi resp. c*iv including the sign of the curl
+	/*!
+	  The coefficients are zero for all cells without a psi update (lower boundary for the voltages, last lines for the currents).
+	  They are calculated from the final vi/iv when the engine extension is created, after all extensions changing the coefficients inside the pml are build.
+	  */
+	FDTD_FLOAT*** m_volt_coeff[2];
+	FDTD_FLOAT*** m_curr_coeff[2];
+};
+
+#endif // OPERATOR_EXT_CPML_H
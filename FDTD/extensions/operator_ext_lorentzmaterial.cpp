@@ -19,6 +19,12 @@
 #include "engine_ext_lorentzmaterial.h"
 #include "operator_ext_cylinder.h"
 #include "../operator_cylinder.h"
+#include "../operator_sse_compressed.h"
+#include "operator_ext_upml.h"
+#include "operator_ext_mur_abc.h"
+
+#include <algorithm>
+#include <map>
 
 #include "CSPropLorentzMaterial.h"
 #include "CSPropDebyeMaterial.h"
@@ -35,6 +41,10 @@ Operator_Ext_LorentzMaterial::Operator_Ext_LorentzMaterial(Operator* op) : Opera
 
 	m_curr_Lor_ADE_On = NULL;
 	m_curr_Lor_ADE_On = NULL;
+
+	m_LM_coeff = NULL;
+
+	m_Folded = false;
 }
 
 Operator_Ext_LorentzMaterial::Operator_Ext_LorentzMaterial(Operator* op, Operator_Ext_LorentzMaterial* op_ext) : Operator_Ext_Dispersive(op,op_ext)
@@ -49,12 +59,18 @@ Operator_Ext_LorentzMaterial::Operator_Ext_LorentzMaterial(Operator* op, Operato
 
 	m_curr_Lor_ADE_On = NULL;
 	m_curr_Lor_ADE_On = NULL;
+
+	m_LM_coeff = NULL;
+
+	m_Folded = false;
 }
 
 Operator_Ext_LorentzMaterial::~Operator_Ext_LorentzMaterial()
 {
 	for (int i=0;i<m_Order;++i)
 	{
+		if (m_LM_coeff)
+			delete[] m_LM_coeff[i];
 		for (int n=0; n<3; ++n)
 		{
 			if (m_volt_ADE_On[i])
@@ -105,6 +121,9 @@ Operator_Ext_LorentzMaterial::~Operator_Ext_LorentzMaterial()
 	delete[] m_volt_Lor_ADE_On;
 	m_curr_Lor_ADE_On = NULL;
 	m_curr_Lor_ADE_On = NULL;
+
+	delete[] m_LM_coeff;
+	m_LM_coeff = NULL;
 }
 
 Operator_Extension* Operator_Ext_LorentzMaterial::Clone(Operator* op)
@@ -354,6 +373,22 @@ bool Operator_Ext_LorentzMaterial::BuildExtension()
 			}
 		}
 
+		//sort the cells into the memory order of the engine (x, y, z), the sse engines interleave each z-line over its sse vectors
+		//the engine extension relies on the cells being sorted by x
+		vector< pair<size_t,unsigned int> > cell_order(v_pos[0].size());
+		unsigned int numVectors = ceil((double)numLines[2]/4.0);
+		bool sse_order = (dynamic_cast<Operator_sse*>(m_Op)!=NULL);
+		for (unsigned int i=0; i<v_pos[0].size(); ++i)
+		{
+			size_t column = (size_t)v_pos[0].at(i)*numLines[1] + v_pos[1].at(i);
+			if (sse_order)
+				cell_order.at(i).first = (column*numVectors + v_pos[2].at(i)%numVectors)*4 + v_pos[2].at(i)/numVectors;
+			else
+				cell_order.at(i).first = column*numLines[2] + v_pos[2].at(i);
+			cell_order.at(i).second = i;
+		}
+		sort(cell_order.begin(), cell_order.end());
+
 		//copy all vectors into the array's
 		m_LM_Count.push_back(v_pos[0].size());
 
@@ -395,7 +430,7 @@ bool Operator_Ext_LorentzMaterial::BuildExtension()
 		{
 			m_LM_pos[order][n] = new unsigned int[m_LM_Count.at(order)];
 			for (unsigned int i=0; i<m_LM_Count.at(order); ++i)
-				m_LM_pos[order][n][i] = v_pos[n].at(i);
+				m_LM_pos[order][n][i] = v_pos[n].at(cell_order[i].second);
 			if (m_volt_ADE_On[order])
 			{
 				v_int_ADE[order][n]  = new FDTD_FLOAT[m_LM_Count.at(order)];
@@ -403,8 +438,8 @@ bool Operator_Ext_LorentzMaterial::BuildExtension()
 
 				for (unsigned int i=0; i<m_LM_Count.at(order); ++i)
 				{
-					v_int_ADE[order][n][i] = v_int[n].at(i);
-					v_ext_ADE[order][n][i] = v_ext[n].at(i);
+					v_int_ADE[order][n][i] = v_int[n].at(cell_order[i].second);
+					v_ext_ADE[order][n][i] = v_ext[n].at(cell_order[i].second);
 				}
 			}
 			if (m_curr_ADE_On[order])
@@ -414,8 +449,8 @@ bool Operator_Ext_LorentzMaterial::BuildExtension()
 
 				for (unsigned int i=0; i<m_LM_Count.at(order); ++i)
 				{
-					i_int_ADE[order][n][i] = i_int[n].at(i);
-					i_ext_ADE[order][n][i] = i_ext[n].at(i);
+					i_int_ADE[order][n][i] = i_int[n].at(cell_order[i].second);
+					i_ext_ADE[order][n][i] = i_ext[n].at(cell_order[i].second);
 				}
 			}
 
@@ -423,17 +458,129 @@ bool Operator_Ext_LorentzMaterial::BuildExtension()
 			{
 				v_Lor_ADE[order][n]  = new FDTD_FLOAT[m_LM_Count.at(order)];
 				for (unsigned int i=0; i<m_LM_Count.at(order); ++i)
-					v_Lor_ADE[order][n][i] = v_Lor[n].at(i);
+					v_Lor_ADE[order][n][i] = v_Lor[n].at(cell_order[i].second);
 			}
 			if (m_curr_Lor_ADE_On[order])
 			{
 				i_Lor_ADE[order][n]  = new FDTD_FLOAT[m_LM_Count.at(order)];
 				for (unsigned int i=0; i<m_LM_Count.at(order); ++i)
-					i_Lor_ADE[order][n][i] = i_Lor[n].at(i);
+					i_Lor_ADE[order][n][i] = i_Lor[n].at(cell_order[i].second);
 			}
 		}
 	}
 
+	CompressCoefficients();
+	FoldIntoMainUpdate();
+	return true;
+}
+
+void Operator_Ext_LorentzMaterial::CompressCoefficients()
+{
+	m_Coeff_Count.clear();
+	m_LM_coeff = new unsigned int*[m_Order];
+	for (int o=0; o<m_Order; ++o)
+	{
+		// all coefficients of this order, a cell is defined by the coefficients of all three directions
+		FDTD_FLOAT** coeff[6] = {NULL,NULL,NULL,NULL,NULL,NULL};
+		if (m_volt_ADE_On[o])
+		{
+			coeff[0] = v_int_ADE[o];
+			coeff[1] = v_ext_ADE[o];
+		}
+		if (m_curr_ADE_On[o])
+		{
+			coeff[2] = i_int_ADE[o];
+			coeff[3] = i_ext_ADE[o];
+		}
+		if (m_volt_Lor_ADE_On[o])
+			coeff[4] = v_Lor_ADE[o];
+		if (m_curr_Lor_ADE_On[o])
+			coeff[5] = i_Lor_ADE[o];
+
+		unsigned int count = m_LM_Count.at(o);
+		m_LM_coeff[o] = new unsigned int[count];
+		map<vector<FDTD_FLOAT>, unsigned int> sets;
+		vector<unsigned int> firstCell; //first cell of each coefficient set
+		vector<FDTD_FLOAT> key;
+		for (unsigned int i=0; i<count; ++i)
+		{
+			key.clear();
+			for (int c=0; c<6; ++c)
+				if (coeff[c])
+					for (int n=0; n<3; ++n)
+						key.push_back(coeff[c][n][i]);
+			pair<map<vector<FDTD_FLOAT>, unsigned int>::iterator, bool> ins = sets.insert(make_pair(key, (unsigned int)firstCell.size()));
+			if (ins.second)
+				firstCell.push_back(i);
+			m_LM_coeff[o][i] = ins.first->second;
+		}
+		m_Coeff_Count.push_back(firstCell.size());
+
+		// replace the per cell coefficients by the shared coefficient sets
+		for (int c=0; c<6; ++c)
+		{
+			if (coeff[c]==NULL)
+				continue;
+			for (int n=0; n<3; ++n)
+			{
+				FDTD_FLOAT* shared = new FDTD_FLOAT[firstCell.size()];
+				for (size_t k=0; k<firstCell.size(); ++k)
+					shared[k] = coeff[c][n][firstCell.at(k)];
+				delete[] coeff[c][n];
+				coeff[c][n] = shared;
+			}
+		}
+	}
+}
+
+bool Operator_Ext_LorentzMaterial::FoldIntoMainUpdate()
+{
+	m_Folded = false;
+	if (!g_settings.FoldDispersiveADE() || (m_Order==0))
+		return false;
+
+	Operator_SSE_Compressed* op_compr = dynamic_cast<Operator_SSE_Compressed*>(m_Op);
+	if ((op_compr==NULL) || (op_compr->UseCompression()==false))
+		return false;
+
+	// the engine applies the ADE correction before all post-update extensions, the cylindrical closure, the upml and the mur abc do not commute with it
+	if (dynamic_cast<Operator_Cylinder*>(m_Op))
+	{
+		cerr << "Operator_Ext_LorentzMaterial::FoldIntoMainUpdate: Warning: Not available for cylindrical coordinates, using the separate dispersive update..." << endl;
+		return false;
+	}
+	for (size_t n=0; n<m_Op->GetNumberOfExtentions(); ++n)
+	{
+		Operator_Extension* op_ext = m_Op->GetExtension(n);
+		if (dynamic_cast<Operator_Ext_UPML*>(op_ext))
+		{
+			cerr << "Operator_Ext_LorentzMaterial::FoldIntoMainUpdate: Warning: Not available together with the upml, using the separate dispersive update..." << endl;
+			return false;
+		}
+		if (dynamic_cast<Operator_Ext_Mur_ABC*>(op_ext))
+		{
+			cerr << "Operator_Ext_LorentzMaterial::FoldIntoMainUpdate: Warning: Not available together with the mur abc, using the separate dispersive update..." << endl;
+			return false;
+		}
+		Operator_Ext_LorentzMaterial* op_ext_lor = dynamic_cast<Operator_Ext_LorentzMaterial*>(op_ext);
+		if (op_ext_lor && (op_ext_lor!=this) && op_ext_lor->m_Folded)
+			return false;
+	}
+
+	unsigned int numVectors = ceil((double)m_Op->GetNumberOfLines(2,true)/4.0);
+	for (int o=0; o<m_Order; ++o)
+	{
+		unsigned char flags = 0;
+		if (m_volt_ADE_On[o])
+			flags |= Operator_SSE_Compressed::COEFF_DISPERSIVE_VOLT;
+		if (m_curr_ADE_On[o])
+			flags |= Operator_SSE_Compressed::COEFF_DISPERSIVE_CURR;
+		if (flags==0)
+			continue;
+		for (unsigned int i=0; i<m_LM_Count.at(o); ++i)
+			op_compr->AddCoeffFlags(m_LM_pos[o][0][i], m_LM_pos[o][1][i], m_LM_pos[o][2][i]%numVectors, flags);
+	}
+	m_Folded = true;
 	return true;
 }
 
@@ -448,12 +595,30 @@ void Operator_Ext_LorentzMaterial::ShowStat(ostream &ostr)  const
 	Operator_Extension::ShowStat(ostr);
 	string On_Off[2] = {"Off", "On"};
 	ostr << " Max. Dispersion Order N = " << m_Order << endl;
+	ostr << " Folded into main update\t: " << On_Off[m_Folded] << endl;
 	for (int i=0;i<m_Order;++i)
 	{
 		ostr << " N=" << i << ":\t Active cells\t\t: " << 	m_LM_Count.at(i) << endl;
+		ostr << " N=" << i << ":\t Coefficient sets\t: " << 	m_Coeff_Count.at(i) << endl;
 		ostr << " N=" << i << ":\t Voltage ADE is \t: " << On_Off[m_volt_ADE_On[i]] << endl;
 		ostr << " N=" << i << ":\t Voltage Lor-ADE is \t: " << On_Off[m_volt_Lor_ADE_On[i]] << endl;
 		ostr << " N=" << i << ":\t Current ADE is \t: " << On_Off[m_curr_ADE_On[i]] << endl;
 		ostr << " N=" << i << ":\t Current Lor-ADE is \t: " << On_Off[m_curr_Lor_ADE_On[i]] << endl;
 	}
 }
+
+double Operator_Ext_LorentzMaterial::EstimateMemory() const
+{
+	int order = 0;
+	vector<CSProperties*> LD_props = m_Op->CSX->GetPropertyByType((CSProperties::PropertyType)(CSProperties::LORENTZMATERIAL | CSProperties::DEBYEMATERIAL));
+	for (size_t n=0;n<LD_props.size();++n)
+	{
+		CSPropDispersiveMaterial* dispMat = dynamic_cast<CSPropDispersiveMaterial*>(LD_props.at(n));
+		if (dispMat && (dispMat->GetDispersionOrder()>order))
+			order = dispMat->GetDispersionOrder();
+	}
+	// per cell, direction and order: the position, six operator and four engine ADE values, plus the temporary (double) build vectors
+	// this is the peak during the build, afterwards the operator values are merged into shared coefficient sets
+	double numCells = m_Op->GetNumberCellsInBoundBox((CSProperties::PropertyType)(CSProperties::LORENTZMATERIAL | CSProperties::DEBYEMATERIAL));
+	return numCells*3.0*order*(sizeof(unsigned int) + 10.0*sizeof(FDTD_FLOAT) + 7.0*sizeof(double));
+}
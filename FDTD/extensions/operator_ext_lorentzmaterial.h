@@ -42,11 +42,35 @@ public:
 
 	virtual void ShowStat(ostream &ostr) const;
 
+	virtual double EstimateMemory() const;
+
 protected:
 	//! Copy constructor
 	Operator_Ext_LorentzMaterial(Operator* op, Operator_Ext_LorentzMaterial* op_ext);
 
-	//ADE update coefficients, array setup: coeff[N_order][direction][mesh_pos_index]
+	//! Flag all dispersive cells in the compressed operator, the compressed sse engines will then apply the ADEs within their main update (needs: --fold-dispersive)
+	/*!
+	  Call at the end of BuildExtension, all cells and coefficients have to be known.
+	  Only available for the cartesian operator without upml, as the post-update extensions have to commute with the ADE correction.
+	  Only a single dispersive extension per operator can be folded.
+	  */
+	bool FoldIntoMainUpdate();
+	//! The dispersive cells are flagged in the compressed operator \sa FoldIntoMainUpdate
+	bool m_Folded;
+
+	//! Merge all cells of an order with identical ADE coefficients into shared coefficient sets
+	/*!
+	  Call at the end of BuildExtension, before FoldIntoMainUpdate.
+	  Afterwards all coefficient arrays are indexed by the coefficient set of the cell, see m_LM_coeff.
+	  */
+	void CompressCoefficients();
+
+	//! Index of the shared coefficient set of each cell, array setup: m_LM_coeff[N_order][mesh_pos_index]
+	unsigned int **m_LM_coeff;
+	//! Number of shared coefficient sets per order
+	vector<unsigned int> m_Coeff_Count;
+
+	//ADE update coefficients, array setup: coeff[N_order][direction][coeff_set_index]
 	FDTD_FLOAT ***v_int_ADE;
 	FDTD_FLOAT ***v_ext_ADE;
 	FDTD_FLOAT ***i_int_ADE;
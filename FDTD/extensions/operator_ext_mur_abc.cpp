@@ -208,3 +208,9 @@ void Operator_Ext_Mur_ABC::ShowStat(ostream &ostr)  const
 	if (m_v_phase>0.0)
 		ostr << " Used phase velocity\t: " << m_v_phase << " (" << m_v_phase/__C0__ << " * c_0)" <<endl;
 }
+
+double Operator_Ext_Mur_ABC::EstimateMemory() const
+{
+	// two coefficient planes and two voltage planes of the engine extension
+	return 4.0*m_numLines[0]*m_numLines[1]*sizeof(FDTD_FLOAT);
+}
@@ -43,11 +43,14 @@ public:
 	virtual bool IsCylinderCoordsSave(bool closedAlpha, bool R0_included) const;
 	virtual bool IsCylindricalMultiGridSave(bool child) const;
 	virtual bool IsMPISave() const {return true;}
+	virtual bool IsBuildParallelSave() const {return true;}
 
 	virtual string GetExtensionName() const {return string("Mur ABC Extension");}
 
 	virtual void ShowStat(ostream &ostr) const;
 
+	virtual double EstimateMemory() const;
+
 protected:
 	Operator_Ext_Mur_ABC(Operator* op, Operator_Ext_Mur_ABC* op_ext);
 	void Initialize();
@@ -38,6 +38,7 @@ public:
 	virtual bool IsCylinderCoordsSave(bool closedAlpha, bool R0_included) const {UNUSED(closedAlpha); UNUSED(R0_included); return true;}
 	virtual bool IsCylindricalMultiGridSave(bool child) const {UNUSED(child); return true;}
 	virtual bool IsMPISave() const {return true;}
+	virtual bool IsBuildParallelSave() const {return true;}
 
 	virtual string GetExtensionName() const {return string("Steady-State Detection Extension");}
 
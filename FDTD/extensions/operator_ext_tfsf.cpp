@@ -17,7 +17,9 @@
 
 #include "operator_ext_tfsf.h"
 #include "engine_ext_tfsf.h"
+#include "FDTD/operator_sse.h"
 #include <cmath>
+#include <algorithm>
 
 #include "CSPrimBox.h"
 #include "CSPropExcitation.h"
@@ -52,6 +54,22 @@ void Operator_Ext_TFSF::Init()
 }
 
 void Operator_Ext_TFSF::Reset()
+{
+	DeleteFaceTables();
+	Injection* inj[2] = {&m_VoltInj, &m_CurrInj};
+	for (int i=0;i<2;++i)
+	{
+		for (int n=0;n<3;++n)
+			inj[i]->pos[n].clear();
+		inj[i]->dir.clear();
+		inj[i]->delay.clear();
+		inj[i]->amp_lo.clear();
+		inj[i]->amp_hi.clear();
+	}
+	Operator_Extension::Reset();
+}
+
+void Operator_Ext_TFSF::DeleteFaceTables()
 {
 	for (int n=0;n<3;++n)
 		for (int l=0;l<2;++l)
@@ -70,7 +88,87 @@ void Operator_Ext_TFSF::Reset()
 				delete[] m_CurrAmp[n][l][c];
 				m_CurrAmp[n][l][c]=NULL;
 			}
-	Operator_Extension::Reset();
+}
+
+void Operator_Ext_TFSF::PackInjection(bool volt)
+{
+	unsigned int* (*delayTab)[2][2] = volt ? m_VoltDelay : m_CurrDelay;
+	FDTD_FLOAT* (*deltaTab)[2][2] = volt ? m_VoltDelayDelta : m_CurrDelayDelta;
+	FDTD_FLOAT* (*ampTab)[2][2] = volt ? m_VoltAmp : m_CurrAmp;
+	Injection &inj = volt ? m_VoltInj : m_CurrInj;
+
+	unsigned int numLines[3] = {m_Op->GetNumberOfLines(0,true), m_Op->GetNumberOfLines(1,true), m_Op->GetNumberOfLines(2,true)};
+	unsigned int numVectors = ceil((double)numLines[2]/4.0);
+	bool sse_order = (dynamic_cast<Operator_sse*>(m_Op)!=NULL);
+
+	// collect all points with a non-zero amplitude, the key is the memory position in the engine, the sse engines interleave each z-line over its sse vectors
+	vector< pair<size_t,unsigned int> > order;
+	vector<unsigned int> point; // direction, low/high, component and position index of each point
+	unsigned int pos[3];
+	for (int n=0;n<3;++n)
+	{
+		int nP = (n+1)%3;
+		int nPP = (n+2)%3;
+		for (int l=0;l<2;++l)
+		{
+			if (!m_ActiveDir[n][l])
+				continue;
+			if (l==0)
+				pos[n] = volt ? m_Start[n] : m_Start[n]-1;
+			else
+				pos[n] = m_Stop[n];
+			for (int c=0;c<2;++c)
+			{
+				int dir = c==0 ? nP : nPP;
+				unsigned int ui_pos = 0;
+				for (unsigned int i=0;i<m_numLines[nP];++i)
+					for (unsigned int j=0;j<m_numLines[nPP];++j,++ui_pos)
+					{
+						if (ampTab[n][l][c][ui_pos]==0)
+							continue;
+						pos[nP] = m_Start[nP]+i;
+						pos[nPP] = m_Start[nPP]+j;
+						size_t key = ((size_t)dir*numLines[0] + pos[0])*numLines[1] + pos[1];
+						if (sse_order)
+							key = (key*numVectors + pos[2]%numVectors)*4 + pos[2]/numVectors;
+						else
+							key = key*numLines[2] + pos[2];
+						order.push_back(pair<size_t,unsigned int>(key, point.size()));
+						point.push_back(((n*2+l)*2+c));
+						point.push_back(ui_pos);
+					}
+			}
+		}
+	}
+	sort(order.begin(), order.end());
+
+	size_t num = order.size();
+	for (int n=0;n<3;++n)
+		inj.pos[n].resize(num);
+	inj.dir.resize(num);
+	inj.delay.resize(num);
+	inj.amp_lo.resize(num);
+	inj.amp_hi.resize(num);
+	for (size_t k=0;k<num;++k)
+	{
+		unsigned int face = point.at(order.at(k).second);
+		unsigned int ui_pos = point.at(order.at(k).second+1);
+		int n = face/4;
+		int l = (face/2)%2;
+		int c = face%2;
+		int nP = (n+1)%3;
+		int nPP = (n+2)%3;
+		if (l==0)
+			inj.pos[n][k] = volt ? m_Start[n] : m_Start[n]-1;
+		else
+			inj.pos[n][k] = m_Stop[n];
+		inj.pos[nP][k] = m_Start[nP] + ui_pos/m_numLines[nPP];
+		inj.pos[nPP][k] = m_Start[nPP] + ui_pos%m_numLines[nPP];
+		inj.dir[k] = c==0 ? nP : nPP;
+		inj.delay[k] = delayTab[n][l][c][ui_pos];
+		inj.amp_lo[k] = (1.0-deltaTab[n][l][c][ui_pos])*ampTab[n][l][c][ui_pos];
+		inj.amp_hi[k] = deltaTab[n][l][c][ui_pos]*ampTab[n][l][c][ui_pos];
+	}
 }
 
 Operator_Extension* Operator_Ext_TFSF::Clone(Operator* op)
@@ -403,6 +501,10 @@ bool Operator_Ext_TFSF::BuildExtension()
 			}
 		}
 		++m_maxDelay;
+
+		PackInjection(true);
+		PackInjection(false);
+		DeleteFaceTables();
 		return true;
 	}
 	SetActive(false);
@@ -424,6 +526,7 @@ void Operator_Ext_TFSF::ShowStat(ostream &ostr) const
 	cout << "H-field amplitude (A/m)\t: " << "(" << m_H_Amp[0] << ", " << m_H_Amp[1] << ", " << m_H_Amp[2] << ")" << endl;
 	cout << "Box Dimensions\t\t: " << m_numLines[0] << " x " << m_numLines[1] << " x " << m_numLines[2] << endl;
 	cout << "Max. Delay (TS)\t\t: " << m_maxDelay << endl;
-	int dirs = m_ActiveDir[0][0] + m_ActiveDir[0][1] + m_ActiveDir[1][0] + m_ActiveDir[1][1] + m_ActiveDir[2][0] + m_ActiveDir[2][1] ;
-	cout << "Memory usage (est.)\t: ~" << m_numLines[0] * m_numLines[1] * m_numLines[2] * dirs * 4 * 4 / 1024 << " kiB" << endl;
+	cout << "Injection points\t: " << m_VoltInj.dir.size() << " (voltages), " << m_CurrInj.dir.size() << " (currents)" << endl;
+	size_t points = m_VoltInj.dir.size() + m_CurrInj.dir.size();
+	cout << "Memory usage (est.)\t: ~" << points*(5*sizeof(unsigned int)+2*sizeof(FDTD_FLOAT))/1024 << " kiB" << endl;
 }
@@ -68,7 +68,7 @@ protected:
 
 	unsigned int m_maxDelay;
 
-	// array setup [direction][low/high][component][ <mesh_position> ]
+	// temporary face tables during BuildExtension, array setup [direction][low/high][component][ <mesh_position> ]
 	unsigned int* m_VoltDelay[3][2][2];
 	FDTD_FLOAT* m_VoltDelayDelta[3][2][2];
 	FDTD_FLOAT* m_VoltAmp[3][2][2];
@@ -77,6 +77,22 @@ protected:
 	FDTD_FLOAT* m_CurrDelayDelta[3][2][2];
 	FDTD_FLOAT* m_CurrAmp[3][2][2];
 
+	void DeleteFaceTables();
+
+	//! Injection points of all active faces, sorted into the memory order of the engine, array setup [ <injection_point> ]
+	struct Injection
+	{
+		vector<unsigned int> pos[3];
+		vector<unsigned int> dir;   //!< field component
+		vector<unsigned int> delay; //!< integer part of the delay in timesteps
+		vector<FDTD_FLOAT> amp_lo;  //!< amplitude of the signal at delay
+		vector<FDTD_FLOAT> amp_hi;  //!< amplitude of the signal at delay+1
+	};
+	Injection m_VoltInj;
+	Injection m_CurrInj;
+
+	//! Collect all non-zero injection points of the face tables into the sorted injection tables
+	void PackInjection(bool volt);
 };
 
 #endif // OPERATOR_EXT_TFSF_H
@@ -479,3 +479,9 @@ void Operator_Ext_UPML::ShowStat(ostream &ostr)  const
 	<<  m_StartPos[0]+m_numLines[0]-1 << "," << m_StartPos[1]+m_numLines[1]-1 << "," << m_StartPos[2]+m_numLines[2]-1 << "]" << endl;
 	ostr << " Grading function\t: \"" << m_GradFunc << "\"" << endl;
 }
+
+double Operator_Ext_UPML::EstimateMemory() const
+{
+	// six operator arrays, the voltage and current flux of the engine extension and a packed copy of the operator for the sse engines
+	return 14.0*3.0*m_numLines[0]*m_numLines[1]*m_numLines[2]*sizeof(FDTD_FLOAT);
+}
@@ -70,6 +70,8 @@ public:
 
 	virtual void ShowStat(ostream &ostr) const;
 
+	virtual double EstimateMemory() const;
+
 	//! Create the UPML
 	static bool Create_UPML(Operator* op, const int ui_BC[6], const unsigned int ui_size[6], const string gradFunc);
 
@@ -58,10 +58,16 @@ public:
 	//! The MPI operator (if enabled) will check whether the extension is compatible with MPI. Default is false. Derive this method to override.
 	virtual bool IsMPISave() const {return false;}
 
+	//! The extension build is only reading the geometry and mesh and writing its own data, thus it can be build concurrently to other extensions and does not depend on their results.
+	virtual bool IsBuildParallelSave() const {return false;}
+
 	virtual std::string GetExtensionName() const {return std::string("Abstract Operator Extension Base Class");}
 
 	virtual void ShowStat(std::ostream &ostr) const;
 
+	//! Estimate the memory (in bytes) of this extension and its engine extension before it is build. Default is a negligible size.
+	virtual double EstimateMemory() const {return 0;}
+
 	virtual bool IsActive() const {return m_Active;}
 	virtual void SetActive(bool active=true) {m_Active=active;}
 
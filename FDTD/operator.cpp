@@ -16,15 +16,21 @@
 */
 
 #include <fstream>
+#include <sstream>
 #include <algorithm>
+#include <typeinfo>
+#include <stdint.h>
 #include "operator.h"
 #include "engine.h"
 #include "extensions/operator_extension.h"
 #include "extensions/operator_ext_excitation.h"
 #include "Common/processfields.h"
+#include "primitive_index.h"
 #include "tools/array_ops.h"
+#include "tools/useful.h"
 #include "tools/vtk_file_writer.h"
 #include "fparser.hh"
+#include "tinyxml.h"
 #include "extensions/operator_ext_excitation.h"
 
 #include "vtkPolyData.h"
@@ -37,6 +43,8 @@
 #include "CSPropMaterial.h"
 #include "CSPropLumpedElement.h"
 
+#include <boost/thread.hpp>
+
 Operator* Operator::New()
 {
 	cout << "Create FDTD operator" << endl;
@@ -49,6 +57,7 @@ Operator::Operator() : Operator_Base()
 {
 	m_Exc = 0;
 	m_InvaildTimestep = false;
+	m_Nr_PEC_Estimated = false;
 	m_TimeStepVar = 3;
 }
 
@@ -79,10 +88,9 @@ void Operator::Init()
 	iv=NULL;
 	ii=NULL;
 
-	m_epsR=NULL;
-	m_kappa=NULL;
-	m_mueR=NULL;
-	m_sigma=NULL;
+
+	m_MatPrimIndex=NULL;
+	m_PECPrimIndex=NULL;
 
 	MainOp=NULL;
 
@@ -102,6 +110,7 @@ void Operator::Init()
 void Operator::Delete()
 {
 	CSX = NULL;
+	ClearPrimitiveIndex();
 
 	Delete_N_3DArray(vv,numLines);
 	Delete_N_3DArray(vi,numLines);
@@ -117,14 +126,8 @@ void Operator::Delete()
 		delete[] EC_R[n];EC_R[n]=0;
 	}
 
-	Delete_N_3DArray(m_epsR,numLines);
-	m_epsR=0;
-	Delete_N_3DArray(m_kappa,numLines);
-	m_kappa=0;
-	Delete_N_3DArray(m_mueR,numLines);
-	m_mueR=0;
-	Delete_N_3DArray(m_sigma,numLines);
-	m_sigma=0;
+	for (int n=0; n<4; ++n)
+		DeleteMaterialStorage(n);
 }
 
 void Operator::Reset()
@@ -507,6 +510,46 @@ double Operator::GetNumberCells() const
 	return 0;
 }
 
+double Operator::EstimateSetupMemory() const
+{
+	// EC_C, EC_G, EC_L and EC_R
+	return 4.0*3.0*numLines[0]*numLines[1]*numLines[2]*sizeof(FDTD_FLOAT);
+}
+
+double Operator::EstimateCoefficientMemory(bool compressed) const
+{
+	UNUSED(compressed);
+	// vv, vi, iv and ii
+	return 4.0*3.0*numLines[0]*numLines[1]*numLines[2]*sizeof(FDTD_FLOAT);
+}
+
+double Operator::EstimateFieldMemory() const
+{
+	return 2.0*3.0*numLines[0]*numLines[1]*numLines[2]*sizeof(FDTD_FLOAT);
+}
+
+double Operator::GetNumberCellsInBoundBox(CSProperties::PropertyType type) const
+{
+	double numCells = 0;
+	vector<CSPrimitives*> vPrims = CSX->GetAllPrimitives(false, type);
+	for (size_t i=0; i<vPrims.size(); ++i)
+	{
+		double bnd[6] = {0,0,0,0,0,0};
+		if (vPrims.at(i)->GetBoundBox(bnd,true)==false)
+			continue;
+		double start[3] = {bnd[0],bnd[2],bnd[4]};
+		double stop[3] = {bnd[1],bnd[3],bnd[5]};
+		unsigned int uiStart[3], uiStop[3];
+		if (SnapBox2Mesh(start, stop, uiStart, uiStop)<0)
+			continue;
+		double boxCells = 1;
+		for (int n=0; n<3; ++n)
+			boxCells *= (double)uiStop[n]-(double)uiStart[n]+1;
+		numCells += boxCells;
+	}
+	return min(numCells, (double)numLines[0]*numLines[1]*numLines[2]);
+}
+
 void Operator::ShowStat() const
 {
 	unsigned int OpSize = 12*numLines[0]*numLines[1]*numLines[2]*sizeof(FDTD_FLOAT);
@@ -520,7 +563,10 @@ void Operator::ShowStat() const
 	cout << "-----------------------------------" << endl;
 	cout << "Background materials (epsR/mueR/kappa/sigma): " << GetBackgroundEpsR() << "/" << GetBackgroundMueR() << "/" << GetBackgroundKappa() << "/" << GetBackgroundSigma() << endl;
 	cout << "-----------------------------------" << endl;
-	cout << "Number of PEC edges\t: " << m_Nr_PEC[0]+m_Nr_PEC[1]+m_Nr_PEC[2] << endl;
+	cout << "Number of PEC edges\t: " << m_Nr_PEC[0]+m_Nr_PEC[1]+m_Nr_PEC[2];
+	if (m_Nr_PEC_Estimated)
+		cout << " (estimated by the operator update)";
+	cout << endl;
 	cout << "in " << GetDirName(0) << " direction\t\t: " << m_Nr_PEC[0] << endl;
 	cout << "in " << GetDirName(1) << " direction\t\t: " << m_Nr_PEC[1] << endl;
 	cout << "in " << GetDirName(2) << " direction\t\t: " << m_Nr_PEC[2] << endl;
@@ -743,6 +789,9 @@ void Operator::DumpMaterial2File(string filename)
 
 	cout << "Operator: Dumping material information to vtk file: " << filename << " ..."  << flush;
 
+	if (m_MatPrimIndex==NULL)
+		InitPrimitiveIndex();
+
 	FDTD_FLOAT**** epsilon = Create_N_3DArray<FDTD_FLOAT>(numLines);
 	FDTD_FLOAT**** mue     = Create_N_3DArray<FDTD_FLOAT>(numLines);
 	FDTD_FLOAT**** kappa   = Create_N_3DArray<FDTD_FLOAT>(numLines);
@@ -753,9 +802,9 @@ void Operator::DumpMaterial2File(string filename)
 	{
 		for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
 		{
-			vector<CSPrimitives*> vPrims = this->GetPrimitivesBoundBox(pos[0], pos[1], -1, CSProperties::MATERIAL);
 			for (pos[2]=0; pos[2]<numLines[2]; ++pos[2])
 			{
+				const vector<CSPrimitives*>& vPrims = m_MatPrimIndex->GetPrimitives(pos);
 				for (int n=0; n<3; ++n)
 				{
 					double inMat[4];
@@ -850,88 +899,116 @@ void Operator::InitOperator()
 
 void Operator::InitDataStorage()
 {
-	if (m_StoreMaterial[0])
+	const char* matNames[4] = {"epsR", "kappa", "mueR", "sigma"};
+	for (int n=0; n<4; ++n)
 	{
+		DeleteMaterialStorage(n);
+		if (!m_StoreMaterial[n])
+			continue;
 		if (g_settings.GetVerboseLevel()>0)
-			cerr << "Operator::InitDataStorage(): Storing epsR material data..." << endl;
-		Delete_N_3DArray(m_epsR,numLines);
-		m_epsR = Create_N_3DArray<float>(numLines);
+			cerr << "Operator::InitDataStorage(): Storing " << matNames[n] << " material data..." << endl;
+
+		vector<unsigned int> regions = m_MatStorageRegions[n];
+		if (regions.empty())
+		{
+			// no region was requested, store the full mesh
+			unsigned int full[6] = {0, 0, 0, numLines[0]-1, numLines[1]-1, numLines[2]-1};
+			regions.assign(full, full+6);
+		}
+		for (size_t r=0; r<regions.size(); r+=6)
+		{
+			MaterialStorage storage;
+			for (int d=0; d<3; ++d)
+			{
+				storage.start[d] = regions.at(r+d);
+				storage.numLines[d] = regions.at(r+3+d) - regions.at(r+d) + 1;
+			}
+			storage.data = Create_N_3DArray<float>(storage.numLines);
+			m_MatStorage[n].push_back(storage);
+		}
 	}
-	if (m_StoreMaterial[1])
+}
+
+void Operator::DeleteMaterialStorage(int type)
+{
+	for (size_t r=0; r<m_MatStorage[type].size(); ++r)
+		Delete_N_3DArray(m_MatStorage[type].at(r).data, m_MatStorage[type].at(r).numLines);
+	m_MatStorage[type].clear();
+}
+
+void Operator::AddMaterialStorageRegion(int type, const unsigned int start[3], const unsigned int stop[3])
+{
+	if ((type<0) || (type>3))
+		return;
+	// the field interpolation may access the neighboring lines of a dump region
+	for (int n=0; n<3; ++n)
 	{
-		if (g_settings.GetVerboseLevel()>0)
-			cerr << "Operator::InitDataStorage(): Storing kappa material data..." << endl;
-		Delete_N_3DArray(m_kappa,numLines);
-		m_kappa = Create_N_3DArray<float>(numLines);
+		unsigned int lower = min(min(start[n],stop[n]),numLines[n]-1);
+		m_MatStorageRegions[type].push_back( lower>0 ? lower-1 : 0 );
 	}
-	if (m_StoreMaterial[2])
+	for (int n=0; n<3; ++n)
+		m_MatStorageRegions[type].push_back( min(max(start[n],stop[n])+1,numLines[n]-1) );
+}
+
+double Operator::GetMaterialStorageSize(int type) const
+{
+	if ((type<0) || (type>3))
+		return 0;
+	if (m_MatStorageRegions[type].empty())
+		return 3.0*numLines[0]*numLines[1]*numLines[2]*sizeof(float);
+	double size = 0;
+	for (size_t r=0; r<m_MatStorageRegions[type].size(); r+=6)
 	{
-		if (g_settings.GetVerboseLevel()>0)
-			cerr << "Operator::InitDataStorage(): Storing muR material data..." << endl;
-		Delete_N_3DArray(m_mueR,numLines);
-		m_mueR = Create_N_3DArray<float>(numLines);
+		double cells = 1;
+		for (int n=0; n<3; ++n)
+			cells *= m_MatStorageRegions[type].at(r+3+n) - m_MatStorageRegions[type].at(r+n) + 1;
+		size += 3.0*cells*sizeof(float);
 	}
-	if (m_StoreMaterial[3])
+	return size;
+}
+
+void Operator::StoreMaterial(int ny, const unsigned int pos[3], const double* EffMat) const
+{
+	for (int n=0; n<4; ++n)
 	{
-		if (g_settings.GetVerboseLevel()>0)
-			cerr << "Operator::InitDataStorage(): Storing sigma material data..." << endl;
-		Delete_N_3DArray(m_sigma,numLines);
-		m_sigma = Create_N_3DArray<float>(numLines);
+		for (size_t r=0; r<m_MatStorage[n].size(); ++r)
+		{
+			const MaterialStorage &storage = m_MatStorage[n].at(r);
+			// unsigned underflow will also fail these checks
+			unsigned int x = pos[0]-storage.start[0];
+			unsigned int y = pos[1]-storage.start[1];
+			unsigned int z = pos[2]-storage.start[2];
+			if ((x<storage.numLines[0]) && (y<storage.numLines[1]) && (z<storage.numLines[2]))
+				storage.data[ny][x][y][z] = EffMat[n];
+		}
 	}
 }
 
 void Operator::CleanupMaterialStorage()
 {
-	if (!m_StoreMaterial[0] && m_epsR)
-	{
-		if (g_settings.GetVerboseLevel()>0)
-			cerr << "Operator::CleanupMaterialStorage(): Delete epsR material data..." << endl;
-		Delete_N_3DArray(m_epsR,numLines);
-		m_epsR = NULL;
-	}
-	if (!m_StoreMaterial[1] && m_kappa)
-	{
-		if (g_settings.GetVerboseLevel()>0)
-			cerr << "Operator::CleanupMaterialStorage(): Delete kappa material data..." << endl;
-		Delete_N_3DArray(m_kappa,numLines);
-		m_kappa = NULL;
-	}
-	if (!m_StoreMaterial[2] && m_mueR)
-	{
-		if (g_settings.GetVerboseLevel()>0)
-			cerr << "Operator::CleanupMaterialStorage(): Delete mueR material data..." << endl;
-		Delete_N_3DArray(m_mueR,numLines);
-		m_mueR = NULL;
-	}
-	if (!m_StoreMaterial[3] && m_sigma)
+	const char* matNames[4] = {"epsR", "kappa", "mueR", "sigma"};
+	for (int n=0; n<4; ++n)
 	{
+		if (m_StoreMaterial[n] || m_MatStorage[n].empty())
+			continue;
 		if (g_settings.GetVerboseLevel()>0)
-			cerr << "Operator::CleanupMaterialStorage(): Delete sigma material data..." << endl;
-		Delete_N_3DArray(m_sigma,numLines);
-		m_sigma = NULL;
+			cerr << "Operator::CleanupMaterialStorage(): Delete " << matNames[n] << " material data..." << endl;
+		DeleteMaterialStorage(n);
 	}
 }
 
 double Operator::GetDiscMaterial(int type, int n, const unsigned int pos[3]) const
 {
-	switch (type)
+	if ((type<0) || (type>3))
+		return 0;
+	for (size_t r=0; r<m_MatStorage[type].size(); ++r)
 	{
-	case 0:
-		if (m_epsR==0)
-			return 0;
-		return m_epsR[n][pos[0]][pos[1]][pos[2]];
-	case 1:
-		if (m_kappa==0)
-			return 0;
-		return m_kappa[n][pos[0]][pos[1]][pos[2]];
-	case 2:
-		if (m_mueR==0)
-			return 0;
-		return m_mueR[n][pos[0]][pos[1]][pos[2]];
-	case 3:
-		if (m_sigma==0)
-			return 0;
-		return m_sigma[n][pos[0]][pos[1]][pos[2]];
+		const MaterialStorage &storage = m_MatStorage[type].at(r);
+		unsigned int x = pos[0]-storage.start[0];
+		unsigned int y = pos[1]-storage.start[1];
+		unsigned int z = pos[2]-storage.start[2];
+		if ((x<storage.numLines[0]) && (y<storage.numLines[1]) && (z<storage.numLines[2]))
+			return storage.data[n][x][y][z];
 	}
 	return 0;
 }
@@ -943,110 +1020,152 @@ void Operator::SetExcitationSignal(Excitation* exc)
 
 void Operator::Calc_ECOperatorPos(int n, unsigned int* pos)
 {
-	unsigned int i = MainOp->SetPos(pos[0],pos[1],pos[2]);
+	Calc_ECOperatorAt(n, pos, MainOp->SetPos(pos[0],pos[1],pos[2]));
+}
+
+void Operator::Calc_ECOperatorAt(int n, const unsigned int* pos, unsigned int i)
+{
+	FDTD_FLOAT coeff[4];
+	Calc_ECOperatorCoeff(n, i, coeff);
+	SetVV(n,pos[0],pos[1],pos[2], coeff[0] );
+	SetVI(n,pos[0],pos[1],pos[2], coeff[1] );
+	SetIV(n,pos[0],pos[1],pos[2], coeff[2] );
+	SetII(n,pos[0],pos[1],pos[2], coeff[3] );
+}
+
+void Operator::Calc_ECOperatorCoeff(int n, unsigned int i, FDTD_FLOAT coeff[4]) const
+{
 	double C = EC_C[n][i];
 	double G = EC_G[n][i];
 	if (C>0)
 	{
-		SetVV(n,pos[0],pos[1],pos[2], (1.0-dT*G/2.0/C)/(1.0+dT*G/2.0/C) );
-		SetVI(n,pos[0],pos[1],pos[2], (dT/C)/(1.0+dT*G/2.0/C) );
+		coeff[0] = (1.0-dT*G/2.0/C)/(1.0+dT*G/2.0/C);
+		coeff[1] = (dT/C)/(1.0+dT*G/2.0/C);
 	}
 	else
 	{
-		SetVV(n,pos[0],pos[1],pos[2], 0 );
-		SetVI(n,pos[0],pos[1],pos[2], 0 );
+		coeff[0] = 0;
+		coeff[1] = 0;
 	}
 
 	double L = EC_L[n][i];
 	double R = EC_R[n][i];
 	if (L>0)
 	{
-		SetII(n,pos[0],pos[1],pos[2], (1.0-dT*R/2.0/L)/(1.0+dT*R/2.0/L) );
-		SetIV(n,pos[0],pos[1],pos[2], (dT/L)/(1.0+dT*R/2.0/L) );
+		coeff[2] = (dT/L)/(1.0+dT*R/2.0/L);
+		coeff[3] = (1.0-dT*R/2.0/L)/(1.0+dT*R/2.0/L);
 	}
 	else
 	{
-		SetII(n,pos[0],pos[1],pos[2], 0 );
-		SetIV(n,pos[0],pos[1],pos[2], 0 );
+		coeff[2] = 0;
+		coeff[3] = 0;
 	}
 }
 
+//! Print the time passed since \p stageTime in verbose mode and reset \p stageTime
+static void ShowStageTime(const char* stage, timeval &stageTime)
+{
+	timeval currTime;
+	gettimeofday(&currTime,NULL);
+	if (g_settings.GetVerboseLevel()>0)
+		cout << "Operator::CalcECOperator: " << stage << ": " << CalcDiffTime(currTime,stageTime) << " s" << endl;
+	stageTime = currTime;
+}
+
 int Operator::CalcECOperator( DebugFlags debugFlags )
 {
+	timeval stageTime;
+	gettimeofday(&stageTime,NULL);
+
 	Init_EC();
 	InitDataStorage();
 
-	if (Calc_EC()==0)
-		return -1;
-
-	m_InvaildTimestep = false;
-	opt_dT = 0;
-	if (dT>0)
+	// the key depends on the settings (e.g. a forced timestep) before the operator is calculated
+	string cacheKey, geoCacheKey;
+	if (!m_OpCacheFile.empty())
 	{
-		double save_dT = dT;
-		CalcTimestep();
-		opt_dT = dT;
-		if (dT<save_dT)
-		{
-			cerr << "Operator::CalcECOperator: Warning, forced timestep: " << save_dT << "s is larger than calculated timestep: " << dT << "s! It is not recommended using this timestep!! " << endl;
-			m_InvaildTimestep = true;
-		}
-
-		dT = save_dT;
+		cacheKey = GetOperatorCacheKey();
+		geoCacheKey = GetGeometryCacheKey();
 	}
-	else
-		CalcTimestep();
-
-	dT*=m_TimeStepFactor;
 
-	if (m_Exc->GetSignalPeriod()>0)
+	if (ReadOperatorCache(cacheKey, geoCacheKey))
 	{
-		unsigned int TS = ceil(m_Exc->GetSignalPeriod()/dT);
-		double new_dT = m_Exc->GetSignalPeriod()/TS;
-		cout << "Operartor::CalcECOperator: Decreasing timestep by " << round((dT-new_dT)/dT*1000)/10.0 << "% to " << new_dT << " (" << dT << ") to match periodic signal" << endl;
-		dT = new_dT;
+		m_Exc->Reset(dT);
+		ShowStageTime("read operator cache", stageTime);
 	}
+	else
+	{
+		InitPrimitiveIndex();
+		ShowStageTime("setup data storage and primitive index", stageTime);
 
-	m_Exc->Reset(dT);
-
-	InitOperator();
+		if (Calc_EC()==0)
+			return -1;
+		ShowStageTime("calculate equivalent circuit", stageTime);
 
-	unsigned int pos[3];
-
-	for (int n=0; n<3; ++n)
-	{
-		for (pos[0]=0; pos[0]<numLines[0]; ++pos[0])
+		m_InvaildTimestep = false;
+		opt_dT = 0;
+		if (dT>0)
 		{
-			for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
+			double save_dT = dT;
+			CalcTimestep();
+			opt_dT = dT;
+			if (dT<save_dT)
 			{
-				for (pos[2]=0; pos[2]<numLines[2]; ++pos[2])
-				{
-					Calc_ECOperatorPos(n,pos);
-				}
+				cerr << "Operator::CalcECOperator: Warning, forced timestep: " << save_dT << "s is larger than calculated timestep: " << dT << "s! It is not recommended using this timestep!! " << endl;
+				m_InvaildTimestep = true;
 			}
+
+			dT = save_dT;
 		}
-	}
+		else
+			CalcTimestep();
 
-	//Apply PEC to all boundary's
-	bool PEC[6]={1,1,1,1,1,1};
-	//make an exception for BC == -1
-	for (int n=0; n<6; ++n)
-		if ((m_BC[n]==-1))
-			PEC[n] = false;
-	ApplyElectricBC(PEC);
+		dT*=m_TimeStepFactor;
 
-	CalcPEC();
+		if (m_Exc->GetSignalPeriod()>0)
+		{
+			unsigned int TS = ceil(m_Exc->GetSignalPeriod()/dT);
+			double new_dT = m_Exc->GetSignalPeriod()/TS;
+			cout << "Operartor::CalcECOperator: Decreasing timestep by " << round((dT-new_dT)/dT*1000)/10.0 << "% to " << new_dT << " (" << dT << ") to match periodic signal" << endl;
+			dT = new_dT;
+		}
 
-	Calc_LumpedElements();
+		m_Exc->Reset(dT);
+		ShowStageTime("calculate timestep", stageTime);
 
-	bool PMC[6];
-	for (int n=0; n<6; ++n)
-		PMC[n] = m_BC[n]==1;
-	ApplyMagneticBC(PMC);
+		InitOperator();
+		Calc_ECOperator();
+		ShowStageTime("calculate operator coefficients", stageTime);
+
+		//Apply PEC to all boundary's
+		bool PEC[6]={1,1,1,1,1,1};
+		//make an exception for BC == -1
+		for (int n=0; n<6; ++n)
+			if ((m_BC[n]==-1))
+				PEC[n] = false;
+		ApplyElectricBC(PEC);
+
+		CalcPEC();
+		m_Nr_PEC_Estimated = false;
+		ShowStageTime("apply PEC and electric boundary conditions", stageTime);
+
+		Calc_LumpedElements();
+
+		bool PMC[6];
+		for (int n=0; n<6; ++n)
+			PMC[n] = m_BC[n]==1;
+		ApplyMagneticBC(PMC);
+		FinalizeCoefficients();
+
+		ShowStageTime("apply lumped elements and magnetic boundary conditions", stageTime);
+
+		if (WriteOperatorCache(cacheKey, geoCacheKey))
+			ShowStageTime("write operator cache", stageTime);
+	}
 
 	//all information available for extension... create now...
-	for (size_t n=0; n<m_Op_exts.size(); ++n)
-		m_Op_exts.at(n)->BuildExtension();
+	BuildExtensions();
+	ShowStageTime("build extensions", stageTime);
 
 	//remove inactive extensions
 	vector<Operator_Extension*>::iterator it = m_Op_exts.begin();
@@ -1084,6 +1203,511 @@ int Operator::CalcECOperator( DebugFlags debugFlags )
 	return 0;
 }
 
+bool Operator::Calc_ECOperator()
+{
+	MainOp->SetPos(0,0,0);
+	Calc_ECOperator_Range(0,numLines[0]-1);
+	return true;
+}
+
+void Operator::Calc_ECOperator_Range(unsigned int xStart, unsigned int xStop)
+{
+	unsigned int start[3] = {xStart, 0, 0};
+	unsigned int stop[3] = {xStop, numLines[1]-1, numLines[2]-1};
+	Calc_ECOperator_Box(start, stop);
+}
+
+void Operator::Calc_ECOperator_Boxes(const vector<unsigned int> &boxes)
+{
+	MainOp->SetPos(0,0,0);
+	for (size_t b=0; b<boxes.size(); b+=6)
+		Calc_ECOperator_Box(&boxes.at(b), &boxes.at(b+3));
+}
+
+void Operator::Calc_ECOperator_Box(const unsigned int start[3], const unsigned int stop[3])
+{
+	// MainOp is set to the origin, the relative access is thread safe
+	unsigned int pos[3];
+	for (int n=0; n<3; ++n)
+	{
+		for (pos[0]=start[0]; pos[0]<=stop[0]; ++pos[0])
+		{
+			for (pos[1]=start[1]; pos[1]<=stop[1]; ++pos[1])
+			{
+				for (pos[2]=start[2]; pos[2]<=stop[2]; ++pos[2])
+				{
+					Calc_ECOperatorAt(n,pos,MainOp->GetPos(pos[0],pos[1],pos[2]));
+				}
+			}
+		}
+	}
+}
+
+void Operator::BuildExtensions()
+{
+	// extensions not depending on other extensions are build concurrently, all others in order of their priority
+	// the concurrent builds only read the operator, they are finished before the next extension that may change the coefficients is build
+	boost::thread_group* threads = new boost::thread_group();
+	for (size_t n=0; n<m_Op_exts.size(); ++n)
+	{
+		Operator_Extension* op_ext = m_Op_exts.at(n);
+		if (op_ext->IsBuildParallelSave())
+			threads->add_thread( new boost::thread( &Operator_Extension::BuildExtension, op_ext ) );
+		else
+		{
+			threads->join_all();
+			delete threads;
+			threads = new boost::thread_group();
+			op_ext->BuildExtension();
+		}
+	}
+	threads->join_all();
+	delete threads;
+}
+
+//! 64 bit FNV-1a hash of a string
+static uint64_t HashString(const string &str)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t n=0; n<str.size(); ++n)
+	{
+		hash ^= (unsigned char)str[n];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static void WriteCacheString(ostream &file, const string &str)
+{
+	uint64_t size = str.size();
+	file.write((const char*)&size, sizeof(size));
+	file.write(str.c_str(), size);
+}
+
+static bool ReadCacheString(istream &file, string &str)
+{
+	uint64_t size = 0;
+	file.read((char*)&size, sizeof(size));
+	if (!file.good() || (size>(1<<30)))
+		return false;
+	str.resize(size);
+	if (size>0)
+		file.read(&str[0], size);
+	return file.good();
+}
+
+//! The primitives the operator setup may mark as used
+static vector<CSPrimitives*> GetCachePrimitives(ContinuousStructure* CSX)
+{
+	return CSX->GetAllPrimitives(false, (CSProperties::PropertyType)(CSProperties::MATERIAL | CSProperties::METAL | CSProperties::LUMPED_ELEMENT));
+}
+
+void Operator::AddOperatorUpdateBox(const double start[3], const double stop[3])
+{
+	for (int n=0; n<3; ++n)
+		m_OpUpdateBoxes.push_back(start[n]);
+	for (int n=0; n<3; ++n)
+		m_OpUpdateBoxes.push_back(stop[n]);
+}
+
+string Operator::GetGeometryCacheKey() const
+{
+	// hash the geometry without the properties (dumps, probes and excitations) that do not change the operator before the extensions are build
+	TiXmlDocument doc;
+	CSX->Write2XML(&doc, false, false);
+	TiXmlElement* props = NULL;
+	if (doc.FirstChildElement("ContinuousStructure"))
+		props = doc.FirstChildElement("ContinuousStructure")->FirstChildElement("Properties");
+	if (props)
+	{
+		TiXmlElement* prop = props->FirstChildElement();
+		while (prop)
+		{
+			TiXmlElement* next = prop->NextSiblingElement();
+			string type(prop->Value());
+			if ((type=="DumpBox") || (type=="ProbeBox") || (type=="Excitation"))
+				props->RemoveChild(prop);
+			prop = next;
+		}
+	}
+	TiXmlPrinter printer;
+	doc.Accept(&printer);
+
+	ostringstream key;
+	key << hex << HashString(printer.CStr());
+	return key.str();
+}
+
+string Operator::GetOperatorCacheKey() const
+{
+	ostringstream key;
+	key.precision(17);
+	key << "openEMS operator cache v4" << endl;
+	key << typeid(*this).name() << " " << sizeof(FDTD_FLOAT) << endl;
+	key << "mesh " << gridDelta;
+	for (int n=0; n<3; ++n)
+	{
+		key << endl << numLines[n] << ":";
+		for (unsigned int i=0; i<numLines[n]; ++i)
+			key << " " << discLines[n][i];
+	}
+	key << endl << "BC";
+	for (int n=0; n<6; ++n)
+		key << " " << m_BC[n];
+	key << endl << "background " << m_BG_epsR << " " << m_BG_mueR << " " << m_BG_kappa << " " << m_BG_sigma << endl;
+	key << "material averaging " << m_MatAverageMethod << endl;
+	key << "timestep " << dT << " " << m_TimeStepVar << " " << m_TimeStepFactor << " " << m_Exc->GetSignalPeriod() << endl;
+	return key.str();
+}
+
+bool Operator::WriteOperatorCache(const string &key, const string &geoKey) const
+{
+	if (m_OpCacheFile.empty())
+		return false;
+
+	ofstream file(m_OpCacheFile.c_str(), ios::out | ios::binary | ios::trunc);
+	if (!file.is_open())
+	{
+		cerr << "Operator::WriteOperatorCache: Error, can't open cache file \"" << m_OpCacheFile << "\" for writing!" << endl;
+		return false;
+	}
+
+	WriteCacheString(file, key);
+	WriteCacheString(file, geoKey);
+
+	// the layout of the stored material regions
+	for (int n=0; n<4; ++n)
+	{
+		unsigned int numRegions = m_MatStorage[n].size();
+		file.write((const char*)&numRegions, sizeof(numRegions));
+		for (size_t r=0; r<m_MatStorage[n].size(); ++r)
+		{
+			file.write((const char*)m_MatStorage[n].at(r).start, sizeof(unsigned int)*3);
+			file.write((const char*)m_MatStorage[n].at(r).numLines, sizeof(unsigned int)*3);
+		}
+	}
+
+	char invalidTS = m_InvaildTimestep;
+	char estimatedPEC = m_Nr_PEC_Estimated;
+	file.write((const char*)&dT, sizeof(dT));
+	file.write((const char*)&opt_dT, sizeof(opt_dT));
+	file.write(&invalidTS, 1);
+	WriteCacheString(file, m_Used_TS_Name);
+	file.write((const char*)m_Nr_PEC, sizeof(m_Nr_PEC));
+	file.write(&estimatedPEC, 1);
+
+	for (int n=0; n<3; ++n)
+	{
+		file.write((const char*)EC_C[n], sizeof(FDTD_FLOAT)*MainOp->GetSize());
+		file.write((const char*)EC_G[n], sizeof(FDTD_FLOAT)*MainOp->GetSize());
+		file.write((const char*)EC_L[n], sizeof(FDTD_FLOAT)*MainOp->GetSize());
+		file.write((const char*)EC_R[n], sizeof(FDTD_FLOAT)*MainOp->GetSize());
+	}
+
+	WriteCoefficientCache(file);
+
+	for (int n=0; n<4; ++n)
+		for (size_t r=0; r<m_MatStorage[n].size(); ++r)
+			Write_N_3DArray2Stream(file, m_MatStorage[n].at(r).data, m_MatStorage[n].at(r).numLines, m_MatStorage[n].at(r).numLines[2]);
+
+	vector<CSPrimitives*> vPrims = GetCachePrimitives(CSX);
+	vector<unsigned int> used;
+	for (unsigned int i=0; i<vPrims.size(); ++i)
+		if (vPrims.at(i)->GetPrimitiveUsed())
+			used.push_back(i);
+	uint64_t numPrims = vPrims.size();
+	uint64_t numUsed = used.size();
+	file.write((const char*)&numPrims, sizeof(numPrims));
+	file.write((const char*)&numUsed, sizeof(numUsed));
+	if (numUsed>0)
+		file.write((const char*)&used[0], sizeof(unsigned int)*numUsed);
+
+	if (!file.good())
+	{
+		cerr << "Operator::WriteOperatorCache: Error, writing the cache file \"" << m_OpCacheFile << "\" failed!" << endl;
+		file.close();
+		remove(m_OpCacheFile.c_str());
+		return false;
+	}
+	if (g_settings.GetVerboseLevel()>0)
+		cout << "Operator::WriteOperatorCache: Operator written to cache file \"" << m_OpCacheFile << "\"" << endl;
+	return true;
+}
+
+bool Operator::ReadOperatorCache(const string &key, const string &geoKey)
+{
+	if (m_OpCacheFile.empty())
+		return false;
+
+	ifstream file(m_OpCacheFile.c_str(), ios::in | ios::binary);
+	if (!file.is_open())
+		return false;
+
+	string cache_key;
+	if (!ReadCacheString(file, cache_key) || (cache_key!=key))
+	{
+		if (g_settings.GetVerboseLevel()>0)
+			cout << "Operator::ReadOperatorCache: Mesh or settings changed, cache file \"" << m_OpCacheFile << "\" is outdated." << endl;
+		return false;
+	}
+	// a changed geometry can be updated inside the given update boxes only
+	string cache_geoKey;
+	ReadCacheString(file, cache_geoKey);
+	bool update = (cache_geoKey!=geoKey);
+	if (update && m_OpUpdateBoxes.empty())
+	{
+		if (g_settings.GetVerboseLevel()>0)
+			cout << "Operator::ReadOperatorCache: Geometry changed, cache file \"" << m_OpCacheFile << "\" is outdated." << endl;
+		return false;
+	}
+
+	// the requested material storage has to match the stored regions, unrequested data is skipped
+	vector<unsigned int> storedRegions[4];
+	for (int n=0; n<4; ++n)
+	{
+		unsigned int numRegions = 0;
+		file.read((char*)&numRegions, sizeof(numRegions));
+		if (!file.good())
+			return false;
+		storedRegions[n].resize(6*numRegions);
+		if (numRegions>0)
+			file.read((char*)&storedRegions[n][0], sizeof(unsigned int)*6*numRegions);
+		bool match = m_MatStorage[n].empty() || (m_MatStorage[n].size()==numRegions);
+		for (size_t r=0; match && (r<m_MatStorage[n].size()); ++r)
+			for (int d=0; d<3; ++d)
+				match &= (m_MatStorage[n].at(r).start[d]==storedRegions[n].at(6*r+d)) && (m_MatStorage[n].at(r).numLines[d]==storedRegions[n].at(6*r+3+d));
+		if (!match)
+		{
+			if (g_settings.GetVerboseLevel()>0)
+				cout << "Operator::ReadOperatorCache: Requested material storage is missing in cache file \"" << m_OpCacheFile << "\"." << endl;
+			return false;
+		}
+	}
+
+	// keep a forced timestep until the cache was read successfully
+	double cache_dT = 0;
+	char invalidTS = 0;
+	char estimatedPEC = 0;
+	file.read((char*)&cache_dT, sizeof(cache_dT));
+	file.read((char*)&opt_dT, sizeof(opt_dT));
+	file.read(&invalidTS, 1);
+	m_InvaildTimestep = invalidTS;
+	ReadCacheString(file, m_Used_TS_Name);
+	file.read((char*)m_Nr_PEC, sizeof(m_Nr_PEC));
+	file.read(&estimatedPEC, 1);
+	m_Nr_PEC_Estimated = estimatedPEC;
+
+	for (int n=0; n<3; ++n)
+	{
+		file.read((char*)EC_C[n], sizeof(FDTD_FLOAT)*MainOp->GetSize());
+		file.read((char*)EC_G[n], sizeof(FDTD_FLOAT)*MainOp->GetSize());
+		file.read((char*)EC_L[n], sizeof(FDTD_FLOAT)*MainOp->GetSize());
+		file.read((char*)EC_R[n], sizeof(FDTD_FLOAT)*MainOp->GetSize());
+	}
+
+	InitOperator();
+	ReadCoefficientCache(file);
+
+	for (int n=0; n<4; ++n)
+	{
+		for (size_t r=0; r<storedRegions[n].size(); r+=6)
+		{
+			if (m_MatStorage[n].empty())
+			{
+				// not requested, skip the stored data
+				file.seekg(sizeof(float)*3*storedRegions[n].at(r+3)*storedRegions[n].at(r+4)*storedRegions[n].at(r+5), ios::cur);
+				continue;
+			}
+			MaterialStorage &storage = m_MatStorage[n].at(r/6);
+			Read_N_3DArrayFromStream(file, storage.data, storage.numLines, storage.numLines[2]);
+		}
+	}
+
+	vector<CSPrimitives*> vPrims = GetCachePrimitives(CSX);
+	uint64_t numPrims = 0;
+	uint64_t numUsed = 0;
+	file.read((char*)&numPrims, sizeof(numPrims));
+	file.read((char*)&numUsed, sizeof(numUsed));
+	vector<unsigned int> used;
+	if (file.good() && (numUsed<=numPrims))
+	{
+		used.resize(numUsed);
+		if (numUsed>0)
+			file.read((char*)&used[0], sizeof(unsigned int)*numUsed);
+	}
+	else
+		file.setstate(ios::failbit);
+
+	if (!file.good())
+	{
+		cerr << "Operator::ReadOperatorCache: Error, cache file \"" << m_OpCacheFile << "\" is damaged, recalculating the operator..." << endl;
+		return false;
+	}
+
+	file.close();
+
+	double preset_dT = dT;
+	dT = cache_dT;
+	// the primitive list is only comparable if no primitive was added or removed
+	if (numPrims==vPrims.size())
+		for (size_t i=0; i<used.size(); ++i)
+			vPrims.at(used.at(i))->SetPrimitiveUsed(true);
+
+	if (update)
+	{
+		if (UpdateOperatorBoxes(preset_dT>0)==false)
+		{
+			dT = preset_dT;
+			return false;
+		}
+		if (g_settings.GetVerboseLevel()>0)
+			cout << "Operator::ReadOperatorCache: Operator restored from cache file \"" << m_OpCacheFile << "\" and updated inside " << m_OpUpdateBoxes.size()/6 << " box(es)" << endl;
+		WriteOperatorCache(key, geoKey);
+		return true;
+	}
+
+	if (g_settings.GetVerboseLevel()>0)
+		cout << "Operator::ReadOperatorCache: Operator restored from cache file \"" << m_OpCacheFile << "\"" << endl;
+	return true;
+}
+
+//! Count the edges with a shorted (zero) voltage update inside the given box
+static void CountShortedEdges(const Operator* op, const unsigned int* start, const unsigned int* stop, unsigned int* counter)
+{
+	unsigned int pos[3];
+	for (int n=0; n<3; ++n)
+		for (pos[0]=start[0]; pos[0]<=stop[0]; ++pos[0])
+			for (pos[1]=start[1]; pos[1]<=stop[1]; ++pos[1])
+				for (pos[2]=start[2]; pos[2]<=stop[2]; ++pos[2])
+					if ((op->GetVV(n,pos)==0) && (op->GetVI(n,pos)==0))
+						++counter[n];
+}
+
+bool Operator::UpdateOperatorBoxes(bool forcedTimestep)
+{
+	InitPrimitiveIndex();
+
+	// snap all update boxes to the mesh, including all edges whose material averaging may reach into the box
+	vector<unsigned int> boxes;
+	for (size_t b=0; b<m_OpUpdateBoxes.size()/6; ++b)
+	{
+		unsigned int start[3], stop[3];
+		if (SnapBox2Mesh(&m_OpUpdateBoxes.at(6*b), &m_OpUpdateBoxes.at(6*b+3), start, stop, false, false, 2)<0)
+			continue;
+		for (int n=0; n<3; ++n)
+			boxes.push_back(start[n]>0 ? start[n]-1 : 0);
+		for (int n=0; n<3; ++n)
+			boxes.push_back(min(stop[n]+1, numLines[n]-1));
+	}
+
+	unsigned int shorted[3] = {0,0,0};
+	unsigned int nr_PEC[3] = {m_Nr_PEC[0], m_Nr_PEC[1], m_Nr_PEC[2]};
+	bool lowerTimestep = false;
+	unsigned int pos[3];
+	MainOp->SetPos(0,0,0);
+	for (size_t b=0; b<boxes.size(); b+=6)
+	{
+		const unsigned int* start = &boxes.at(b);
+		const unsigned int* stop = &boxes.at(b+3);
+		CountShortedEdges(this, start, stop, shorted);
+
+		// the timestep may only decrease if a capacitance or inductance decreases
+		vector<FDTD_FLOAT> oldEC;
+		for (int n=0; n<3; ++n)
+			for (pos[0]=start[0]; pos[0]<=stop[0]; ++pos[0])
+				for (pos[1]=start[1]; pos[1]<=stop[1]; ++pos[1])
+					for (pos[2]=start[2]; pos[2]<=stop[2]; ++pos[2])
+					{
+						oldEC.push_back(EC_C[n][MainOp->GetPos(pos[0],pos[1],pos[2])]);
+						oldEC.push_back(EC_L[n][MainOp->GetPos(pos[0],pos[1],pos[2])]);
+					}
+
+		Calc_EC_Box(start, stop);
+
+		size_t i = 0;
+		for (int n=0; n<3; ++n)
+			for (pos[0]=start[0]; pos[0]<=stop[0]; ++pos[0])
+				for (pos[1]=start[1]; pos[1]<=stop[1]; ++pos[1])
+					for (pos[2]=start[2]; pos[2]<=stop[2]; ++pos[2])
+					{
+						if (EC_C[n][MainOp->GetPos(pos[0],pos[1],pos[2])]<oldEC.at(i++))
+							lowerTimestep = true;
+						if (EC_L[n][MainOp->GetPos(pos[0],pos[1],pos[2])]<oldEC.at(i++))
+							lowerTimestep = true;
+					}
+	}
+
+	if (lowerTimestep)
+	{
+		double used_dT = dT;
+		string used_TS_Name = m_Used_TS_Name;
+		CalcTimestep();
+		double new_dT = dT;
+		dT = used_dT;
+		m_Used_TS_Name = used_TS_Name;
+		if (forcedTimestep)
+		{
+			opt_dT = new_dT;
+			m_InvaildTimestep = (new_dT<dT);
+			if (m_InvaildTimestep)
+				cerr << "Operator::UpdateOperatorBoxes: Warning, forced timestep: " << dT << "s is larger than calculated timestep: " << new_dT << "s! It is not recommended using this timestep!! " << endl;
+		}
+		else if (new_dT*m_TimeStepFactor<dT)
+		{
+			if (g_settings.GetVerboseLevel()>0)
+				cout << "Operator::UpdateOperatorBoxes: The updated geometry requires a smaller timestep, recalculating the operator..." << endl;
+			return false;
+		}
+	}
+
+	Calc_ECOperator_Boxes(boxes);
+
+	// re-apply everything that may overwrite the coefficients inside the boxes, all of these are independent of the previous operator state
+	bool PEC[6]={1,1,1,1,1,1};
+	for (int n=0; n<6; ++n)
+		if ((m_BC[n]==-1))
+			PEC[n] = false;
+	ApplyElectricBC(PEC);
+
+	for (size_t b=0; b<boxes.size(); b+=6)
+		CalcPEC_Box(&boxes.at(b), &boxes.at(b+3), m_Nr_PEC);
+	CalcPEC_Curves();
+
+	Calc_LumpedElements();
+
+	bool PMC[6];
+	for (int n=0; n<6; ++n)
+		PMC[n] = m_BC[n]==1;
+	ApplyMagneticBC(PMC);
+	FinalizeCoefficients();
+
+	// update the PEC statistics by the difference of shorted edges inside the boxes
+	// an exact count would need the metal of the previous geometry, the difference also contains the edges shorted by boundary conditions and lumped elements
+	for (size_t b=0; b<boxes.size(); b+=6)
+		CountShortedEdges(this, &boxes.at(b), &boxes.at(b+3), nr_PEC);
+	for (int n=0; n<3; ++n)
+		m_Nr_PEC[n] = nr_PEC[n] - shorted[n];
+	m_Nr_PEC_Estimated = true;
+
+	return true;
+}
+
+bool Operator::WriteCoefficientCache(ostream &file) const
+{
+	Write_N_3DArray2Stream(file, vv, numLines, numLines[2]);
+	Write_N_3DArray2Stream(file, vi, numLines, numLines[2]);
+	Write_N_3DArray2Stream(file, iv, numLines, numLines[2]);
+	return Write_N_3DArray2Stream(file, ii, numLines, numLines[2]);
+}
+
+bool Operator::ReadCoefficientCache(istream &file)
+{
+	Read_N_3DArrayFromStream(file, vv, numLines, numLines[2]);
+	Read_N_3DArrayFromStream(file, vi, numLines, numLines[2]);
+	Read_N_3DArrayFromStream(file, iv, numLines, numLines[2]);
+	return Read_N_3DArrayFromStream(file, ii, numLines, numLines[2]);
+}
+
 void Operator::ApplyElectricBC(bool* dirs)
 {
 	if (!dirs)
@@ -1174,19 +1798,12 @@ void Operator::ApplyMagneticBC(bool* dirs)
 	}
 }
 
-bool Operator::Calc_ECPos(int ny, const unsigned int* pos, double* EC, vector<CSPrimitives*> vPrims) const
+bool Operator::Calc_ECPos(int ny, const unsigned int* pos, double* EC, const vector<CSPrimitives*> &vPrims) const
 {
 	double EffMat[4];
 	Calc_EffMatPos(ny,pos,EffMat, vPrims);
 
-	if (m_epsR)
-		m_epsR[ny][pos[0]][pos[1]][pos[2]] =  EffMat[0];
-	if (m_kappa)
-		m_kappa[ny][pos[0]][pos[1]][pos[2]] =  EffMat[1];
-	if (m_mueR)
-		m_mueR[ny][pos[0]][pos[1]][pos[2]] =  EffMat[2];
-	if (m_sigma)
-		m_sigma[ny][pos[0]][pos[1]][pos[2]] =  EffMat[3];
+	StoreMaterial(ny,pos,EffMat);
 
 	double delta = GetEdgeLength(ny,pos);
 	double area  = GetEdgeArea(ny,pos);
@@ -1249,17 +1866,27 @@ bool Operator::GetCellCenterMaterialAvgCoord(const int pos[], double coord[3]) c
 	return true;
 }
 
-double Operator::GetMaterial(int ny, const double* coords, int MatType, vector<CSPrimitives*> vPrims, bool markAsUsed) const
+CSProperties* Operator::GetPropertyByCoordPriority(const double* coords, const vector<CSPrimitives*> &vPrims, bool markAsUsed) const
 {
-	CSProperties* prop = CSX->GetPropertyByCoordPriority(coords,vPrims,markAsUsed);
-//	CSProperties* old_prop = CSX->GetPropertyByCoordPriority(coords,CSProperties::MATERIAL,markAsUsed);
-//	if (old_prop!=prop)
-//	{
-//		cerr << "ERROR: Unequal properties!" << endl;
-//		exit(-1);
-//	}
+	CSPrimitives* found = NULL;
+	for (size_t i=0; i<vPrims.size(); ++i)
+	{
+		CSPrimitives* prim = vPrims[i];
+		// the first primitive found with the highest priority wins
+		if ((found!=NULL) && (prim->GetPriority()<=found->GetPriority()))
+			continue;
+		if (prim->IsInside(coords))
+			found = prim;
+	}
+	if (found==NULL)
+		return NULL;
+	if (markAsUsed)
+		found->SetPrimitiveUsed(true);
+	return found->GetProperty();
+}
 
-	CSPropMaterial* mat = dynamic_cast<CSPropMaterial*>(prop);
+double Operator::GetMaterialValue(int ny, const double* coords, int MatType, CSPropMaterial* mat) const
+{
 	if (mat)
 	{
 		switch (MatType)
@@ -1298,7 +1925,20 @@ double Operator::GetMaterial(int ny, const double* coords, int MatType, vector<C
 	}
 }
 
-bool Operator::AverageMatCellCenter(int ny, const unsigned int* pos, double* EffMat, vector<CSPrimitives *> vPrims) const
+double Operator::GetMaterial(int ny, const double* coords, int MatType, const vector<CSPrimitives*> &vPrims, bool markAsUsed) const
+{
+	CSPropMaterial* mat = dynamic_cast<CSPropMaterial*>(GetPropertyByCoordPriority(coords,vPrims,markAsUsed));
+	return GetMaterialValue(ny, coords, MatType, mat);
+}
+
+void Operator::SampleMaterial(int ny, const double* coords, double* mat, const vector<CSPrimitives*> &vPrims, bool markAsUsed) const
+{
+	CSPropMaterial* prop = dynamic_cast<CSPropMaterial*>(GetPropertyByCoordPriority(coords,vPrims,markAsUsed));
+	for (int n=0; n<4; ++n)
+		mat[n] = GetMaterialValue(ny, coords, n, prop);
+}
+
+bool Operator::AverageMatCellCenter(int ny, const unsigned int* pos, double* EffMat, const vector<CSPrimitives *> &vPrims) const
 {
 	int n=ny;
 	double coord[3];
@@ -1308,6 +1948,7 @@ bool Operator::AverageMatCellCenter(int ny, const unsigned int* pos, double* Eff
 	int loc_pos[3] = {(int)pos[0],(int)pos[1],(int)pos[2]};
 	double A_n;
 	double area = 0;
+	double mat[4];
 	EffMat[0] = 0;
 	EffMat[1] = 0;
 	EffMat[2] = 0;
@@ -1318,8 +1959,9 @@ bool Operator::AverageMatCellCenter(int ny, const unsigned int* pos, double* Eff
 	if (GetCellCenterMaterialAvgCoord(loc_pos,coord))
 	{
 		A_n = GetNodeArea(ny,loc_pos,true);
-		EffMat[0] += GetMaterial(n, coord, 0, vPrims)*A_n;
-		EffMat[1] += GetMaterial(n, coord, 1, vPrims)*A_n;
+		SampleMaterial(n, coord, mat, vPrims);
+		EffMat[0] += mat[0]*A_n;
+		EffMat[1] += mat[1]*A_n;
 		area+=A_n;
 	}
 
@@ -1328,8 +1970,9 @@ bool Operator::AverageMatCellCenter(int ny, const unsigned int* pos, double* Eff
 	if (GetCellCenterMaterialAvgCoord(loc_pos,coord))
 	{
 		A_n = GetNodeArea(ny,loc_pos,true);
-		EffMat[0] += GetMaterial(n, coord, 0, vPrims)*A_n;
-		EffMat[1] += GetMaterial(n, coord, 1, vPrims)*A_n;
+		SampleMaterial(n, coord, mat, vPrims);
+		EffMat[0] += mat[0]*A_n;
+		EffMat[1] += mat[1]*A_n;
 		area+=A_n;
 	}
 
@@ -1339,8 +1982,9 @@ bool Operator::AverageMatCellCenter(int ny, const unsigned int* pos, double* Eff
 	if (GetCellCenterMaterialAvgCoord(loc_pos,coord))
 	{
 		A_n = GetNodeArea(ny,loc_pos,true);
-		EffMat[0] += GetMaterial(n, coord, 0, vPrims)*A_n;
-		EffMat[1] += GetMaterial(n, coord, 1, vPrims)*A_n;
+		SampleMaterial(n, coord, mat, vPrims);
+		EffMat[0] += mat[0]*A_n;
+		EffMat[1] += mat[1]*A_n;
 		area+=A_n;
 	}
 
@@ -1349,8 +1993,9 @@ bool Operator::AverageMatCellCenter(int ny, const unsigned int* pos, double* Eff
 	if (GetCellCenterMaterialAvgCoord(loc_pos,coord))
 	{
 		A_n = GetNodeArea(ny,loc_pos,true);
-		EffMat[0] += GetMaterial(n, coord, 0, vPrims)*A_n;
-		EffMat[1] += GetMaterial(n, coord, 1, vPrims)*A_n;
+		SampleMaterial(n, coord, mat, vPrims);
+		EffMat[0] += mat[0]*A_n;
+		EffMat[1] += mat[1]*A_n;
 		area+=A_n;
 	}
 
@@ -1368,8 +2013,9 @@ bool Operator::AverageMatCellCenter(int ny, const unsigned int* pos, double* Eff
 	if (GetCellCenterMaterialAvgCoord(loc_pos,coord))
 	{
 		delta_ny = GetNodeWidth(n,loc_pos,true);
-		EffMat[2] += delta_ny / GetMaterial(n, coord, 2, vPrims);
-		sigma = GetMaterial(n, coord, 3, vPrims);
+		SampleMaterial(n, coord, mat, vPrims);
+		EffMat[2] += delta_ny / mat[2];
+		sigma = mat[3];
 		if (sigma)
 			EffMat[3] += delta_ny / sigma;
 		else
@@ -1382,8 +2028,9 @@ bool Operator::AverageMatCellCenter(int ny, const unsigned int* pos, double* Eff
 	if (GetCellCenterMaterialAvgCoord(loc_pos,coord))
 	{
 		delta_ny = GetNodeWidth(n,loc_pos,true);
-		EffMat[2] += delta_ny / GetMaterial(n, coord, 2, vPrims);
-		sigma = GetMaterial(n, coord, 3, vPrims);
+		SampleMaterial(n, coord, mat, vPrims);
+		EffMat[2] += delta_ny / mat[2];
+		sigma = mat[3];
 		if (sigma)
 			EffMat[3] += delta_ny / sigma;
 		else
@@ -1404,7 +2051,7 @@ bool Operator::AverageMatCellCenter(int ny, const unsigned int* pos, double* Eff
 	return true;
 }
 
-bool Operator::AverageMatQuarterCell(int ny, const unsigned int* pos, double* EffMat, vector<CSPrimitives*> vPrims) const
+bool Operator::AverageMatQuarterCell(int ny, const unsigned int* pos, double* EffMat, const vector<CSPrimitives*> &vPrims) const
 {
 	int n=ny;
 	double coord[3];
@@ -1424,6 +2071,7 @@ bool Operator::AverageMatQuarterCell(int ny, const unsigned int* pos, double* Ef
 	int loc_pos[3] = {(int)pos[0],(int)pos[1],(int)pos[2]};
 	double A_n;
 	double area = 0;
+	double mat[4];
 
 	//******************************* epsilon,kappa averaging *****************************//
 	//shift up-right
@@ -1431,8 +2079,9 @@ bool Operator::AverageMatQuarterCell(int ny, const unsigned int* pos, double* Ef
 	shiftCoord[nP] = coord[nP]+deltaP*0.25;
 	shiftCoord[nPP] = coord[nPP]+deltaPP*0.25;
 	A_n = GetNodeArea(ny,loc_pos,true);
-	EffMat[0] = GetMaterial(n, shiftCoord, 0, vPrims)*A_n;
-	EffMat[1] = GetMaterial(n, shiftCoord, 1, vPrims)*A_n;
+	SampleMaterial(n, shiftCoord, mat, vPrims);
+	EffMat[0] = mat[0]*A_n;
+	EffMat[1] = mat[1]*A_n;
 	area+=A_n;
 
 	//shift up-left
@@ -1442,8 +2091,9 @@ bool Operator::AverageMatQuarterCell(int ny, const unsigned int* pos, double* Ef
 
 	--loc_pos[nP];
 	A_n = GetNodeArea(ny,loc_pos,true);
-	EffMat[0] += GetMaterial(n, shiftCoord, 0, vPrims)*A_n;
-	EffMat[1] += GetMaterial(n, shiftCoord, 1, vPrims)*A_n;
+	SampleMaterial(n, shiftCoord, mat, vPrims);
+	EffMat[0] += mat[0]*A_n;
+	EffMat[1] += mat[1]*A_n;
 	area+=A_n;
 
 	//shift down-right
@@ -1453,8 +2103,9 @@ bool Operator::AverageMatQuarterCell(int ny, const unsigned int* pos, double* Ef
 	++loc_pos[nP];
 	--loc_pos[nPP];
 	A_n = GetNodeArea(ny,loc_pos,true);
-	EffMat[0] += GetMaterial(n, shiftCoord, 0, vPrims)*A_n;
-	EffMat[1] += GetMaterial(n, shiftCoord, 1, vPrims)*A_n;
+	SampleMaterial(n, shiftCoord, mat, vPrims);
+	EffMat[0] += mat[0]*A_n;
+	EffMat[1] += mat[1]*A_n;
 	area+=A_n;
 
 	//shift down-left
@@ -1463,8 +2114,9 @@ bool Operator::AverageMatQuarterCell(int ny, const unsigned int* pos, double* Ef
 	shiftCoord[nPP] = coord[nPP]-deltaPP_M*0.25;
 	--loc_pos[nP];
 	A_n = GetNodeArea(ny,loc_pos,true);
-	EffMat[0] += GetMaterial(n, shiftCoord, 0, vPrims)*A_n;
-	EffMat[1] += GetMaterial(n, shiftCoord, 1, vPrims)*A_n;
+	SampleMaterial(n, shiftCoord, mat, vPrims);
+	EffMat[0] += mat[0]*A_n;
+	EffMat[1] += mat[1]*A_n;
 	area+=A_n;
 
 	EffMat[0]*=__EPS0__/area;
@@ -1482,8 +2134,9 @@ bool Operator::AverageMatQuarterCell(int ny, const unsigned int* pos, double* Ef
 	shiftCoord[nPP] = coord[nPP]+deltaPP*0.5;
 	--loc_pos[n];
 	double delta_ny = GetNodeWidth(n,loc_pos,true);
-	EffMat[2] = delta_ny / GetMaterial(n, shiftCoord, 2, vPrims);
-	double sigma = GetMaterial(n, shiftCoord, 3, vPrims);
+	SampleMaterial(n, shiftCoord, mat, vPrims);
+	EffMat[2] = delta_ny / mat[2];
+	double sigma = mat[3];
 	if (sigma)
 		EffMat[3] = delta_ny / sigma;
 	else
@@ -1496,8 +2149,9 @@ bool Operator::AverageMatQuarterCell(int ny, const unsigned int* pos, double* Ef
 	shiftCoord[nPP] = coord[nPP]+deltaPP*0.5;
 	++loc_pos[n];
 	delta_ny = GetNodeWidth(n,loc_pos,true);
-	EffMat[2] += delta_ny / GetMaterial(n, shiftCoord, 2, vPrims);
-	sigma = GetMaterial(n, shiftCoord, 3, vPrims);
+	SampleMaterial(n, shiftCoord, mat, vPrims);
+	EffMat[2] += delta_ny / mat[2];
+	sigma = mat[3];
 	if (sigma)
 		EffMat[3] += delta_ny / sigma;
 	else
@@ -1518,7 +2172,7 @@ bool Operator::AverageMatQuarterCell(int ny, const unsigned int* pos, double* Ef
 	return true;
 }
 
-bool Operator::Calc_EffMatPos(int ny, const unsigned int* pos, double* EffMat, vector<CSPrimitives *> vPrims) const
+bool Operator::Calc_EffMatPos(int ny, const unsigned int* pos, double* EffMat, const vector<CSPrimitives *> &vPrims) const
 {
 	switch (m_MatAverageMethod)
 	{
@@ -1761,19 +2415,45 @@ vector<CSPrimitives*> Operator::GetPrimitivesBoundBox(int posX, int posY, int po
 	return vPrim;
 }
 
+void Operator::InitPrimitiveIndex()
+{
+	ClearPrimitiveIndex();
+	if (CSX==NULL)
+		return;
+	m_MatPrimIndex = new Primitive_Index(this, CSX, CSProperties::MATERIAL);
+	m_PECPrimIndex = new Primitive_Index(this, CSX, (CSProperties::PropertyType)(CSProperties::MATERIAL | CSProperties::METAL));
+	if (g_settings.GetVerboseLevel()>1)
+		cout << "Operator::InitPrimitiveIndex: Using " << m_MatPrimIndex->GetNumberOfBins() << " bins with an average of " << m_MatPrimIndex->GetAveragePrimitivesPerBin() << " material primitives per bin." << endl;
+}
+
+void Operator::ClearPrimitiveIndex()
+{
+	delete m_MatPrimIndex;
+	m_MatPrimIndex = NULL;
+	delete m_PECPrimIndex;
+	m_PECPrimIndex = NULL;
+}
+
 void Operator::Calc_EC_Range(unsigned int xStart, unsigned int xStop)
+{
+	unsigned int start[3] = {xStart, 0, 0};
+	unsigned int stop[3] = {xStop, numLines[1]-1, numLines[2]-1};
+	Calc_EC_Box(start, stop);
+}
+
+void Operator::Calc_EC_Box(const unsigned int start[3], const unsigned int stop[3])
 {
 //	vector<CSPrimitives*> vPrims = this->CSX->GetAllPrimitives(true, CSProperties::MATERIAL);
 	unsigned int ipos;
 	unsigned int pos[3];
 	double inEC[4];
-	for (pos[0]=xStart; pos[0]<=xStop; ++pos[0])
+	for (pos[0]=start[0]; pos[0]<=stop[0]; ++pos[0])
 	{
-		for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
+		for (pos[1]=start[1]; pos[1]<=stop[1]; ++pos[1])
 		{
-			vector<CSPrimitives*> vPrims = this->GetPrimitivesBoundBox(pos[0], pos[1], -1, CSProperties::MATERIAL);
-			for (pos[2]=0; pos[2]<numLines[2]; ++pos[2])
+			for (pos[2]=start[2]; pos[2]<=stop[2]; ++pos[2])
 			{
+				const vector<CSPrimitives*>& vPrims = m_MatPrimIndex->GetPrimitives(pos);
 				ipos = MainOp->GetPos(pos[0],pos[1],pos[2]);
 				for (int n=0; n<3; ++n)
 				{
@@ -1814,42 +2494,27 @@ double Operator::CalcTimestep_Var1()
 {
 	m_Used_TS_Name = string("Rennings_1");
 //	cout << "Operator::CalcTimestep(): Using timestep algorithm by Andreas Rennings, Dissertation @ University Duisburg-Essen, 2008, pp. 66, eq. 4.52" << endl;
-	dT=1e200;
-	double newT;
-	unsigned int pos[3];
-	unsigned int smallest_pos[3] = {0, 0, 0};
-	unsigned int smallest_n = 0;
-	unsigned int ipos;
-	unsigned int ipos_PM;
-	unsigned int ipos_PPM;
-	MainOp->SetReflection2Cell();
-	for (int n=0; n<3; ++n)
+	Timestep_Min ts_min = CalcTimestep_Parallel(1);
+	dT = ts_min.dT;
+	if (dT==0)
 	{
-		int nP = (n+1)%3;
-		int nPP = (n+2)%3;
-
-		for (pos[2]=0; pos[2]<numLines[2]; ++pos[2])
-		{
-			for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
-			{
-				for (pos[0]=0; pos[0]<numLines[0]; ++pos[0])
-				{
-					ipos = MainOp->SetPos(pos[0],pos[1],pos[2]);
-					ipos_PM = MainOp->Shift(nP,-1);
-					MainOp->ResetShift();
-					ipos_PPM= MainOp->Shift(nPP,-1);
-					MainOp->ResetShift();
-					newT = 2/sqrt( ( 4/EC_L[nP][ipos] + 4/EC_L[nP][ipos_PPM] + 4/EC_L[nPP][ipos] + 4/EC_L[nPP][ipos_PM]) / EC_C[n][ipos] );
-					if ((newT<dT) && (newT>0.0))
-					{
-						dT=newT;
-						smallest_pos[0]=pos[0];smallest_pos[1]=pos[1];smallest_pos[2]=pos[2];
-						smallest_n = n;
-					}
-				}
-			}
-		}
+		cerr << "Operator::CalcTimestep: Timestep is zero... this is not supposed to happen!!! exit!" << endl;
+		exit(3);
 	}
+	if (g_settings.GetVerboseLevel()>1)
+	{
+		cout << "Operator::CalcTimestep_Var1: Smallest timestep (" << dT << "s) found at position: " <<  ts_min.n << " : " << ts_min.pos[0] << ";" <<  ts_min.pos[1] << ";" <<  ts_min.pos[2] << endl;
+	}
+	return 0;
+}
+
+//Berechnung nach Andreas Rennings Dissertation 2008, Seite 76 ff, Formel 4.77 ff
+double Operator::CalcTimestep_Var3()
+{
+	m_Used_TS_Name = string("Rennings_2");
+//	cout << "Operator::CalcTimestep(): Using timestep algorithm by Andreas Rennings, Dissertation @ University Duisburg-Essen, 2008, pp. 76, eq. 4.77 ff." << endl;
+	Timestep_Min ts_min = CalcTimestep_Parallel(3);
+	dT = ts_min.dT;
 	if (dT==0)
 	{
 		cerr << "Operator::CalcTimestep: Timestep is zero... this is not supposed to happen!!! exit!" << endl;
@@ -1857,97 +2522,176 @@ double Operator::CalcTimestep_Var1()
 	}
 	if (g_settings.GetVerboseLevel()>1)
 	{
-		cout << "Operator::CalcTimestep_Var1: Smallest timestep (" << dT << "s) found at position: " <<  smallest_n << " : " << smallest_pos[0] << ";" <<  smallest_pos[1] << ";" <<  smallest_pos[2] << endl;
+		cout << "Operator::CalcTimestep_Var3: Smallest timestep (" << dT << "s) found at position: " <<  ts_min.n << " : " << ts_min.pos[0] << ";" <<  ts_min.pos[1] << ";" <<  ts_min.pos[2] << endl;
 	}
 	return 0;
 }
 
-double min(double* val, unsigned int count)
+Operator::Timestep_Min Operator::CalcTimestep_Parallel(int variant) const
 {
-	if (count==0)
-		return 0.0;
-	double min = val[0];
-	for (unsigned int n=1; n<count; ++n)
-		if (val[n]<min)
-			min = val[n];
-	return min;
+	vector<unsigned int> jpt = AssignJobs2Threads(numLines[0], max(GetNumberOfSetupThreads(),(unsigned int)1), true);
+	vector<Timestep_Min> results(jpt.size());
+	boost::thread_group threads;
+	unsigned int xStart = 0;
+	for (size_t t=0; t<jpt.size(); ++t)
+	{
+		// the last range is calculated by the calling thread
+		if (t+1<jpt.size())
+			threads.add_thread( new boost::thread( &Operator::CalcTimestep_Range, this, variant, xStart, xStart+jpt.at(t)-1, &results.at(t) ) );
+		else
+			CalcTimestep_Range(variant, xStart, xStart+jpt.at(t)-1, &results.at(t));
+		xStart += jpt.at(t);
+	}
+	threads.join_all();
+
+	// the smallest timestep is independent of the number of threads, only the reported position may differ for equal timesteps
+	Timestep_Min ts_min = results.at(0);
+	for (size_t t=1; t<results.size(); ++t)
+		if (results.at(t).dT<ts_min.dT)
+			ts_min = results.at(t);
+	return ts_min;
 }
 
-//Berechnung nach Andreas Rennings Dissertation 2008, Seite 76 ff, Formel 4.77 ff
-double Operator::CalcTimestep_Var3()
+//! Calculate the argument w of the timestep 2/sqrt(w) of the given variant for count cells of an x-line, starting at ipos (internal to CalcTimestep_Range)
+/*!
+  All neighbors are accessed by constant offsets, a neighbor outside the mesh is replaced by the cell itself (offset zero).
+  The boundary cells of an x-line are calculated by separate calls, the loop has no branches and can be vectorized.
+  */
+template <int variant>
+static void CalcTimestep_Line(const FDTD_FLOAT* const* EC_C, const FDTD_FLOAT* const* EC_L, int n, unsigned int ipos, const int offM[3], const int offP[3], unsigned int count, double* w)
 {
-	dT=1e200;
-	m_Used_TS_Name = string("Rennings_2");
-//	cout << "Operator::CalcTimestep(): Using timestep algorithm by Andreas Rennings, Dissertation @ University Duisburg-Essen, 2008, pp. 76, eq. 4.77 ff." << endl;
-	double newT;
+	int nP = (n+1)%3;
+	int nPP = (n+2)%3;
+	const FDTD_FLOAT* C_n = EC_C[n]+ipos;
+	const FDTD_FLOAT* L_nP = EC_L[nP]+ipos;
+	const FDTD_FLOAT* L_nPP = EC_L[nPP]+ipos;
+	// shifted by -1 in nPP (L_nP) or nP (L_nPP) direction
+	const FDTD_FLOAT* L_nP_M = L_nP+offM[nPP];
+	const FDTD_FLOAT* L_nPP_M = L_nPP+offM[nP];
+
+	if (variant==1)
+	{
+		for (unsigned int i=0; i<count; ++i)
+			w[i] = ( 4/L_nP[i] + 4/L_nP_M[i] + 4/L_nPP[i] + 4/L_nPP_M[i]) / C_n[i];
+		return;
+	}
+
+	const FDTD_FLOAT* C_nP = EC_C[nP]+ipos;
+	const FDTD_FLOAT* C_nPP = EC_C[nPP]+ipos;
+	const FDTD_FLOAT* C_n_PnP = C_n+offP[nP];
+	const FDTD_FLOAT* C_n_PnPP = C_n+offP[nPP];
+	const FDTD_FLOAT* C_n_MnP = C_n+offM[nP];
+	// shifted by -1 in nP and in nPP direction
+	const FDTD_FLOAT* C_n_MM = C_n+offM[nP]+offM[nPP];
+	const FDTD_FLOAT* L_nP_MM = L_nP+offM[nP]+offM[nPP];
+	const FDTD_FLOAT* C_nP_Pn = C_nP+offP[n];
+	const FDTD_FLOAT* C_nPP_Pn = C_nPP+offP[n];
+	for (unsigned int i=0; i<count; ++i)
+	{
+		double wqp, wt1, wt2;
+		double wt_4[4];
+		wqp  = 1/(L_nPP[i]*C_n_PnP[i]) + 1/(L_nPP[i]*C_n[i]);
+		wqp += 1/(L_nP[i]*C_n_PnPP[i]) + 1/(L_nP[i]*C_n[i]);
+		wqp += 1/(L_nPP_M[i]*C_n[i]) + 1/(L_nPP_M[i]*C_n_MnP[i]);
+		wqp += 1/(L_nP_MM[i]*C_n_MnP[i]) + 1/(L_nP_MM[i]*C_n_MM[i]);
+
+		wt_4[0] = 1/(L_nPP[i]   *C_nP[i]);
+		wt_4[1] = 1/(L_nPP_M[i] *C_nP[i]);
+		wt_4[2] = 1/(L_nP[i]    *C_nPP[i]);
+		wt_4[3] = 1/(L_nP_M[i]  *C_nPP[i]);
+		wt1 = wt_4[0]+wt_4[1]+wt_4[2]+wt_4[3] - 2*min(min(min(wt_4[0],wt_4[1]),wt_4[2]),wt_4[3]);
+
+		wt_4[0] = 1/(L_nPP[i]   *C_nP_Pn[i]);
+		wt_4[1] = 1/(L_nPP_M[i] *C_nP_Pn[i]);
+		wt_4[2] = 1/(L_nP[i]    *C_nPP_Pn[i]);
+		wt_4[3] = 1/(L_nP_M[i]  *C_nPP_Pn[i]);
+		wt2 = wt_4[0]+wt_4[1]+wt_4[2]+wt_4[3] - 2*min(min(min(wt_4[0],wt_4[1]),wt_4[2]),wt_4[3]);
+
+		w[i] = wqp + wt1 + wt2;
+	}
+}
+
+void Operator::CalcTimestep_Range(int variant, unsigned int xStart, unsigned int xStop, Timestep_Min* result) const
+{
+	if (variant==1)
+		CalcTimestep_Kernel<1>(xStart, xStop, result);
+	else
+		CalcTimestep_Kernel<3>(xStart, xStop, result);
+}
+
+template <int variant>
+void Operator::CalcTimestep_Kernel(unsigned int xStart, unsigned int xStop, Timestep_Min* result) const
+{
+	// direct index access equivalent to MainOp with "reflection to cell", a neighbor outside the mesh is replaced by the cell itself
+	const int stride[3] = {1, (int)numLines[0], (int)(numLines[0]*numLines[1])};
+	result->dT = 1e200;
+	result->n = 0;
+	result->pos[0] = result->pos[1] = result->pos[2] = 0;
+
+	// the timestep 2/sqrt(w) never decreases for a w smaller than the one of the current minimum
+	double wMin = 0;
+	vector<double> w(xStop-xStart+1);
 	unsigned int pos[3];
-	unsigned int smallest_pos[3] = {0, 0, 0};
-	unsigned int smallest_n = 0;
-	unsigned int ipos;
-	double w_total=0;
-	double wqp=0,wt1=0,wt2=0;
-	double wt_4[4]={0,0,0,0};
-	MainOp->SetReflection2Cell();
+	int offM[3];	// offset of the neighbor shifted by -1 in each direction
+	int offP[3];	// offset of the neighbor shifted by +1 in each direction
 	for (int n=0; n<3; ++n)
 	{
-		int nP = (n+1)%3;
-		int nPP = (n+2)%3;
-
 		for (pos[2]=0; pos[2]<numLines[2]; ++pos[2])
 		{
 			for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
 			{
-				for (pos[0]=0; pos[0]<numLines[0]; ++pos[0])
+				for (int m=1; m<3; ++m)
+				{
+					offM[m] = (pos[m]>0) ? -stride[m] : 0;
+					offP[m] = (pos[m]+1<numLines[m]) ? stride[m] : 0;
+				}
+				unsigned int ipos = xStart + pos[1]*stride[1] + pos[2]*stride[2];
+
+				// the first and last line in x-direction reflect to the cell itself
+				unsigned int first = xStart;
+				unsigned int last = xStop;
+				if (xStart==0)
 				{
-					MainOp->ResetShift();
-					ipos = MainOp->SetPos(pos[0],pos[1],pos[2]);
-					wqp  = 1/(EC_L[nPP][ipos]*EC_C[n][MainOp->GetShiftedPos(nP ,1)]) + 1/(EC_L[nPP][ipos]*EC_C[n][ipos]);
-					wqp += 1/(EC_L[nP ][ipos]*EC_C[n][MainOp->GetShiftedPos(nPP,1)]) + 1/(EC_L[nP ][ipos]*EC_C[n][ipos]);
-					ipos = MainOp->Shift(nP,-1);
-					wqp += 1/(EC_L[nPP][ipos]*EC_C[n][MainOp->GetShiftedPos(nP ,1)]) + 1/(EC_L[nPP][ipos]*EC_C[n][ipos]);
-					ipos = MainOp->Shift(nPP,-1);
-					wqp += 1/(EC_L[nP ][ipos]*EC_C[n][MainOp->GetShiftedPos(nPP,1)]) + 1/(EC_L[nP ][ipos]*EC_C[n][ipos]);
-
-					MainOp->ResetShift();
-					ipos = MainOp->SetPos(pos[0],pos[1],pos[2]);
-					wt_4[0] = 1/(EC_L[nPP][ipos]						  *EC_C[nP ][ipos]);
-					wt_4[1] = 1/(EC_L[nPP][MainOp->GetShiftedPos(nP ,-1)] *EC_C[nP ][ipos]);
-					wt_4[2] = 1/(EC_L[nP ][ipos]						  *EC_C[nPP][ipos]);
-					wt_4[3] = 1/(EC_L[nP ][MainOp->GetShiftedPos(nPP,-1)] *EC_C[nPP][ipos]);
-
-					wt1 = wt_4[0]+wt_4[1]+wt_4[2]+wt_4[3] - 2*min(wt_4,4);
-
-					MainOp->ResetShift();
-					ipos = MainOp->SetPos(pos[0],pos[1],pos[2]);
-					wt_4[0] = 1/(EC_L[nPP][ipos]						  *EC_C[nP ][MainOp->GetShiftedPos(n,1)]);
-					wt_4[1] = 1/(EC_L[nPP][MainOp->GetShiftedPos(nP ,-1)] *EC_C[nP ][MainOp->GetShiftedPos(n,1)]);
-					wt_4[2] = 1/(EC_L[nP ][ipos]						  *EC_C[nPP][MainOp->GetShiftedPos(n,1)]);
-					wt_4[3] = 1/(EC_L[nP ][MainOp->GetShiftedPos(nPP,-1)] *EC_C[nPP][MainOp->GetShiftedPos(n,1)]);
-
-					wt2 = wt_4[0]+wt_4[1]+wt_4[2]+wt_4[3] - 2*min(wt_4,4);
-
-					w_total = wqp + wt1 + wt2;
-					newT = 2/sqrt( w_total );
-					if ((newT<dT) && (newT>0.0))
+					offM[0] = 0;
+					offP[0] = (numLines[0]>1) ? 1 : 0;
+					CalcTimestep_Line<variant>(EC_C, EC_L, n, ipos, offM, offP, 1, &w[0]);
+					++first;
+				}
+				if ((xStop+1==numLines[0]) && (last>=first))
+				{
+					offM[0] = -1;
+					offP[0] = 0;
+					CalcTimestep_Line<variant>(EC_C, EC_L, n, ipos+last-xStart, offM, offP, 1, &w[last-xStart]);
+					--last;
+				}
+				if (first<=last)
+				{
+					offM[0] = -1;
+					offP[0] = 1;
+					CalcTimestep_Line<variant>(EC_C, EC_L, n, ipos+first-xStart, offM, offP, last-first+1, &w[first-xStart]);
+				}
+
+				for (pos[0]=xStart; pos[0]<=xStop; ++pos[0])
+				{
+					double wx = w[pos[0]-xStart];
+					if (!(wx>wMin))
+						continue;
+					double newT;
+					if (variant==1)
+						newT = 2/sqrt( (FDTD_FLOAT)wx );
+					else
+						newT = 2/sqrt( wx );
+					if ((newT<result->dT) && (newT>0.0))
 					{
-						dT=newT;
-						smallest_pos[0]=pos[0];smallest_pos[1]=pos[1];smallest_pos[2]=pos[2];
-						smallest_n = n;
+						result->dT = newT;
+						result->pos[0]=pos[0];result->pos[1]=pos[1];result->pos[2]=pos[2];
+						result->n = n;
+						wMin = wx;
 					}
 				}
 			}
 		}
 	}
-	if (dT==0)
-	{
-		cerr << "Operator::CalcTimestep: Timestep is zero... this is not supposed to happen!!! exit!" << endl;
-		exit(3);
-	}
-	if (g_settings.GetVerboseLevel()>1)
-	{
-		cout << "Operator::CalcTimestep_Var3: Smallest timestep (" << dT << "s) found at position: " <<  smallest_n << " : " << smallest_pos[0] << ";" <<  smallest_pos[1] << ";" <<  smallest_pos[2] << endl;
-	}
-	return 0;
 }
 
 bool Operator::CalcPEC()
@@ -1964,20 +2708,27 @@ bool Operator::CalcPEC()
 }
 
 void Operator::CalcPEC_Range(unsigned int startX, unsigned int stopX, unsigned int* counter)
+{
+	unsigned int start[3] = {startX, 0, 0};
+	unsigned int stop[3] = {stopX, numLines[1]-1, numLines[2]-1};
+	CalcPEC_Box(start, stop, counter);
+}
+
+void Operator::CalcPEC_Box(const unsigned int start[3], const unsigned int stop[3], unsigned int* counter)
 {
 	double coord[3];
 	unsigned int pos[3];
-	for (pos[0]=startX; pos[0]<=stopX; ++pos[0])
+	for (pos[0]=start[0]; pos[0]<=stop[0]; ++pos[0])
 	{
-		for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
+		for (pos[1]=start[1]; pos[1]<=stop[1]; ++pos[1])
 		{
-			vector<CSPrimitives*> vPrims = this->GetPrimitivesBoundBox(pos[0], pos[1], -1, (CSProperties::PropertyType)(CSProperties::MATERIAL | CSProperties::METAL));
-			for (pos[2]=0; pos[2]<numLines[2]; ++pos[2])
+			for (pos[2]=start[2]; pos[2]<=stop[2]; ++pos[2])
 			{
+				const vector<CSPrimitives*>& vPrims = m_PECPrimIndex->GetPrimitives(pos);
 				for (int n=0; n<3; ++n)
 				{
 					GetYeeCoords(n,pos,coord,false);
-					CSProperties* prop = CSX->GetPropertyByCoordPriority(coord, vPrims, true);
+					CSProperties* prop = GetPropertyByCoordPriority(coord, vPrims, true);
 //					CSProperties* old_prop = CSX->GetPropertyByCoordPriority(coord, (CSProperties::PropertyType)(CSProperties::MATERIAL | CSProperties::METAL), true);
 //					if (old_prop!=prop)
 //					{
@@ -2002,9 +2753,22 @@ void Operator::CalcPEC_Range(unsigned int startX, unsigned int stopX, unsigned i
 void Operator::CalcPEC_Curves()
 {
 	//special treatment for primitives of type curve (treated as wires)
-	double p1[3];
-	double p2[3];
+	vector<CSPrimitives*> curves = GetPEC_Curves();
 	Grid_Path path;
+	for (size_t c=0; c<curves.size(); ++c)
+	{
+		path.dir.clear();
+		for (int n=0; n<3; ++n)
+			path.posPath[n].clear();
+		if (CalcPEC_CurvePath(curves.at(c), path))
+			curves.at(c)->SetPrimitiveUsed(true);
+		ApplyPEC_Path(path);
+	}
+}
+
+vector<CSPrimitives*> Operator::GetPEC_Curves() const
+{
+	vector<CSPrimitives*> curves;
 	vector<CSProperties*> vec_prop = CSX->GetPropertyByType(CSProperties::METAL);
 	for (size_t p=0; p<vec_prop.size(); ++p)
 	{
@@ -2012,26 +2776,45 @@ void Operator::CalcPEC_Curves()
 		for (size_t n=0; n<prop->GetQtyPrimitives(); ++n)
 		{
 			CSPrimitives* prim = prop->GetPrimitive(n);
-			CSPrimCurve* curv = prim->ToCurve();
-			if (curv)
-			{
-				for (size_t i=1; i<curv->GetNumberOfPoints(); ++i)
-				{
-					curv->GetPoint(i-1,p1,m_MeshType);
-					curv->GetPoint(i,p2,m_MeshType);
-					path = FindPath(p1,p2);
-					if (path.dir.size()>0)
-						prim->SetPrimitiveUsed(true);
-					for (size_t t=0; t<path.dir.size(); ++t)
-					{
-						SetVV(path.dir.at(t),path.posPath[0].at(t),path.posPath[1].at(t),path.posPath[2].at(t), 0 );
-						SetVI(path.dir.at(t),path.posPath[0].at(t),path.posPath[1].at(t),path.posPath[2].at(t), 0 );
-						++m_Nr_PEC[path.dir.at(t)];
-					}
-				}
-			}
+			if (prim->ToCurve())
+				curves.push_back(prim);
 		}
 	}
+	return curves;
+}
+
+bool Operator::CalcPEC_CurvePath(CSPrimitives* prim, Grid_Path &path)
+{
+	CSPrimCurve* curv = prim->ToCurve();
+	if (curv==NULL)
+		return false;
+	double p1[3];
+	double p2[3];
+	bool found = false;
+	Grid_Path segment;
+	for (size_t i=1; i<curv->GetNumberOfPoints(); ++i)
+	{
+		curv->GetPoint(i-1,p1,m_MeshType);
+		curv->GetPoint(i,p2,m_MeshType);
+		segment = FindPath(p1,p2);
+		if (segment.dir.size()==0)
+			continue;
+		found = true;
+		path.dir.insert(path.dir.end(), segment.dir.begin(), segment.dir.end());
+		for (int n=0; n<3; ++n)
+			path.posPath[n].insert(path.posPath[n].end(), segment.posPath[n].begin(), segment.posPath[n].end());
+	}
+	return found;
+}
+
+void Operator::ApplyPEC_Path(const Grid_Path &path)
+{
+	for (size_t t=0; t<path.dir.size(); ++t)
+	{
+		SetVV(path.dir.at(t),path.posPath[0].at(t),path.posPath[1].at(t),path.posPath[2].at(t), 0 );
+		SetVI(path.dir.at(t),path.posPath[0].at(t),path.posPath[1].at(t),path.posPath[2].at(t), 0 );
+		++m_Nr_PEC[path.dir.at(t)];
+	}
 }
 
 Operator_Ext_Excitation* Operator::GetExcitationExtension() const
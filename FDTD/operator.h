@@ -25,6 +25,7 @@
 
 class Operator_Extension;
 class Operator_Ext_Excitation;
+class Primitive_Index;
 class Engine;
 class TiXmlElement;
 
@@ -55,6 +56,11 @@ public:
 
 	virtual int CalcECOperator( DebugFlags debugFlags = None );
 
+	//! Set a file to cache the operator, an existing cache is reused if geometry, mesh and settings are unchanged (empty string disables the cache)
+	virtual void SetOperatorCacheFile(string file) {m_OpCacheFile=file;}
+	//! Add a box (drawing units) in which the geometry was changed, a cached operator for a different geometry is reused and recalculated inside all update boxes only \sa SetOperatorCacheFile
+	virtual void AddOperatorUpdateBox(const double start[3], const double stop[3]);
+
 	// the next four functions need to be reimplemented in a derived class
 	inline virtual FDTD_FLOAT GetVV( unsigned int n, unsigned int x, unsigned int y, unsigned int z ) const { return vv[n][x][y][z]; }
 	inline virtual FDTD_FLOAT GetVI( unsigned int n, unsigned int x, unsigned int y, unsigned int z ) const { return vi[n][x][y][z]; }
@@ -105,6 +111,15 @@ public:
 	virtual void ShowStat() const;
 	virtual void ShowExtStat() const;
 
+	//! Estimate the temporary memory (in bytes) of the equivalent circuit needed during the operator setup
+	virtual double EstimateSetupMemory() const;
+	//! Estimate the memory (in bytes) of the operator coefficients, with or without compression (if supported)
+	virtual double EstimateCoefficientMemory(bool compressed=true) const;
+	//! Estimate the memory (in bytes) of the voltages and currents of the engine created by this operator
+	virtual double EstimateFieldMemory() const;
+	//! Upper bound of the number of cells inside the primitives of the given property type (sum of their snapped bounding boxes)
+	double GetNumberCellsInBoundBox(CSProperties::PropertyType type) const;
+
 	virtual double GetGridDelta() const {return gridDelta;}
 
 	//! Get the disc line in \a n direction (in drawing units)
@@ -167,6 +182,13 @@ public:
 
 	virtual void CleanupMaterialStorage();
 
+	//! Limit the material storage of the given type to a region (inclusive mesh indices), multiple regions will store their union. Must be called before CalcECOperator.
+	virtual void AddMaterialStorageRegion(int type, const unsigned int start[3], const unsigned int stop[3]);
+	//! Check if material data of the given type is stored
+	bool HasMaterialStorage(int type) const {if ((type<0) || (type>3)) return false; return !m_MatStorage[type].empty();}
+	//! Get the memory needed to store the material data of the given type
+	double GetMaterialStorageSize(int type) const;
+
 	virtual double GetDiscMaterial(int type, int ny, const unsigned int pos[3]) const;
 
 	//! Get the cell center coordinate usable for material averaging (Warning, may not be the yee cell center)
@@ -195,15 +217,27 @@ protected:
 
 	virtual Grid_Path FindPath(double start[], double stop[]);
 
+	//! Called after each setup stage that may change single coefficients, all coefficients are final afterwards
+	virtual void FinalizeCoefficients() {}
+
 	// debug
 	virtual void DumpOperator2File(string filename);
 	virtual void DumpMaterial2File(string filename);
 	virtual void DumpPEC2File( string filename, unsigned int *range = NULL );
 
 	unsigned int m_Nr_PEC[3]; //count PEC edges
+	//! the PEC count was updated by UpdateOperatorBoxes and is only an estimate, see ShowStat
+	bool m_Nr_PEC_Estimated;
 	virtual bool CalcPEC();
 	virtual void CalcPEC_Range(unsigned int startX, unsigned int stopX, unsigned int* counter);	//internal to CalcPEC
+	void CalcPEC_Box(const unsigned int start[3], const unsigned int stop[3], unsigned int* counter);	//internal to CalcPEC
 	virtual void CalcPEC_Curves();	//internal to CalcPEC
+	//! Get all curve primitives of metal properties, these are treated as thin wires (internal to CalcPEC)
+	vector<CSPrimitives*> GetPEC_Curves() const;
+	//! Rasterize all segments of a curve primitive onto the mesh and append the edges to \p path, the operator is not changed (internal to CalcPEC)
+	bool CalcPEC_CurvePath(CSPrimitives* prim, Grid_Path &path);
+	//! Set all edges of the given path to PEC and count them (internal to CalcPEC)
+	void ApplyPEC_Path(const Grid_Path &path);
 
 	//Calc timestep only internal use
 	int m_TimeStepVar;
@@ -216,8 +250,25 @@ protected:
 	double CalcTimestep_Var1();
 	double CalcTimestep_Var3();
 
+	//! smallest timestep found by a (partial) timestep calculation
+	struct Timestep_Min
+	{
+		double dT;
+		unsigned int pos[3];
+		unsigned int n;
+	};
+	//! Calculate the smallest timestep of the given variant (1 or 3) for all x-lines in the given range, this method is thread-safe
+	void CalcTimestep_Range(int variant, unsigned int xStart, unsigned int xStop, Timestep_Min* result) const;
+	//! Calculate the smallest timestep of the given variant for all x-lines in the given range (internal to CalcTimestep_Range)
+	template <int variant>
+	void CalcTimestep_Kernel(unsigned int xStart, unsigned int xStop, Timestep_Min* result) const;
+	//! Calculate the smallest timestep of the given variant using GetNumberOfSetupThreads() threads, each working on a range of x-lines
+	Timestep_Min CalcTimestep_Parallel(int variant) const;
+	//! Number of threads used by the parallel parts of the operator setup outside of the worker stages
+	virtual unsigned int GetNumberOfSetupThreads() const {return 1;}
+
 	//! Calculate the FDTD equivalent circuit parameter for the given position and direction ny. \sa Calc_EffMat_Pos
-	virtual bool Calc_ECPos(int ny, const unsigned int* pos, double* EC, vector<CSPrimitives *> vPrims) const;
+	virtual bool Calc_ECPos(int ny, const unsigned int* pos, double* EC, const vector<CSPrimitives *> &vPrims) const;
 
 	//! Get the FDTD raw disc delta, needed by Calc_EffMatPos() \sa Calc_EffMatPos
 	/*!
@@ -228,18 +279,67 @@ protected:
 	virtual double GetRawDiscDelta(int ny, const int pos) const;
 
 	//! Get the material at a given coordinate, direction and type from CSX (internal use only)
-	virtual double GetMaterial(int ny, const double coords[3], int MatType, vector<CSPrimitives*> vPrims, bool markAsUsed=true) const;
+	virtual double GetMaterial(int ny, const double coords[3], int MatType, const vector<CSPrimitives*> &vPrims, bool markAsUsed=true) const;
+	//! Get all material properties (epsilon, kappa, mue, sigma) at a given coordinate and direction from CSX with a single property search (internal use only)
+	virtual void SampleMaterial(int ny, const double coords[3], double* mat, const vector<CSPrimitives*> &vPrims, bool markAsUsed=true) const;
+	//! Find the property with the highest priority at the given coordinate in the given primitive list, equivalent to ContinuousStructure::GetPropertyByCoordPriority without copying the list
+	CSProperties* GetPropertyByCoordPriority(const double* coords, const vector<CSPrimitives*> &vPrims, bool markAsUsed) const;
+	//! Get a material value of the given type (see GetMaterial) of a property, or the background material if \p mat is NULL
+	double GetMaterialValue(int ny, const double coords[3], int MatType, CSPropMaterial* mat) const;
 
 	MatAverageMethods m_MatAverageMethod;
 
+	//! Build the spatial primitive indices used during the operator setup. \sa Primitive_Index
+	virtual void InitPrimitiveIndex();
+	//! Delete the spatial primitive indices
+	void ClearPrimitiveIndex();
+	//! spatial index of all material primitives
+	Primitive_Index* m_MatPrimIndex;
+	//! spatial index of all material and metal primitives
+	Primitive_Index* m_PECPrimIndex;
+
 	//! Calculate the effective/averaged material properties at the given position and direction ny.
-	virtual bool Calc_EffMatPos(int ny, const unsigned int* pos, double* EffMat, vector<CSPrimitives*> vPrims) const;
+	virtual bool Calc_EffMatPos(int ny, const unsigned int* pos, double* EffMat, const vector<CSPrimitives*> &vPrims) const;
 
-	virtual bool AverageMatCellCenter(int ny, const unsigned int* pos, double* EffMat, vector<CSPrimitives*> vPrims) const;
-	virtual bool AverageMatQuarterCell(int ny, const unsigned int* pos, double* EffMat, vector<CSPrimitives*> vPrims) const;
+	virtual bool AverageMatCellCenter(int ny, const unsigned int* pos, double* EffMat, const vector<CSPrimitives*> &vPrims) const;
+	virtual bool AverageMatQuarterCell(int ny, const unsigned int* pos, double* EffMat, const vector<CSPrimitives*> &vPrims) const;
 
 	//! Calc operator at certain \a pos
 	virtual void Calc_ECOperatorPos(int n, unsigned int* pos);
+	//! Calc operator at certain \a pos for the given EC index, does not change the MainOp position
+	void Calc_ECOperatorAt(int n, const unsigned int* pos, unsigned int ecIndex);
+	//! Calc the operator coefficients (vv, vi, iv and ii) for the given EC index
+	void Calc_ECOperatorCoeff(int n, unsigned int ecIndex, FDTD_FLOAT coeff[4]) const;
+	//! Calc the operator coefficients from the EC elements
+	virtual bool Calc_ECOperator();
+	//! Calc the operator coefficients from the EC elements for the given x-range (internal to Calc_ECOperator)
+	virtual void Calc_ECOperator_Range(unsigned int xStart, unsigned int xStop);
+	//! Calc the operator coefficients from the EC elements inside the given box (inclusive start and stop index)
+	void Calc_ECOperator_Box(const unsigned int start[3], const unsigned int stop[3]);
+	//! Calc the operator coefficients inside all given boxes (start and stop index of each box), internal to UpdateOperatorBoxes
+	virtual void Calc_ECOperator_Boxes(const vector<unsigned int> &boxes);
+
+	//! Build all operator extensions, independent extensions are build concurrently \sa Operator_Extension::IsBuildParallelSave
+	virtual void BuildExtensions();
+
+	//! Operator cache file \sa SetOperatorCacheFile
+	string m_OpCacheFile;
+	//! Update boxes in drawing units (start and stop coordinates) \sa AddOperatorUpdateBox
+	vector<double> m_OpUpdateBoxes;
+	//! Get a key describing the mesh and all settings the cached operator depends on
+	virtual string GetOperatorCacheKey() const;
+	//! Get a key describing the geometry the cached operator depends on
+	virtual string GetGeometryCacheKey() const;
+	//! Write the operator (before building the extensions) to the cache file
+	virtual bool WriteOperatorCache(const string &key, const string &geoKey) const;
+	//! Restore the operator from the cache file, returns false if no cache matching the given keys (or update boxes for a changed geometry) was found
+	virtual bool ReadOperatorCache(const string &key, const string &geoKey);
+	//! Recalculate the operator inside all update boxes, returns false if the operator needs a complete recalculation (e.g. a smaller timestep)
+	virtual bool UpdateOperatorBoxes(bool forcedTimestep);
+	//! Write the operator coefficients to the cache, needs to be reimplemented by an operator with a different storage
+	virtual bool WriteCoefficientCache(ostream &file) const;
+	//! Read the operator coefficients from the cache \sa WriteCoefficientCache
+	virtual bool ReadCoefficientCache(istream &file);
 
 	//! Calculate and setup lumped elements
 	virtual bool Calc_LumpedElements();
@@ -247,16 +347,27 @@ protected:
 	//! Store the size of the applied boundary conditions
 	int m_BC_Size[6];
 
-	//store material properties for post-processing
-	float**** m_epsR;
-	float**** m_kappa;
-	float**** m_mueR;
-	float**** m_sigma;
+	//! material data (epsR, kappa, mueR or sigma) stored for post-processing inside a region of the mesh
+	struct MaterialStorage
+	{
+		unsigned int start[3];
+		unsigned int numLines[3];
+		float**** data;
+	};
+	//! stored material regions for each material type
+	vector<MaterialStorage> m_MatStorage[4];
+	//! requested storage regions for each material type (start and stop index), the full mesh is stored if no region was requested
+	vector<unsigned int> m_MatStorageRegions[4];
+	//! Store the effective material (epsR, kappa, mueR, sigma) in all storage regions containing the given position
+	void StoreMaterial(int ny, const unsigned int pos[3], const double* EffMat) const;
+	//! Delete all stored material data of the given type
+	void DeleteMaterialStorage(int type);
 
 	//EC elements, internal only!
 	virtual void Init_EC();
 	virtual bool Calc_EC();
 	virtual void Calc_EC_Range(unsigned int xStart, unsigned int xStop);
+	void Calc_EC_Box(const unsigned int start[3], const unsigned int stop[3]);
 	FDTD_FLOAT* EC_C[3];
 	FDTD_FLOAT* EC_G[3];
 	FDTD_FLOAT* EC_L[3];
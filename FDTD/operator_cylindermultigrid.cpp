@@ -17,6 +17,7 @@
 
 #include "operator_cylindermultigrid.h"
 #include "engine_cylindermultigrid.h"
+#include "primitive_index.h"
 #include "extensions/operator_ext_cylinder.h"
 #include "tools/useful.h"
 #include "CSUseful.h"
@@ -27,6 +28,7 @@ Operator_CylinderMultiGrid::Operator_CylinderMultiGrid(vector<double> Split_Radi
 	m_Split_Rad = m_Split_Radii.back();
 	m_Split_Radii.pop_back();
 	m_MultiGridLevel = level;
+	m_AlternateLevels = false;
 }
 
 Operator_CylinderMultiGrid::~Operator_CylinderMultiGrid()
@@ -51,7 +53,38 @@ Operator_CylinderMultiGrid* Operator_CylinderMultiGrid::New(vector<double> Split
 
 Engine* Operator_CylinderMultiGrid::CreateEngine()
 {
-	m_Engine = Engine_CylinderMultiGrid::New(this, m_orig_numThreads);
+	unsigned int numThreads = m_orig_numThreads;
+	if (numThreads==0)
+		numThreads = boost::thread::hardware_concurrency();
+	if (numThreads==0)
+		numThreads = 1;
+
+	unsigned int baseThreads = numThreads;
+	unsigned int childThreads = numThreads;
+	// a concurrent update needs at least one thread per grid, with a single thread both grids take turns
+	m_AlternateLevels = (numThreads<2);
+	if (m_AlternateLevels)
+	{
+		if (g_settings.GetVerboseLevel()>0)
+			cout << "Operator_CylinderMultiGrid::CreateEngine: Using " << numThreads << " thread for the base and child grid in turns (level " << m_MultiGridLevel << ")" << endl;
+	}
+	else
+	{
+		// the base and child grid are updated concurrently, distribute the threads proportional to their number of cells
+		double baseCells = (double)(numLines[0]-m_Split_Pos)*numLines[1]*numLines[2];
+		double childCells = m_InnerOp->GetNumberCells();
+		childThreads = (unsigned int)(numThreads*childCells/(baseCells+childCells) + 0.5);
+		if (childThreads>=numThreads)
+			childThreads = numThreads-1;
+		if (childThreads<1)
+			childThreads = 1;
+		baseThreads = numThreads-childThreads;
+		if (g_settings.GetVerboseLevel()>0)
+			cout << "Operator_CylinderMultiGrid::CreateEngine: Using " << baseThreads << " threads for the base grid and " << childThreads << " threads for the child grid (level " << m_MultiGridLevel << ")" << endl;
+	}
+
+	m_InnerOp->setNumThreads(childThreads);
+	m_Engine = Engine_CylinderMultiGrid::New(this, baseThreads);
 	return m_Engine;
 }
 
@@ -62,6 +95,16 @@ double Operator_CylinderMultiGrid::GetNumberCells() const
 	return 0;
 }
 
+double Operator_CylinderMultiGrid::EstimateCoefficientMemory(bool compressed) const
+{
+	return Operator_Cylinder::EstimateCoefficientMemory(compressed) + m_InnerOp->EstimateCoefficientMemory(compressed);
+}
+
+double Operator_CylinderMultiGrid::EstimateFieldMemory() const
+{
+	return Operator_Cylinder::EstimateFieldMemory() + m_InnerOp->EstimateFieldMemory();
+}
+
 bool Operator_CylinderMultiGrid::SetupCSXGrid(CSRectGrid* grid)
 {
 	if (Operator_Cylinder::SetupCSXGrid(grid)==false)
@@ -213,25 +256,19 @@ void Operator_CylinderMultiGrid::FillMissingDataStorage()
 {
 	unsigned int pos[3];
 	double EffMat[4];
+	if (m_MatPrimIndex==NULL)
+		InitPrimitiveIndex();
 	for (int ny=0; ny<3; ++ny)
 	{
 		for (pos[0]=0; pos[0]<m_Split_Pos-1; ++pos[0])
 		{
 			for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
 			{
-				vector<CSPrimitives*> vPrims = this->GetPrimitivesBoundBox(pos[0], pos[1], -1, CSProperties::MATERIAL);
 				for (pos[2]=0; pos[2]<numLines[2]; ++pos[2])
 				{
-					Calc_EffMatPos(ny,pos,EffMat,vPrims);
-
-					if (m_epsR)
-						m_epsR[ny][pos[0]][pos[1]][pos[2]] =  EffMat[0];
-					if (m_kappa)
-						m_kappa[ny][pos[0]][pos[1]][pos[2]] =  EffMat[1];
-					if (m_mueR)
-						m_mueR[ny][pos[0]][pos[1]][pos[2]] =  EffMat[2];
-					if (m_sigma)
-						m_sigma[ny][pos[0]][pos[1]][pos[2]] =  EffMat[3];
+					Calc_EffMatPos(ny,pos,EffMat,m_MatPrimIndex->GetPrimitives(pos));
+
+					StoreMaterial(ny,pos,EffMat);
 				}
 			}
 		}
@@ -489,6 +526,21 @@ void Operator_CylinderMultiGrid::SetExcitationSignal(Excitation* exc)
 	Operator_Cylinder::SetExcitationSignal(exc);
 }
 
+void Operator_CylinderMultiGrid::SetOperatorCacheFile(string file)
+{
+	if (file.empty())
+		m_InnerOp->SetOperatorCacheFile(file);
+	else
+		m_InnerOp->SetOperatorCacheFile(file + "_S" + ConvertInt(m_MultiGridLevel+1));
+	Operator_Cylinder::SetOperatorCacheFile(file);
+}
+
+void Operator_CylinderMultiGrid::AddOperatorUpdateBox(const double start[3], const double stop[3])
+{
+	m_InnerOp->AddOperatorUpdateBox(start, stop);
+	Operator_Cylinder::AddOperatorUpdateBox(start, stop);
+}
+
 void Operator_CylinderMultiGrid::Delete()
 {
 	delete m_InnerOp;
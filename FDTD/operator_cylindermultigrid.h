@@ -37,6 +37,9 @@ public:
 
 	virtual double GetNumberCells() const;
 
+	virtual double EstimateCoefficientMemory(bool compressed=true) const;
+	virtual double EstimateFieldMemory() const;
+
 	virtual Engine* CreateEngine();
 
 	virtual bool SetGeometryCSX(ContinuousStructure* geo);
@@ -55,8 +58,15 @@ public:
 
 	Operator_Cylinder* GetInnerOperator() const {return m_InnerOp;}
 
+	//! The base and child grid take turns using all threads instead of updating concurrently, set by CreateEngine for less than two threads
+	bool AlternateLevels() const {return m_AlternateLevels;}
+
 	virtual void SetExcitationSignal(Excitation* exc);
 
+	//! Set the operator cache file, the inner operators use the same file name with the suffix "_S<level>"
+	virtual void SetOperatorCacheFile(string file);
+	virtual void AddOperatorUpdateBox(const double start[3], const double stop[3]);
+
 	virtual void ShowStat() const;
 
 	//! Get the cell center coordinate usable for material averaging (Warning, may not be the yee cell center)
@@ -87,6 +97,7 @@ protected:
 	double m_Split_Rad;
 	vector<double> m_Split_Radii;
 	unsigned int m_Split_Pos;
+	bool m_AlternateLevels;
 
 	Operator_Cylinder* m_InnerOp;
 
@@ -183,6 +183,41 @@ void Operator_MPI::AddExtension(Operator_Extension* op_ext)
 }
 
 
+void Operator_MPI::SetOperatorCacheFile(string file)
+{
+	stringstream out_name;
+	out_name << file;
+	if (m_MPI_Enabled && !file.empty())
+		out_name << "_ID" << m_MyID;
+	Operator_SSE_Compressed::SetOperatorCacheFile(out_name.str());
+}
+
+void Operator_MPI::AddOperatorUpdateBox(const double start[3], const double stop[3])
+{
+	if (m_MPI_Enabled)
+	{
+		cerr << "Operator_MPI::AddOperatorUpdateBox: Warning, operator updates are not supported with MPI, ignoring!" << endl;
+		return;
+	}
+	Operator_SSE_Compressed::AddOperatorUpdateBox(start, stop);
+}
+
+bool Operator_MPI::ReadOperatorCache(const string &key, const string &geoKey)
+{
+	double preset_dT = dT;
+	bool ok = Operator_SSE_Compressed::ReadOperatorCache(key, geoKey);
+	if (!m_MPI_Enabled)
+		return ok;
+
+	// all ranks have to restore their operator, otherwise all of them have to recalculate it
+	int local_ok = ok;
+	int all_ok = 0;
+	MPI_Allreduce(&local_ok, &all_ok, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+	if (ok && !all_ok)
+		dT = preset_dT;
+	return all_ok;
+}
+
 string Operator_MPI::PrependRank(string name)
 {
 	stringstream out_name;
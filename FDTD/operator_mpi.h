@@ -54,6 +54,11 @@ public:
 
 	virtual void AddExtension(Operator_Extension* op_ext);
 
+	//! Set the operator cache file, the MPI rank is appended to the file name
+	virtual void SetOperatorCacheFile(string file);
+	//! Operator updates are not supported with MPI
+	virtual void AddOperatorUpdateBox(const double start[3], const double stop[3]);
+
 protected:
 	Operator_MPI();
 	bool m_MPI_Enabled;
@@ -63,6 +68,8 @@ protected:
 
 	virtual double CalcTimestep();
 
+	virtual bool ReadOperatorCache(const string &key, const string &geoKey);
+
 	unsigned int m_MyID;
 	unsigned int m_NumProc;
 	int m_MyTag;
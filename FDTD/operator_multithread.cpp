@@ -50,8 +50,14 @@ Operator_Multithread::Operator_Multithread() : OPERATOR_MULTITHREAD_BASE()
 	m_CalcEC_Start=NULL;
 	m_CalcEC_Stop=NULL;
 
+	m_CalcOp_Start=NULL;
+	m_CalcOp_Stop=NULL;
+
 	m_CalcPEC_Start=NULL;
 	m_CalcPEC_Stop=NULL;
+
+	m_CacheRestored=false;
+	m_UpdateBoxes=NULL;
 }
 
 void Operator_Multithread::Init()
@@ -61,8 +67,14 @@ void Operator_Multithread::Init()
 	m_CalcEC_Start=NULL;
 	m_CalcEC_Stop=NULL;
 
+	m_CalcOp_Start=NULL;
+	m_CalcOp_Stop=NULL;
+
 	m_CalcPEC_Start=NULL;
 	m_CalcPEC_Stop=NULL;
+
+	m_CacheRestored=false;
+	m_UpdateBoxes=NULL;
 }
 
 void Operator_Multithread::Delete()
@@ -74,6 +86,11 @@ void Operator_Multithread::Delete()
 	delete m_CalcEC_Stop;
 	m_CalcEC_Stop=NULL;
 
+	delete m_CalcOp_Start;
+	m_CalcOp_Start=NULL;
+	delete m_CalcOp_Stop;
+	m_CalcOp_Stop=NULL;
+
 	delete m_CalcPEC_Start;
 	m_CalcPEC_Start=NULL;
 	delete m_CalcPEC_Stop;
@@ -123,6 +140,11 @@ int Operator_Multithread::CalcECOperator( DebugFlags debugFlags )
 	delete m_CalcEC_Stop;
 	m_CalcEC_Stop = new boost::barrier(m_numThreads+1); // numThread workers + 1 controller
 
+	delete m_CalcOp_Start;
+	m_CalcOp_Start = new boost::barrier(m_numThreads+1); // numThread workers + 1 controller
+	delete m_CalcOp_Stop;
+	m_CalcOp_Stop = new boost::barrier(m_numThreads+1); // numThread workers + 1 controller
+
 	delete m_CalcPEC_Start;
 	m_CalcPEC_Start = new boost::barrier(m_numThreads+1); // numThread workers + 1 controller
 	delete m_CalcPEC_Stop;
@@ -137,6 +159,25 @@ int Operator_Multithread::CalcECOperator( DebugFlags debugFlags )
 	return OPERATOR_MULTITHREAD_BASE::CalcECOperator( debugFlags );
 }
 
+bool Operator_Multithread::ReadOperatorCache(const string &key, const string &geoKey)
+{
+	m_CacheRestored = OPERATOR_MULTITHREAD_BASE::ReadOperatorCache(key, geoKey);
+	if (m_CacheRestored)
+		m_CalcEC_Start->wait(); // release the waiting worker threads, there is nothing to calculate
+	return m_CacheRestored;
+}
+
+void Operator_Multithread::Calc_ECOperator_Boxes(const vector<unsigned int> &boxes)
+{
+	MainOp->SetPos(0,0,0);
+
+	m_UpdateBoxes = &boxes;
+	m_CalcEC_Start->wait();
+
+	m_CalcEC_Stop->wait();
+	m_UpdateBoxes = NULL;
+}
+
 bool Operator_Multithread::Calc_EC()
 {
 	if (CSX==NULL)
@@ -154,6 +195,17 @@ bool Operator_Multithread::Calc_EC()
 	return true;
 }
 
+bool Operator_Multithread::Calc_ECOperator()
+{
+	MainOp->SetPos(0,0,0);
+
+	m_CalcOp_Start->wait();
+
+	m_CalcOp_Stop->wait();
+
+	return true;
+}
+
 bool Operator_Multithread::CalcPEC()
 {
 	m_Nr_PEC[0]=0;
@@ -162,6 +214,12 @@ bool Operator_Multithread::CalcPEC()
 
 	m_Nr_PEC_thread = new unsigned int[m_numThreads][3];
 
+	// the worker threads rasterize the curves into separate paths, these are applied to the operator afterwards without any locking
+	m_PEC_Curves = GetPEC_Curves();
+	m_PEC_CurvePaths.clear();
+	m_PEC_CurvePaths.resize(m_PEC_Curves.size());
+	m_PEC_CurveUsed.assign(m_PEC_Curves.size(), 0);
+
 	m_CalcPEC_Start->wait();
 
 	m_CalcPEC_Stop->wait();
@@ -170,13 +228,28 @@ bool Operator_Multithread::CalcPEC()
 		for (int n=0; n<3; ++n)
 			m_Nr_PEC[n]+=m_Nr_PEC_thread[t][n];
 
-	CalcPEC_Curves();
+	// merge the curve paths in their original order, the result is identical to the serial CalcPEC_Curves
+	for (size_t c=0; c<m_PEC_Curves.size(); ++c)
+	{
+		if (m_PEC_CurveUsed.at(c))
+			m_PEC_Curves.at(c)->SetPrimitiveUsed(true);
+		ApplyPEC_Path(m_PEC_CurvePaths.at(c));
+	}
+	m_PEC_Curves.clear();
+	m_PEC_CurvePaths.clear();
+	m_PEC_CurveUsed.clear();
 
 	delete[] m_Nr_PEC_thread;
 
 	return true;
 }
 
+void Operator_Multithread::CalcPEC_CurvesThread(unsigned int threadID)
+{
+	// interleave the curves between the threads, neighboring curves often have a similar complexity
+	for (size_t c=threadID; c<m_PEC_Curves.size(); c+=m_numThreads)
+		m_PEC_CurveUsed.at(c) = CalcPEC_CurvePath(m_PEC_Curves.at(c), m_PEC_CurvePaths.at(c));
+}
 
 Operator_Thread::Operator_Thread( Operator_Multithread* ptr, unsigned int start, unsigned int stop, unsigned int threadID )
 {
@@ -190,15 +263,37 @@ void Operator_Thread::operator()()
 {
 	//************** calculate EC (Calc_EC) ***********************//
 	m_OpPtr->m_CalcEC_Start->wait();
+	// an operator update of a restored cache, every thread calculates its own lines of all boxes (Calc_ECOperator_Boxes)
+	while (m_OpPtr->m_UpdateBoxes)
+	{
+		const vector<unsigned int> &boxes = *m_OpPtr->m_UpdateBoxes;
+		for (size_t b=0; b<boxes.size(); b+=6)
+		{
+			unsigned int start[3] = {max(boxes.at(b),m_start), boxes.at(b+1), boxes.at(b+2)};
+			unsigned int stop[3] = {min(boxes.at(b+3),m_stop), boxes.at(b+4), boxes.at(b+5)};
+			if (start[0]<=stop[0])
+				m_OpPtr->Calc_ECOperator_Box(start, stop);
+		}
+		m_OpPtr->m_CalcEC_Stop->wait();
+		m_OpPtr->m_CalcEC_Start->wait();
+	}
+	if (m_OpPtr->m_CacheRestored)
+		return; // operator was restored from the cache
 	m_OpPtr->Calc_EC_Range(m_start,m_stop);
 	m_OpPtr->m_CalcEC_Stop->wait();
 
-	//************** calculate EC (Calc_EC) ***********************//
+	//************** calculate operator (Calc_ECOperator) ***********************//
+	m_OpPtr->m_CalcOp_Start->wait();
+	m_OpPtr->Calc_ECOperator_Range(m_start,m_stop);
+	m_OpPtr->m_CalcOp_Stop->wait();
+
+	//************** calculate PEC (CalcPEC) ***********************//
 	m_OpPtr->m_CalcPEC_Start->wait();
 	for (int n=0; n<3; ++n)
 		m_OpPtr->m_Nr_PEC_thread[m_threadID][n] = 0;
 
 	m_OpPtr->CalcPEC_Range(m_start,m_stop,m_OpPtr->m_Nr_PEC_thread[m_threadID]);
+	m_OpPtr->CalcPEC_CurvesThread(m_threadID);
 	m_OpPtr->m_CalcPEC_Stop->wait();
 }
 
@@ -50,14 +50,39 @@ protected:
 
 	virtual bool Calc_EC(); //this method is using multi-threading
 
+	virtual bool Calc_ECOperator(); //this method is using multi-threading
+
 	unsigned int (*m_Nr_PEC_thread)[3]; //count PEC edges per thread
 	virtual bool CalcPEC(); //this method is using multi-threading
 
+	virtual unsigned int GetNumberOfSetupThreads() const {return m_numThreads;}
+
+	//! metal curve primitives, rasterized by the worker threads during CalcPEC
+	vector<CSPrimitives*> m_PEC_Curves;
+	//! rasterized path of each curve in m_PEC_Curves, every curve is written by a single thread only
+	vector<Grid_Path> m_PEC_CurvePaths;
+	//! curve was found on the mesh (char instead of bool to allow concurrent writes to different curves)
+	vector<char> m_PEC_CurveUsed;
+	//! Rasterize every numThreads-th curve starting with the given thread id (internal to CalcPEC)
+	void CalcPEC_CurvesThread(unsigned int threadID);
+
 	virtual int CalcECOperator( DebugFlags debugFlags = None );
 
+	virtual bool ReadOperatorCache(const string &key, const string &geoKey);
+	//! operator was restored from the cache, the worker threads have nothing to calculate
+	bool m_CacheRestored;
+
+	//! The worker threads calculate their lines of all boxes while waiting for Calc_EC (the operator update happens while the cache is read)
+	virtual void Calc_ECOperator_Boxes(const vector<unsigned int> &boxes);
+	//! boxes of the running operator update, NULL otherwise
+	const vector<unsigned int>* m_UpdateBoxes;
+
 	//Calc_EC barrier
 	boost::barrier* m_CalcEC_Start;
 	boost::barrier* m_CalcEC_Stop;
+	//Calc_ECOperator barrier
+	boost::barrier* m_CalcOp_Start;
+	boost::barrier* m_CalcOp_Stop;
 	//CalcPEC barrier
 	boost::barrier* m_CalcPEC_Start;
 	boost::barrier* m_CalcPEC_Stop;
@@ -48,6 +48,18 @@ Engine* Operator_sse::CreateEngine()
 	return m_Engine;
 }
 
+double Operator_sse::EstimateCoefficientMemory(bool compressed) const
+{
+	UNUSED(compressed);
+	// vv, vi, iv and ii, the z-direction is padded to a multiple of four
+	return 4.0*3.0*numLines[0]*numLines[1]*ceil((double)numLines[2]/4.0)*sizeof(f4vector);
+}
+
+double Operator_sse::EstimateFieldMemory() const
+{
+	return 2.0*3.0*numLines[0]*numLines[1]*ceil((double)numLines[2]/4.0)*sizeof(f4vector);
+}
+
 void Operator_sse::Init()
 {
 	Operator::Init();
@@ -89,3 +101,19 @@ void Operator_sse::InitOperator()
 
 	numVectors =  ceil((double)numLines[2]/4.0);
 }
+
+bool Operator_sse::WriteCoefficientCache(ostream &file) const
+{
+	Write_N_3DArray2Stream(file, f4_vv, numLines, numVectors);
+	Write_N_3DArray2Stream(file, f4_vi, numLines, numVectors);
+	Write_N_3DArray2Stream(file, f4_iv, numLines, numVectors);
+	return Write_N_3DArray2Stream(file, f4_ii, numLines, numVectors);
+}
+
+bool Operator_sse::ReadCoefficientCache(istream &file)
+{
+	Read_N_3DArrayFromStream(file, f4_vv, numLines, numVectors);
+	Read_N_3DArrayFromStream(file, f4_vi, numLines, numVectors);
+	Read_N_3DArrayFromStream(file, f4_iv, numLines, numVectors);
+	return Read_N_3DArrayFromStream(file, f4_ii, numLines, numVectors);
+}
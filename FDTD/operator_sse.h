@@ -31,6 +31,9 @@ public:
 
 	virtual Engine* CreateEngine();
 
+	virtual double EstimateCoefficientMemory(bool compressed=true) const;
+	virtual double EstimateFieldMemory() const;
+
 	inline virtual FDTD_FLOAT GetVV( unsigned int n, unsigned int x, unsigned int y, unsigned int z ) const { return f4_vv[n][x][y][z%numVectors].f[z/numVectors]; }
 	inline virtual FDTD_FLOAT GetVI( unsigned int n, unsigned int x, unsigned int y, unsigned int z ) const { return f4_vi[n][x][y][z%numVectors].f[z/numVectors]; }
 	inline virtual FDTD_FLOAT GetII( unsigned int n, unsigned int x, unsigned int y, unsigned int z ) const { return f4_ii[n][x][y][z%numVectors].f[z/numVectors]; }
@@ -50,6 +53,9 @@ protected:
 	virtual void Reset();
 	virtual void InitOperator();
 
+	virtual bool WriteCoefficientCache(ostream &file) const;
+	virtual bool ReadCoefficientCache(istream &file);
+
 	unsigned int numVectors;
 
 	// engine/post-proc needs access
@@ -20,8 +20,8 @@
 #include "engine_sse.h"
 #include "tools/array_ops.h"
 
-#include <map>
 #include <cstring>
+#include <stdint.h>
 
 Operator_SSE_Compressed* Operator_SSE_Compressed::New()
 {
@@ -52,11 +52,17 @@ Engine* Operator_SSE_Compressed::CreateEngine()
 	return m_Engine;
 }
 
+double Operator_SSE_Compressed::EstimateCoefficientMemory(bool compressed) const
+{
+	if (!compressed)
+		return Operator_sse::EstimateCoefficientMemory(false);
+	return numLines[0]*numLines[1]*ceil((double)numLines[2]/4.0)*sizeof(unsigned int);
+}
+
 int Operator_SSE_Compressed::CalcECOperator( DebugFlags debugFlags )
 {
 	int ErrCode = Operator_sse::CalcECOperator( debugFlags );
-	m_Use_Compression = false;
-	m_Use_Compression = CompressOperator();
+	CompressOperator();
 
 	return ErrCode;
 }
@@ -84,6 +90,9 @@ void Operator_SSE_Compressed::Delete()
 		f4_iv_Compressed[n].clear();
 		f4_ii_Compressed[n].clear();
 	}
+	m_Coeff_Flags.clear();
+	m_CoeffMap.clear();
+	m_PendingCoeff.clear();
 }
 
 void Operator_SSE_Compressed::Reset()
@@ -95,17 +104,17 @@ void Operator_SSE_Compressed::Reset()
 void Operator_SSE_Compressed::InitOperator()
 {
 	//cleanup compression
-	m_Use_Compression = false;
-	for (int n=0; n<3; n++)
-	{
-		f4_vv_Compressed[n].clear();
-		f4_vi_Compressed[n].clear();
-		f4_iv_Compressed[n].clear();
-		f4_ii_Compressed[n].clear();
-	}
+	Delete();
+
+	// the uncompressed operator is never created, all coefficients are stored in the compressed table right away
+	numVectors =  ceil((double)numLines[2]/4.0);
+	unsigned int indexLines[3] = {numLines[0], numLines[1], numVectors};
+	m_Op_index = Create3DArray<unsigned int>( indexLines );
 
-	Operator_sse::InitOperator();
-	m_Op_index = Create3DArray<unsigned int>( numLines );
+	// all cells start with the all-zero coefficient set at index 0
+	InsertCompressedCoeff(SSE_coeff());
+	m_PendingCoeff.resize(numLines[0]);
+	m_Use_Compression = true;
 }
 
 void Operator_SSE_Compressed::ShowStat() const
@@ -119,67 +128,258 @@ void Operator_SSE_Compressed::ShowStat() const
 
 bool Operator_SSE_Compressed::CompressOperator()
 {
-	if (g_settings.GetVerboseLevel()>0)
-		cout << "Compressing the FDTD operator... this may take a while..." << endl;
+	if (!m_Use_Compression || (m_Op_index==NULL))
+		return false;
 
-	map<SSE_coeff,unsigned int> lookUpMap;
+	FinalizeCoefficients();
 
+	// the changes of single coefficients (PEC, boundary conditions, extensions) leave unused coefficient sets behind
+	unsigned int unused = (unsigned int)-1;
+	vector<unsigned int> newIndex(f4_vv_Compressed[0].size(), unused);
+	unsigned int numUsed = 0;
 	unsigned int pos[3];
 	for (pos[0]=0; pos[0]<numLines[0]; ++pos[0])
+		for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
+			for (pos[2]=0; pos[2]<numVectors; ++pos[2])
+			{
+				unsigned int &index = m_Op_index[pos[0]][pos[1]][pos[2]];
+				if (newIndex.at(index)==unused)
+					newIndex.at(index) = numUsed++;
+				index = newIndex.at(index);
+			}
+
+	if (g_settings.GetVerboseLevel()>0)
+		cout << "Operator_SSE_Compressed::CompressOperator: Removing " << newIndex.size()-numUsed << " unused of " << newIndex.size() << " coefficient sets" << endl;
+
+	vector<f4vector,aligned_allocator<f4vector> >* tables[4] = {f4_vv_Compressed, f4_vi_Compressed, f4_iv_Compressed, f4_ii_Compressed};
+	for (int type=0; type<4; ++type)
+		for (int n=0; n<3; n++)
+		{
+			vector<f4vector,aligned_allocator<f4vector> > table(numUsed);
+			for (size_t i=0; i<newIndex.size(); ++i)
+				if (newIndex.at(i)!=unused)
+					table.at(newIndex.at(i)) = tables[type][n].at(i);
+			tables[type][n].swap(table);
+		}
+
+	vector<unsigned char> flags(numUsed);
+	for (size_t i=0; i<newIndex.size(); ++i)
+		if (newIndex.at(i)!=unused)
+			flags.at(newIndex.at(i)) = m_Coeff_Flags.at(i);
+	m_Coeff_Flags.swap(flags);
+
+	m_CoeffMap.clear();
+	for (unsigned int i=0; i<numUsed; ++i)
+		m_CoeffMap[GetCompressedCoeff(i)] = i;
+
+	return true;
+}
+
+void Operator_SSE_Compressed::Calc_ECOperator_Range(unsigned int xStart, unsigned int xStop)
+{
+	if (!m_Use_Compression)
+		return Operator_sse::Calc_ECOperator_Range(xStart, xStop);
+
+	// a slab (constant x) is deduplicated locally first, only its few unique coefficient sets are merged into the shared table
+	CoeffMap slabMap;
+	vector<SSE_coeff> slabCoeff;
+	vector<unsigned int> slabIndex(numLines[1]*numVectors);
+	vector<unsigned int> tableIndex;
+	FDTD_FLOAT coeff[4];
+	unsigned int pos[3];
+	for (pos[0]=xStart; pos[0]<=xStop; ++pos[0])
 	{
+		slabMap.clear();
+		slabCoeff.clear();
 		for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
 		{
-			for (pos[2]=0; pos[2]<numVectors; ++pos[2])
+			for (unsigned int v=0; v<numVectors; ++v)
 			{
-				f4vector vv[3] = { f4_vv[0][pos[0]][pos[1]][pos[2]], f4_vv[1][pos[0]][pos[1]][pos[2]], f4_vv[2][pos[0]][pos[1]][pos[2]] };
-				f4vector vi[3] = { f4_vi[0][pos[0]][pos[1]][pos[2]], f4_vi[1][pos[0]][pos[1]][pos[2]], f4_vi[2][pos[0]][pos[1]][pos[2]] };
-				f4vector iv[3] = { f4_iv[0][pos[0]][pos[1]][pos[2]], f4_iv[1][pos[0]][pos[1]][pos[2]], f4_iv[2][pos[0]][pos[1]][pos[2]] };
-				f4vector ii[3] = { f4_ii[0][pos[0]][pos[1]][pos[2]], f4_ii[1][pos[0]][pos[1]][pos[2]], f4_ii[2][pos[0]][pos[1]][pos[2]] };
-				SSE_coeff c( vv, vi, iv, ii );
-
-				map<SSE_coeff,unsigned int>::iterator it;
-				it = lookUpMap.find(c);
-				if (it == lookUpMap.end())
+				SSE_coeff c;
+				// unused lanes of the last vector remain zero
+				for (unsigned int lane=0; (lane<4) && (lane*numVectors+v<numLines[2]); ++lane)
 				{
-					// not found -> insert
-					unsigned int index = f4_vv_Compressed[0].size();
-					for (int n=0; n<3; n++)
+					pos[2] = lane*numVectors+v;
+					// MainOp is set to the origin, the relative access is thread safe
+					unsigned int ecIndex = MainOp->GetPos(pos[0],pos[1],pos[2]);
+					for (int n=0; n<3; ++n)
 					{
-						f4_vv_Compressed[n].push_back( vv[n] );
-						f4_vi_Compressed[n].push_back( vi[n] );
-						f4_iv_Compressed[n].push_back( iv[n] );
-						f4_ii_Compressed[n].push_back( ii[n] );
+						Calc_ECOperatorCoeff(n, ecIndex, coeff);
+						for (int type=0; type<4; ++type)
+							c.GetCoeff(type)[n].f[lane] = coeff[type];
 					}
-					lookUpMap[c] = index;
-					m_Op_index[pos[0]][pos[1]][pos[2]] = index;
-				}
-				else
-				{
-					// this operator is already in the list
-					unsigned int index = (*it).second;
-					m_Op_index[pos[0]][pos[1]][pos[2]] = index;
 				}
+				pair<CoeffMap::iterator,bool> it = slabMap.insert(CoeffMap::value_type(c, slabCoeff.size()));
+				if (it.second)
+					slabCoeff.push_back(c);
+				slabIndex.at(pos[1]*numVectors+v) = it.first->second;
 			}
 		}
+
+		tableIndex.resize(slabCoeff.size());
+		{
+			boost::mutex::scoped_lock lock(m_CompressMutex);
+			for (size_t i=0; i<slabCoeff.size(); ++i)
+				tableIndex.at(i) = InsertCompressedCoeff(slabCoeff.at(i));
+		}
+
+		for (pos[1]=0; pos[1]<numLines[1]; ++pos[1])
+			for (unsigned int v=0; v<numVectors; ++v)
+				m_Op_index[pos[0]][pos[1]][v] = tableIndex.at(slabIndex.at(pos[1]*numVectors+v));
 	}
+}
 
-	Delete_N_3DArray_v4sf(f4_vv,numLines);
-	Delete_N_3DArray_v4sf(f4_vi,numLines);
-	Delete_N_3DArray_v4sf(f4_iv,numLines);
-	Delete_N_3DArray_v4sf(f4_ii,numLines);
-	f4_vv = 0;
-	f4_vi = 0;
-	f4_iv = 0;
-	f4_ii = 0;
+SSE_coeff Operator_SSE_Compressed::GetCompressedCoeff(unsigned int index) const
+{
+	f4vector vv[3] = { f4_vv_Compressed[0][index], f4_vv_Compressed[1][index], f4_vv_Compressed[2][index] };
+	f4vector vi[3] = { f4_vi_Compressed[0][index], f4_vi_Compressed[1][index], f4_vi_Compressed[2][index] };
+	f4vector iv[3] = { f4_iv_Compressed[0][index], f4_iv_Compressed[1][index], f4_iv_Compressed[2][index] };
+	f4vector ii[3] = { f4_ii_Compressed[0][index], f4_ii_Compressed[1][index], f4_ii_Compressed[2][index] };
+	SSE_coeff coeff( vv, vi, iv, ii );
+	coeff.SetFlags(m_Coeff_Flags[index]);
+	return coeff;
+}
 
-	return true;
+unsigned int Operator_SSE_Compressed::InsertCompressedCoeff(const SSE_coeff& coeff)
+{
+	pair<CoeffMap::iterator,bool> it = m_CoeffMap.insert(CoeffMap::value_type(coeff, f4_vv_Compressed[0].size()));
+	if (it.second)
+	{
+		// not found -> insert
+		for (int n=0; n<3; n++)
+		{
+			f4_vv_Compressed[n].push_back( coeff.GetCoeff(0)[n] );
+			f4_vi_Compressed[n].push_back( coeff.GetCoeff(1)[n] );
+			f4_iv_Compressed[n].push_back( coeff.GetCoeff(2)[n] );
+			f4_ii_Compressed[n].push_back( coeff.GetCoeff(3)[n] );
+		}
+		m_Coeff_Flags.push_back( coeff.GetFlags() );
+	}
+	return it.first->second;
+}
+
+SSE_coeff& Operator_SSE_Compressed::GetPendingCoeff(unsigned int x, unsigned int &index)
+{
+	if ((index & COEFF_PENDING)==0)
+	{
+		m_PendingCoeff[x].push_back(GetCompressedCoeff(index));
+		index = COEFF_PENDING | (m_PendingCoeff[x].size()-1);
+	}
+	return m_PendingCoeff[x][index & ~COEFF_PENDING];
 }
 
+void Operator_SSE_Compressed::SetCompressedValue(int type, unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value)
+{
+	SSE_coeff& c = GetPendingCoeff(x, m_Op_index[x][y][z%numVectors]);
+	c.GetCoeff(type)[n].f[z/numVectors] = value;
+}
+
+void Operator_SSE_Compressed::AddCoeffFlags(unsigned int x, unsigned int y, unsigned int vec, unsigned char flags)
+{
+	unsigned int &index = m_Op_index[x][y][vec];
+	if (((index & COEFF_PENDING)==0) && ((m_Coeff_Flags[index] & flags) == flags))
+		return;
+	SSE_coeff& c = GetPendingCoeff(x, index);
+	c.SetFlags(c.GetFlags() | flags);
+}
+
+void Operator_SSE_Compressed::FinalizeCoefficients()
+{
+	if (!m_Use_Compression || (m_Op_index==NULL))
+		return;
+
+	for (unsigned int x=0; x<m_PendingCoeff.size(); ++x)
+	{
+		if (m_PendingCoeff[x].empty())
+			continue;
+		for (unsigned int y=0; y<numLines[1]; ++y)
+			for (unsigned int v=0; v<numVectors; ++v)
+			{
+				unsigned int &index = m_Op_index[x][y][v];
+				if (index & COEFF_PENDING)
+					index = InsertCompressedCoeff(m_PendingCoeff[x][index & ~COEFF_PENDING]);
+			}
+		m_PendingCoeff[x].clear();
+	}
+}
+
+bool Operator_SSE_Compressed::WriteCoefficientCache(ostream &file) const
+{
+	if (!m_Use_Compression)
+		return Operator_sse::WriteCoefficientCache(file);
+
+	uint64_t size = f4_vv_Compressed[0].size();
+	file.write((const char*)&size, sizeof(size));
+	const vector<f4vector,aligned_allocator<f4vector> >* tables[4] = {f4_vv_Compressed, f4_vi_Compressed, f4_iv_Compressed, f4_ii_Compressed};
+	for (int type=0; type<4; ++type)
+		for (int n=0; n<3; n++)
+			file.write((const char*)&tables[type][n][0], sizeof(f4vector)*size);
+
+	for (unsigned int x=0; x<numLines[0]; ++x)
+		for (unsigned int y=0; y<numLines[1]; ++y)
+			file.write((const char*)m_Op_index[x][y], sizeof(unsigned int)*numVectors);
+	return file.good();
+}
+
+bool Operator_SSE_Compressed::ReadCoefficientCache(istream &file)
+{
+	if (!m_Use_Compression)
+		return Operator_sse::ReadCoefficientCache(file);
+
+	uint64_t size = 0;
+	file.read((char*)&size, sizeof(size));
+	if (!file.good() || (size==0) || (size>(uint64_t)numLines[0]*numLines[1]*numVectors))
+	{
+		file.setstate(ios::failbit);
+		return false;
+	}
+
+	vector<f4vector,aligned_allocator<f4vector> >* tables[4] = {f4_vv_Compressed, f4_vi_Compressed, f4_iv_Compressed, f4_ii_Compressed};
+	for (int type=0; type<4; ++type)
+		for (int n=0; n<3; n++)
+		{
+			tables[type][n].resize(size);
+			file.read((char*)&tables[type][n][0], sizeof(f4vector)*size);
+		}
+	// the flags are not cached, they are only set by the extensions after the cache was written
+	m_Coeff_Flags.assign(size, 0);
 
+	for (unsigned int x=0; x<numLines[0]; ++x)
+		for (unsigned int y=0; y<numLines[1]; ++y)
+		{
+			file.read((char*)m_Op_index[x][y], sizeof(unsigned int)*numVectors);
+			for (unsigned int v=0; v<numVectors; ++v)
+				if (m_Op_index[x][y][v]>=size)
+				{
+					m_Op_index[x][y][v] = 0;
+					file.setstate(ios::failbit);
+				}
+		}
 
+	m_CoeffMap.clear();
+	for (unsigned int i=0; i<size; ++i)
+		m_CoeffMap[GetCompressedCoeff(i)] = i;
+
+	return file.good();
+}
 
 // ----------------------------------------------------------------------------
 
+SSE_coeff::SSE_coeff()
+{
+	for (int n=0; n<3; n++)
+	{
+		for (int c=0; c<4; c++)
+		{
+			m_vv[n].f[c] = 0;
+			m_vi[n].f[c] = 0;
+			m_iv[n].f[c] = 0;
+			m_ii[n].f[c] = 0;
+		}
+	}
+	m_flags = 0;
+}
+
 SSE_coeff::SSE_coeff( f4vector vv[3], f4vector vi[3], f4vector iv[3], f4vector ii[3] )
 {
 	for (int n=0; n<3; n++)
@@ -189,10 +389,12 @@ SSE_coeff::SSE_coeff( f4vector vv[3], f4vector vi[3], f4vector iv[3], f4vector i
 		m_iv[n] = iv[n];
 		m_ii[n] = ii[n];
 	}
+	m_flags = 0;
 }
 
 bool SSE_coeff::operator==( const SSE_coeff& other ) const
 {
+	if (m_flags != other.m_flags) return false;
 	for (int n=0; n<3; n++)
 	{
 		if (memcmp( &(m_vv[n]), &(other.m_vv[n]), sizeof(f4vector) ) != 0) return false;
@@ -208,6 +410,7 @@ bool SSE_coeff::operator!=( const SSE_coeff& other ) const
 }
 bool SSE_coeff::operator<( const SSE_coeff& other ) const
 {
+	if (m_flags != other.m_flags) return m_flags < other.m_flags;
 	for (int n=0; n<3; n++)
 	{
 		for (int c=0; c<4; c++)
@@ -225,6 +428,36 @@ bool SSE_coeff::operator<( const SSE_coeff& other ) const
 	return false;
 }
 
+f4vector* SSE_coeff::GetCoeff(int type)
+{
+	f4vector* coeff[4] = {m_vv, m_vi, m_iv, m_ii};
+	return coeff[type];
+}
+
+const f4vector* SSE_coeff::GetCoeff(int type) const
+{
+	const f4vector* coeff[4] = {m_vv, m_vi, m_iv, m_ii};
+	return coeff[type];
+}
+
+size_t SSE_coeff::Hash() const
+{
+	// FNV-1a over the raw coefficient data
+	size_t hash = 2166136261U;
+	for (int type=0; type<4; ++type)
+	{
+		const unsigned char* data = (const unsigned char*)GetCoeff(type);
+		for (size_t i=0; i<3*sizeof(f4vector); ++i)
+		{
+			hash ^= data[i];
+			hash *= 16777619U;
+		}
+	}
+	hash ^= m_flags;
+	hash *= 16777619U;
+	return hash;
+}
+
 void SSE_coeff::print( ostream& stream ) const
 {
 	stream << "SSE_coeff: (" << endl;
@@ -21,21 +21,40 @@
 #include "operator_sse.h"
 #include "tools/aligned_allocator.h"
 
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
+
 class SSE_coeff
 {
 public:
+	//! Create an all-zero coefficient set
+	SSE_coeff();
 	SSE_coeff( f4vector vv[3], f4vector vi[3], f4vector iv[3], f4vector ii[3] );
 	bool operator==( const SSE_coeff& ) const;
 	bool operator!=( const SSE_coeff& ) const;
 	bool operator<( const SSE_coeff& ) const;
 	void print( ostream& stream ) const;
+
+	//! Get the coefficients of the given type (0=vv, 1=vi, 2=iv, 3=ii) for all three directions
+	f4vector* GetCoeff(int type);
+	const f4vector* GetCoeff(int type) const;
+
+	//! Get/Set the coefficient class flags, see Operator_SSE_Compressed::CoeffFlags
+	unsigned char GetFlags() const {return m_flags;}
+	void SetFlags(unsigned char flags) {m_flags=flags;}
+
+	//! Hash of the binary coefficient data and flags, consistent with operator==
+	size_t Hash() const;
 protected:
 	f4vector m_vv[3];
 	f4vector m_vi[3];
 	f4vector m_iv[3];
 	f4vector m_ii[3];
+	unsigned char m_flags;
 };
 
+inline size_t hash_value(const SSE_coeff& coeff) {return coeff.Hash();}
+
 class Operator_SSE_Compressed : public Operator_sse
 {
 public:
@@ -43,22 +62,39 @@ public:
 	static Operator_SSE_Compressed* New();
 	virtual ~Operator_SSE_Compressed();
 
+	//! Flags of a coefficient class, vectors with different flags never share a class
+	enum CoeffFlags
+	{
+		COEFF_DISPERSIVE_VOLT = 1, //!< the engine applies the dispersive voltage ADEs of this vector within the main update
+		COEFF_DISPERSIVE_CURR = 2  //!< the engine applies the dispersive current ADEs of this vector within the main update
+	};
+
+	//! Returns true if the coefficients are stored in the compressed table
+	bool UseCompression() const {return m_Use_Compression;}
+
 	virtual Engine* CreateEngine();
 
-	inline virtual FDTD_FLOAT GetVV( unsigned int n, unsigned int x, unsigned int y, unsigned int z ) const { if (m_Use_Compression) return f4_vv_Compressed[n][m_Op_index[x][y][z%numVectors]].f[z/numVectors]; else return Operator_sse::GetVV(n,x,y,z);}
-	inline virtual FDTD_FLOAT GetVI( unsigned int n, unsigned int x, unsigned int y, unsigned int z ) const { if (m_Use_Compression) return f4_vi_Compressed[n][m_Op_index[x][y][z%numVectors]].f[z/numVectors]; else return Operator_sse::GetVI(n,x,y,z);}
-	inline virtual FDTD_FLOAT GetII( unsigned int n, unsigned int x, unsigned int y, unsigned int z ) const { if (m_Use_Compression) return f4_ii_Compressed[n][m_Op_index[x][y][z%numVectors]].f[z/numVectors]; else return Operator_sse::GetII(n,x,y,z);}
-	inline virtual FDTD_FLOAT GetIV( unsigned int n, unsigned int x, unsigned int y, unsigned int z ) const { if (m_Use_Compression) return f4_iv_Compressed[n][m_Op_index[x][y][z%numVectors]].f[z/numVectors]; else return Operator_sse::GetIV(n,x,y,z);}
+	//! The compressed estimate only contains the index, the size of the table of unique coefficients depends on the geometry
+	virtual double EstimateCoefficientMemory(bool compressed=true) const;
+
+	inline virtual FDTD_FLOAT GetVV( unsigned int n, unsigned int x, unsigned int y, unsigned int z ) const { if (m_Use_Compression) return GetCompressedValue(0,n,x,y,z); else return Operator_sse::GetVV(n,x,y,z);}
+	inline virtual FDTD_FLOAT GetVI( unsigned int n, unsigned int x, unsigned int y, unsigned int z ) const { if (m_Use_Compression) return GetCompressedValue(1,n,x,y,z); else return Operator_sse::GetVI(n,x,y,z);}
+	inline virtual FDTD_FLOAT GetII( unsigned int n, unsigned int x, unsigned int y, unsigned int z ) const { if (m_Use_Compression) return GetCompressedValue(3,n,x,y,z); else return Operator_sse::GetII(n,x,y,z);}
+	inline virtual FDTD_FLOAT GetIV( unsigned int n, unsigned int x, unsigned int y, unsigned int z ) const { if (m_Use_Compression) return GetCompressedValue(2,n,x,y,z); else return Operator_sse::GetIV(n,x,y,z);}
 
-	inline virtual void SetVV( unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value ) { if (m_Use_Compression) f4_vv_Compressed[n][m_Op_index[x][y][z%numVectors]].f[z/numVectors] = value; else Operator_sse::SetVV(n,x,y,z,value);}
-	inline virtual void SetVI( unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value ) { if (m_Use_Compression) f4_vi_Compressed[n][m_Op_index[x][y][z%numVectors]].f[z/numVectors] = value; else Operator_sse::SetVI(n,x,y,z,value);}
-	inline virtual void SetII( unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value ) { if (m_Use_Compression) f4_ii_Compressed[n][m_Op_index[x][y][z%numVectors]].f[z/numVectors] = value; else Operator_sse::SetII(n,x,y,z,value);}
-	inline virtual void SetIV( unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value ) { if (m_Use_Compression) f4_iv_Compressed[n][m_Op_index[x][y][z%numVectors]].f[z/numVectors] = value; else Operator_sse::SetIV(n,x,y,z,value);}
+	inline virtual void SetVV( unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value ) { if (m_Use_Compression) SetCompressedValue(0,n,x,y,z,value); else Operator_sse::SetVV(n,x,y,z,value);}
+	inline virtual void SetVI( unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value ) { if (m_Use_Compression) SetCompressedValue(1,n,x,y,z,value); else Operator_sse::SetVI(n,x,y,z,value);}
+	inline virtual void SetII( unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value ) { if (m_Use_Compression) SetCompressedValue(3,n,x,y,z,value); else Operator_sse::SetII(n,x,y,z,value);}
+	inline virtual void SetIV( unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value ) { if (m_Use_Compression) SetCompressedValue(2,n,x,y,z,value); else Operator_sse::SetIV(n,x,y,z,value);}
 
 	virtual void ShowStat() const;
 
+	//! Remove all coefficient sets no longer used by any cell from the compressed table
 	bool CompressOperator();
 
+	//! Add the \a flags (see CoeffFlags) to the coefficient class of the vector \a vec of the (x,y)-column, the change is pending until FinalizeCoefficients (see SetCompressedValue)
+	void AddCoeffFlags(unsigned int x, unsigned int y, unsigned int vec, unsigned char flags);
+
 protected:
 	Operator_SSE_Compressed();
 
@@ -71,6 +107,40 @@ protected:
 
 	virtual int CalcECOperator( DebugFlags debugFlags = None );
 
+	//! Insert all pending coefficient changes into the compressed table, each changed vector is inserted only once
+	virtual void FinalizeCoefficients();
+
+	//! Calc and deduplicate the operator coefficients slab by slab directly into the compressed table
+	virtual void Calc_ECOperator_Range(unsigned int xStart, unsigned int xStop);
+
+	virtual bool WriteCoefficientCache(ostream &file) const;
+	virtual bool ReadCoefficientCache(istream &file);
+
+	//! Get the coefficient set stored at \p index of the compressed table
+	SSE_coeff GetCompressedCoeff(unsigned int index) const;
+	//! Find the coefficient set in the compressed table or append it, returns its index (not thread-safe)
+	unsigned int InsertCompressedCoeff(const SSE_coeff& coeff);
+	//! Get a single coefficient value (type: 0=vv, 1=vi, 2=iv, 3=ii), including pending changes
+	inline FDTD_FLOAT GetCompressedValue(int type, unsigned int n, unsigned int x, unsigned int y, unsigned int z) const;
+	//! Set a single coefficient value (type: 0=vv, 1=vi, 2=iv, 3=ii)
+	/*!
+	  The coefficient set may be shared with other cells and is never modified in place. On the first change the set of this vector is copied into the pending changes of its x-slab,
+	  all further changes (vv, vi, PEC and boundary conditions, flags) modify this copy, which is inserted into the compressed table by FinalizeCoefficients.
+	  Setup threads may change and read coefficients concurrently as long as each thread works on its own x-slabs, the compressed table itself is not modified until FinalizeCoefficients.
+	  FinalizeCoefficients must not run concurrently to any reader.
+	  */
+	void SetCompressedValue(int type, unsigned int n, unsigned int x, unsigned int y, unsigned int z, FDTD_FLOAT value);
+	//! Get the pending coefficient set of the vector with the given \p index in the x-slab \p x, a copy of the table entry is made on the first access
+	SSE_coeff& GetPendingCoeff(unsigned int x, unsigned int &index);
+
+	typedef boost::unordered_map<SSE_coeff,unsigned int> CoeffMap;
+	CoeffMap m_CoeffMap; //!< index of all coefficient sets in the compressed table
+	boost::mutex m_CompressMutex;
+
+	//! an index with this bit set refers to the pending changes of its x-slab instead of the compressed table
+	static const unsigned int COEFF_PENDING = 0x80000000u;
+	vector< vector<SSE_coeff,aligned_allocator<SSE_coeff> > > m_PendingCoeff; //!< pending coefficient changes of each x-slab
+
 	// engine needs access
 public:
 	unsigned int*** m_Op_index;
@@ -78,7 +148,17 @@ public:
 	vector<f4vector,aligned_allocator<f4vector> > f4_vi_Compressed[3]; //!< coefficient: calc new voltage from old current
 	vector<f4vector,aligned_allocator<f4vector> > f4_iv_Compressed[3]; //!< coefficient: calc new current from old voltage
 	vector<f4vector,aligned_allocator<f4vector> > f4_ii_Compressed[3]; //!< coefficient: calc new current from old current
+	vector<unsigned char> m_Coeff_Flags; //!< flags of each coefficient set, see CoeffFlags
 
 };
 
+inline FDTD_FLOAT Operator_SSE_Compressed::GetCompressedValue(int type, unsigned int n, unsigned int x, unsigned int y, unsigned int z) const
+{
+	unsigned int index = m_Op_index[x][y][z%numVectors];
+	if (index & COEFF_PENDING)
+		return m_PendingCoeff[x][index & ~COEFF_PENDING].GetCoeff(type)[n].f[z/numVectors];
+	const vector<f4vector,aligned_allocator<f4vector> >* tables[4] = {f4_vv_Compressed, f4_vi_Compressed, f4_iv_Compressed, f4_ii_Compressed};
+	return tables[type][n][index].f[z/numVectors];
+}
+
 #endif // OPERATOR_SSE_Compressed_H
@@ -0,0 +1,103 @@
+/*
+*	Copyright (C) 2026 agent (agent@local)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "primitive_index.h"
+#include "operator.h"
+#include "CSPrimitives.h"
+
+using namespace std;
+
+Primitive_Index::Primitive_Index(const Operator* op, ContinuousStructure* CSX, CSProperties::PropertyType type)
+{
+	size_t numBins = 1;
+	for (int n=0; n<3; ++n)
+	{
+		m_numLines[n] = op->GetNumberOfLines(n,true);
+		m_BinSize[n] = max(1u, (m_numLines[n]+MaxBins-1)/MaxBins);
+		m_numBins[n] = (m_numLines[n]+m_BinSize[n]-1)/m_BinSize[n];
+		numBins *= m_numBins[n];
+	}
+	m_Bins.resize(numBins);
+
+	// sorted by priority, all bins keep this order
+	vector<CSPrimitives*> vPrims = CSX->GetAllPrimitives(true, type);
+
+	double boundBox[6];
+	for (int n=0; n<3; ++n)
+	{
+		boundBox[2*n]   = op->GetDiscLine(n,0);
+		boundBox[2*n+1] = op->GetDiscLine(n,m_numLines[n]-1);
+	}
+
+	// refine the primitive lists direction by direction
+	vector<CSPrimitives*> vPrims_X;
+	vector<CSPrimitives*> vPrims_XY;
+	size_t index = 0;
+	for (unsigned int bx=0; bx<m_numBins[0]; ++bx)
+	{
+		SetBinBoundBox(op, 0, bx, boundBox);
+		boundBox[2] = op->GetDiscLine(1,0);
+		boundBox[3] = op->GetDiscLine(1,m_numLines[1]-1);
+		boundBox[4] = op->GetDiscLine(2,0);
+		boundBox[5] = op->GetDiscLine(2,m_numLines[2]-1);
+		vPrims_X.clear();
+		FilterPrimitives(vPrims, boundBox, vPrims_X);
+		for (unsigned int by=0; by<m_numBins[1]; ++by)
+		{
+			SetBinBoundBox(op, 1, by, boundBox);
+			boundBox[4] = op->GetDiscLine(2,0);
+			boundBox[5] = op->GetDiscLine(2,m_numLines[2]-1);
+			vPrims_XY.clear();
+			FilterPrimitives(vPrims_X, boundBox, vPrims_XY);
+			for (unsigned int bz=0; bz<m_numBins[2]; ++bz)
+			{
+				SetBinBoundBox(op, 2, bz, boundBox);
+				FilterPrimitives(vPrims_XY, boundBox, m_Bins[index]);
+				++index;
+			}
+		}
+	}
+}
+
+Primitive_Index::~Primitive_Index()
+{
+}
+
+double Primitive_Index::GetAveragePrimitivesPerBin() const
+{
+	if (m_Bins.size()==0)
+		return 0;
+	size_t sum = 0;
+	for (size_t n=0; n<m_Bins.size(); ++n)
+		sum += m_Bins[n].size();
+	return (double)sum/(double)m_Bins.size();
+}
+
+void Primitive_Index::SetBinBoundBox(const Operator* op, int ny, unsigned int bin, double* boundBox) const
+{
+	unsigned int start = bin*m_BinSize[ny];
+	unsigned int stop = min(m_numLines[ny]-1, start+m_BinSize[ny]-1);
+	boundBox[2*ny]   = op->GetDiscLine(ny, start>0 ? start-1 : 0);
+	boundBox[2*ny+1] = op->GetDiscLine(ny, min(m_numLines[ny]-1, stop+1));
+}
+
+void Primitive_Index::FilterPrimitives(const vector<CSPrimitives*> &in, const double* boundBox, vector<CSPrimitives*> &out) const
+{
+	for (size_t n=0; n<in.size(); ++n)
+		if (in[n]->IsInsideBox(boundBox)>=0)
+			out.push_back(in[n]);
+}
@@ -0,0 +1,65 @@
+/*
+*	Copyright (C) 2026 agent (agent@local)
+*
+*	This program is free software: you can redistribute it and/or modify
+*	it under the terms of the GNU General Public License as published by
+*	the Free Software Foundation, either version 3 of the License, or
+*	(at your option) any later version.
+*
+*	This program is distributed in the hope that it will be useful,
+*	but WITHOUT ANY WARRANTY; without even the implied warranty of
+*	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*	GNU General Public License for more details.
+*
+*	You should have received a copy of the GNU General Public License
+*	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PRIMITIVE_INDEX_H
+#define PRIMITIVE_INDEX_H
+
+#include <vector>
+#include "ContinuousStructure.h"
+
+class Operator;
+
+//! Spatial index of all CSX primitives of a given property type, binned by mesh index.
+/*!
+  The mesh is divided into blocks of mesh lines (bins). Each bin holds all primitives (sorted by priority) whose bounding box intersects the bin, extended by one mesh line in each direction.
+  Thus all primitives that may contain a coordinate between the neighbouring mesh lines of a given mesh position can be found in constant time, independent of the total number of primitives.
+  The index has to be rebuild if the mesh or the geometry changes.
+  */
+class Primitive_Index
+{
+public:
+	Primitive_Index(const Operator* op, ContinuousStructure* CSX, CSProperties::PropertyType type);
+	virtual ~Primitive_Index();
+
+	//! Get all primitives (sorted by priority) which may be found at or around the given mesh position.
+	inline const std::vector<CSPrimitives*>& GetPrimitives(const unsigned int* pos) const
+	{
+		return m_Bins[((size_t)(pos[0]/m_BinSize[0])*m_numBins[1] + pos[1]/m_BinSize[1])*m_numBins[2] + pos[2]/m_BinSize[2]];
+	}
+
+	//! Get the total number of bins
+	size_t GetNumberOfBins() const {return m_Bins.size();}
+	//! Get the average number of primitives per bin
+	double GetAveragePrimitivesPerBin() const;
+
+	//! Maximum number of bins in each direction
+	static const unsigned int MaxBins = 32;
+
+protected:
+	unsigned int m_numLines[3];
+	unsigned int m_BinSize[3];
+	unsigned int m_numBins[3];
+
+	std::vector< std::vector<CSPrimitives*> > m_Bins;
+
+	//! Set the bound box range of bin \p bin in direction \p ny, including the neighbouring mesh lines
+	void SetBinBoundBox(const Operator* op, int ny, unsigned int bin, double* boundBox) const;
+	//! Add all primitives of \p in intersecting the given bound box to \p out, preserving the order
+	void FilterPrimitives(const std::vector<CSPrimitives*> &in, const double* boundBox, std::vector<CSPrimitives*> &out) const;
+};
+
+#endif // PRIMITIVE_INDEX_H
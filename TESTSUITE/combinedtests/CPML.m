@@ -0,0 +1,196 @@
+function pass = CPML( openEMS_options, options )
+%pass = CPML( openEMS_options, options )
+%
+% Checks the reflection of the convolutional pml (CPML_x boundary) terminating
+% a parallel plate line in x- and z-direction. The reflected wave is the
+% difference to a reference line, which is long enough that its termination
+% has no influence within the simulated time.
+% The cpml must absorb at least as good as the upml (PML_x boundary) of the
+% same size, the engine speed of both is reported.
+% A conducting sheet running into the cpml is a PEC inside the pml, the
+% tangential voltages of the sheet must remain zero.
+
+ENABLE_PLOTS = 1;
+CLEANUP = 1;        % if enabled and result is PASS, remove simulation folder
+STOP_IF_FAILED = 1; % if enabled and result is FAILED, stop with error
+SILENT = 0;         % 0=show openEMS output
+
+if nargin < 1
+    openEMS_options = '';
+end
+if nargin < 2
+    options = '';
+end
+if any(strcmp( options, 'run_testsuite' ))
+    ENABLE_PLOTS = 0;
+    STOP_IF_FAILED = 0;
+    SILENT = 1;
+end
+
+% LIMITS
+max_reflection = 0.01; % max -40dB
+upml_margin = 1;       % max 1dB more reflection than the upml
+
+global Sim_Path Sim_CSX
+Sim_Path = 'tmp_CPML';
+Sim_CSX = 'cpml.xml';
+
+% propagation direction of the line: x (packed sse update) and z
+directions = [1 3];
+dir_names = {'x' 'y' 'z'};
+
+pass = 1;
+for d=directions
+    [u_cpml, ~, speed_cpml] = sim( d, 300, 'CPML_8', 0, openEMS_options, SILENT );
+    [u_upml, ~, speed_upml] = sim( d, 300, 'PML_8', 0, openEMS_options, SILENT );
+    u_ref = sim( d, 900, 'PEC', 0, openEMS_options, SILENT );
+
+    reflection = max(abs(u_cpml.val - u_ref.val)) / max(abs(u_ref.val));
+    reflection_upml = max(abs(u_upml.val - u_ref.val)) / max(abs(u_ref.val));
+    disp( ['cpml in ' dir_names{d} '-direction: reflection ' num2str(20*log10(reflection)) ' dB (upml: ' num2str(20*log10(reflection_upml)) ' dB)'] );
+    disp( ['cpml in ' dir_names{d} '-direction: speed ' num2str(speed_cpml) ' MC/s (upml: ' num2str(speed_upml) ' MC/s)'] );
+    if ENABLE_PLOTS
+        figure
+        plot( u_ref.t*1e9, [u_ref.val; u_cpml.val - u_ref.val] );
+        xlabel( 'time (ns)' );
+        ylabel( 'voltage (V)' );
+        legend( {'incident', 'reflected'} );
+        title( ['cpml in ' dir_names{d} '-direction'] );
+    end
+    if ~(reflection < max_reflection)
+        disp( ['reflection error: cpml in ' dir_names{d} '-direction: reflection ' num2str(20*log10(reflection)) ' dB'] );
+        pass = 0;
+    end
+    if ~(20*log10(reflection) <= 20*log10(reflection_upml) + upml_margin)
+        disp( ['reflection error: cpml in ' dir_names{d} '-direction: reflection ' num2str(20*log10(reflection)) ' dB is larger than the upml reflection ' num2str(20*log10(reflection_upml)) ' dB'] );
+        pass = 0;
+    end
+
+    [u_sheet, E_sheet] = sim( d, 300, 'CPML_8', 1, openEMS_options, SILENT );
+    for o=1:numel(E_sheet.TD.values)
+        E_tan = E_sheet.TD.values{o}(:,:,:,2); % y-component, tangential to the sheet
+        if any(E_tan(:)~=0) || any(isnan(u_sheet.val))
+            disp( ['sheet error: cpml in ' dir_names{d} '-direction: field on the conducting sheet inside the pml at timestep ' E_sheet.names{o}] );
+            pass = 0;
+            break
+        end
+    end
+    if ~SILENT
+        disp( ['cpml in ' dir_names{d} '-direction: conducting sheet inside the pml checked'] );
+    end
+end
+
+if pass
+    disp( 'combinedtests/CPML.m (cpml reflection):  pass' );
+else
+    disp( 'combinedtests/CPML.m (cpml reflection):  * FAILED *' );
+end
+
+if pass && CLEANUP
+    rmdir( Sim_Path, 's' );
+end
+if ~pass && STOP_IF_FAILED
+    error 'test failed';
+end
+
+return
+
+
+function [u, E_sheet, speed] = sim( d, line_length, BC_end, sheet, openEMS_options, SILENT )
+global Sim_Path Sim_CSX
+
+f_max = 10e9;
+mesh_res = 2;   % mm
+plate_dist = 10; % mm
+plate_width = 40; % mm, other transverse direction
+probe_pos = 150; % mm
+
+% prepare simulation dir
+[status,message,messageid] = rmdir(Sim_Path,'s');
+[status,message,messageid] = mkdir(Sim_Path);
+
+% setup FDTD parameter
+FDTD = InitFDTD( 800, 0 );
+FDTD = SetGaussExcite(FDTD,0,f_max);
+% parallel plates in y-direction, the other transverse direction is a PMC
+% (TEM wave), the line is terminated by BC_end
+BC = {'PMC' 'PMC' 'PEC' 'PEC' 'PMC' 'PMC'};
+BC{2*d-1} = 'PEC';
+BC{2*d} = BC_end;
+FDTD = SetBoundaryCond(FDTD,BC);
+
+% setup CSXCAD geometry
+CSX = InitCSX();
+mesh.x = 0 : mesh_res : plate_dist;
+mesh.y = 0 : mesh_res : plate_dist;
+mesh.z = 0 : mesh_res : plate_dist;
+mesh.(dir_name(4-d)) = 0 : mesh_res : plate_width;
+mesh.(dir_name(d)) = 0 : mesh_res : line_length;
+CSX = DefineRectGrid(CSX, 1e-3, mesh);
+
+% excitation, a soft source in front of the PEC at the line start
+CSX = AddExcitation(CSX,'excite',0,[0 1 0]);
+start = [0 0 0];
+stop  = [plate_width plate_dist plate_width];
+start(d) = mesh_res;
+stop(d) = mesh_res;
+CSX = AddBox(CSX,'excite',0,start,stop);
+
+% voltage between the plates
+CSX = AddProbe(CSX,'ut',0);
+start = [plate_width/2 0 plate_width/2];
+stop  = [plate_width/2 plate_dist plate_width/2];
+start(d) = probe_pos;
+stop(d) = probe_pos;
+CSX = AddBox(CSX,'ut',0,start,stop);
+
+% conducting sheet strip in the plane of the other transverse direction, running into the pml at the line end
+if sheet
+    t = 4-d; % other transverse direction
+    CSX = AddConductingSheet( CSX, 'sheet', 56e6, 10e-6 );
+    start = [0 2 0];
+    stop  = [0 8 0];
+    start(t) = 4;
+    stop(t) = 4;
+    start(d) = line_length - 50;
+    stop(d) = line_length;
+    CSX = AddBox( CSX, 'sheet', 10, start, stop );
+
+    % E-field at the sheet edges inside the pml (the last 8 cells)
+    CSX = AddDump( CSX, 'Et_sheet', 'DumpType', 0, 'DumpMode', 0, 'FileType', 1 ); % hdf5 E-field dump without interpolation
+    start(2) = 2;
+    stop(2) = 6;
+    start(d) = line_length - 7*mesh_res;
+    stop(d) = line_length - mesh_res;
+    CSX = AddBox( CSX, 'Et_sheet', 0, start, stop );
+end
+
+% Write openEMS compatible xml-file
+WriteOpenEMS( [Sim_Path '/' Sim_CSX], FDTD, CSX );
+
+% cd to working dir and run openEMS
+folder = fileparts( mfilename('fullpath') );
+Settings.LogFile = [folder '/' Sim_Path '/openEMS.log'];
+Settings.Silent = SILENT;
+RunOpenEMS( Sim_Path, Sim_CSX, openEMS_options, Settings );
+
+UI = ReadUI( 'ut', Sim_Path );
+u = UI.TD{1};
+E_sheet = [];
+if sheet
+    E_sheet = ReadHDF5FieldData( [Sim_Path '/Et_sheet.h5'] );
+end
+
+% engine speed of the whole simulation
+speed = NaN;
+log = fileread( Settings.LogFile );
+tokens = regexp( log, 'Speed:\s*([\d\.eE+-]+)\s*MCells/s', 'tokens' );
+if ~isempty(tokens)
+    speed = str2double( tokens{end}{1} );
+end
+
+
+
+function name = dir_name( d )
+names = {'x' 'y' 'z'};
+name = names{d};
@@ -0,0 +1,183 @@
+function pass = compressed_operator( openEMS_options, options )
+%pass = compressed_operator( openEMS_options, options )
+%
+% Checks, if the compressed operator is independent of the number of setup threads
+% and identical to the uncompressed operator, if single coefficients are changed
+% by metal, lumped elements and boundary conditions after the operator calculation
+
+CLEANUP = 1;        % if enabled and result is PASS, remove simulation folder
+STOP_IF_FAILED = 1; % if enabled and result is FAILED, stop with error
+SILENT = 0;         % 0=show openEMS output
+
+if nargin < 1
+    openEMS_options = '';
+end
+if nargin < 2
+    options = '';
+end
+if any(strcmp( options, 'run_testsuite' ))
+    STOP_IF_FAILED = 0;
+    SILENT = 1;
+end
+% clean openEMS_options
+openEMS_options = regexprep( openEMS_options, '--engine=\w+', '' );
+openEMS_options = regexprep( openEMS_options, '--numThreads=\d+', '' );
+
+% the first simulation is the reference of the uncompressed operator
+engines = {'--engine=sse' '--engine=sse-compressed' '--engine=multithreaded --numThreads=1' '--engine=multithreaded --numThreads=4'};
+
+global Sim_Path Sim_CSX
+Sim_Path = 'tmp_compressed_operator';
+Sim_CSX = 'compressed_operator.xml';
+
+for n=1:numel(engines)
+    result{n} = sim( [engines{n} ' -v ' openEMS_options], SILENT );
+end
+
+pass = compare( result, SILENT );
+
+if pass
+    disp( 'enginetests/compressed_operator.m (compressed operator):  pass' );
+else
+    disp( 'enginetests/compressed_operator.m (compressed operator):  * FAILED *' );
+end
+
+if pass && CLEANUP
+    rmdir( Sim_Path, 's' );
+end
+if ~pass && STOP_IF_FAILED
+    error 'test failed'
+end
+
+return
+
+
+function result = sim( openEMS_options, SILENT )
+global Sim_Path Sim_CSX
+physical_constants;
+
+a = 5e-2;
+b = 2e-2;
+d = 6e-2;
+
+f_start = 1e9;
+f_stop = 10e9;
+
+% prepare simulation dir
+[status,message,messageid] = rmdir(Sim_Path,'s');
+[status,message,messageid] = mkdir(Sim_Path);
+
+% setup FDTD parameter
+FDTD = InitFDTD( 500, 0 );
+FDTD = SetGaussExcite(FDTD,(f_stop-f_start)/2,(f_stop-f_start)/2);
+BC = {'MUR' 'PML_8' 'PMC' 'PEC' 'PEC' 'PMC'}; % boundaries
+FDTD = SetBoundaryCond(FDTD,BC);
+
+% setup CSXCAD geometry
+CSX = InitCSX();
+mesh.x = linspace(0,a,27);
+mesh.y = linspace(0,b,11);
+mesh.z = linspace(0,d,33);
+CSX = DefineRectGrid(CSX, 1,mesh);
+
+% excitation
+CSX = AddExcitation(CSX,'excite1',0,[1 1 1]);
+p(1,1) = mesh.x(floor(end*2/3));
+p(2,1) = mesh.y(floor(end*2/3));
+p(3,1) = mesh.z(floor(end*2/3));
+p(1,2) = mesh.x(floor(end*2/3)+1);
+p(2,2) = mesh.y(floor(end*2/3)+1);
+p(3,2) = mesh.z(floor(end*2/3)+1);
+CSX = AddCurve( CSX, 'excite1', 0, p );
+
+% probes
+CSX = AddProbe( CSX, 'E_probe', 2 );
+p(1,1) = mesh.x(floor(end*1/3));
+p(2,1) = mesh.y(floor(end*1/3));
+p(3,1) = mesh.z(floor(end*1/3));
+CSX = AddPoint( CSX, 'E_probe', 0, p );
+CSX = AddProbe( CSX, 'H_probe', 3 );
+CSX = AddPoint( CSX, 'H_probe', 0, p );
+
+% material
+CSX = AddMaterial( CSX, 'RO4350B', 'Epsilon', 3.66 );
+start = [mesh.x(3) mesh.y(3) mesh.z(3)];
+stop  = [mesh.x(9) mesh.y(6) mesh.z(12)];
+CSX = AddBox( CSX, 'RO4350B', 100, start, stop );
+
+% metal, partly overlapping the material, spanning many x-slabs
+CSX = AddMetal( CSX, 'metal' );
+start = [mesh.x(6) mesh.y(2) mesh.z(10)];
+stop  = [mesh.x(20) mesh.y(5) mesh.z(10)];
+CSX = AddBox( CSX, 'metal', 10, start, stop );
+p = [mesh.x(4) mesh.x(15) mesh.x(15); mesh.y(8) mesh.y(8) mesh.y(8); mesh.z(20) mesh.z(20) mesh.z(28)];
+CSX = AddCurve( CSX, 'metal', 10, p );
+
+% lumped resistor
+CSX = AddLumpedElement( CSX, 'resist', 2, 'R', 50 );
+start = [mesh.x(22) mesh.y(3) mesh.z(15)];
+stop  = [mesh.x(23) mesh.y(4) mesh.z(18)];
+CSX = AddBox( CSX, 'resist', 10, start, stop );
+
+% dump
+CSX = AddDump( CSX, 'Et', 'DumpType', 0, 'DumpMode', 0, 'FileType', 1 ); % hdf5 E-field dump without interpolation
+pos1 = [mesh.x(1) mesh.y(1) mesh.z(1)];
+pos2 = [mesh.x(end) mesh.y(end) mesh.z(end)];
+CSX = AddBox( CSX, 'Et', 0, pos1, pos2 );
+
+CSX = AddDump( CSX, 'Ht', 'DumpType', 1, 'DumpMode', 0, 'FileType', 1 ); % hdf5 H-field dump without interpolation
+CSX = AddBox( CSX, 'Ht', 0, pos1, pos2 );
+
+% Write openEMS compatible xml-file
+WriteOpenEMS( [Sim_Path '/' Sim_CSX], FDTD, CSX );
+
+% cd to working dir and run openEMS
+folder = fileparts( mfilename('fullpath') );
+Settings.LogFile = [folder '/' Sim_Path '/openEMS.log'];
+Settings.Silent = SILENT;
+RunOpenEMS( Sim_Path, Sim_CSX, openEMS_options, Settings );
+
+% collect result
+result.E = ReadHDF5FieldData( [Sim_Path '/Et.h5'] );
+result.H = ReadHDF5FieldData( [Sim_Path '/Ht.h5'] );
+
+% number of unique coefficient sets after the final compression (empty for the uncompressed operator)
+result.unique = [];
+log = fileread( Settings.LogFile );
+tokens = regexp( log, 'Unique SSE operators\s*:\s*(\d+)', 'tokens' );
+if ~isempty(tokens)
+    result.unique = str2double( tokens{end}{1} );
+end
+
+
+
+function pass = compare( results, SILENT )
+pass = 0;
+% n=1: reference simulation (uncompressed operator)
+for n=2:numel(results)
+    EHfields = {'E','H'};
+    for m=1:numel(EHfields)
+        EHfield = EHfields{m};
+        for o=1:numel(results{1}.(EHfield).TD.values)
+            cmp_result = results{1}.(EHfield).TD.values{o} ~= results{n}.(EHfield).TD.values{o};
+            if any(cmp_result(:))
+                disp( ['compare error: n=' num2str(n) '  field=' EHfield '  timestep:' num2str(o) '=' results{1}.(EHfield).names{o}] );
+                return
+            end
+        end
+    end
+    if isempty(results{n}.unique)
+        disp( ['compare error: n=' num2str(n) '  number of unique coefficient sets not found in the log file'] );
+        return
+    end
+    % the table after the final compression must not depend on the number of setup threads
+    if results{n}.unique ~= results{2}.unique
+        disp( ['compare error: n=' num2str(n) '  ' num2str(results{n}.unique) ' unique coefficient sets instead of ' num2str(results{2}.unique)] );
+        return
+    end
+    if ~SILENT
+        disp( ['simulation ' num2str(n) ' is identical to simulation 1 (' num2str(results{n}.unique) ' unique coefficient sets)'] );
+    end
+end
+
+pass = 1;
@@ -0,0 +1,179 @@
+function pass = fold_dispersive( openEMS_options, options )
+%pass = fold_dispersive( openEMS_options, options )
+%
+% Checks, if the dispersive (Lorentz/Drude) material update folded into the
+% main update (--fold-dispersive) produces results identical to the separate
+% dispersive update, with and without a boundary condition excluding the fold
+
+CLEANUP = 1;        % if enabled and result is PASS, remove simulation folder
+STOP_IF_FAILED = 1; % if enabled and result is FAILED, stop with error
+SILENT = 0;         % 0=show openEMS output
+
+if nargin < 1
+    openEMS_options = '';
+end
+if nargin < 2
+    options = '';
+end
+if any(strcmp( options, 'run_testsuite' ))
+    STOP_IF_FAILED = 0;
+    SILENT = 1;
+end
+% clean openEMS_options
+openEMS_options = regexprep( openEMS_options, '--engine=\w+', '' );
+openEMS_options = regexprep( openEMS_options, '--fold-dispersive', '' );
+
+global Sim_Path Sim_CSX
+Sim_Path = 'tmp_fold_dispersive';
+Sim_CSX = 'fold_dispersive.xml';
+
+engines = {'--engine=sse-compressed' '--engine=multithreaded'};
+boundaries = {{'PEC' 'PEC' 'PMC' 'PEC' 'PEC' 'PEC'}, {'MUR' 'MUR' 'PMC' 'PEC' 'PEC' 'PEC'}};
+% the mur abc does not commute with the folded update, the fold has to be disabled
+fold_excluded = [0 1];
+
+pass = 1;
+for b=1:numel(boundaries)
+    for n=1:numel(engines)
+        ref = sim( [engines{n} ' ' openEMS_options], boundaries{b}, SILENT );
+        [folded, log] = sim( [engines{n} ' --fold-dispersive ' openEMS_options], boundaries{b}, SILENT );
+
+        excluded = ~isempty( strfind( log, 'FoldIntoMainUpdate: Warning' ) );
+        if excluded ~= fold_excluded(b)
+            disp( ['fold error: ' engines{n} ' boundaries ' num2str(b) ': the fold was ' iif(excluded,'disabled','used') ' unexpectedly'] );
+            pass = 0;
+        end
+        if ~compare( ref, folded )
+            disp( ['compare error: ' engines{n} ' boundaries ' num2str(b) ': the folded update differs from the separate update'] );
+            pass = 0;
+        elseif ~SILENT
+            disp( [engines{n} ' boundaries ' num2str(b) ': folded and separate update are identical'] );
+        end
+    end
+end
+
+if pass
+    disp( 'enginetests/fold_dispersive.m (folded dispersive update):  pass' );
+else
+    disp( 'enginetests/fold_dispersive.m (folded dispersive update):  * FAILED *' );
+end
+
+if pass && CLEANUP
+    rmdir( Sim_Path, 's' );
+end
+if ~pass && STOP_IF_FAILED
+    error 'test failed'
+end
+
+return
+
+
+function [result, log] = sim( openEMS_options, BC, SILENT )
+global Sim_Path Sim_CSX
+physical_constants;
+
+a = 5e-2;
+b = 2e-2;
+d = 6e-2;
+
+f_start = 1e9;
+f_stop = 10e9;
+
+% prepare simulation dir
+[status,message,messageid] = rmdir(Sim_Path,'s');
+[status,message,messageid] = mkdir(Sim_Path);
+
+% setup FDTD parameter
+FDTD = InitFDTD( 1000, 0 );
+FDTD = SetGaussExcite(FDTD,(f_stop-f_start)/2,(f_stop-f_start)/2);
+FDTD = SetBoundaryCond(FDTD,BC);
+
+% setup CSXCAD geometry
+CSX = InitCSX();
+mesh.x = linspace(0,a,27);
+mesh.y = linspace(0,b,11);
+mesh.z = linspace(0,d,33);
+CSX = DefineRectGrid(CSX, 1,mesh);
+
+% excitation
+CSX = AddExcitation(CSX,'excite1',0,[1 1 1]);
+p(1,1) = mesh.x(floor(end*2/3));
+p(2,1) = mesh.y(floor(end*2/3));
+p(3,1) = mesh.z(floor(end*2/3));
+p(1,2) = mesh.x(floor(end*2/3)+1);
+p(2,2) = mesh.y(floor(end*2/3)+1);
+p(3,2) = mesh.z(floor(end*2/3)+1);
+CSX = AddCurve( CSX, 'excite1', 0, p );
+
+% probes
+CSX = AddProbe( CSX, 'E_probe', 2 );
+p(1,1) = mesh.x(floor(end*1/3));
+p(2,1) = mesh.y(floor(end*1/3));
+p(3,1) = mesh.z(floor(end*1/3));
+CSX = AddPoint( CSX, 'E_probe', 0, p );
+CSX = AddProbe( CSX, 'H_probe', 3 );
+CSX = AddPoint( CSX, 'H_probe', 0, p );
+
+% electric and magnetic dispersive material, touching the mur boundary
+CSX = AddLorentzMaterial( CSX, 'drude' );
+CSX = SetMaterialProperty( CSX, 'drude', 'Epsilon', 2, 'EpsilonPlasmaFrequency', 5e9, 'EpsilonRelaxTime', 1e-9 );
+CSX = SetMaterialProperty( CSX, 'drude', 'Mue', 1.5, 'MuePlasmaFrequency', 3e9, 'MueRelaxTime', 2e-9 );
+start = [mesh.x(1) mesh.y(2) mesh.z(4)];
+stop  = [mesh.x(12) mesh.y(8) mesh.z(16)];
+CSX = AddBox( CSX, 'drude', 10, start, stop );
+
+% dump
+CSX = AddDump( CSX, 'Et', 'DumpType', 0, 'DumpMode', 0, 'FileType', 1 ); % hdf5 E-field dump without interpolation
+pos1 = [mesh.x(1) mesh.y(1) mesh.z(1)];
+pos2 = [mesh.x(end) mesh.y(end) mesh.z(end)];
+CSX = AddBox( CSX, 'Et', 0, pos1, pos2 );
+
+CSX = AddDump( CSX, 'Ht', 'DumpType', 1, 'DumpMode', 0, 'FileType', 1 ); % hdf5 H-field dump without interpolation
+CSX = AddBox( CSX, 'Ht', 0, pos1, pos2 );
+
+% Write openEMS compatible xml-file
+WriteOpenEMS( [Sim_Path '/' Sim_CSX], FDTD, CSX );
+
+% cd to working dir and run openEMS
+folder = fileparts( mfilename('fullpath') );
+Settings.LogFile = [folder '/' Sim_Path '/openEMS.log'];
+Settings.Silent = SILENT;
+RunOpenEMS( Sim_Path, Sim_CSX, openEMS_options, Settings );
+
+% collect result
+result.E = ReadHDF5FieldData( [Sim_Path '/Et.h5'] );
+result.H = ReadHDF5FieldData( [Sim_Path '/Ht.h5'] );
+result.probes = ReadUI( {'E_probe','H_probe'}, Sim_Path );
+log = fileread( Settings.LogFile );
+
+
+
+function pass = compare( ref, result )
+pass = 0;
+EHfields = {'E','H'};
+for m=1:numel(EHfields)
+    EHfield = EHfields{m};
+    for o=1:numel(ref.(EHfield).TD.values)
+        cmp_result = ref.(EHfield).TD.values{o} ~= result.(EHfield).TD.values{o};
+        if any(cmp_result(:))
+            disp( ['compare error: field=' EHfield '  timestep:' num2str(o) '=' ref.(EHfield).names{o}] );
+            return
+        end
+    end
+end
+for n=1:numel(ref.probes.TD)
+    if any( ref.probes.TD{n}.val ~= result.probes.TD{n}.val )
+        disp( ['compare error: probe ' num2str(n)] );
+        return
+    end
+end
+pass = 1;
+
+
+
+function r = iif( cond, a, b )
+if cond
+    r = a;
+else
+    r = b;
+end
@@ -0,0 +1,161 @@
+function pass = material_storage( openEMS_options, options )
+%pass = material_storage( openEMS_options, options )
+%
+% Checks, if the D- and B-field dumps using the material storage limited to the
+% dump regions are identical to the dumps using a material storage of the full
+% mesh (requested by an additional dump box covering the whole mesh)
+
+CLEANUP = 1;        % if enabled and result is PASS, remove simulation folder
+STOP_IF_FAILED = 1; % if enabled and result is FAILED, stop with error
+SILENT = 0;         % 0=show openEMS output
+
+if nargin < 1
+    openEMS_options = '';
+end
+if nargin < 2
+    options = '';
+end
+if any(strcmp( options, 'run_testsuite' ))
+    STOP_IF_FAILED = 0;
+    SILENT = 1;
+end
+% clean openEMS_options
+openEMS_options = regexprep( openEMS_options, '--disable-dumps', '' );
+
+global Sim_Path Sim_CSX
+Sim_Path = 'tmp_material_storage';
+Sim_CSX = 'material_storage.xml';
+
+% dumps inside the mesh and at the mesh boundary, with and without interpolation
+dumps = {'Dt_in' 'Dt_edge' 'Bt_in' 'Bt_edge'};
+
+result_region = sim( 0, openEMS_options, SILENT, dumps );
+result_full   = sim( 1, openEMS_options, SILENT, dumps );
+
+pass = 1;
+for n=1:numel(dumps)
+    if ~compare( result_full.(dumps{n}), result_region.(dumps{n}), dumps{n} )
+        pass = 0;
+    elseif ~SILENT
+        disp( ['dump ' dumps{n} ': region and full mesh material storage are identical'] );
+    end
+end
+
+if pass
+    disp( 'enginetests/material_storage.m (material storage of the dump regions):  pass' );
+else
+    disp( 'enginetests/material_storage.m (material storage of the dump regions):  * FAILED *' );
+end
+
+if pass && CLEANUP
+    rmdir( Sim_Path, 's' );
+end
+if ~pass && STOP_IF_FAILED
+    error 'test failed'
+end
+
+return
+
+
+function result = sim( full_storage, openEMS_options, SILENT, dumps )
+global Sim_Path Sim_CSX
+physical_constants;
+
+a = 5e-2;
+b = 2e-2;
+d = 6e-2;
+
+f_start = 1e9;
+f_stop = 10e9;
+
+% prepare simulation dir
+[status,message,messageid] = rmdir(Sim_Path,'s');
+[status,message,messageid] = mkdir(Sim_Path);
+
+% setup FDTD parameter
+FDTD = InitFDTD( 300, 0 );
+FDTD = SetGaussExcite(FDTD,(f_stop-f_start)/2,(f_stop-f_start)/2);
+BC = {'PEC' 'PEC' 'PMC' 'PEC' 'PEC' 'PEC'}; % boundaries
+FDTD = SetBoundaryCond(FDTD,BC);
+
+% setup CSXCAD geometry
+CSX = InitCSX();
+mesh.x = linspace(0,a,26);
+mesh.y = linspace(0,b,11);
+mesh.z = linspace(0,d,31);
+CSX = DefineRectGrid(CSX, 1,mesh);
+
+% excitation
+CSX = AddExcitation(CSX,'excite1',0,[1 1 1]);
+p(1,1) = mesh.x(floor(end*2/3));
+p(2,1) = mesh.y(floor(end*2/3));
+p(3,1) = mesh.z(floor(end*2/3));
+p(1,2) = mesh.x(floor(end*2/3)+1);
+p(2,2) = mesh.y(floor(end*2/3)+1);
+p(3,2) = mesh.z(floor(end*2/3)+1);
+CSX = AddCurve( CSX, 'excite1', 0, p );
+
+% electric and magnetic material crossing the dump boxes and touching the mesh boundary
+CSX = AddMaterial( CSX, 'material', 'Epsilon', 3.66, 'Mue', 2.1 );
+start = [mesh.x(1)  mesh.y(3) mesh.z(5)];
+stop  = [mesh.x(12) mesh.y(8) mesh.z(14)];
+CSX = AddBox( CSX, 'material', 10, start, stop );
+
+% dumps of the electric (4) and magnetic (5) flux density
+types = struct( 'Dt', 4, 'Bt', 5 );
+for n=1:numel(dumps)
+    type = types.(dumps{n}(1:2));
+    if ~isempty( strfind( dumps{n}, '_in' ) )
+        % inside the mesh across the material interface, cell interpolated
+        CSX = AddDump( CSX, dumps{n}, 'DumpType', type, 'DumpMode', 2, 'FileType', 1 );
+        pos1 = [mesh.x(8)  mesh.y(2) mesh.z(10)];
+        pos2 = [mesh.x(16) mesh.y(6) mesh.z(18)];
+    else
+        % at the mesh boundary, without interpolation
+        CSX = AddDump( CSX, dumps{n}, 'DumpType', type, 'DumpMode', 0, 'FileType', 1 );
+        pos1 = [mesh.x(1) mesh.y(1)   mesh.z(3)];
+        pos2 = [mesh.x(5) mesh.y(end) mesh.z(8)];
+    end
+    CSX = AddBox( CSX, dumps{n}, 0, pos1, pos2 );
+end
+
+% request the material storage of the full mesh
+if full_storage
+    pos1 = [mesh.x(1) mesh.y(1) mesh.z(1)];
+    pos2 = [mesh.x(end) mesh.y(end) mesh.z(end)];
+    CSX = AddDump( CSX, 'Dt_full', 'DumpType', 4, 'DumpMode', 0, 'FileType', 1 );
+    CSX = AddBox( CSX, 'Dt_full', 0, pos1, pos2 );
+    CSX = AddDump( CSX, 'Bt_full', 'DumpType', 5, 'DumpMode', 0, 'FileType', 1 );
+    CSX = AddBox( CSX, 'Bt_full', 0, pos1, pos2 );
+end
+
+% Write openEMS compatible xml-file
+WriteOpenEMS( [Sim_Path '/' Sim_CSX], FDTD, CSX );
+
+% cd to working dir and run openEMS
+folder = fileparts( mfilename('fullpath') );
+Settings.LogFile = [folder '/' Sim_Path '/openEMS.log'];
+Settings.Silent = SILENT;
+RunOpenEMS( Sim_Path, Sim_CSX, openEMS_options, Settings );
+
+% collect result
+for n=1:numel(dumps)
+    result.(dumps{n}) = ReadHDF5FieldData( [Sim_Path '/' dumps{n} '.h5'] );
+end
+
+
+
+function pass = compare( ref, result, name )
+pass = 0;
+if numel(ref.TD.values) ~= numel(result.TD.values)
+    disp( ['compare error: dump=' name '  different number of timesteps'] );
+    return
+end
+for o=1:numel(ref.TD.values)
+    cmp_result = ref.TD.values{o} ~= result.TD.values{o};
+    if any(cmp_result(:))
+        disp( ['compare error: dump=' name '  timestep:' num2str(o) '=' ref.names{o}] );
+        return
+    end
+end
+pass = 1;
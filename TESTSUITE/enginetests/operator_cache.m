@@ -0,0 +1,181 @@
+function pass = operator_cache( openEMS_options, options )
+%pass = operator_cache( openEMS_options, options )
+%
+% Checks, if an operator restored from the cache file (--operator-cache) or
+% updated inside a box of changed geometry (--operator-update) produces results
+% identical to a freshly calculated operator, and if the cache is invalidated
+% for a changed geometry, mesh or settings
+
+CLEANUP = 1;        % if enabled and result is PASS, remove simulation folder
+STOP_IF_FAILED = 1; % if enabled and result is FAILED, stop with error
+SILENT = 0;         % 0=show openEMS output
+
+if nargin < 1
+    openEMS_options = '';
+end
+if nargin < 2
+    options = '';
+end
+if any(strcmp( options, 'run_testsuite' ))
+    STOP_IF_FAILED = 0;
+    SILENT = 1;
+end
+% clean openEMS_options
+openEMS_options = regexprep( openEMS_options, '--operator-cache=\S+', '' );
+openEMS_options = regexprep( openEMS_options, '--operator-update=\S+', '' );
+
+global Sim_Path Sim_CSX
+Sim_Path = 'tmp_operator_cache';
+Sim_CSX = 'operator_cache.xml';
+
+% the cache file is kept in the simulation folder for all runs
+[status,message,messageid] = rmdir(Sim_Path,'s');
+[status,message,messageid] = mkdir(Sim_Path);
+cache = ' -v --operator-cache=operator.cache ';
+% box containing the changed material (drawing units), see sim()
+update = ' --operator-update=10,2,10,35,16,40 ';
+
+% references without cache
+ref_A    = sim( 'A', 0, [' -v ' openEMS_options], SILENT );
+ref_B    = sim( 'B', 0, [' -v ' openEMS_options], SILENT );
+ref_mesh = sim( 'A', 1, [' -v ' openEMS_options], SILENT );
+
+% name, geometry, changed mesh, options, reference, expected and unexpected log messages
+runs = { ...
+    {'write',          'A', 0, cache,            ref_A,    {'Operator written to cache file'}, {'Operator restored from cache file'}}, ...
+    {'read',           'A', 0, cache,            ref_A,    {'Operator restored from cache file'}, {'Operator written to cache file', 'is outdated'}}, ...
+    {'geometry',       'B', 0, cache,            ref_B,    {'Geometry changed', 'Operator written to cache file'}, {'Operator restored from cache file'}}, ...
+    {'update',         'A', 0, [cache update],   ref_A,    {'Operator restored from cache file .* and updated inside 1 box'}, {'is outdated'}}, ...
+    {'mesh',           'A', 1, cache,            ref_mesh, {'Mesh or settings changed', 'Operator written to cache file'}, {'Operator restored from cache file'}}, ...
+    };
+
+pass = 1;
+for n=1:numel(runs)
+    r = runs{n};
+    result = sim( r{2}, r{3}, [r{4} openEMS_options], SILENT );
+    for m=1:numel(r{6})
+        if isempty( regexp( result.log, r{6}{m}, 'once' ) )
+            disp( ['log error: ' r{1} ': message "' r{6}{m} '" not found'] );
+            pass = 0;
+        end
+    end
+    for m=1:numel(r{7})
+        if ~isempty( regexp( result.log, r{7}{m}, 'once' ) )
+            disp( ['log error: ' r{1} ': unexpected message "' r{7}{m} '"'] );
+            pass = 0;
+        end
+    end
+    if ~compare( r{5}, result )
+        disp( ['compare error: ' r{1} ': the result differs from the freshly calculated operator'] );
+        pass = 0;
+    elseif ~SILENT
+        disp( [r{1} ': identical to the freshly calculated operator'] );
+    end
+end
+
+if pass
+    disp( 'enginetests/operator_cache.m (operator cache):  pass' );
+else
+    disp( 'enginetests/operator_cache.m (operator cache):  * FAILED *' );
+end
+
+if pass && CLEANUP
+    rmdir( Sim_Path, 's' );
+end
+if ~pass && STOP_IF_FAILED
+    error 'test failed'
+end
+
+return
+
+
+function result = sim( geometry, change_mesh, openEMS_options, SILENT )
+global Sim_Path Sim_CSX
+physical_constants;
+
+f_start = 1e9;
+f_stop = 10e9;
+
+% setup FDTD parameter
+FDTD = InitFDTD( 300, 0 );
+FDTD = SetGaussExcite(FDTD,(f_stop-f_start)/2,(f_stop-f_start)/2);
+BC = {'PEC' 'PEC' 'PMC' 'PEC' 'PEC' 'PEC'}; % boundaries
+FDTD = SetBoundaryCond(FDTD,BC);
+
+% setup CSXCAD geometry (drawing unit mm)
+CSX = InitCSX();
+mesh.x = linspace(0,50,26);
+mesh.y = linspace(0,20,11);
+mesh.z = linspace(0,60,31);
+if change_mesh
+    mesh.z = linspace(0,60,32);
+end
+CSX = DefineRectGrid(CSX, 1e-3, mesh);
+
+% excitation
+CSX = AddExcitation(CSX,'excite1',0,[1 1 1]);
+p(1,1) = mesh.x(floor(end*2/3));
+p(2,1) = mesh.y(floor(end*2/3));
+p(3,1) = mesh.z(floor(end*2/3));
+p(1,2) = mesh.x(floor(end*2/3)+1);
+p(2,2) = mesh.y(floor(end*2/3)+1);
+p(3,2) = mesh.z(floor(end*2/3)+1);
+CSX = AddCurve( CSX, 'excite1', 0, p );
+
+% unchanged material and metal
+CSX = AddMaterial( CSX, 'RO4350B', 'Epsilon', 3.66 );
+CSX = AddBox( CSX, 'RO4350B', 10, [30 0 40], [46 10 56] );
+CSX = AddMetal( CSX, 'metal' );
+CSX = AddBox( CSX, 'metal', 10, [4 2 4], [44 2 8] );
+
+% material changed between the geometries A and B, inside the update box
+if strcmp( geometry, 'A' )
+    CSX = AddMaterial( CSX, 'changed', 'Epsilon', 2.2, 'Kappa', 0.01 );
+else
+    CSX = AddMaterial( CSX, 'changed', 'Epsilon', 4.5, 'Kappa', 0.02 );
+end
+CSX = AddBox( CSX, 'changed', 10, [14 4 14], [30 14 34] );
+
+% dump
+CSX = AddDump( CSX, 'Et', 'DumpType', 0, 'DumpMode', 0, 'FileType', 1 ); % hdf5 E-field dump without interpolation
+pos1 = [mesh.x(1) mesh.y(1) mesh.z(1)];
+pos2 = [mesh.x(end) mesh.y(end) mesh.z(end)];
+CSX = AddBox( CSX, 'Et', 0, pos1, pos2 );
+
+CSX = AddDump( CSX, 'Ht', 'DumpType', 1, 'DumpMode', 0, 'FileType', 1 ); % hdf5 H-field dump without interpolation
+CSX = AddBox( CSX, 'Ht', 0, pos1, pos2 );
+
+% Write openEMS compatible xml-file
+WriteOpenEMS( [Sim_Path '/' Sim_CSX], FDTD, CSX );
+
+% cd to working dir and run openEMS
+folder = fileparts( mfilename('fullpath') );
+Settings.LogFile = [folder '/' Sim_Path '/openEMS.log'];
+Settings.Silent = SILENT;
+RunOpenEMS( Sim_Path, Sim_CSX, openEMS_options, Settings );
+
+% collect result
+result.E = ReadHDF5FieldData( [Sim_Path '/Et.h5'] );
+result.H = ReadHDF5FieldData( [Sim_Path '/Ht.h5'] );
+result.log = fileread( Settings.LogFile );
+
+
+
+function pass = compare( ref, result )
+pass = 0;
+EHfields = {'E','H'};
+for m=1:numel(EHfields)
+    EHfield = EHfields{m};
+    if numel(ref.(EHfield).TD.values) ~= numel(result.(EHfield).TD.values)
+        disp( ['compare error: field=' EHfield '  different number of timesteps'] );
+        return
+    end
+    for o=1:numel(ref.(EHfield).TD.values)
+        cmp_result = ref.(EHfield).TD.values{o} ~= result.(EHfield).TD.values{o};
+        if any(cmp_result(:))
+            disp( ['compare error: field=' EHfield '  timestep:' num2str(o) '=' ref.(EHfield).names{o}] );
+            return
+        end
+    end
+end
+pass = 1;
@@ -0,0 +1,145 @@
+function pass = sar_averaging( openEMS_options, options )
+%pass = sar_averaging( openEMS_options, options )
+%
+% Checks, if the averaged SAR using the summed volume tables matches the
+% reference of the direct summation (--sar-direct-summation), which is the
+% single threaded cell by cell summation of the former implementation.
+% The body consists of a muscle cube with a fat layer and a bone sphere, the
+% 1g SAR uses the IEEE_62704 method (incl. unused voxel), the 10g SAR uses the
+% IEEE_C95_3 method (incl. used voxel). The averaging time of both is reported.
+
+CLEANUP = 1;        % if enabled and result is PASS, remove simulation folder
+STOP_IF_FAILED = 1; % if enabled and result is FAILED, stop with error
+SILENT = 0;         % 0=show openEMS output
+
+if nargin < 1
+    openEMS_options = '';
+end
+if nargin < 2
+    options = '';
+end
+if any(strcmp( options, 'run_testsuite' ))
+    STOP_IF_FAILED = 0;
+    SILENT = 1;
+end
+% clean openEMS_options
+openEMS_options = regexprep( openEMS_options, '--disable-dumps', '' );
+openEMS_options = regexprep( openEMS_options, '--sar-direct-summation', '' );
+
+% LIMITS
+% max deviation of a single voxel relative to the max reference SAR, the
+% summed volume tables differ from the direct summation by rounding only
+max_deviation = 1e-5;
+
+global Sim_Path Sim_CSX
+Sim_Path = 'tmp_sar_averaging';
+Sim_CSX = 'sar_averaging.xml';
+
+dumps = {'SAR_1g' 'SAR_10g'};
+
+[result, time] = sim( [' -v ' openEMS_options], SILENT, dumps, 'summed volume tables' );
+[ref, time_ref] = sim( [' -v --sar-direct-summation ' openEMS_options], SILENT, dumps, 'direct summation' );
+
+pass = 1;
+if isnan(time) || isnan(time_ref)
+    disp( 'log error: the averaging time of the summed volume tables or of the direct summation was not found' );
+    pass = 0;
+end
+for n=1:numel(dumps)
+    SAR_ref = ref.(dumps{n});
+    SAR = result.(dumps{n});
+    max_SAR = max(SAR_ref(:));
+    deviation = abs(SAR - SAR_ref) / max_SAR;
+    if ~(max_SAR > 0) || any(isnan(SAR(:))) || any(size(SAR) ~= size(SAR_ref))
+        disp( ['compare error: dump=' dumps{n} '  invalid SAR'] );
+        pass = 0;
+    elseif any(deviation(:) > max_deviation)
+        disp( ['compare error: dump=' dumps{n} '  ' num2str(sum(deviation(:) > max_deviation)) ' voxel deviate, max deviation ' num2str(max(deviation(:))) ' of the max SAR'] );
+        pass = 0;
+    elseif ~SILENT
+        disp( ['dump ' dumps{n} ': max deviation ' num2str(max(deviation(:))) ' of the max SAR ' num2str(max_SAR) ' W/kg'] );
+    end
+end
+disp( ['averaging time: ' num2str(time) ' s (summed volume tables), ' num2str(time_ref) ' s (direct summation)'] );
+
+if pass
+    disp( 'enginetests/sar_averaging.m (SAR averaging):  pass' );
+else
+    disp( 'enginetests/sar_averaging.m (SAR averaging):  * FAILED *' );
+end
+
+if pass && CLEANUP
+    rmdir( Sim_Path, 's' );
+end
+if ~pass && STOP_IF_FAILED
+    error 'test failed'
+end
+
+return
+
+
+function [result, time] = sim( openEMS_options, SILENT, dumps, summation )
+global Sim_Path Sim_CSX
+
+f0 = 1e9;
+
+% prepare simulation dir
+[status,message,messageid] = rmdir(Sim_Path,'s');
+[status,message,messageid] = mkdir(Sim_Path);
+
+% setup FDTD parameter
+FDTD = InitFDTD( 2000, 1e-4 );
+FDTD = SetGaussExcite(FDTD,f0,f0/2);
+BC = {'MUR' 'MUR' 'MUR' 'MUR' 'MUR' 'MUR'}; % boundaries
+FDTD = SetBoundaryCond(FDTD,BC);
+
+% setup CSXCAD geometry (drawing unit mm)
+CSX = InitCSX();
+mesh.x = -30:2:30;
+mesh.y = -30:2:30;
+mesh.z = -30:2:30;
+CSX = DefineRectGrid(CSX, 1e-3, mesh);
+
+% excitation, a short soft source in front of the fat layer
+CSX = AddExcitation(CSX,'excite',0,[0 0 1]);
+CSX = AddBox(CSX,'excite',0,[-26 0 -10],[-26 0 10]);
+
+% inhomogeneous body: muscle cube with a fat layer and a bone sphere
+CSX = AddMaterial( CSX, 'muscle', 'Epsilon', 55, 'Kappa', 0.9, 'Density', 1040 );
+CSX = AddBox( CSX, 'muscle', 10, [-20 -20 -20], [20 20 20] );
+CSX = AddMaterial( CSX, 'fat', 'Epsilon', 5.5, 'Kappa', 0.05, 'Density', 920 );
+CSX = AddBox( CSX, 'fat', 20, [-20 -20 -20], [-12 20 20] );
+CSX = AddMaterial( CSX, 'bone', 'Epsilon', 12, 'Kappa', 0.1, 'Density', 1850 );
+CSX = AddSphere( CSX, 'bone', 30, [0 0 0], 8 );
+
+% averaged SAR dumps
+CSX = AddDump( CSX, 'SAR_1g', 'DumpType', 21, 'Frequency', f0, 'FileType', 1, 'SAR_Method', 'IEEE_62704' );
+CSX = AddBox( CSX, 'SAR_1g', 0, [-30 -30 -30], [30 30 30] );
+CSX = AddDump( CSX, 'SAR_10g', 'DumpType', 22, 'Frequency', f0, 'FileType', 1, 'SAR_Method', 'IEEE_C95_3' );
+CSX = AddBox( CSX, 'SAR_10g', 0, [-30 -30 -30], [30 30 30] );
+
+% Write openEMS compatible xml-file
+WriteOpenEMS( [Sim_Path '/' Sim_CSX], FDTD, CSX );
+
+% cd to working dir and run openEMS
+folder = fileparts( mfilename('fullpath') );
+Settings.LogFile = [folder '/' Sim_Path '/openEMS.log'];
+Settings.Silent = SILENT;
+RunOpenEMS( Sim_Path, Sim_CSX, openEMS_options, Settings );
+
+% collect result
+for n=1:numel(dumps)
+    SAR_field = ReadHDF5Dump( [Sim_Path '/' dumps{n} '.h5'] );
+    result.(dumps{n}) = SAR_field.FD.values{1};
+end
+
+% total averaging time of all dumps
+time = NaN;
+log = fileread( Settings.LogFile );
+tokens = regexp( log, ['Averaging time:\s*([\d\.eE+-]+) s \(' summation '\)'], 'tokens' );
+if numel(tokens) == numel(dumps)
+    time = 0;
+    for n=1:numel(tokens)
+        time = time + str2double( tokens{n}{1} );
+    end
+end
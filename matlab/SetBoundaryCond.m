@@ -8,6 +8,7 @@ function FDTD = SetBoundaryCond(FDTD, BC, varargin)
 %   1 = PMC      or  'PMC'
 %   2 = MUR-ABC  or  'MUR'
 %   3 = PML-ABC  or  'PML_x' with pml size x => 4..50
+%   4 = CPML-ABC or  'CPML_x' with pml size x => 4..50 (cartesian mesh only)
 % 
 % example:
 % BC = [ 1     1     0     0     2     3     ]  %using numbers or
@@ -29,6 +29,7 @@
 #include "FDTD/extensions/operator_ext_tfsf.h"
 #include "FDTD/extensions/operator_ext_mur_abc.h"
 #include "FDTD/extensions/operator_ext_upml.h"
+#include "FDTD/extensions/operator_ext_cpml.h"
 #include "FDTD/extensions/operator_ext_lorentzmaterial.h"
 #include "FDTD/extensions/operator_ext_conductingsheet.h"
 #include "FDTD/extensions/operator_ext_steadystate.h"
@@ -55,13 +56,6 @@
 
 using namespace std;
 
-double CalcDiffTime(timeval t1, timeval t2)
-{
-	double s_diff = t1.tv_sec - t2.tv_sec;
-	s_diff += (t1.tv_usec-t2.tv_usec)*1e-6;
-	return s_diff;
-}
-
 openEMS::openEMS()
 {
 	setlocale(LC_NUMERIC, "en_US.UTF-8");
@@ -77,6 +71,8 @@ openEMS::openEMS()
 	m_debugCSX = false;
 	m_debugBox = m_debugPEC = m_no_simulation = false;
 	m_DumpStats = false;
+	m_OverlapProcessing = false;
+	m_Estimate = false;
 	endCrit = 1e-6;
 	m_OverSampling = 4;
 	m_CellConstantMaterial=false;
@@ -143,6 +139,10 @@ void openEMS::showUsage()
 #endif
 	cout << "\t--numThreads=<n>\tForce use n threads for multithreaded engine (needs: --engine=multithreaded)" << endl;
 	cout << "\t--no-simulation\t\tonly run preprocessing; do not simulate" << endl;
+	cout << "\t--overlap-processing\tprocess field dumps and probes in the background while the engine continues" << endl;
+	cout << "\t--operator-cache=<file>\tcache the operator in <file> and reuse it for an unchanged geometry, mesh and settings" << endl;
+	cout << "\t--operator-update=<x1,y1,z1,x2,y2,z2>\tonly recalculate the cached operator inside the given box of changed geometry (needs: --operator-cache)" << endl;
+	cout << "\t--estimate\t\testimate the memory and runtime requirements and exit" << endl;
 	cout << "\t--dump-statistics\tdump simulation statistics to '" << __OPENEMS_RUN_STAT_FILE__ << "' and '" << __OPENEMS_STAT_FILE__ << "'" << endl;
 	cout << "\n\t Additional global arguments " << endl;
 	g_settings.ShowArguments(cout,"\t");
@@ -235,6 +235,36 @@ bool openEMS::parseCommandLineArgument( const char *argv )
 		m_no_simulation = true;
 		return true;
 	}
+	else if (strcmp(argv,"--overlap-processing")==0)
+	{
+		cout << "openEMS - overlap processing with the engine iteration" << endl;
+		m_OverlapProcessing = true;
+		return true;
+	}
+	else if (strncmp(argv,"--operator-cache=",17)==0)
+	{
+		SetOperatorCache(argv+17);
+		cout << "openEMS - using operator cache file: '" << m_OpCacheFile << "'" << endl;
+		return true;
+	}
+	else if (strncmp(argv,"--operator-update=",18)==0)
+	{
+		vector<double> box = SplitString2Double(argv+18,',');
+		if (box.size()!=6)
+		{
+			cerr << "openEMS::parseCommandLineArgument: Error, invalid operator update box: " << argv+18 << ", ignoring!" << endl;
+			return true;
+		}
+		AddOperatorUpdateBox(&box[0],&box[3]);
+		cout << "openEMS - operator update box: (" << box[0] << "," << box[1] << "," << box[2] << ") -> (" << box[3] << "," << box[4] << "," << box[5] << ")" << endl;
+		return true;
+	}
+	else if (strcmp(argv,"--estimate")==0)
+	{
+		cout << "openEMS - estimate the memory and runtime requirements only" << endl;
+		m_Estimate = true;
+		return true;
+	}
 	else if (strcmp(argv,"--dump-statistics")==0)
 	{
 		cout << "openEMS - dump simulation statistics to '" << __OPENEMS_RUN_STAT_FILE__ << "' and '" << __OPENEMS_STAT_FILE__ << "'" << endl;
@@ -300,6 +330,15 @@ void openEMS::WelcomeScreen()
 
 bool openEMS::SetupBoundaryConditions()
 {
+	//the cpml is only available for the cartesian operator, use the upml instead
+	if (dynamic_cast<Operator_Cylinder*>(FDTD_Op))
+		for (int n=0; n<6; ++n)
+			if (m_BC_type[n]==4)
+			{
+				cerr << "openEMS::SetupBoundaryConditions: Warning, the cpml is not available for cylindrical coordinates, using the upml instead..." << endl;
+				m_BC_type[n]=3;
+			}
+
 	FDTD_Op->SetBoundaryCondition(m_BC_type); //operator only knows about PEC and PMC, everything else is defined by extensions (see below)
 
 	/**************************** create all operator/engine extensions here !!!! **********************************/
@@ -315,7 +354,7 @@ bool openEMS::SetupBoundaryConditions()
 				op_ext_mur->SetPhaseVelocity(m_Mur_v_ph[n]);
 			FDTD_Op->AddExtension(op_ext_mur);
 		}
-		if (m_BC_type[n]==3)
+		if ((m_BC_type[n]==3) || (m_BC_type[n]==4))
 			FDTD_Op->SetBCSize(n, m_PML_size[n]);
 	}
 
@@ -323,6 +362,9 @@ bool openEMS::SetupBoundaryConditions()
 	//create the upml
 	Operator_Ext_UPML::Create_UPML(FDTD_Op, m_BC_type, m_PML_size, string());
 
+	//create the cpml
+	Operator_Ext_CPML::Create_CPML(FDTD_Op, m_BC_type, m_PML_size, string());
+
 	return true;
 }
 
@@ -370,6 +412,8 @@ bool openEMS::SetupProcessing()
 
 	unsigned int Nyquist = FDTD_Op->GetExcitationSignal()->GetNyquistNum();
 	PA = new ProcessingArray(Nyquist);
+	// independent processings run concurrently while the engine threads are waiting
+	PA->SetNumberOfThreads(m_engine_numThreads);
 
 	double start[3];
 	double stop[3];
@@ -572,6 +616,10 @@ bool openEMS::SetupProcessing()
 		}
 	}
 
+	// processings added after this point (e.g. the end-criteria processing) will not overlap with the engine
+	if (m_OverlapProcessing)
+		PA->SetOverlapProcessing(true);
+
 	return true;
 }
 
@@ -583,21 +631,48 @@ bool openEMS::SetupMaterialStorages()
 		CSPropDumpBox* db = DumpProps.at(i)->ToDumpBox();
 		if (!db)
 			continue;
-		if (db->GetQtyPrimitives()==0)
+		if ((db->GetQtyPrimitives()==0) || !Enable_Dumps)
 			continue;
-		//check for current density dump types
-		if ( ((db->GetDumpType()==2) || (db->GetDumpType()==12) || // current density storage
-			  (db->GetDumpType()==20) || (db->GetDumpType()==21) || (db->GetDumpType()==22)) && // SAR dump types
-			  Enable_Dumps )
-			FDTD_Op->SetMaterialStoreFlags(1,true); //tell operator to store kappa material data
-		if ( ((db->GetDumpType()==4) || (db->GetDumpType()==14)) || Enable_Dumps) // electric flux density storage
-			FDTD_Op->SetMaterialStoreFlags(0,true); //tell operator to store epsR material data
-		if ( ((db->GetDumpType()==5) || (db->GetDumpType()==15)) || Enable_Dumps) // magnetic flux density storage
-			FDTD_Op->SetMaterialStoreFlags(2,true); //tell operator to store mueR material data
+		bool store[4] = {false, false, false, false};
+		//check for current density dump types, the SAR dumps use the cell center conductivity and need no material storage
+		if ( (db->GetDumpType()==2) || (db->GetDumpType()==12)) // current density storage
+			store[1] = true; //tell operator to store kappa material data
+		if ( (db->GetDumpType()==4) || (db->GetDumpType()==14)) // electric flux density storage
+			store[0] = true; //tell operator to store epsR material data
+		if ( (db->GetDumpType()==5) || (db->GetDumpType()==15)) // magnetic flux density storage
+			store[2] = true; //tell operator to store mueR material data
+
+		// store the material data only inside the dump regions
+		for (size_t nb=0; nb<db->GetQtyPrimitives(); ++nb)
+		{
+			CSPrimitives* prim = db->GetPrimitive(nb);
+			double bnd[6] = {0,0,0,0,0,0};
+			if (prim->GetBoundBox(bnd,true)==false)
+				continue;
+			double start[3] = {bnd[0],bnd[2],bnd[4]};
+			double stop[3] = {bnd[1],bnd[3],bnd[5]};
+			unsigned int uiStart[3], uiStop[3];
+			if (FDTD_Op->SnapBox2Mesh(start, stop, uiStart, uiStop)<0)
+				continue;
+			for (int n=0; n<4; ++n)
+				if (store[n])
+				{
+					FDTD_Op->SetMaterialStoreFlags(n,true);
+					FDTD_Op->AddMaterialStorageRegion(n, uiStart, uiStop);
+				}
+		}
 	}
 	return true;
 }
 
+void openEMS::AddOperatorUpdateBox(const double start[3], const double stop[3])
+{
+	for (int n=0; n<3; ++n)
+		m_OpUpdateBoxes.push_back(start[n]);
+	for (int n=0; n<3; ++n)
+		m_OpUpdateBoxes.push_back(stop[n]);
+}
+
 void openEMS::SetupCylinderMultiGrid(std::string val)
 {
 	m_CC_MultiGrid.clear();
@@ -658,11 +733,19 @@ void openEMS::Set_BC_PML(int idx, unsigned int size)
 	m_PML_size[idx] = size;
 }
 
+void openEMS::Set_BC_CPML(int idx, unsigned int size)
+{
+	if ((idx<0) || (idx>5))
+		return;
+	m_BC_type[idx] = 4;
+	m_PML_size[idx] = size;
+}
+
 int openEMS::Get_PML_Size(int idx)
 {
 	if ((idx<0) || (idx>5))
 		return -1;
-	if (m_BC_type[idx]!=3)
+	if ((m_BC_type[idx]!=3) && (m_BC_type[idx]!=4))
 		return -1; // return -1 if BC was *not* a PML
 	return m_PML_size[idx];
 }
@@ -791,6 +874,8 @@ bool openEMS::Parse_XML_FDTDSetup(TiXmlElement* FDTD_Opts)
 				this->Set_BC_Type(n, 1);
 			else if (s_bc=="MUR")
 				this->Set_BC_Type(n, 2);
+			else if (strncmp(s_bc.c_str(),"CPML_",5)==0)
+				this->Set_BC_CPML(n, atoi(s_bc.c_str()+5));
 			else if (strncmp(s_bc.c_str(),"PML_=",4)==0)
 				this->Set_BC_PML(n, atoi(s_bc.c_str()+4));
 			else
@@ -954,6 +1039,9 @@ int openEMS::SetupFDTD()
 	SetupBoundaryConditions();
 
 	FDTD_Op->SetTimeStepMethod(m_TS_method);
+	FDTD_Op->SetOperatorCacheFile(m_OpCacheFile);
+	for (size_t n=0; n+5<m_OpUpdateBoxes.size(); n+=6)
+		FDTD_Op->AddOperatorUpdateBox(&m_OpUpdateBoxes[n],&m_OpUpdateBoxes[n+3]);
 
 	if (m_TS>0)
 		FDTD_Op->SetTimestep(m_TS);
@@ -999,6 +1087,12 @@ int openEMS::SetupFDTD()
 	//check all properties to request material storage during operator creation...
 	SetupMaterialStorages();
 
+	if (m_Estimate)
+	{
+		ShowEstimate();
+		return 1;
+	}
+
 	/*******************   create the EC-FDTD operator *****************************/
 	Operator::DebugFlags debugFlags = Operator::None;
 	if (DebugMat)
@@ -1109,6 +1203,182 @@ string FormatTime(int sec)
 	return ss.str();
 }
 
+static string FormatMemory(double bytes)
+{
+	stringstream ss;
+	ss << fixed << setprecision(1);
+	if (bytes<1024.0*1024.0)
+		ss << bytes/1024.0 << " KiB";
+	else if (bytes<1024.0*1024.0*1024.0)
+		ss << bytes/1024.0/1024.0 << " MiB";
+	else
+		ss << bytes/1024.0/1024.0/1024.0 << " GiB";
+	return ss.str();
+}
+
+void openEMS::ShowEstimate()
+{
+	cout << "------- Estimated memory requirements -------" << endl;
+	double setup = FDTD_Op->EstimateSetupMemory();
+	cout << "Equivalent circuit (setup only)\t: " << FormatMemory(setup) << endl;
+
+	double coeff = FDTD_Op->EstimateCoefficientMemory(true);
+	double coeffFull = FDTD_Op->EstimateCoefficientMemory(false);
+	if (coeff<coeffFull)
+	{
+		cout << "Operator (uncompressed)\t\t: " << FormatMemory(coeffFull) << " (not allocated)" << endl;
+		cout << "Operator (compressed)\t\t: " << FormatMemory(coeff) << " + unique coefficient table" << endl;
+	}
+	else
+		cout << "Operator\t\t\t: " << FormatMemory(coeff) << endl;
+
+	double material = 0;
+	for (int n=0; n<4; ++n)
+		if (FDTD_Op->GetMaterialStoreFlag(n))
+			material += FDTD_Op->GetMaterialStorageSize(n);
+	if (material>0)
+		cout << "Material storage\t\t: " << FormatMemory(material) << endl;
+
+	double extensions = 0;
+	for (size_t n=0; n<FDTD_Op->GetNumberOfExtentions(); ++n)
+	{
+		Operator_Extension* op_ext = FDTD_Op->GetExtension(n);
+		double extMem = op_ext->EstimateMemory();
+		cout << op_ext->GetExtensionName() << "\t: " << FormatMemory(extMem) << endl;
+		extensions += extMem;
+	}
+
+	double fields = FDTD_Op->EstimateFieldMemory();
+	cout << "Fields (voltages and currents)\t: " << FormatMemory(fields) << endl;
+
+	// time domain dumps need a temporary copy of the dumped field, frequency domain dumps accumulate every frequency
+	double dumps = 0;
+	vector<CSProperties*> DumpProps = m_CSX->GetPropertyByType(CSProperties::DUMPBOX);
+	for (size_t i=0; (i<DumpProps.size()) && Enable_Dumps; ++i)
+	{
+		CSPropDumpBox* db = DumpProps.at(i)->ToDumpBox();
+		if (db==NULL)
+			continue;
+		for (size_t nb=0; nb<db->GetQtyPrimitives(); ++nb)
+		{
+			CSPrimitives* prim = db->GetPrimitive(nb);
+			double bnd[6] = {0,0,0,0,0,0};
+			if ((prim==NULL) || (prim->GetBoundBox(bnd,true)==false))
+				continue;
+			double start[3] = {bnd[0],bnd[2],bnd[4]};
+			double stop[3] = {bnd[1],bnd[3],bnd[5]};
+			unsigned int uiStart[3], uiStop[3];
+			if (FDTD_Op->SnapBox2Mesh(start, stop, uiStart, uiStop)<0)
+				continue;
+			double boxCells = 1;
+			for (int n=0; n<3; ++n)
+			{
+				double lines = (double)uiStop[n]-(double)uiStart[n]+1;
+				if (db->GetSubSampling() && (db->GetSubSampling(n)>1))
+					lines = ceil(lines/db->GetSubSampling(n));
+				boxCells *= lines;
+			}
+			double numFreq = db->GetFDSamples()->size();
+			double dumpMem = 0;
+			if (db->GetDumpType()<10)
+				dumpMem = 3.0*boxCells*sizeof(float);
+			else if (db->GetDumpType()<20)
+				dumpMem = numFreq*3.0*boxCells*sizeof(std::complex<float>);
+			else
+				// electric field and current density accumulation plus the temporary SAR arrays
+				dumpMem = 2.0*numFreq*3.0*boxCells*sizeof(std::complex<float>) + 4.0*boxCells*sizeof(float);
+			cout << "Dump '" << db->GetName() << "'\t\t: " << FormatMemory(dumpMem) << endl;
+			dumps += dumpMem;
+		}
+	}
+
+	cout << "Estimated peak memory\t\t: " << FormatMemory(coeff + material + extensions + max(setup, fields + dumps)) << endl;
+
+	cout << "------- Estimated runtime -------" << endl;
+	double dT = m_TS;
+	if (dT<=0)
+	{
+		// Courant criterion for vacuum using the smallest edge length in each direction
+		double sum = 0;
+		for (int n=0; n<3; ++n)
+		{
+			int nPP = (n+2)%3;
+			double minLength = 0;
+			unsigned int pos[3] = {0,0,0};
+			for (pos[n]=0; pos[n]+1<FDTD_Op->GetNumberOfLines(n,true); ++pos[n])
+				for (pos[nPP]=0; pos[nPP]<FDTD_Op->GetNumberOfLines(nPP,true); ++pos[nPP])
+				{
+					double length = FDTD_Op->GetEdgeLength(n,pos);
+					if ((length>0) && ((minLength==0) || (length<minLength)))
+						minLength = length;
+				}
+			if (minLength>0)
+				sum += 1.0/minLength/minLength;
+		}
+		dT = m_TS_fac/(__C0__*sqrt(sum));
+	}
+	double numTS = NrTS;
+	if (m_maxTime>0)
+		numTS = min(numTS, floor(m_maxTime/dT));
+	cout << "Estimated timestep\t\t: " << dT << " s" << (m_TS>0 ? "" : " (vacuum Courant limit)") << endl;
+	cout << "Max. number of timesteps\t: " << numTS << endl;
+
+	double speed = CalibrateEngineSpeed();
+	cout << "Calibrated engine speed\t\t: " << speed/1e6 << " MC/s" << endl;
+	cout << "Estimated max. runtime\t\t: " << FormatTime((int)(FDTD_Op->GetNumberCells()*numTS/speed)) << endl;
+	cout << "---------------------------------------------" << endl;
+}
+
+double openEMS::CalibrateEngineSpeed()
+{
+	// a vacuum domain of up to 64 lines in each direction
+	ContinuousStructure csx;
+	CSRectGrid* grid = csx.GetGrid();
+	for (int n=0; n<3; ++n)
+	{
+		unsigned int numLines = min(FDTD_Op->GetNumberOfLines(n,true), (unsigned int)64);
+		for (unsigned int i=0; i<max(numLines,(unsigned int)2); ++i)
+			grid->AddDiscLine(n, i);
+	}
+
+	// the cylindrical operators are benchmarked with the cartesian operator of the same engine
+	Operator* op = NULL;
+	if (m_engine == EngineType_Basic)
+		op = Operator::New();
+	else if (m_engine == EngineType_SSE)
+		op = Operator_sse::New();
+	else if (m_engine == EngineType_SSE_Compressed)
+		op = Operator_SSE_Compressed::New();
+	else
+		op = Operator_Multithread::New(m_engine_numThreads);
+
+	g_settings.SetTempVerboseLevel(0);
+	op->SetExcitationSignal(m_Exc);
+	op->SetGeometryCSX(&csx);
+	op->CalcECOperator();
+	Engine* eng = op->CreateEngine();
+	g_settings.RestoreVerboseLevel();
+
+	// warm up, then iterate for about one second
+	eng->IterateTS(1);
+	timeval startTime, currTime;
+	gettimeofday(&startTime,NULL);
+	unsigned int numTS = 0;
+	double t_diff = 0;
+	while ((t_diff<1.0) && (numTS<10000))
+	{
+		eng->IterateTS(10);
+		numTS += 10;
+		gettimeofday(&currTime,NULL);
+		t_diff = CalcDiffTime(currTime,startTime);
+	}
+	double speed = op->GetNumberCells()*numTS/t_diff;
+
+	delete eng;
+	delete op;
+	return speed;
+}
+
 bool openEMS::CheckAbortCond()
 {
 	if (m_Abort) //abort was set externally
@@ -77,6 +77,14 @@ public:
 	void SetMaxTime(double val) {m_maxTime=val;}
 
 	void SetNumberOfThreads(int val);
+	//! Overlap field dumps and probes with the engine iteration, using a snapshot of the processed fields
+	void SetOverlapProcessing(bool val) {m_OverlapProcessing=val;}
+	//! Cache the operator in the given file and reuse it as long as geometry, mesh and settings are unchanged
+	void SetOperatorCache(std::string file) {m_OpCacheFile=file;}
+	//! Add a box (in drawing units) of changed geometry, the cached operator is only recalculated inside all given boxes
+	void AddOperatorUpdateBox(const double start[3], const double stop[3]);
+	//! Only estimate the memory and runtime requirements during SetupFDTD, neither the operator nor the engine are created
+	void SetEstimate(bool val) {m_Estimate=val;}
 
 	void DebugMaterial() {DebugMat=true;}
 	void DebugOperator() {DebugOp=true;}
@@ -87,6 +95,8 @@ public:
 	void Set_BC_Type(int idx, int type);
 	int Get_BC_Type(int idx);
 	void Set_BC_PML(int idx, unsigned int size);
+	//! Set a convolutional pml with the given size, only available for the cartesian mesh
+	void Set_BC_CPML(int idx, unsigned int size);
 	int Get_PML_Size(int idx);
 	void Set_Mur_PhaseVel(int idx, double val);
 
@@ -134,6 +144,10 @@ protected:
 	bool m_debugCSX;
 	bool m_DumpStats;
 	bool m_debugBox, m_debugPEC, m_no_simulation;
+	bool m_OverlapProcessing;
+	bool m_Estimate;
+	std::string m_OpCacheFile;
+	std::vector<double> m_OpUpdateBoxes;
 
 	double endCrit;
 	int m_OverSampling;
@@ -170,6 +184,11 @@ protected:
 	//! Setup all processings.
 	virtual bool SetupProcessing();
 
+	//! Show the estimated memory per component and the estimated runtime of the simulation
+	virtual void ShowEstimate();
+	//! Run the selected engine on a small vacuum domain, returns the speed in cells per second
+	double CalibrateEngineSpeed();
+
 	//! Dump statistics to file
 	virtual bool DumpStatistics(const std::string& filename, double time);
 
@@ -40,10 +40,15 @@ cdef extern from "openEMS/openems.h":
         void SetMaxTime(double val)
 
         void SetNumberOfThreads(int val)
+        void SetOverlapProcessing(bool val)
+        void SetOperatorCache(string file)
+        void AddOperatorUpdateBox(double start[3], double stop[3])
+        void SetEstimate(bool val)
 
         void Set_BC_Type(int idx, int _type)
         int Get_BC_Type(int idx)
         void Set_BC_PML(int idx, unsigned int size)
+        void Set_BC_CPML(int idx, unsigned int size)
         int Get_PML_Size(int idx)
         void Set_Mur_PhaseVel(int idx, double val)
 
@@ -133,6 +133,23 @@ cdef class openEMS:
         """
         self.thisptr.SetOverSampling(val)
 
+    def AddOperatorUpdateBox(self, start, stop):
+        """ AddOperatorUpdateBox(start, stop)
+
+        Add a box of changed geometry (in drawing units). If an operator cache
+        is used (see Run), the cached operator is only recalculated inside all
+        given boxes.
+
+        :param start, stop: (3,) array -- box start and stop coordinates
+        """
+        assert len(start)==3 and len(stop)==3, 'AddOperatorUpdateBox: invalid box'
+        cdef double _start[3]
+        cdef double _stop[3]
+        for n in range(3):
+            _start[n] = start[n]
+            _stop[n]  = stop[n]
+        self.thisptr.AddOperatorUpdateBox(_start, _stop)
+
     def SetCellConstantMaterial(self, val):
         """ SetCellConstantMaterial(val)
 
@@ -271,6 +288,7 @@ cdef class openEMS:
         * 1 or 'PMC' : perfect magnetic conductor, useful for symmetries
         * 2 or 'MUR' : simple MUR absorbing boundary conditions
         * 3 or 'PML-8' : PML absorbing boundary conditions
+        * 4 or 'CPML_8' : convolutional PML absorbing boundary conditions (cartesian mesh only)
 
         :param BC: (8,) array or list -- see options above
         """
@@ -283,6 +301,10 @@ cdef class openEMS:
             if BC[n] in ['PEC', 'PMC', 'MUR']:
                 self.thisptr.Set_BC_Type(n, ['PEC', 'PMC', 'MUR'].index(BC[n]))
                 continue
+            if BC[n].startswith('CPML_'):
+                size = int(BC[n][5:])
+                self.thisptr.Set_BC_CPML(n, size)
+                continue
             if BC[n].startswith('PML_'):
                 size = int(BC[n].strip('PML_'))
                 self.thisptr.Set_BC_PML(n, size)
@@ -381,7 +403,7 @@ cdef class openEMS:
                 mirror[n]    = 2  # PMC mirror
             elif BC_type[n]==2:
                 BC_size[n] = 2
-            elif BC_type[n]==3:
+            elif BC_type[n]==3 or BC_type[n]==4:
                 BC_size[n] = self.thisptr.Get_PML_Size(n)+1
 
         if start is None or stop is None:
@@ -460,6 +482,9 @@ cdef class openEMS:
 
         Additional keyword parameter:
         :param numThreads: int -- set the number of threads (default 0 --> max)
+        :param overlapProcessing: bool -- process field dumps and probes in the background while the engine continues
+        :param operatorCache: str -- cache the operator in this file and reuse it for an unchanged geometry, mesh and settings
+        :param estimate: bool -- only estimate the memory and runtime requirements, the simulation is not run
         """
         if cleanup and os.path.exists(sim_path):
             shutil.rmtree(sim_path, ignore_errors=True)
@@ -486,11 +511,19 @@ cdef class openEMS:
                 self.thisptr.DebugCSX()
         if 'numThreads' in kw:
             self.thisptr.SetNumberOfThreads(int(kw['numThreads']))
+        if 'overlapProcessing' in kw:
+            self.thisptr.SetOverlapProcessing(bool(kw['overlapProcessing']))
+        if 'operatorCache' in kw:
+            self.thisptr.SetOperatorCache(kw['operatorCache'].encode('UTF-8'))
+        estimate = bool(kw.get('estimate', False))
+        self.thisptr.SetEstimate(estimate)
         assert os.getcwd() == os.path.realpath(sim_path)
         _openEMS.WelcomeScreen()
         cdef int EC
         with nogil:
             EC = self.thisptr.SetupFDTD()
+        if estimate:
+            return 0
         if EC!=0:
             print('Run: Setup failed, error code: {}'.format(EC))
         if setup_only or EC!=0:
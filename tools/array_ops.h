@@ -211,4 +211,26 @@ void Dump_N_3DArray2File(std::ostream &file, T**** array, const unsigned int* nu
 	}
 }
 
+//! Write the raw binary data of a N_3DArray to a stream, \a numZ is the number of elements in z-direction (e.g. for vector arrays)
+template <typename T>
+bool Write_N_3DArray2Stream(std::ostream &file, T**** array, const unsigned int* numLines, unsigned int numZ)
+{
+	for (int n=0; n<3; ++n)
+		for (unsigned int x=0; x<numLines[0]; ++x)
+			for (unsigned int y=0; y<numLines[1]; ++y)
+				file.write((const char*)array[n][x][y], sizeof(T)*numZ);
+	return file.good();
+}
+
+//! Read the raw binary data of a N_3DArray from a stream \sa Write_N_3DArray2Stream
+template <typename T>
+bool Read_N_3DArrayFromStream(std::istream &file, T**** array, const unsigned int* numLines, unsigned int numZ)
+{
+	for (int n=0; n<3; ++n)
+		for (unsigned int x=0; x<numLines[0]; ++x)
+			for (unsigned int y=0; y<numLines[1]; ++y)
+				file.read((char*)array[n][x][y], sizeof(T)*numZ);
+	return file.good();
+}
+
 #endif // ARRAY_OPS_H
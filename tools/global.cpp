@@ -28,6 +28,8 @@ Global::Global()
 {
 	m_showProbeDiscretization = false;
 	m_nativeFieldDumps = false;
+	m_foldDispersiveADE = false;
+	m_SARDirectSummation = false;
 	m_VerboseLevel = 0;
 }
 
@@ -35,6 +37,8 @@ void Global::ShowArguments(ostream& ostr, string front)
 {
 	ostr << front << "--showProbeDiscretization\tShow probe discretization information" << endl;
 	ostr << front << "--nativeFieldDumps\t\tDump all fields using the native field components" << endl;
+	ostr << front << "--fold-dispersive\t\tUpdate dispersive materials within the main update (compressed sse engines)" << endl;
+	ostr << front << "--sar-direct-summation		Average the SAR by a single threaded direct summation (reference, slow)" << endl;
 	ostr << front << "-v,-vv,-vvv\t\t\tSet debug level: 1 to 3" << endl;
 }
 
@@ -56,6 +60,18 @@ bool Global::parseCommandLineArgument( const char *argv )
 		m_nativeFieldDumps = true;
 		return true;
 	}
+	else if (strcmp(argv,"--fold-dispersive")==0)
+	{
+		cout << "openEMS - updating dispersive materials within the main update" << endl;
+		m_foldDispersiveADE = true;
+		return true;
+	}
+	else if (strcmp(argv,"--sar-direct-summation")==0)
+	{
+		cout << "openEMS - averaging the SAR by a direct summation" << endl;
+		m_SARDirectSummation = true;
+		return true;
+	}
 	else if (strcmp(argv,"-v")==0)
 	{
 		cout << "openEMS - verbose level 1" << endl;
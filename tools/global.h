@@ -44,6 +44,16 @@ public:
 	//! Set dumps to use native fields.
 	void SetNativeFieldDumps(bool val) {m_nativeFieldDumps=val;}
 
+	//! Returns true if dispersive materials should be updated within the main update of the compressed engines
+	bool FoldDispersiveADE() const {return m_foldDispersiveADE;}
+	//! Enable or disable the dispersive update within the main update
+	void SetFoldDispersiveADE(bool val) {m_foldDispersiveADE=val;}
+
+	//! Returns true if the SAR averaging should use the direct summation (single threaded reference of the summed volume tables)
+	bool SARDirectSummation() const {return m_SARDirectSummation;}
+	//! Enable or disable the direct summation of the SAR averaging
+	void SetSARDirectSummation(bool val) {m_SARDirectSummation=val;}
+
 	//! Set the verbose level
 	void SetVerboseLevel(int level) {m_VerboseLevel=level;m_SavedVerboseLevel=level;}
 	//! Get the verbose level
@@ -57,6 +67,8 @@ public:
 protected:
 	bool m_showProbeDiscretization;
 	bool m_nativeFieldDumps;
+	bool m_foldDispersiveADE;
+	bool m_SARDirectSummation;
 	int m_VerboseLevel;
 	int m_SavedVerboseLevel;
 };
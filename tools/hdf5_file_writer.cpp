@@ -19,14 +19,19 @@ using namespace std;
 
 #include "hdf5_file_writer.h"
 #include <boost/algorithm/string.hpp>
+#include <boost/thread/mutex.hpp>
 #include <hdf5.h>
 
 #include <sstream>
 #include <iostream>
 #include <iomanip>
 
+// the hdf5 library is usually not build thread-safe, serialize all access by concurrent processings
+static boost::mutex g_HDF5_Mutex;
+
 HDF5_File_Writer::HDF5_File_Writer(string filename)
 {
+	boost::mutex::scoped_lock lock(g_HDF5_Mutex);
 	m_filename = filename;
 	m_Group = "/";
 	hid_t hdf5_file = H5Fcreate(m_filename.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
@@ -95,6 +100,8 @@ void HDF5_File_Writer::SetCurrentGroup(std::string group, bool createGrp)
 	if (createGrp==false)
 		return;
 
+	boost::mutex::scoped_lock lock(g_HDF5_Mutex);
+
 	hid_t hdf5_file = H5Fopen( m_filename.c_str(), H5F_ACC_RDWR, H5P_DEFAULT );
 	if (hdf5_file<0)
 	{
@@ -126,6 +133,7 @@ bool HDF5_File_Writer::WriteRectMesh(unsigned int const* numLines, double const*
 
 bool HDF5_File_Writer::WriteRectMesh(unsigned int const* numLines, float const* const* discLines, int MeshType, float scaling)
 {
+	boost::mutex::scoped_lock lock(g_HDF5_Mutex);
 	hid_t hdf5_file = H5Fopen( m_filename.c_str(), H5F_ACC_RDWR, H5P_DEFAULT );
 	if (hdf5_file<0)
 	{
@@ -389,6 +397,7 @@ bool HDF5_File_Writer::WriteData(std::string dataSetName, double const* field_bu
 
 bool HDF5_File_Writer::WriteData(std::string dataSetName,  hid_t mem_type, void const* field_buf, size_t dim, size_t* datasize)
 {
+	boost::mutex::scoped_lock lock(g_HDF5_Mutex);
 	hid_t hdf5_file = H5Fopen( m_filename.c_str(), H5F_ACC_RDWR, H5P_DEFAULT );
 	if (hdf5_file<0)
 	{
@@ -428,6 +437,7 @@ bool HDF5_File_Writer::WriteData(std::string dataSetName,  hid_t mem_type, void
 
 bool HDF5_File_Writer::WriteAtrribute(std::string locName, std::string attr_name, void const* value, hsize_t size, hid_t mem_type)
 {
+	boost::mutex::scoped_lock lock(g_HDF5_Mutex);
 	hid_t hdf5_file = H5Fopen( m_filename.c_str(), H5F_ACC_RDWR, H5P_DEFAULT );
 	if (hdf5_file<0)
 	{
@@ -21,20 +21,37 @@
 #include "cfloat"
 #include "array_ops.h"
 #include "global.h"
+#include "useful.h"
+
+#include <boost/thread.hpp>
 
 using namespace std;
 
 SAR_Calculation::SAR_Calculation()
 {
+	m_SAR = NULL;
 	m_Vx_Used = NULL;
 	m_Vx_Valid = NULL;
 	m_DebugLevel = 0;
+	m_numThreads = 0;
+	m_DirectSummation = false;
+	m_SVT_Mass = NULL;
+	m_SVT_Volume = NULL;
+	m_SVT_BG_Volume = NULL;
+	m_SVT_Power = NULL;
+	m_SVT_Material = NULL;
 	SetAveragingMethod(SIMPLE, true);
 	Reset();
 }
 
+SAR_Calculation::~SAR_Calculation()
+{
+	Reset();
+}
+
 void SAR_Calculation::Reset()
 {
+	ClearSummedVolumeTables();
 	Delete3DArray(m_Vx_Used,m_numLines);
 	m_Vx_Used = NULL;
 	Delete3DArray(m_Vx_Valid,m_numLines);
@@ -116,6 +133,7 @@ void SAR_Calculation::SetAveragingMethod(SARAveragingMethod method, bool silent)
 
 void SAR_Calculation::SetNumLines(unsigned int numLines[3])
 {
+	ClearSummedVolumeTables();
 	Delete3DArray(m_Vx_Used,m_numLines);
 	m_Vx_Used = NULL;
 	Delete3DArray(m_Vx_Valid,m_numLines);
@@ -127,6 +145,7 @@ void SAR_Calculation::SetNumLines(unsigned int numLines[3])
 
 void SAR_Calculation::SetCellWidth(float* cellWidth[3])
 {
+	ClearSummedVolumeTables();
 	for (int n=0;n<3;++n)
 		m_cellWidth[n]=cellWidth[n];
 }
@@ -181,7 +200,7 @@ double SAR_Calculation::CalcSARPower()
 	return power;
 }
 
-double SAR_Calculation::CalcLocalPowerDensity(unsigned int pos[3])
+double SAR_Calculation::CalcLocalPowerDensity(unsigned int pos[3]) const
 {
 	double l_pow=0;
 	if (m_cell_conductivity==NULL)
@@ -230,7 +249,7 @@ float*** SAR_Calculation::CalcLocalSAR(float*** SAR)
 }
 
 int SAR_Calculation::FindFittingCubicalMass(unsigned int pos[3], float box_size, unsigned int start[3], unsigned int stop[3],
-					float partial_start[3], float partial_stop[3], double &mass, double &volume, double &bg_ratio, int disabledFace, bool ignoreFaceValid)
+					float partial_start[3], float partial_stop[3], double &mass, double &volume, double &bg_ratio, int disabledFace, bool ignoreFaceValid) const
 {
 	unsigned int mass_iterations = 0;
 	double old_mass=0;
@@ -291,7 +310,7 @@ int SAR_Calculation::FindFittingCubicalMass(unsigned int pos[3], float box_size,
 }
 
 bool SAR_Calculation::GetCubicalMass(unsigned int pos[3], double box_size, unsigned int start[3], unsigned int stop[3],
-									 float partial_start[3], float partial_stop[3], double &mass, double &volume, double &bg_ratio, int disabledFace)
+									 float partial_start[3], float partial_stop[3], double &mass, double &volume, double &bg_ratio, int disabledFace) const
 {
 	if ((box_size<=0) || std::isnan(box_size) || std::isinf(box_size))
 	{
@@ -366,174 +385,180 @@ bool SAR_Calculation::GetCubicalMass(unsigned int pos[3], double box_size, unsig
 			face_valid=false;
 	}
 
-	mass = 0;
-	volume = 0;
-	double bg_volume=0;
-	double weight[3];
-	unsigned int f_pos[3];
-	bool face_intersect[6] = {false,false,false,false,false,false};
-	for (f_pos[0]=start[0];f_pos[0]<=stop[0];++f_pos[0])
+	double bg_volume;
+	if (m_DirectSummation)
 	{
-		weight[0]=1;
-		if (f_pos[0]==start[0])
-			weight[0]*=abs(partial_start[0]);
-		if (f_pos[0]==stop[0])
-			weight[0]*=abs(partial_stop[0]);
-
-		for (f_pos[1]=start[1];f_pos[1]<=stop[1];++f_pos[1])
-		{
-			weight[1]=1;
-			if (f_pos[1]==start[1])
-				weight[1]*=abs(partial_start[1]);
-			if (f_pos[1]==stop[1])
-				weight[1]*=abs(partial_stop[1]);
-
-			for (f_pos[2]=start[2];f_pos[2]<=stop[2];++f_pos[2])
-			{
-				weight[2]=1;
-				if (f_pos[2]==start[2])
-					weight[2]*=abs(partial_start[2]);
-				if (f_pos[2]==stop[2])
-					weight[2]*=abs(partial_stop[2]);
+		if (DirectSumMass(start, stop, partial_start, partial_stop, mass, volume, bg_volume)==false)
+			face_valid=false;
+		bg_ratio = bg_volume/volume;
+		return face_valid;
+	}
 
-				mass += CellMass(f_pos)*weight[0]*weight[1]*weight[2];
-				volume += CellVolume(f_pos)*weight[0]*weight[1]*weight[2];
+	mass = WeightedSumBox(m_SVT_Mass, start, stop, partial_start, partial_stop);
+	volume = WeightedSumBox(m_SVT_Volume, start, stop, partial_start, partial_stop);
+	bg_volume = WeightedSumBox(m_SVT_BG_Volume, start, stop, partial_start, partial_stop);
 
-				if (m_cell_density[f_pos[0]][f_pos[1]][f_pos[2]]==0)
-					bg_volume += CellVolume(f_pos)*weight[0]*weight[1]*weight[2];
-				else
-				{
-					for (int n=0;n<3;++n)
-					{
-						if (start[n]==f_pos[n])
-							face_intersect[2*n]=true;
-						if (stop[n]==f_pos[n])
-							face_intersect[2*n+1]=true;
-					}
-				}
-			}
+	//check if all bounds have intersected a material boundary
+	unsigned int face_start[3];
+	unsigned int face_stop[3];
+	for (int n=0;n<3;++n)
+	{
+		for (int m=0;m<3;++m)
+		{
+			face_start[m]=start[m];
+			face_stop[m]=stop[m];
 		}
+		face_stop[n]=start[n];
+		if (SumBox(m_SVT_Material, face_start, face_stop)==0)
+			face_valid=false;
+		face_start[n]=stop[n];
+		face_stop[n]=stop[n];
+		if (SumBox(m_SVT_Material, face_start, face_stop)==0)
+			face_valid=false;
 	}
-	//check if all bounds have intersected a material boundary
-	for (int n=0;n<6;++n)
-		face_valid *= face_intersect[n];
 
 	bg_ratio = bg_volume/volume;
 
 	return face_valid;
 }
 
-float SAR_Calculation::CalcCubicalSAR(float*** SAR, unsigned int pos[3], unsigned int start[3], unsigned int stop[3], float partial_start[3], float partial_stop[3], bool assignUsed)
+float SAR_Calculation::CalcCubicalSAR(float*** SAR, unsigned int pos[3], unsigned int start[3], unsigned int stop[3], float partial_start[3], float partial_stop[3]) const
 {
-	double power_mass=0;
-	double mass=0;
-	double weight[3];
-	unsigned int f_pos[3];
-	for (f_pos[0]=start[0];f_pos[0]<=stop[0];++f_pos[0])
+	double mass;
+	double power_mass;
+	if (m_DirectSummation)
+		DirectSumPower(start, stop, partial_start, partial_stop, mass, power_mass);
+	else
 	{
-		weight[0]=1;
-		if (f_pos[0]==start[0])
-			weight[0]*=abs(partial_start[0]);
-		if (f_pos[0]==stop[0])
-			weight[0]*=abs(partial_stop[0]);
+		mass = WeightedSumBox(m_SVT_Mass, start, stop, partial_start, partial_stop);
+		// prevent tiny negative values due to rounding errors of the summed volume table
+		power_mass = max(0.0, WeightedSumBox(m_SVT_Power, start, stop, partial_start, partial_stop));
+	}
+	float vx_SAR = power_mass/mass;
+	if (SAR!=NULL)
+		SAR[pos[0]][pos[1]][pos[2]]=vx_SAR;
+	return vx_SAR;
+}
 
-		for (f_pos[1]=start[1];f_pos[1]<=stop[1];++f_pos[1])
-		{
-			weight[1]=1;
-			if (f_pos[1]==start[1])
-				weight[1]*=abs(partial_start[1]);
-			if (f_pos[1]==stop[1])
-				weight[1]*=abs(partial_stop[1]);
+float*** SAR_Calculation::CalcAveragedSAR(float*** SAR)
+{
+	Delete3DArray(m_Vx_Used,m_numLines);
+	m_Vx_Used = Create3DArray<bool>(m_numLines);
+	Delete3DArray(m_Vx_Valid,m_numLines);
+	m_Vx_Valid = Create3DArray<bool>(m_numLines);
 
-			for (f_pos[2]=start[2];f_pos[2]<=stop[2];++f_pos[2])
-			{
-				weight[2]=1;
-				if (f_pos[2]==start[2])
-					weight[2]*=abs(partial_start[2]);
-				if (f_pos[2]==stop[2])
-					weight[2]*=abs(partial_stop[2]);
+	timeval t_start;
+	gettimeofday(&t_start,NULL);
 
-				if (m_cell_density[f_pos[0]][f_pos[1]][f_pos[2]]>=0)
-				{
-					mass += CellMass(f_pos)*weight[0]*weight[1]*weight[2];
-					power_mass += CalcLocalPowerDensity(f_pos) * CellVolume(f_pos)*weight[0]*weight[1]*weight[2];
-				}
-			}
-		}
+	if (m_DirectSummation==false)
+	{
+		InitSummedVolumeTables();
+		CalcPowerSummedVolumeTable();
 	}
-	float vx_SAR = power_mass/mass;
-	if (SAR==NULL)
-		return vx_SAR;
 
-	SAR[pos[0]][pos[1]][pos[2]]=vx_SAR;
+	m_Valid=0;
+	m_Used=0;
+	m_Unused=0;
+	m_AirVoxel=0;
 
-	if (assignUsed==false)
-		return vx_SAR;
+	m_SAR = SAR;
+	m_ThreadData.clear();
+	// find all valid cubes, the assignment to the used voxel has to wait for all valid voxel to be known
+	RunThreads(&SAR_Calculation::FindValidCubes);
+	RunThreads(&SAR_Calculation::AssignUsedVoxel);
+	// count all used and unused etc. + special handling of unused voxels!!
+	RunThreads(&SAR_Calculation::HandleUnusedVoxel);
 
-	// assign SAR to all used voxel
-	bool is_partial[3];
-	for (f_pos[0]=start[0];f_pos[0]<=stop[0];++f_pos[0])
+	// debug counter
+	unsigned int cnt_case1=0;
+	unsigned int cnt_case2=0;
+	unsigned int cnt_NoConvergence=0;
+	for (size_t n=0; n<m_ThreadData.size(); ++n)
 	{
-		if ( ((f_pos[0]==start[0]) && (partial_start[0]!=1)) || ((f_pos[0]==stop[0]) && (partial_stop[0]!=1)) )
-			is_partial[0]=true;
-		else
-			is_partial[0]=false;
+		m_Valid += m_ThreadData.at(n).valid;
+		m_Used += m_ThreadData.at(n).used;
+		m_Unused += m_ThreadData.at(n).unused;
+		m_AirVoxel += m_ThreadData.at(n).air;
+		cnt_case1 += m_ThreadData.at(n).case1;
+		cnt_case2 += m_ThreadData.at(n).case2;
+		cnt_NoConvergence += m_ThreadData.at(n).noConvergence;
+	}
+	m_ThreadData.clear();
+	m_SAR = NULL;
 
-		for (f_pos[1]=start[1];f_pos[1]<=stop[1];++f_pos[1])
-		{
-			if ( ((f_pos[1]==start[1]) && (partial_start[1]!=1)) || ((f_pos[1]==stop[1]) && (partial_stop[1]!=1)) )
-				is_partial[1]=true;
-			else
-				is_partial[1]=false;
+	if (cnt_NoConvergence>0)
+	{
+		cerr << "SAR_Calculation::CalcAveragedSAR: Warning, for some voxel a valid averaging cube could not be found (no convergence)... " << endl;
+	}
+	if (m_DebugLevel>0)
+	{
+		cerr << "Number of invalid cubes (case 1): " << cnt_case1 << endl;
+		cerr << "Number of invalid cubes (case 2): " << cnt_case2 << endl;
+		cerr << "Number of invalid cubes (failed to converge): " << cnt_NoConvergence << endl;
+	}
 
-			for (f_pos[2]=start[2];f_pos[2]<=stop[2];++f_pos[2])
-			{
-				if ( ((f_pos[2]==start[2]) && (partial_start[2]!=1)) || ((f_pos[2]==stop[2]) && (partial_stop[2]!=1)) )
-					is_partial[2]=true;
-				else
-					is_partial[2]=false;
+	if (m_Valid+m_Used+m_Unused+m_AirVoxel!=m_numLines[0]*m_numLines[1]*m_numLines[2])
+	{
+		cerr << "SAR_Calculation::CalcAveragedSAR: critical error, mismatch in voxel status count... EXIT" << endl;
+		exit(1);
+	}
 
-				if ( (!is_partial[0] && !is_partial[1] && !is_partial[2]) || m_markPartialAsUsed)
-				{
-					if (!m_Vx_Valid[f_pos[0]][f_pos[1]][f_pos[2]] && (m_cell_density[f_pos[0]][f_pos[1]][f_pos[2]]>0))
-					{
-						m_Vx_Used[f_pos[0]][f_pos[1]][f_pos[2]]=true;
-						SAR[f_pos[0]][f_pos[1]][f_pos[2]]=max(SAR[f_pos[0]][f_pos[1]][f_pos[2]], vx_SAR);
-					}
-				}
-			}
+	if (m_DebugLevel>0)
+		cerr << "SAR_Calculation::CalcAveragedSAR: Stats: Valid=" << m_Valid << " Used=" << m_Used << " Unused=" << m_Unused << " Air-Voxel=" << m_AirVoxel << endl;
+
+	timeval t_stop;
+	gettimeofday(&t_stop,NULL);
+	if (m_DebugLevel>0)
+		cerr << "SAR_Calculation::CalcAveragedSAR: Averaging time: " << CalcDiffTime(t_stop,t_start) << " s (" << (m_DirectSummation ? "direct summation" : "summed volume tables") << ")" << endl;
+
+	return SAR;
+}
+
+void SAR_Calculation::RunThreads(void (SAR_Calculation::*func)(unsigned int, unsigned int, unsigned int))
+{
+	unsigned int numThreads = m_numThreads;
+	if (numThreads==0)
+		numThreads = boost::thread::hardware_concurrency();
+	if (m_DirectSummation)
+		numThreads = 1;
+	vector<unsigned int> jpt = AssignJobs2Threads(m_numLines[0], numThreads, true);
+
+	// the thread data is kept for all averaging steps
+	if (m_ThreadData.size()!=jpt.size())
+	{
+		m_ThreadData.resize(jpt.size());
+		for (size_t n=0; n<m_ThreadData.size(); ++n)
+		{
+			ThreadData& data = m_ThreadData.at(n);
+			data.valid = data.used = data.unused = data.air = 0;
+			data.case1 = data.case2 = data.noConvergence = 0;
+			data.cubes.clear();
 		}
 	}
-	return vx_SAR;
-}
 
+	boost::thread_group threads;
+	unsigned int start=0;
+	for (size_t n=0; n<jpt.size(); ++n)
+	{
+		threads.add_thread( new boost::thread(func, this, start, start+jpt.at(n)-1, n) );
+		start += jpt.at(n);
+	}
+	threads.join_all();
+}
 
-float*** SAR_Calculation::CalcAveragedSAR(float*** SAR)
+void SAR_Calculation::FindValidCubes(unsigned int x_start, unsigned int x_stop, unsigned int threadID)
 {
+	ThreadData& data = m_ThreadData.at(threadID);
 	unsigned int pos[3];
-	m_Vx_Used = Create3DArray<bool>(m_numLines);
-	m_Vx_Valid = Create3DArray<bool>(m_numLines);
-
 	double voxel_volume;
 	double total_mass;
-	unsigned int start[3];
-	unsigned int stop[3];
-	float partial_start[3];
-	float partial_stop[3];
 	double bg_ratio;
 	int EC=0;
+	AveragingCube cube;
+	float partial_start[3];
+	float partial_stop[3];
 
-	// debug counter
-	unsigned int cnt_case1=0;
-	unsigned int cnt_case2=0;
-	unsigned int cnt_NoConvergence=0;
-
-	m_Valid=0;
-	m_Used=0;
-	m_Unused=0;
-	m_AirVoxel=0;
-
-	for (pos[0]=0; pos[0]<m_numLines[0]; ++pos[0])
+	for (pos[0]=x_start; pos[0]<=x_stop; ++pos[0])
 	{
 		for (pos[1]=0; pos[1]<m_numLines[1]; ++pos[1])
 		{
@@ -541,60 +566,104 @@ float*** SAR_Calculation::CalcAveragedSAR(float*** SAR)
 			{
 				if (m_cell_density[pos[0]][pos[1]][pos[2]]==0)
 				{
-					SAR[pos[0]][pos[1]][pos[2]] = 0;
-					++m_AirVoxel;
+					m_SAR[pos[0]][pos[1]][pos[2]] = 0;
+					++data.air;
 					continue;
 				}
 
 				// guess an initial box size and find a fitting cube
-				EC = FindFittingCubicalMass(pos, pow(m_avg_mass/m_cell_density[pos[0]][pos[1]][pos[2]],1.0/3.0)/2, start, stop,
+				EC = FindFittingCubicalMass(pos, pow(m_avg_mass/m_cell_density[pos[0]][pos[1]][pos[2]],1.0/3.0)/2, cube.start, cube.stop,
 											partial_start, partial_stop, total_mass, voxel_volume, bg_ratio, -1, m_IgnoreFaceValid);
 
 				if (EC==0)
 				{
 					m_Vx_Valid[pos[0]][pos[1]][pos[2]] = true;
 					m_Vx_Used[pos[0]][pos[1]][pos[2]] = true;
-					++m_Valid;
-					CalcCubicalSAR(SAR, pos, start, stop, partial_start, partial_stop, true);
+					++data.valid;
+					cube.SAR = CalcCubicalSAR(m_SAR, pos, cube.start, cube.stop, partial_start, partial_stop);
+					for (int n=0;n<3;++n)
+					{
+						cube.partial_start[n] = (partial_start[n]!=1);
+						cube.partial_stop[n] = (partial_stop[n]!=1);
+					}
+					data.cubes.push_back(cube);
 				}
 				else if (EC==1)
-					++cnt_case1;
+					++data.case1;
 				else if (EC==2)
-					++cnt_case2;
+					++data.case2;
 				else if (EC==-1)
-					++cnt_NoConvergence;
+					++data.noConvergence;
 				else
 					cerr << "other EC" << EC << endl;
 			}
 		}
 	}
-	if (cnt_NoConvergence>0)
-	{
-		cerr << "SAR_Calculation::CalcAveragedSAR: Warning, for some voxel a valid averaging cube could not be found (no convergence)... " << endl;
-	}
-	if (m_DebugLevel>0)
+}
+void SAR_Calculation::AssignUsedVoxel(unsigned int x_start, unsigned int x_stop, unsigned int threadID)
+{
+	UNUSED(threadID);
+	unsigned int f_pos[3];
+	bool is_partial[3];
+
+	// check the valid cubes of all threads, but only assign to voxel in the own x-range
+	for (size_t t=0; t<m_ThreadData.size(); ++t)
 	{
-		cerr << "Number of invalid cubes (case 1): " << cnt_case1 << endl;
-		cerr << "Number of invalid cubes (case 2): " << cnt_case2 << endl;
-		cerr << "Number of invalid cubes (failed to converge): " << cnt_NoConvergence << endl;
+		const vector<AveragingCube>& cubes = m_ThreadData.at(t).cubes;
+		for (size_t c=0; c<cubes.size(); ++c)
+		{
+			const AveragingCube& cube = cubes.at(c);
+			if ((cube.stop[0]<x_start) || (cube.start[0]>x_stop))
+				continue;
+			for (f_pos[0]=max(cube.start[0],x_start);f_pos[0]<=min(cube.stop[0],x_stop);++f_pos[0])
+			{
+				is_partial[0] = ((f_pos[0]==cube.start[0]) && cube.partial_start[0]) || ((f_pos[0]==cube.stop[0]) && cube.partial_stop[0]);
+				for (f_pos[1]=cube.start[1];f_pos[1]<=cube.stop[1];++f_pos[1])
+				{
+					is_partial[1] = ((f_pos[1]==cube.start[1]) && cube.partial_start[1]) || ((f_pos[1]==cube.stop[1]) && cube.partial_stop[1]);
+					for (f_pos[2]=cube.start[2];f_pos[2]<=cube.stop[2];++f_pos[2])
+					{
+						is_partial[2] = ((f_pos[2]==cube.start[2]) && cube.partial_start[2]) || ((f_pos[2]==cube.stop[2]) && cube.partial_stop[2]);
+						if ( (!is_partial[0] && !is_partial[1] && !is_partial[2]) || m_markPartialAsUsed)
+						{
+							if (!m_Vx_Valid[f_pos[0]][f_pos[1]][f_pos[2]] && (m_cell_density[f_pos[0]][f_pos[1]][f_pos[2]]>0))
+							{
+								m_Vx_Used[f_pos[0]][f_pos[1]][f_pos[2]]=true;
+								m_SAR[f_pos[0]][f_pos[1]][f_pos[2]]=max(m_SAR[f_pos[0]][f_pos[1]][f_pos[2]], cube.SAR);
+							}
+						}
+					}
+				}
+			}
+		}
 	}
+}
 
-	// count all used and unused etc. + special handling of unused voxels!!
-	m_Used=0;
-	m_Unused=0;
-	for (pos[0]=0;pos[0]<m_numLines[0];++pos[0])
+void SAR_Calculation::HandleUnusedVoxel(unsigned int x_start, unsigned int x_stop, unsigned int threadID)
+{
+	ThreadData& data = m_ThreadData.at(threadID);
+	unsigned int pos[3];
+	double total_mass;
+	unsigned int start[3];
+	unsigned int stop[3];
+	float partial_start[3];
+	float partial_stop[3];
+	double bg_ratio;
+	int EC=0;
+
+	for (pos[0]=x_start;pos[0]<=x_stop;++pos[0])
 	{
 		for (pos[1]=0;pos[1]<m_numLines[1];++pos[1])
 		{
 			for (pos[2]=0;pos[2]<m_numLines[2];++pos[2])
 			{
 				if (!m_Vx_Valid[pos[0]][pos[1]][pos[2]] && m_Vx_Used[pos[0]][pos[1]][pos[2]])
-					++m_Used;
+					++data.used;
 				if ((m_cell_density[pos[0]][pos[1]][pos[2]]>0) && !m_Vx_Valid[pos[0]][pos[1]][pos[2]] && !m_Vx_Used[pos[0]][pos[1]][pos[2]])
 				{
-					++m_Unused;
+					++data.unused;
 
-					SAR[pos[0]][pos[1]][pos[2]] = 0;
+					m_SAR[pos[0]][pos[1]][pos[2]] = 0;
 					double unused_volumes[6];
 					float unused_SAR[6];
 
@@ -613,33 +682,265 @@ float*** SAR_Calculation::CalcAveragedSAR(float*** SAR)
 						}
 						else
 						{
-							unused_SAR[n]=CalcCubicalSAR(NULL, pos, start, stop, partial_start, partial_stop, false);
+							unused_SAR[n]=CalcCubicalSAR(NULL, pos, start, stop, partial_start, partial_stop);
 							min_Vol = min(min_Vol,unused_volumes[n]);
 						}
 					}
 					for (int n=0;n<6;++n)
 					{
 						if (unused_volumes[n]<=m_UnusedRelativeVolLimit*min_Vol)
-							SAR[pos[0]][pos[1]][pos[2]] = max(SAR[pos[0]][pos[1]][pos[2]],unused_SAR[n]);
+							m_SAR[pos[0]][pos[1]][pos[2]] = max(m_SAR[pos[0]][pos[1]][pos[2]],unused_SAR[n]);
 					}
 				}
 			}
 		}
 	}
+}
 
-	if (m_Valid+m_Used+m_Unused+m_AirVoxel!=m_numLines[0]*m_numLines[1]*m_numLines[2])
+template <typename T>
+void IntegrateSummedVolumeTable(T*** svt, const unsigned int* numLines)
+{
+	// running sums in all three directions, the first line in each direction remains zero
+	unsigned int pos[3];
+	for (pos[0]=1;pos[0]<numLines[0];++pos[0])
+		for (pos[1]=1;pos[1]<numLines[1];++pos[1])
+			for (pos[2]=2;pos[2]<numLines[2];++pos[2])
+				svt[pos[0]][pos[1]][pos[2]] += svt[pos[0]][pos[1]][pos[2]-1];
+	for (pos[0]=1;pos[0]<numLines[0];++pos[0])
+		for (pos[1]=2;pos[1]<numLines[1];++pos[1])
+			for (pos[2]=1;pos[2]<numLines[2];++pos[2])
+				svt[pos[0]][pos[1]][pos[2]] += svt[pos[0]][pos[1]-1][pos[2]];
+	for (pos[0]=2;pos[0]<numLines[0];++pos[0])
+		for (pos[1]=1;pos[1]<numLines[1];++pos[1])
+			for (pos[2]=1;pos[2]<numLines[2];++pos[2])
+				svt[pos[0]][pos[1]][pos[2]] += svt[pos[0]-1][pos[1]][pos[2]];
+}
+
+void SAR_Calculation::InitSummedVolumeTables()
+{
+	if (m_SVT_Mass!=NULL) // tables are still valid
+		return;
+
+	for (int n=0;n<3;++n)
+		m_SVT_numLines[n] = m_numLines[n]+1;
+	m_SVT_Mass = Create3DArray<double>(m_SVT_numLines);
+	m_SVT_Volume = Create3DArray<double>(m_SVT_numLines);
+	m_SVT_BG_Volume = Create3DArray<double>(m_SVT_numLines);
+	m_SVT_Material = Create3DArray<unsigned int>(m_SVT_numLines);
+
+	unsigned int pos[3];
+	for (pos[0]=0;pos[0]<m_numLines[0];++pos[0])
 	{
-		cerr << "SAR_Calculation::CalcAveragedSAR: critical error, mismatch in voxel status count... EXIT" << endl;
-		exit(1);
+		for (pos[1]=0;pos[1]<m_numLines[1];++pos[1])
+		{
+			for (pos[2]=0;pos[2]<m_numLines[2];++pos[2])
+			{
+				double volume = CellVolume(pos);
+				m_SVT_Mass[pos[0]+1][pos[1]+1][pos[2]+1] = CellMass(pos);
+				m_SVT_Volume[pos[0]+1][pos[1]+1][pos[2]+1] = volume;
+				if (m_cell_density[pos[0]][pos[1]][pos[2]]==0)
+					m_SVT_BG_Volume[pos[0]+1][pos[1]+1][pos[2]+1] = volume;
+				else
+					m_SVT_Material[pos[0]+1][pos[1]+1][pos[2]+1] = 1;
+			}
+		}
 	}
+	IntegrateSummedVolumeTable(m_SVT_Mass, m_SVT_numLines);
+	IntegrateSummedVolumeTable(m_SVT_Volume, m_SVT_numLines);
+	IntegrateSummedVolumeTable(m_SVT_BG_Volume, m_SVT_numLines);
+	IntegrateSummedVolumeTable(m_SVT_Material, m_SVT_numLines);
+}
 
-	if (m_DebugLevel>0)
-		cerr << "SAR_Calculation::CalcAveragedSAR: Stats: Valid=" << m_Valid << " Used=" << m_Used << " Unused=" << m_Unused << " Air-Voxel=" << m_AirVoxel << endl;
+void SAR_Calculation::CalcPowerSummedVolumeTable()
+{
+	if (m_SVT_Power==NULL)
+		m_SVT_Power = Create3DArray<double>(m_SVT_numLines);
 
-	return SAR;
+	unsigned int pos[3];
+	for (pos[0]=0;pos[0]<m_numLines[0];++pos[0])
+	{
+		for (pos[1]=0;pos[1]<m_numLines[1];++pos[1])
+		{
+			for (pos[2]=0;pos[2]<m_numLines[2];++pos[2])
+			{
+				if (m_cell_density[pos[0]][pos[1]][pos[2]]>=0)
+					m_SVT_Power[pos[0]+1][pos[1]+1][pos[2]+1] = CalcLocalPowerDensity(pos)*CellVolume(pos);
+				else
+					m_SVT_Power[pos[0]+1][pos[1]+1][pos[2]+1] = 0;
+			}
+		}
+	}
+	IntegrateSummedVolumeTable(m_SVT_Power, m_SVT_numLines);
+}
+
+void SAR_Calculation::ClearSummedVolumeTables()
+{
+	Delete3DArray(m_SVT_Mass,m_SVT_numLines);
+	m_SVT_Mass = NULL;
+	Delete3DArray(m_SVT_Volume,m_SVT_numLines);
+	m_SVT_Volume = NULL;
+	Delete3DArray(m_SVT_BG_Volume,m_SVT_numLines);
+	m_SVT_BG_Volume = NULL;
+	Delete3DArray(m_SVT_Power,m_SVT_numLines);
+	m_SVT_Power = NULL;
+	Delete3DArray(m_SVT_Material,m_SVT_numLines);
+	m_SVT_Material = NULL;
+}
+
+double SAR_Calculation::WeightedSumBox(double*** svt, const unsigned int start[3], const unsigned int stop[3], const float partial_start[3], const float partial_stop[3]) const
+{
+	// split the weighting in each direction into the full box and corrections for the first and last cell
+	unsigned int sub_start[3][3];
+	unsigned int sub_stop[3][3];
+	double coeff[3][3];
+	int num[3];
+	for (int n=0;n<3;++n)
+	{
+		double w_start = fabs(partial_start[n]);
+		double w_stop = fabs(partial_stop[n]);
+		sub_start[n][0] = start[n];
+		sub_stop[n][0] = stop[n];
+		coeff[n][0] = 1;
+		num[n] = 1;
+		if (start[n]==stop[n])
+		{
+			coeff[n][0] = w_start*w_stop;
+			continue;
+		}
+		if (w_start!=1)
+		{
+			sub_start[n][num[n]] = sub_stop[n][num[n]] = start[n];
+			coeff[n][num[n]] = w_start-1;
+			++num[n];
+		}
+		if (w_stop!=1)
+		{
+			sub_start[n][num[n]] = sub_stop[n][num[n]] = stop[n];
+			coeff[n][num[n]] = w_stop-1;
+			++num[n];
+		}
+	}
+
+	double sum = 0;
+	unsigned int s[3];
+	unsigned int e[3];
+	for (int i=0;i<num[0];++i)
+	{
+		s[0] = sub_start[0][i];
+		e[0] = sub_stop[0][i];
+		for (int j=0;j<num[1];++j)
+		{
+			s[1] = sub_start[1][j];
+			e[1] = sub_stop[1][j];
+			for (int k=0;k<num[2];++k)
+			{
+				s[2] = sub_start[2][k];
+				e[2] = sub_stop[2][k];
+				sum += coeff[0][i]*coeff[1][j]*coeff[2][k]*SumBox(svt, s, e);
+			}
+		}
+	}
+	return sum;
+}
+
+bool SAR_Calculation::DirectSumMass(const unsigned int start[3], const unsigned int stop[3], const float partial_start[3], const float partial_stop[3], double &mass, double &volume, double &bg_volume) const
+{
+	mass = 0;
+	volume = 0;
+	bg_volume = 0;
+	double weight[3];
+	unsigned int f_pos[3];
+	bool face_intersect[6] = {false,false,false,false,false,false};
+	for (f_pos[0]=start[0];f_pos[0]<=stop[0];++f_pos[0])
+	{
+		weight[0]=1;
+		if (f_pos[0]==start[0])
+			weight[0]*=fabs(partial_start[0]);
+		if (f_pos[0]==stop[0])
+			weight[0]*=fabs(partial_stop[0]);
+
+		for (f_pos[1]=start[1];f_pos[1]<=stop[1];++f_pos[1])
+		{
+			weight[1]=1;
+			if (f_pos[1]==start[1])
+				weight[1]*=fabs(partial_start[1]);
+			if (f_pos[1]==stop[1])
+				weight[1]*=fabs(partial_stop[1]);
+
+			for (f_pos[2]=start[2];f_pos[2]<=stop[2];++f_pos[2])
+			{
+				weight[2]=1;
+				if (f_pos[2]==start[2])
+					weight[2]*=fabs(partial_start[2]);
+				if (f_pos[2]==stop[2])
+					weight[2]*=fabs(partial_stop[2]);
+
+				mass += CellMass(f_pos)*weight[0]*weight[1]*weight[2];
+				volume += CellVolume(f_pos)*weight[0]*weight[1]*weight[2];
+
+				if (m_cell_density[f_pos[0]][f_pos[1]][f_pos[2]]==0)
+					bg_volume += CellVolume(f_pos)*weight[0]*weight[1]*weight[2];
+				else
+				{
+					for (int n=0;n<3;++n)
+					{
+						if (start[n]==f_pos[n])
+							face_intersect[2*n]=true;
+						if (stop[n]==f_pos[n])
+							face_intersect[2*n+1]=true;
+					}
+				}
+			}
+		}
+	}
+
+	for (int n=0;n<6;++n)
+		if (face_intersect[n]==false)
+			return false;
+	return true;
+}
+
+void SAR_Calculation::DirectSumPower(const unsigned int start[3], const unsigned int stop[3], const float partial_start[3], const float partial_stop[3], double &mass, double &power) const
+{
+	mass = 0;
+	power = 0;
+	double weight[3];
+	unsigned int f_pos[3];
+	for (f_pos[0]=start[0];f_pos[0]<=stop[0];++f_pos[0])
+	{
+		weight[0]=1;
+		if (f_pos[0]==start[0])
+			weight[0]*=fabs(partial_start[0]);
+		if (f_pos[0]==stop[0])
+			weight[0]*=fabs(partial_stop[0]);
+
+		for (f_pos[1]=start[1];f_pos[1]<=stop[1];++f_pos[1])
+		{
+			weight[1]=1;
+			if (f_pos[1]==start[1])
+				weight[1]*=fabs(partial_start[1]);
+			if (f_pos[1]==stop[1])
+				weight[1]*=fabs(partial_stop[1]);
+
+			for (f_pos[2]=start[2];f_pos[2]<=stop[2];++f_pos[2])
+			{
+				weight[2]=1;
+				if (f_pos[2]==start[2])
+					weight[2]*=fabs(partial_start[2]);
+				if (f_pos[2]==stop[2])
+					weight[2]*=fabs(partial_stop[2]);
+
+				if (m_cell_density[f_pos[0]][f_pos[1]][f_pos[2]]>=0)
+				{
+					mass += CellMass(f_pos)*weight[0]*weight[1]*weight[2];
+					power += CalcLocalPowerDensity(f_pos) * CellVolume(f_pos)*weight[0]*weight[1]*weight[2];
+				}
+			}
+		}
+	}
 }
 
-double SAR_Calculation::CellVolume(unsigned int pos[3])
+double SAR_Calculation::CellVolume(unsigned int pos[3]) const
 {
 	if (m_cell_volume)
 		return m_cell_volume[pos[0]][pos[1]][pos[2]];
@@ -650,7 +951,7 @@ double SAR_Calculation::CellVolume(unsigned int pos[3])
 	return volume;
 }
 
-double SAR_Calculation::CellMass(unsigned int pos[3])
+double SAR_Calculation::CellMass(unsigned int pos[3]) const
 {
 	return m_cell_density[pos[0]][pos[1]][pos[2]]*CellVolume(pos);
 }
@@ -19,11 +19,13 @@
 #define SAR_CALCULATION_H
 
 #include <complex>
+#include <vector>
 
 class SAR_Calculation
 {
 public:
 	SAR_Calculation();
+	~SAR_Calculation();
 
 	enum SARAveragingMethod { IEEE_C95_3, IEEE_62704, SIMPLE};
 
@@ -33,6 +35,12 @@ public:
 	//! Set the debug level
 	void SetDebugLevel(int level) {m_DebugLevel=level;}
 
+	//! Set the number of threads used for SAR averaging (0 = all cores)
+	void SetNumberOfThreads(unsigned int numThreads) {m_numThreads=numThreads;}
+
+	//! Average by a single threaded direct summation instead of the summed volume tables (reference, slow)
+	void SetDirectSummation(bool val) {m_DirectSummation=val;}
+
 	//! Set the used averaging method
 	void SetAveragingMethod(SARAveragingMethod method, bool silent=false);
 
@@ -48,10 +56,10 @@ public:
 	void SetAveragingMass(float mass) {m_avg_mass=mass;}
 
 	//! Set the cell volumes (optional for speedup)
-	void SetCellVolumes(float*** cell_volume) {m_cell_volume=cell_volume;}
+	void SetCellVolumes(float*** cell_volume) {ClearSummedVolumeTables(); m_cell_volume=cell_volume;}
 
 	//! Set the cell densities (mandatory information)
-	void SetCellDensities(float*** cell_density) {m_cell_density=cell_density;}
+	void SetCellDensities(float*** cell_density) {ClearSummedVolumeTables(); m_cell_density=cell_density;}
 
 	//! Set the cell conductivities (mandatory if no current density field is given)
 	void SetCellCondictivity(float*** cell_conductivity) {m_cell_conductivity=cell_conductivity;}
@@ -78,6 +86,9 @@ protected:
 	std::complex<float>**** m_E_field;
 	std::complex<float>**** m_J_field;
 
+	//! the SAR array currently calculated
+	float*** m_SAR;
+
 	bool*** m_Vx_Used;
 	bool*** m_Vx_Valid;
 
@@ -87,6 +98,8 @@ protected:
 	unsigned int m_AirVoxel;
 
 	int m_DebugLevel;
+	unsigned int m_numThreads;
+	bool m_DirectSummation;
 
 	/*********** SAR calculation parameter and settings ***********/
 	float m_massTolerance;
@@ -97,7 +110,7 @@ protected:
 	bool m_IgnoreFaceValid;
 
 	/*********** SAR calculations methods ********/
-	double CalcLocalPowerDensity(unsigned int pos[3]);
+	double CalcLocalPowerDensity(unsigned int pos[3]) const;
 
 	//! Calculate the local SAR
 	float*** CalcLocalSAR(float*** SAR);
@@ -107,16 +120,80 @@ protected:
 	float*** CalcAveragedSAR(float*** SAR);
 
 	int FindFittingCubicalMass(unsigned int pos[3], float box_size, unsigned int start[3], unsigned int stop[3],
-						float partial_start[3], float partial_stop[3], double &mass, double &volume, double &bg_ratio, int disabledFace=-1, bool ignoreFaceValid=false);
+						float partial_start[3], float partial_stop[3], double &mass, double &volume, double &bg_ratio, int disabledFace=-1, bool ignoreFaceValid=false) const;
 	bool GetCubicalMass(unsigned int pos[3], double box_size, unsigned int start[3], unsigned int stop[3],
-						float partial_start[3], float partial_stop[3], double &mass, double &volume, double &bg_ratio, int disabledFace=-1);
-
-	float CalcCubicalSAR(float*** SAR, unsigned int pos[3], unsigned int start[3], unsigned int stop[3], float partial_start[3], float partial_stop[3], bool assignUsed=false);
+						float partial_start[3], float partial_stop[3], double &mass, double &volume, double &bg_ratio, int disabledFace=-1) const;
+
+	float CalcCubicalSAR(float*** SAR, unsigned int pos[3], unsigned int start[3], unsigned int stop[3], float partial_start[3], float partial_stop[3]) const;
+
+	//! A valid averaging cube, its SAR is assigned to all voxel used by this cube
+	struct AveragingCube
+	{
+		unsigned int start[3];
+		unsigned int stop[3];
+		bool partial_start[3];
+		bool partial_stop[3];
+		float SAR;
+	};
+
+	//! Voxel statistics and valid averaging cubes found by a single thread
+	struct ThreadData
+	{
+		unsigned int valid, used, unused, air;
+		unsigned int case1, case2, noConvergence;
+		std::vector<AveragingCube> cubes;
+	};
+	std::vector<ThreadData> m_ThreadData;
+
+	//! Run the given averaging step with all threads, each thread working on its own range of x-lines
+	void RunThreads(void (SAR_Calculation::*func)(unsigned int, unsigned int, unsigned int));
+	//! Find the valid averaging cubes for all voxel in the given x-range
+	void FindValidCubes(unsigned int x_start, unsigned int x_stop, unsigned int threadID);
+	//! Assign the SAR of all valid cubes to the used voxel in the given x-range
+	void AssignUsedVoxel(unsigned int x_start, unsigned int x_stop, unsigned int threadID);
+	//! Count used voxel and handle all unused voxel in the given x-range
+	void HandleUnusedVoxel(unsigned int x_start, unsigned int x_stop, unsigned int threadID);
 	/****** end SAR averaging and all necessary methods ********/
 
+	/****** summed volume tables for constant time cubical sums ********/
+	//! summed volume tables with numLines+1 entries in each direction, entry [i][j][k] is the sum over all cells below [i][j][k]
+	double*** m_SVT_Mass;
+	double*** m_SVT_Volume;
+	double*** m_SVT_BG_Volume;
+	double*** m_SVT_Power;
+	//! summed volume table of the number of non-background cells
+	unsigned int*** m_SVT_Material;
+	unsigned int m_SVT_numLines[3];
+
+	//! Create the mass, volume and background tables, these are kept until the densities or the mesh change.
+	void InitSummedVolumeTables();
+	//! Create the power table for the current field
+	void CalcPowerSummedVolumeTable();
+	void ClearSummedVolumeTables();
+
+	//! Sum up a summed volume table inside the given box (inclusive start and stop)
+	template <typename T>
+	inline T SumBox(T*** svt, const unsigned int start[3], const unsigned int stop[3]) const
+	{
+		const unsigned int* s = start;
+		unsigned int e[3] = {stop[0]+1, stop[1]+1, stop[2]+1};
+		return svt[e[0]][e[1]][e[2]] - svt[s[0]][e[1]][e[2]] - svt[e[0]][s[1]][e[2]] - svt[e[0]][e[1]][s[2]]
+				+ svt[s[0]][s[1]][e[2]] + svt[s[0]][e[1]][s[2]] + svt[e[0]][s[1]][s[2]] - svt[s[0]][s[1]][s[2]];
+	}
+	//! Sum up a summed volume table inside the given box, weighting the first and last cell in each direction by the given partial weights
+	double WeightedSumBox(double*** svt, const unsigned int start[3], const unsigned int stop[3], const float partial_start[3], const float partial_stop[3]) const;
+	/****** end summed volume tables ********/
+
+	/****** direct summation, the reference of the summed volume tables ********/
+	//! Sum up mass, volume and background volume cell by cell inside the given box, returns false if a face of the box does not intersect any material
+	bool DirectSumMass(const unsigned int start[3], const unsigned int stop[3], const float partial_start[3], const float partial_stop[3], double &mass, double &volume, double &bg_volume) const;
+	//! Sum up mass and absorbed power cell by cell inside the given box
+	void DirectSumPower(const unsigned int start[3], const unsigned int stop[3], const float partial_start[3], const float partial_stop[3], double &mass, double &power) const;
+	/****** end direct summation ********/
+
 	bool CheckValid();
-	double CellVolume(unsigned int pos[3]);
-	double CellMass(unsigned int pos[3]);
+	double CellVolume(unsigned int pos[3]) const;
+	double CellMass(unsigned int pos[3]) const;
 };
 
 #endif // SAR_CALCULATION_H
@@ -184,6 +184,13 @@ int LinePlaneIntersection(const double *p0, const double *p1, const double *p2,
 	return 0;
 }
 
+double CalcDiffTime(timeval t1, timeval t2)
+{
+	double s_diff = t1.tv_sec - t2.tv_sec;
+	s_diff += (t1.tv_usec-t2.tv_usec)*1e-6;
+	return s_diff;
+}
+
 #ifndef __GNUC__
 #include <chrono>
 #include <Winsock2.h> // for struct timeval
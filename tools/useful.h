@@ -20,6 +20,11 @@
 
 #include <vector>
 #include <string>
+#ifndef __GNUC__
+#include <Winsock2.h> // for struct timeval
+#else
+#include <sys/time.h>
+#endif
 
 //! Calc the nyquist number of timesteps for a given frequency and timestep
 unsigned int CalcNyquistNum(double fmax, double dT);
@@ -41,6 +46,9 @@ double* Invert(const double* in, double* out);
 
 int LinePlaneIntersection(const double *p0, const double* p1, const double* p2, const double* l_start, const double* l_stop, double* is_point, double &dist);
 
+//! Calc the time difference t1-t2 in seconds
+double CalcDiffTime(timeval t1, timeval t2);
+
 #ifndef __GNUC__
 int gettimeofday(struct timeval* tp, struct timezone* tzp);
 #endif // _WIN32